@@ -5,6 +5,8 @@
 
 #include  <vector>
 #include  <expected>
+#include  <span>
+#include  <glm/ext/matrix_float4x4.hpp>
 
 #include "error.h"
 #include "program.h"
@@ -20,6 +22,9 @@ private:
   unsigned int vbo = 0;
   unsigned int ebo = 0;
   size_t indices_count = 0;
+  // Per instance model matrices, reallocated when DrawInstanced needs more
+  unsigned int instance_buffer = 0;
+  size_t instance_capacity = 0;
 
   Mesh(const unsigned int vbo, const unsigned int ebo,
        const size_t indices_count);
@@ -42,6 +47,21 @@ public:
       const Program& program,
       const unsigned int vao,
       const unsigned int binding_index) const -> void;
+
+  // Points the attributes first_location to first_location + 3 of vao at
+  // the columns of a model matrix, advancing once per instance through the
+  // buffer bound to instance_binding_index. Call once when setting up vao.
+  static auto SetupInstanceAttributes(unsigned int vao,
+                                      unsigned int first_location,
+                                      unsigned int instance_binding_index)
+      -> void;
+
+  // Streams transforms into the instance buffer and draws a copy of the mesh
+  // for each in a single call. vao needs SetupInstanceAttributes.
+  auto DrawInstanced(const Program& program, unsigned int vao,
+                     unsigned int binding_index,
+                     unsigned int instance_binding_index,
+                     std::span<const glm::mat4> transforms) -> void;
 };
 } // namespace camera_control
 
@@ -5,43 +5,107 @@
 
 #include <expected>
 #include <format>
+#include <span>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <glm/ext/matrix_float4x4.hpp>
 
 #include  "error.h"
+#include  "program_build.h"
+#include  "shader_preprocessor/shader_preprocessor.h"
 
 #include  "gl/gl.h"
 
 namespace camera_control {
+using UniformBlock = struct UniformBlock {
+  GLuint index;
+  // Bytes the block takes in its buffer
+  size_t data_size;
+};
+
+// The GL entry points Program calls, so the calls it makes per frame can be
+// counted without a context
+using ProgramFunctions = struct ProgramFunctions {
+  PFNGLGETPROGRAMINTERFACEIVPROC get_program_interface_iv;
+  PFNGLGETPROGRAMRESOURCEIVPROC get_program_resource_iv;
+  PFNGLGETPROGRAMRESOURCENAMEPROC get_program_resource_name;
+  PFNGLUSEPROGRAMPROC use_program;
+  PFNGLPROGRAMUNIFORMMATRIX4FVPROC program_uniform_matrix_4fv;
+  PFNGLPROGRAMUNIFORM3FPROC program_uniform_3f;
+  PFNGLPROGRAMUNIFORM1FPROC program_uniform_1f;
+  PFNGLPROGRAMUNIFORM1IPROC program_uniform_1i;
+  PFNGLUNIFORMBLOCKBINDINGPROC uniform_block_binding;
+  PFNGLDELETEPROGRAMPROC delete_program;
+};
+
+// The current context's functions, needs glewInit to have run
+auto gl_program_functions() -> ProgramFunctions;
+
+using ProgramFiles = struct ProgramFiles {
+  std::string vertex_shader_filename;
+  std::string fragment_shader_filename;
+  // Injected into both shaders, picks the permutation to build
+  std::vector<shader_preprocessor::Define> defines;
+};
+
 class Program {
+  // Swaps reloaded programs in place
+  friend class ShaderReloader;
+
 private:
+  ProgramFunctions gl_;
   unsigned int program_id_ = 0;
+  // Active uniforms outside of blocks and blocks by name, read once linked
+  // so setting a uniform doesn't query the driver
+  std::unordered_map<std::string, GLint> uniform_locations_;
+  std::unordered_map<std::string, UniformBlock> uniform_blocks_;
+
+  [[nodiscard]] auto location_of(const std::string& uniform_name) const
+      -> std::expected<GLint, Error>;
 
-  explicit Program(unsigned int program_id);
+  using PreprocessedSources = struct PreprocessedSources {
+    ProgramSources sources;
+    // Every file the sources were read from, includes too
+    std::vector<std::string> files;
+  };
 
-  static auto read_file(
-      const std::string& filename) -> std::expected<std::string, Error>;
+  // Both shaders with their includes resolved and the defines injected
+  static auto preprocess(
+      const ProgramFiles& program_files) -> std::expected<PreprocessedSources,
+    Error>;
 
-  static auto compile_shader(const GLenum type,
-                             const std::string& filename) -> std::expected<
-    GLuint, Error>;
 
 public:
+  // Takes ownership of the linked program_id and reflects its active uniforms
+  // and uniform blocks, every call goes through gl
+  Program(const ProgramFunctions& gl, unsigned int program_id);
+
   // Delete copy constructors
   Program(const Program&) = delete;
   auto operator=(const Program&) -> Program& = delete;
 
   // Take ownership of the program_id
   Program(Program&& other) noexcept;
+  auto operator=(Program&& other) noexcept -> Program&;
 
   ~Program();
 
+  // Loads the program from the binary cache when it was built from the same
+  // sources before, compiles them otherwise
   static auto Create(const std::string& vertex_shader_filename,
                      const std::string& fragment_shader_filename) ->
     std::expected<Program, Error>;
 
+  // Like Create for each program, but the ones missing from the cache are
+  // built together, see build_programs
+  static auto CreateBatch(std::span<const ProgramFiles> programs) ->
+    std::vector<std::expected<Program, Error>>;
+
   auto Use() const -> void;
 
+  // Setters go through glProgramUniform*, the program doesn't need to be in
+  // use and stays unbound
   [[nodiscard]] auto SetUniformMatrix(const std::string& uniform_name,
                                       const glm::mat4& matrix) const ->
     std::expected<
@@ -61,6 +125,15 @@ public:
                            const int i) const ->
     std::expected<
       void, Error>;
+
+  // Reads the std140 block block_name from the uniform buffer bound to
+  // binding. size is the size of the struct filling it, the block can't take
+  // more.
+  [[nodiscard]] auto BindUniformBlock(const std::string& block_name,
+                                      const GLuint binding,
+                                      const size_t size) const ->
+    std::expected<
+      void, Error>;
 };
 } // namespace camera_control
 
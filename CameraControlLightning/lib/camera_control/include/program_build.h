@@ -0,0 +1,80 @@
+#ifndef PROGRAM_BUILD_H
+#define PROGRAM_BUILD_H
+
+#include <GL/glew.h>
+
+#include <expected>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "error.h"
+
+namespace camera_control {
+using ProgramSources = struct ProgramSources {
+  std::string vertex_shader_source;
+  std::string fragment_shader_source;
+};
+
+// The GL entry points build_programs calls, so its sequencing can run
+// against something other than the driver
+using ProgramBuildFunctions = struct ProgramBuildFunctions {
+  PFNGLCREATESHADERPROC create_shader;
+  PFNGLSHADERSOURCEPROC shader_source;
+  PFNGLCOMPILESHADERPROC compile_shader;
+  PFNGLGETSHADERIVPROC get_shader_iv;
+  PFNGLGETSHADERINFOLOGPROC get_shader_info_log;
+  PFNGLDELETESHADERPROC delete_shader;
+  PFNGLCREATEPROGRAMPROC create_program;
+  PFNGLPROGRAMPARAMETERIPROC program_parameter_i;
+  PFNGLATTACHSHADERPROC attach_shader;
+  PFNGLDETACHSHADERPROC detach_shader;
+  PFNGLLINKPROGRAMPROC link_program;
+  PFNGLGETPROGRAMIVPROC get_program_iv;
+  PFNGLGETPROGRAMINFOLOGPROC get_program_info_log;
+  PFNGLDELETEPROGRAMPROC delete_program;
+  // Null without KHR_parallel_shader_compile, GL_COMPLETION_STATUS_KHR is
+  // only queried when set
+  PFNGLMAXSHADERCOMPILERTHREADSKHRPROC max_shader_compiler_threads;
+};
+
+// The current context's functions, needs glewInit to have run
+auto gl_program_build_functions() -> ProgramBuildFunctions;
+
+// Shaders and program of a build the driver may still be working on
+using PendingProgram = struct PendingProgram {
+  GLuint vertex_shader;
+  GLuint fragment_shader;
+  GLuint program;
+};
+
+// Submits the compiles of every shader and then the links of every program,
+// without waiting on any
+auto submit_programs(const ProgramBuildFunctions& gl,
+                     std::span<const ProgramSources> sources)
+    -> std::vector<PendingProgram>;
+
+// Whether the driver is done with every pending program. Always true
+// without KHR_parallel_shader_compile, finish_programs blocks then.
+auto programs_completed(const ProgramBuildFunctions& gl,
+                        std::span<const PendingProgram> pending) -> bool;
+
+// Linked program or error of each pending program, deletes the shaders
+auto finish_programs(const ProgramBuildFunctions& gl,
+                     std::span<const PendingProgram> pending)
+    -> std::vector<std::expected<GLuint, Error>>;
+
+// Submits the compiles of every shader and then the links of every program
+// before asking the driver for any status, so it can overlap them across
+// its threads. With KHR_parallel_shader_compile it polls
+// GL_COMPLETION_STATUS_KHR until all are done instead of blocking on the
+// first link status.
+//
+// Each result is a linked program with its binary retrievable, or the
+// error compiling or linking it, in the order of sources.
+auto build_programs(const ProgramBuildFunctions& gl,
+                    std::span<const ProgramSources> sources)
+    -> std::vector<std::expected<GLuint, Error>>;
+} // namespace camera_control
+
+#endif //PROGRAM_BUILD_H
@@ -0,0 +1,41 @@
+#ifndef PROGRAM_VARIANTS_H
+#define PROGRAM_VARIANTS_H
+
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "error.h"
+#include "program.h"
+
+namespace camera_control {
+// Programs kept by a 64 bit key of their files and defines, so each
+// permutation is built the first time it's asked for and then reused
+class ProgramVariants {
+private:
+  // Called once on each new variant, to set what it needs before drawing
+  std::function<void(Program&, const ProgramFiles&)> on_create;
+  // Nodes don't move, so returned programs stay where they are
+  std::unordered_map<uint64_t, Program> variants;
+
+  static auto key_for(const ProgramFiles& program_files) -> uint64_t;
+
+public:
+  explicit ProgramVariants(
+      std::function<void(Program&, const ProgramFiles&)> on_create);
+
+  // Delete copy constructors
+  ProgramVariants(const ProgramVariants&) = delete;
+  auto operator=(const ProgramVariants&) -> ProgramVariants& = delete;
+
+  // The variant of each program, valid while the ProgramVariants is. Those
+  // not built yet are created together with Program::CreateBatch.
+  [[nodiscard]] auto Get(std::span<const ProgramFiles> programs) ->
+    std::vector<std::expected<Program*, Error>>;
+};
+} // namespace camera_control
+
+#endif //PROGRAM_VARIANTS_H
@@ -0,0 +1,82 @@
+#ifndef SHADER_RELOADER_H
+#define SHADER_RELOADER_H
+
+#include <chrono>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "error.h"
+#include "program.h"
+#include "program_build.h"
+
+namespace camera_control {
+// Rebuilds programs when their shader files or the files they include are
+// saved and swaps them in place, so everything holding a Program keeps using
+// it. A thread watches the shaders' directories with inotify, builds are
+// submitted and swapped in by Poll, which the render loop calls between
+// frames. A program whose new sources don't compile or link stays as it was.
+//
+// Builds only overlap frames with KHR_parallel_shader_compile. Without it
+// the driver can't be asked whether a build is done, so the Poll after a
+// change blocks in finish_programs until the program is compiled and linked.
+//
+// Only Linux has a watcher, Create fails elsewhere.
+class ShaderReloader {
+private:
+  // Shared with the watcher thread, which has to outlive it
+  struct Watch;
+
+  using Build = struct Build {
+    size_t program_index;
+    std::vector<PendingProgram> pending;
+    // When the watcher saw the first change the build includes
+    std::chrono::steady_clock::time_point changed_at;
+  };
+
+  std::vector<Program*> programs;
+  std::vector<ProgramFiles> files;
+  // Of each program, as of its last build
+  std::vector<std::vector<std::filesystem::path>> dependencies;
+  ProgramBuildFunctions gl;
+  std::unique_ptr<Watch> watch;
+  std::vector<Build> builds;
+
+  explicit ShaderReloader(std::unique_ptr<Watch> watch);
+
+  // Watches the directories of files, returns the files as dependencies
+  [[nodiscard]] auto watch_files(const std::vector<std::string>& files) ->
+    std::expected<std::vector<std::filesystem::path>, Error>;
+
+public:
+  // Delete copy constructors
+  ShaderReloader(const ShaderReloader&) = delete;
+  auto operator=(const ShaderReloader&) -> ShaderReloader& = delete;
+
+  ShaderReloader(ShaderReloader&& other) noexcept;
+
+  // Stops the watcher and drops builds still in flight
+  ~ShaderReloader();
+
+  // programs[i] was created from files[i] and must outlive the reloader
+  static auto Create(std::span<Program* const> programs,
+                     std::span<const ProgramFiles> files) -> std::expected<
+    ShaderReloader, Error>;
+
+  // Also reloads program, created from files, which must outlive the
+  // reloader. Returns the index Poll reports it with. On error the program
+  // isn't reloaded and takes no index.
+  [[nodiscard]] auto Add(Program& program, const ProgramFiles& files) ->
+    std::expected<size_t, Error>;
+
+  // Submits builds for programs whose files changed since the last call and
+  // swaps in the ones the driver finished. Returns the indices of the
+  // programs swapped, their uniforms and block bindings are back to their
+  // defaults.
+  [[nodiscard]] auto Poll() -> std::vector<size_t>;
+};
+} // namespace camera_control
+
+#endif //SHADER_RELOADER_H
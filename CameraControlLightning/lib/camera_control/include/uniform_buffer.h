@@ -0,0 +1,46 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include  <GL/glew.h>
+
+#include  <cstddef>
+#include  <expected>
+#include  <span>
+
+#include "error.h"
+
+namespace camera_control {
+// Backs a std140 uniform block shared by every program reading it, so data
+// like the camera is uploaded once per frame instead of once per program
+class UniformBuffer {
+private:
+  unsigned int buffer = 0;
+  size_t size = 0;
+
+  UniformBuffer(const unsigned int buffer, const size_t size);
+
+public:
+  // Delete copy constructors
+  UniformBuffer(const UniformBuffer&) = delete;
+  auto operator=(const UniformBuffer&) -> UniformBuffer& = delete;
+
+  // Take ownership
+  UniformBuffer(UniformBuffer&& other) noexcept;
+
+  ~UniformBuffer();
+
+  static auto Create(const size_t size) -> std::expected<
+    UniformBuffer, Error>;
+
+  // data must be laid out as the block, with std140 alignment and padding
+  [[nodiscard]] auto Update(std::span<const std::byte> data) const ->
+    std::expected<
+      void, Error>;
+
+  // Makes the buffer the source of the blocks bound to binding, see
+  // Program::BindUniformBlock
+  auto Bind(const unsigned int binding) const -> void;
+};
+} // namespace camera_control
+
+#endif //UNIFORM_BUFFER_H
@@ -1,5 +1,7 @@
 #include  "mesh.h"
 
+#include <algorithm>
+
 camera_control::Mesh::Mesh(const unsigned int vbo, const unsigned int ebo,
                      const size_t indices_count): vbo(vbo),
                                                   ebo(ebo),
@@ -10,6 +12,8 @@ camera_control::Mesh::Mesh(Mesh&& other) noexcept {
   std::swap(vbo, other.vbo);
   std::swap(ebo, other.ebo);
   std::swap(indices_count, other.indices_count);
+  std::swap(instance_buffer, other.instance_buffer);
+  std::swap(instance_capacity, other.instance_capacity);
 }
 
 camera_control::Mesh::~Mesh() {
@@ -19,6 +23,9 @@ camera_control::Mesh::~Mesh() {
   if (glIsBuffer(ebo)) {
     glDeleteBuffers(1, &ebo);
   }
+  if (glIsBuffer(instance_buffer)) {
+    glDeleteBuffers(1, &instance_buffer);
+  }
 }
 
 auto camera_control::Mesh::Create(const std::vector<Vertex>& vertices,
@@ -47,4 +54,53 @@ auto camera_control::Mesh::Draw(const Program& program, const unsigned int vao,
   glVertexArrayVertexBuffer(vao, binding_index, vbo, 0, sizeof(Vertex));
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
   glDrawElements(GL_TRIANGLES, indices_count, GL_UNSIGNED_INT, 0);
-}
\ No newline at end of file
+}
+
+auto camera_control::Mesh::SetupInstanceAttributes(
+    const unsigned int vao, const unsigned int first_location,
+    const unsigned int instance_binding_index) -> void {
+  // A mat4 attribute takes one location per column
+  for (unsigned int column = 0; column < 4; column++) {
+    const auto location = first_location + column;
+    glEnableVertexArrayAttrib(vao, location);
+    glVertexArrayAttribBinding(vao, location, instance_binding_index);
+    glVertexArrayAttribFormat(vao, location, 4, GL_FLOAT, GL_FALSE,
+                              column * sizeof(glm::vec4));
+  }
+  glVertexArrayBindingDivisor(vao, instance_binding_index, 1);
+}
+
+auto camera_control::Mesh::DrawInstanced(
+    const Program& program, const unsigned int vao,
+    const unsigned int binding_index,
+    const unsigned int instance_binding_index,
+    const std::span<const glm::mat4> transforms) -> void {
+  if (transforms.empty()) {
+    return;
+  }
+  if (instance_capacity < transforms.size()) {
+    if (glIsBuffer(instance_buffer)) {
+      glDeleteBuffers(1, &instance_buffer);
+    }
+    instance_capacity = std::max(transforms.size(), instance_capacity * 2);
+    glCreateBuffers(1, &instance_buffer);
+  }
+  // Orphan the previous contents so the driver doesn't wait for draws still
+  // reading them
+  glNamedBufferData(instance_buffer,
+                    static_cast<GLsizeiptr>(instance_capacity *
+                                            sizeof(glm::mat4)),
+                    nullptr, GL_STREAM_DRAW);
+  glNamedBufferSubData(instance_buffer, 0,
+                       static_cast<GLsizeiptr>(transforms.size_bytes()),
+                       transforms.data());
+
+  program.Use();
+  glBindVertexArray(vao);
+  glVertexArrayVertexBuffer(vao, binding_index, vbo, 0, sizeof(Vertex));
+  glVertexArrayVertexBuffer(vao, instance_binding_index, instance_buffer, 0,
+                            sizeof(glm::mat4));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glDrawElementsInstanced(GL_TRIANGLES, indices_count, GL_UNSIGNED_INT, 0,
+                          static_cast<GLsizei>(transforms.size()));
+}
@@ -1,146 +1,296 @@
 #include "program.h"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "program_build.h"
+#include "program_cache/program_cache.h"
 
 namespace camera_control {
-Program::Program(unsigned int program_id) : program_id_(program_id) {}
+namespace {
+// Relative to the working directory, next to the shaders
+constexpr auto program_cache_directory = "shader_cache";
+}  // namespace
 
-auto Program::read_file(const std::string& filename)
-    -> std::expected<std::string, Error> {
-  std::ifstream input_stream(filename);
-  std::stringstream file_contents_stream;
+auto gl_program_functions() -> ProgramFunctions {
+  return ProgramFunctions{
+      .get_program_interface_iv = glGetProgramInterfaceiv,
+      .get_program_resource_iv = glGetProgramResourceiv,
+      .get_program_resource_name = glGetProgramResourceName,
+      .use_program = glUseProgram,
+      .program_uniform_matrix_4fv = glProgramUniformMatrix4fv,
+      .program_uniform_3f = glProgramUniform3f,
+      .program_uniform_1f = glProgramUniform1f,
+      .program_uniform_1i = glProgramUniform1i,
+      .uniform_block_binding = glUniformBlockBinding,
+      .delete_program = glDeleteProgram};
+}
 
-  if (!input_stream.is_open() || input_stream.fail()) {
-    return std::unexpected(
-        Error{.message = std::format("Could not open file '{}'", filename)});
+Program::Program(const ProgramFunctions& gl, unsigned int program_id)
+    : gl_(gl), program_id_(program_id) {
+  GLint max_name_length = 0;
+  gl_.get_program_interface_iv(program_id_, GL_UNIFORM, GL_MAX_NAME_LENGTH,
+                          &max_name_length);
+  GLint max_block_name_length = 0;
+  gl_.get_program_interface_iv(program_id_, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH,
+                          &max_block_name_length);
+  std::string name(std::max(max_name_length, max_block_name_length), '\0');
+
+  GLint num_uniforms = 0;
+  gl_.get_program_interface_iv(program_id_, GL_UNIFORM, GL_ACTIVE_RESOURCES,
+                          &num_uniforms);
+  for (GLint i = 0; i < num_uniforms; i++) {
+    constexpr GLenum properties[] = {GL_BLOCK_INDEX, GL_LOCATION,
+                                     GL_ARRAY_SIZE};
+    GLint values[3] = {0};
+    gl_.get_program_resource_iv(program_id_, GL_UNIFORM, i, 3, properties, 3,
+                           nullptr, values);
+    // Members of uniform blocks have no location
+    if (values[0] != -1) {
+      continue;
+    }
+    GLsizei name_length = 0;
+    gl_.get_program_resource_name(program_id_, GL_UNIFORM, i,
+                             static_cast<GLsizei>(name.size()), &name_length,
+                             name.data());
+    const auto uniform_name = name.substr(0, name_length);
+    // Arrays of basic types are listed as their first element and take
+    // consecutive locations, glGetUniformLocation also accepts the array's
+    // name and every element's
+    if (uniform_name.ends_with("[0]")) {
+      const auto array_name = uniform_name.substr(0, uniform_name.size() - 3);
+      uniform_locations_.emplace(array_name, values[1]);
+      for (GLint element = 0; element < values[2]; element++) {
+        uniform_locations_.emplace(std::format("{}[{}]", array_name, element),
+                                   values[1] + element);
+      }
+      continue;
+    }
+    uniform_locations_.emplace(uniform_name, values[1]);
+  }
+
+  GLint num_blocks = 0;
+  gl_.get_program_interface_iv(program_id_, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES,
+                          &num_blocks);
+  for (GLint i = 0; i < num_blocks; i++) {
+    constexpr GLenum properties[] = {GL_BUFFER_DATA_SIZE};
+    GLint data_size = 0;
+    gl_.get_program_resource_iv(program_id_, GL_UNIFORM_BLOCK, i, 1, properties, 1,
+                           nullptr, &data_size);
+    GLsizei name_length = 0;
+    gl_.get_program_resource_name(program_id_, GL_UNIFORM_BLOCK, i,
+                             static_cast<GLsizei>(name.size()), &name_length,
+                             name.data());
+    uniform_blocks_.emplace(
+        name.substr(0, name_length),
+        UniformBlock{.index = static_cast<GLuint>(i),
+                     .data_size = static_cast<size_t>(data_size)});
   }
-  file_contents_stream << input_stream.rdbuf();
-  return {file_contents_stream.str()};
 }
 
-auto Program::compile_shader(const GLenum type, const std::string& filename)
-    -> std::expected<GLuint, Error> {
-  const auto source = read_file(filename);
-  if (!source) {
-    return std::unexpected(with_context(
-        source.error(),
-        std::format("Error getting source for vertex type {}", type)));
+auto Program::location_of(const std::string& uniform_name) const
+    -> std::expected<GLint, Error> {
+  const auto it = uniform_locations_.find(uniform_name);
+  if (it == uniform_locations_.end()) {
+    return std::unexpected(
+        Error{.message = std::format(
+                  "Could not get uniform location of '{}' in program {}",
+                  uniform_name, program_id_)});
   }
+  return it->second;
+}
 
-  const auto shader = glCreateShader(type);
-  const auto source_ptr = source->c_str();
-  glShaderSource(shader, 1, &source_ptr, nullptr);
-
-  glCompileShader(shader);
-  auto shader_compile_status = GL_FALSE;
-  glGetShaderiv(shader, GL_COMPILE_STATUS, &shader_compile_status);
-  if (shader_compile_status != GL_TRUE) {
-    char message[1024] = {0};
-    GLsizei message_len = 0;
-    glGetShaderInfoLog(shader, sizeof(message), &message_len, message);
+auto Program::preprocess(const ProgramFiles& program_files)
+    -> std::expected<PreprocessedSources, Error> {
+  auto vertex_shader = shader_preprocessor::preprocess(
+      program_files.vertex_shader_filename, program_files.defines);
+  if (!vertex_shader) {
     return std::unexpected(
-        Error{.message = std::format("Could not compile shader type {}: {}",
-                                     type, message)});
+        Error{.message = std::format("Could not preprocess vertex shader: {}",
+                                     vertex_shader.error())});
+  }
+  auto fragment_shader = shader_preprocessor::preprocess(
+      program_files.fragment_shader_filename, program_files.defines);
+  if (!fragment_shader) {
+    return std::unexpected(Error{
+        .message = std::format("Could not preprocess fragment shader: {}",
+                               fragment_shader.error())});
   }
-  return shader;
+
+  auto files = std::move(vertex_shader->files);
+  files.insert(files.end(), fragment_shader->files.begin(),
+               fragment_shader->files.end());
+  return PreprocessedSources{
+      .sources = ProgramSources{
+          .vertex_shader_source = std::move(vertex_shader->source),
+          .fragment_shader_source = std::move(fragment_shader->source)},
+      .files = std::move(files)};
 }
 
-Program::Program(Program&& other) noexcept {
+// other keeps the functions too, its destructor still calls delete_program
+Program::Program(Program&& other) noexcept : gl_(other.gl_) {
   std::swap(program_id_, other.program_id_);
+  std::swap(uniform_locations_, other.uniform_locations_);
+  std::swap(uniform_blocks_, other.uniform_blocks_);
 }
 
-Program::~Program() { glDeleteProgram(program_id_); }
+auto Program::operator=(Program&& other) noexcept -> Program& {
+  std::swap(gl_, other.gl_);
+  std::swap(program_id_, other.program_id_);
+  std::swap(uniform_locations_, other.uniform_locations_);
+  std::swap(uniform_blocks_, other.uniform_blocks_);
+  return *this;
+}
+
+Program::~Program() { gl_.delete_program(program_id_); }
 
 auto Program::Create(const std::string& vertex_shader_filename,
                      const std::string& fragment_shader_filename)
     -> std::expected<Program, Error> {
-  const auto vertex_shader =
-      compile_shader(GL_VERTEX_SHADER, vertex_shader_filename);
-  if (!vertex_shader) {
-    return std::unexpected(
-        with_context(vertex_shader.error(), "Could not compile vertex shader"));
-  }
-  const auto fragment_shader =
-      compile_shader(GL_FRAGMENT_SHADER, fragment_shader_filename);
-  if (!fragment_shader) {
-    return std::unexpected(with_context(fragment_shader.error(),
-                                        "Could not compile fragment shader"));
+  const ProgramFiles program_files{
+      .vertex_shader_filename = vertex_shader_filename,
+      .fragment_shader_filename = fragment_shader_filename};
+  auto programs = CreateBatch(std::span(&program_files, 1));
+  return std::move(programs.front());
+}
+
+auto Program::CreateBatch(const std::span<const ProgramFiles> programs)
+    -> std::vector<std::expected<Program, Error>> {
+  using CachedBuild = struct CachedBuild {
+    uint64_t cache_key;
+    // Of the program if it was in the cache
+    GLuint program_id;
+    std::chrono::duration<double, std::milli> link_time;
+  };
+  std::vector<std::expected<CachedBuild, Error>> builds;
+  builds.reserve(programs.size());
+  std::vector<ProgramSources> missing_sources;
+  std::vector<size_t> missing_builds;
+  for (const auto& program_files : programs) {
+    auto preprocessed = preprocess(program_files);
+    if (!preprocessed) {
+      builds.emplace_back(std::unexpected(preprocessed.error()));
+      continue;
+    }
+    auto& sources = preprocessed->sources;
+
+    const auto load_start = std::chrono::steady_clock::now();
+    const auto cache_key = program_cache::key_for(
+        sources.vertex_shader_source, sources.fragment_shader_source);
+    const auto program_id =
+        program_cache::load(program_cache_directory, cache_key);
+    builds.emplace_back(
+        CachedBuild{.cache_key = cache_key,
+                    .program_id = program_id,
+                    .link_time = std::chrono::steady_clock::now() - load_start});
+    if (program_id == 0) {
+      missing_builds.push_back(builds.size() - 1);
+      missing_sources.push_back(std::move(sources));
+    }
   }
 
-  const auto program_id = glCreateProgram();
-  glAttachShader(program_id, *vertex_shader);
-  glAttachShader(program_id, *fragment_shader);
-  glLinkProgram(program_id);
-  auto program_link_status = GL_FALSE;
-  glGetProgramiv(program_id, GL_LINK_STATUS, &program_link_status);
-  if (program_link_status != GL_TRUE) {
-    return std::unexpected(
-        Error{.message = std::format("Could not link program status: {}",
-                                     program_link_status)});
+  // Programs built together finish together, each is reported with the time
+  // of the whole batch
+  const auto build_start = std::chrono::steady_clock::now();
+  const auto built_programs =
+      build_programs(gl_program_build_functions(), missing_sources);
+  const std::chrono::duration<double, std::milli> build_time =
+      std::chrono::steady_clock::now() - build_start;
+  for (size_t i = 0; i < built_programs.size(); i++) {
+    auto& build = builds[missing_builds[i]];
+    if (!built_programs[i]) {
+      build = std::unexpected(built_programs[i].error());
+      continue;
+    }
+    build->program_id = *built_programs[i];
+    build->link_time += build_time;
+    program_cache::store(program_cache_directory, build->cache_key,
+                         build->program_id);
   }
 
-  return Program{program_id};
+  const auto cache_stats = program_cache::stats();
+  std::vector<std::expected<Program, Error>> created_programs;
+  created_programs.reserve(programs.size());
+  for (size_t i = 0; i < programs.size(); i++) {
+    if (!builds[i]) {
+      created_programs.emplace_back(std::unexpected(builds[i].error()));
+      continue;
+    }
+    const auto cache_hit =
+        std::ranges::find(missing_builds, i) == missing_builds.end();
+    std::cout << std::format(
+        "Program '{}' + '{}': cache {}, {:.2f} ms ({} hits, {} misses)\n",
+        programs[i].vertex_shader_filename,
+        programs[i].fragment_shader_filename, cache_hit ? "hit" : "miss",
+        builds[i]->link_time.count(), cache_stats.hits, cache_stats.misses);
+    created_programs.emplace_back(
+        Program{gl_program_functions(), builds[i]->program_id});
+  }
+  return created_programs;
 }
 
-auto Program::Use() const -> void { glUseProgram(program_id_); }
+auto Program::Use() const -> void { gl_.use_program(program_id_); }
 
 auto Program::SetUniformMatrix(const std::string& uniform_name,
                                const glm::mat4& matrix) const
     -> std::expected<void, Error> {
-  glUseProgram(program_id_);
-  const auto location = glGetUniformLocation(program_id_, uniform_name.c_str());
-  if (location == -1) {
-    return std::unexpected(
-        Error{.message = std::format(
-                  "Could not get uniform location of '{}' in program {}",
-                  uniform_name, program_id_)});
+  const auto location = location_of(uniform_name);
+  if (!location) {
+    return std::unexpected(location.error());
   }
-
-  glUniformMatrix4fv(location, 1, GL_FALSE, &matrix[0][0]);
-  glUseProgram(0);
+  gl_.program_uniform_matrix_4fv(program_id_, *location, 1, GL_FALSE,
+                            &matrix[0][0]);
   return {};
 }
 
 auto Program::SetUniformV3(const std::string& uniform_name,
                            const glm::vec3& vec) const
     -> std::expected<void, Error> {
-  glUseProgram(program_id_);
-  const auto location = glGetUniformLocation(program_id_, uniform_name.c_str());
-  if (location == -1) {
-    return std::unexpected(
-        Error{.message = std::format("Could not get uniform location of '{}'",
-                                     uniform_name)});
+  const auto location = location_of(uniform_name);
+  if (!location) {
+    return std::unexpected(location.error());
   }
-
-  glUniform3f(location, vec.x, vec.y, vec.z);
-  glUseProgram(0);
+  gl_.program_uniform_3f(program_id_, *location, vec.x, vec.y, vec.z);
   return {};
 }
 auto Program::SetUniform1F(const std::string& uniform_name, const float f) const
     -> std::expected<void, Error> {
-  glUseProgram(program_id_);
-  const auto location = glGetUniformLocation(program_id_, uniform_name.c_str());
-  if (location == -1) {
-    return std::unexpected(
-        Error{.message = std::format("Could not get uniform location of '{}'",
-                                     uniform_name)});
+  const auto location = location_of(uniform_name);
+  if (!location) {
+    return std::unexpected(location.error());
   }
-  glUniform1f(location, f);
-  glUseProgram(0);
+  gl_.program_uniform_1f(program_id_, *location, f);
   return {};
 }
 auto Program::SetUniform1I(const std::string& uniform_name, const int i) const
     -> std::expected<void, Error> {
-  glUseProgram(program_id_);
-  const auto location = glGetUniformLocation(program_id_, uniform_name.c_str());
-  if (location == -1) {
+  const auto location = location_of(uniform_name);
+  if (!location) {
+    return std::unexpected(location.error());
+  }
+  gl_.program_uniform_1i(program_id_, *location, i);
+  return {};
+}
+
+auto Program::BindUniformBlock(const std::string& block_name,
+                               const GLuint binding, const size_t size) const
+    -> std::expected<void, Error> {
+  const auto it = uniform_blocks_.find(block_name);
+  if (it == uniform_blocks_.end()) {
     return std::unexpected(
-        Error{.message = std::format("Could not get uniform location of '{}'",
-                                     uniform_name)});
+        Error{.message = std::format("Could not find uniform block '{}' in "
+                                     "program {}",
+                                     block_name, program_id_)});
+  }
+  if (size < it->second.data_size) {
+    return std::unexpected(
+        Error{.message = std::format(
+                  "Uniform block '{}' takes {} bytes, more than the {} given",
+                  block_name, it->second.data_size, size)});
   }
-  glUniform1i(location, i);
-  glUseProgram(0);
+  gl_.uniform_block_binding(program_id_, it->second.index, binding);
   return {};
 }
 }  // namespace camera_control
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "program_build.h"
+
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <thread>
+
+namespace camera_control {
+namespace {
+auto submit_shader(const ProgramBuildFunctions& gl, const GLenum type,
+                   const std::string& source) -> GLuint {
+  const auto shader = gl.create_shader(type);
+  const auto source_ptr = source.c_str();
+  gl.shader_source(shader, 1, &source_ptr, nullptr);
+  gl.compile_shader(shader);
+  return shader;
+}
+
+// Error of a shader that failed to compile, nullopt if it compiled
+auto shader_error(const ProgramBuildFunctions& gl, const GLuint shader,
+                  const char* stage) -> std::optional<Error> {
+  auto shader_compile_status = GL_FALSE;
+  gl.get_shader_iv(shader, GL_COMPILE_STATUS, &shader_compile_status);
+  if (shader_compile_status == GL_TRUE) {
+    return std::nullopt;
+  }
+  char message[1024] = {0};
+  GLsizei message_len = 0;
+  gl.get_shader_info_log(shader, sizeof(message), &message_len, message);
+  return Error{.message = std::format("Could not compile {} shader: {}", stage,
+                                      message)};
+}
+} // namespace
+
+auto gl_program_build_functions() -> ProgramBuildFunctions {
+  return ProgramBuildFunctions{
+      .create_shader = glCreateShader,
+      .shader_source = glShaderSource,
+      .compile_shader = glCompileShader,
+      .get_shader_iv = glGetShaderiv,
+      .get_shader_info_log = glGetShaderInfoLog,
+      .delete_shader = glDeleteShader,
+      .create_program = glCreateProgram,
+      .program_parameter_i = glProgramParameteri,
+      .attach_shader = glAttachShader,
+      .detach_shader = glDetachShader,
+      .link_program = glLinkProgram,
+      .get_program_iv = glGetProgramiv,
+      .get_program_info_log = glGetProgramInfoLog,
+      .delete_program = glDeleteProgram,
+      .max_shader_compiler_threads = GLEW_KHR_parallel_shader_compile
+                                         ? glMaxShaderCompilerThreadsKHR
+                                         : nullptr};
+}
+
+auto submit_programs(const ProgramBuildFunctions& gl,
+                     const std::span<const ProgramSources> sources)
+    -> std::vector<PendingProgram> {
+  if (gl.max_shader_compiler_threads != nullptr) {
+    // Let the driver pick how many threads compile
+    gl.max_shader_compiler_threads(0xFFFFFFFF);
+  }
+
+  std::vector<PendingProgram> pending;
+  pending.reserve(sources.size());
+  for (const auto& program_sources : sources) {
+    pending.push_back(PendingProgram{
+        .vertex_shader = submit_shader(gl, GL_VERTEX_SHADER,
+                                       program_sources.vertex_shader_source),
+        .fragment_shader =
+            submit_shader(gl, GL_FRAGMENT_SHADER,
+                          program_sources.fragment_shader_source)});
+  }
+  // Linking doesn't wait for the compiles, a shader that failed makes its
+  // link fail
+  for (auto& program : pending) {
+    program.program = gl.create_program();
+    // So program_cache can store it
+    gl.program_parameter_i(program.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                           GL_TRUE);
+    gl.attach_shader(program.program, program.vertex_shader);
+    gl.attach_shader(program.program, program.fragment_shader);
+    gl.link_program(program.program);
+  }
+  return pending;
+}
+
+auto programs_completed(const ProgramBuildFunctions& gl,
+                        const std::span<const PendingProgram> pending)
+    -> bool {
+  if (gl.max_shader_compiler_threads == nullptr) {
+    return true;
+  }
+  return std::ranges::all_of(pending, [&gl](const PendingProgram& program) {
+    auto completion_status = GL_FALSE;
+    gl.get_program_iv(program.program, GL_COMPLETION_STATUS_KHR,
+                      &completion_status);
+    return completion_status == GL_TRUE;
+  });
+}
+
+auto finish_programs(const ProgramBuildFunctions& gl,
+                     const std::span<const PendingProgram> pending)
+    -> std::vector<std::expected<GLuint, Error>> {
+  std::vector<std::expected<GLuint, Error>> programs;
+  programs.reserve(pending.size());
+  for (const auto& program : pending) {
+    auto program_link_status = GL_FALSE;
+    gl.get_program_iv(program.program, GL_LINK_STATUS, &program_link_status);
+    if (program_link_status == GL_TRUE) {
+      programs.emplace_back(program.program);
+    } else if (const auto vertex_error =
+                   shader_error(gl, program.vertex_shader, "vertex")) {
+      programs.emplace_back(std::unexpected(*vertex_error));
+    } else if (const auto fragment_error =
+                   shader_error(gl, program.fragment_shader, "fragment")) {
+      programs.emplace_back(std::unexpected(*fragment_error));
+    } else {
+      char message[1024] = {0};
+      GLsizei message_len = 0;
+      gl.get_program_info_log(program.program, sizeof(message), &message_len,
+                              message);
+      programs.emplace_back(std::unexpected(Error{
+          .message = std::format("Could not link program: {}", message)}));
+    }
+
+    // The program keeps what it needs once linked
+    gl.detach_shader(program.program, program.vertex_shader);
+    gl.detach_shader(program.program, program.fragment_shader);
+    gl.delete_shader(program.vertex_shader);
+    gl.delete_shader(program.fragment_shader);
+    if (program_link_status != GL_TRUE) {
+      gl.delete_program(program.program);
+    }
+  }
+  return programs;
+}
+
+auto build_programs(const ProgramBuildFunctions& gl,
+                    const std::span<const ProgramSources> sources)
+    -> std::vector<std::expected<GLuint, Error>> {
+  const auto pending = submit_programs(gl, sources);
+  // Polls only while the driver compiles in parallel, finish_programs
+  // blocks otherwise
+  while (!programs_completed(gl, pending)) {
+    std::this_thread::yield();
+  }
+  return finish_programs(gl, pending);
+}
+} // namespace camera_control
@@ -0,0 +1,69 @@
+#include "program_variants.h"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+#include "shader_preprocessor/shader_preprocessor.h"
+
+camera_control::ProgramVariants::ProgramVariants(
+    std::function<void(Program&, const ProgramFiles&)> on_create)
+  : on_create(std::move(on_create)) {}
+
+auto camera_control::ProgramVariants::key_for(
+    const ProgramFiles& program_files) -> uint64_t {
+  // FNV-1a over the filenames, continuing from the defines' key
+  auto key = shader_preprocessor::permutation_key(program_files.defines);
+  for (const std::string_view filename :
+       {program_files.vertex_shader_filename,
+        program_files.fragment_shader_filename}) {
+    for (const auto character : filename) {
+      key = (key ^ static_cast<unsigned char>(character)) * 0x100000001b3;
+    }
+    key = (key ^ '\n') * 0x100000001b3;
+  }
+  return key;
+}
+
+auto camera_control::ProgramVariants::Get(
+    const std::span<const ProgramFiles> programs) ->
+  std::vector<std::expected<Program*, Error>> {
+  std::vector<uint64_t> keys;
+  keys.reserve(programs.size());
+  std::vector<uint64_t> missing_keys;
+  std::vector<ProgramFiles> missing_programs;
+  for (const auto& program_files : programs) {
+    keys.push_back(key_for(program_files));
+    if (!variants.contains(keys.back()) &&
+        std::ranges::find(missing_keys, keys.back()) == missing_keys.end()) {
+      missing_keys.push_back(keys.back());
+      missing_programs.push_back(program_files);
+    }
+  }
+
+  std::unordered_map<uint64_t, Error> errors;
+  auto created_programs = Program::CreateBatch(missing_programs);
+  for (size_t i = 0; i < created_programs.size(); i++) {
+    if (!created_programs[i]) {
+      errors.emplace(missing_keys[i], created_programs[i].error());
+      continue;
+    }
+    auto& program =
+        variants.emplace(missing_keys[i], std::move(*created_programs[i]))
+        .first->second;
+    if (on_create) {
+      on_create(program, missing_programs[i]);
+    }
+  }
+
+  std::vector<std::expected<Program*, Error>> variant_programs;
+  variant_programs.reserve(programs.size());
+  for (const auto key : keys) {
+    if (const auto variant = variants.find(key); variant != variants.end()) {
+      variant_programs.emplace_back(&variant->second);
+    } else {
+      variant_programs.emplace_back(std::unexpected(errors.at(key)));
+    }
+  }
+  return variant_programs;
+}
@@ -0,0 +1,265 @@
+#include "shader_reloader.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace camera_control {
+namespace {
+auto normalized(const std::string& filename) -> std::filesystem::path {
+  return std::filesystem::path(filename).lexically_normal();
+}
+} // namespace
+
+struct ShaderReloader::Watch {
+  int inotify_fd = -1;
+  // Watched directories by watch descriptor
+  std::map<int, std::filesystem::path> directories;
+
+  std::mutex mutex;
+  // Files written since the last Poll and when each was first written
+  std::map<std::filesystem::path, std::chrono::steady_clock::time_point>
+      changed_files;
+
+  // Last so it stops before the rest is destroyed
+  std::jthread thread;
+
+  Watch() = default;
+  Watch(const Watch&) = delete;
+  auto operator=(const Watch&) -> Watch& = delete;
+
+  ~Watch() {
+    if (thread.joinable()) {
+      thread.request_stop();
+      thread.join();
+    }
+#ifdef __linux__
+    if (inotify_fd != -1) {
+      close(inotify_fd);
+    }
+#endif
+  }
+
+#ifdef __linux__
+  auto run(const std::stop_token& stop_token) -> void {
+    // Large enough for several events with names
+    alignas(inotify_event) char buffer[4096];
+    while (!stop_token.stop_requested()) {
+      pollfd poll_fd{.fd = inotify_fd, .events = POLLIN, .revents = 0};
+      // Wakes up every so often to see if it has to stop
+      if (poll(&poll_fd, 1, 100) <= 0) {
+        continue;
+      }
+      const auto length = read(inotify_fd, buffer, sizeof(buffer));
+      if (length <= 0) {
+        continue;
+      }
+      const auto now = std::chrono::steady_clock::now();
+      std::scoped_lock lock(mutex);
+      for (ssize_t offset = 0; offset < length;) {
+        const auto* const event =
+            reinterpret_cast<const inotify_event*>(buffer + offset);
+        offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        const auto directory = directories.find(event->wd);
+        if (event->len == 0 || directory == directories.end()) {
+          continue;
+        }
+        changed_files.try_emplace(
+            (directory->second / event->name).lexically_normal(), now);
+      }
+    }
+  }
+#endif
+};
+
+ShaderReloader::ShaderReloader(std::unique_ptr<Watch> watch)
+    : gl(gl_program_build_functions()), watch(std::move(watch)) {}
+
+ShaderReloader::ShaderReloader(ShaderReloader&& other) noexcept
+    : programs(std::move(other.programs)),
+      files(std::move(other.files)),
+      dependencies(std::move(other.dependencies)),
+      gl(other.gl),
+      watch(std::move(other.watch)),
+      builds(std::move(other.builds)) {}
+
+ShaderReloader::~ShaderReloader() {
+  for (const auto& build : builds) {
+    for (const auto& program : finish_programs(gl, build.pending)) {
+      if (program) {
+        gl.delete_program(*program);
+      }
+    }
+  }
+}
+
+auto ShaderReloader::watch_files(const std::vector<std::string>& files)
+    -> std::expected<std::vector<std::filesystem::path>, Error> {
+  std::vector<std::filesystem::path> program_dependencies;
+  for (const auto& filename : files) {
+    program_dependencies.push_back(normalized(filename));
+#ifdef __linux__
+    auto directory = program_dependencies.back().parent_path();
+    if (directory.empty()) {
+      directory = ".";
+    }
+    // Editors often save by renaming a new file over the old one, which a
+    // watch on the file itself would miss. Watching a directory again gives
+    // back the same descriptor.
+    const auto watch_descriptor = inotify_add_watch(
+        watch->inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch_descriptor == -1) {
+      return std::unexpected(
+          Error{.message = std::format("Could not watch directory '{}'",
+                                       directory.string())});
+    }
+    std::scoped_lock lock(watch->mutex);
+    watch->directories.emplace(watch_descriptor, directory);
+#endif
+  }
+  return program_dependencies;
+}
+
+auto ShaderReloader::Create(const std::span<Program* const> programs,
+                            const std::span<const ProgramFiles> files)
+    -> std::expected<ShaderReloader, Error> {
+  if (programs.size() != files.size()) {
+    return std::unexpected(Error{
+        .message = std::format("Got {} programs but files for {}",
+                               programs.size(), files.size())});
+  }
+#ifdef __linux__
+  auto watch = std::make_unique<Watch>();
+  watch->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (watch->inotify_fd == -1) {
+    return std::unexpected(
+        Error{.message = "Could not initialize inotify"});
+  }
+  watch->thread = std::jthread(
+      [watch = watch.get()](const std::stop_token& stop_token) {
+        watch->run(stop_token);
+      });
+  ShaderReloader shader_reloader(std::move(watch));
+  for (size_t i = 0; i < programs.size(); i++) {
+    if (const auto added = shader_reloader.Add(*programs[i], files[i]);
+        !added) {
+      return std::unexpected(added.error());
+    }
+  }
+  return {std::move(shader_reloader)};
+#else
+  return std::unexpected(
+      Error{.message = "Shader reloading needs inotify, only on Linux"});
+#endif
+}
+
+auto ShaderReloader::Add(Program& program, const ProgramFiles& files)
+    -> std::expected<size_t, Error> {
+  // Only to find the includes
+  const auto preprocessed = Program::preprocess(files);
+  if (!preprocessed) {
+    return std::unexpected(preprocessed.error());
+  }
+  // Registered only once watched, callers drop programs that fail here
+  auto watched = watch_files(preprocessed->files);
+  if (!watched) {
+    return std::unexpected(watched.error());
+  }
+  programs.push_back(&program);
+  this->files.push_back(files);
+  dependencies.push_back(std::move(*watched));
+  return programs.size() - 1;
+}
+
+auto ShaderReloader::Poll() -> std::vector<size_t> {
+  std::map<std::filesystem::path, std::chrono::steady_clock::time_point>
+      changed_files;
+  {
+    std::scoped_lock lock(watch->mutex);
+    std::swap(changed_files, watch->changed_files);
+  }
+
+  for (size_t i = 0; i < files.size() && !changed_files.empty(); i++) {
+    std::optional<std::chrono::steady_clock::time_point> changed_at;
+    for (const auto& dependency : dependencies[i]) {
+      if (const auto change = changed_files.find(dependency);
+          change != changed_files.end()) {
+        changed_at = changed_at ? std::min(*changed_at, change->second)
+                                : change->second;
+      }
+    }
+    if (!changed_at) {
+      continue;
+    }
+
+    auto preprocessed = Program::preprocess(files[i]);
+    if (!preprocessed) {
+      std::cerr << std::format(
+          "Could not reload '{}' + '{}', keeping the previous program: {}\n",
+          files[i].vertex_shader_filename, files[i].fragment_shader_filename,
+          preprocessed.error().message);
+      continue;
+    }
+    // Includes may have been added or removed, the previous ones stay
+    // watched if the new ones can't be
+    if (auto watched = watch_files(preprocessed->files); watched) {
+      dependencies[i] = std::move(*watched);
+    } else {
+      std::cerr << std::format("Could not watch '{}' + '{}': {}\n",
+                               files[i].vertex_shader_filename,
+                               files[i].fragment_shader_filename,
+                               watched.error().message);
+    }
+    builds.push_back(Build{
+        .program_index = i,
+        .pending = submit_programs(gl, std::span(&preprocessed->sources, 1)),
+        .changed_at = *changed_at});
+  }
+
+  // A build waits for the earlier builds of its program, so the latest is
+  // swapped in last
+  std::vector<size_t> swapped;
+  std::vector<size_t> building;
+  std::erase_if(builds, [this, &swapped, &building](const Build& build) {
+    if (std::ranges::find(building, build.program_index) != building.end() ||
+        !programs_completed(gl, build.pending)) {
+      building.push_back(build.program_index);
+      return false;
+    }
+    const auto& program_files = files[build.program_index];
+    auto built_program = std::move(finish_programs(gl, build.pending).front());
+    if (!built_program) {
+      std::cerr << std::format(
+          "Could not reload '{}' + '{}', keeping the previous program: {}\n",
+          program_files.vertex_shader_filename,
+          program_files.fragment_shader_filename,
+          built_program.error().message);
+      return true;
+    }
+    auto& program = *programs[build.program_index];
+    program = Program{program.gl_, *built_program};
+    swapped.push_back(build.program_index);
+    const std::chrono::duration<double, std::milli> reload_latency =
+        std::chrono::steady_clock::now() - build.changed_at;
+    std::cout << std::format("Reloaded '{}' + '{}' in {:.2f} ms\n",
+                             program_files.vertex_shader_filename,
+                             program_files.fragment_shader_filename,
+                             reload_latency.count());
+    return true;
+  });
+  return swapped;
+}
+} // namespace camera_control
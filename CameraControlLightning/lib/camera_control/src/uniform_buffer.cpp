@@ -0,0 +1,46 @@
+#include  "uniform_buffer.h"
+
+#include <format>
+#include <utility>
+
+camera_control::UniformBuffer::UniformBuffer(const unsigned int buffer,
+                                             const size_t size): buffer(buffer),
+  size(size) {}
+
+camera_control::UniformBuffer::UniformBuffer(UniformBuffer&& other) noexcept {
+  std::swap(buffer, other.buffer);
+  std::swap(size, other.size);
+}
+
+camera_control::UniformBuffer::~UniformBuffer() {
+  if (glIsBuffer(buffer)) {
+    glDeleteBuffers(1, &buffer);
+  }
+}
+
+auto camera_control::UniformBuffer::Create(const size_t size) ->
+  std::expected<UniformBuffer, Error> {
+  unsigned int buffer;
+  glCreateBuffers(1, &buffer);
+  glNamedBufferStorage(buffer, static_cast<GLsizeiptr>(size), nullptr,
+                       GL_DYNAMIC_STORAGE_BIT);
+  return {UniformBuffer(buffer, size)};
+}
+
+auto camera_control::UniformBuffer::Update(
+    const std::span<const std::byte> data) const -> std::expected<
+  void, Error> {
+  if (data.size() != size) {
+    return std::unexpected(
+        Error{.message = std::format(
+                  "Uniform buffer holds {} bytes, got {}", size,
+                  data.size())});
+  }
+  glNamedBufferSubData(buffer, 0, static_cast<GLsizeiptr>(size), data.data());
+  return {};
+}
+
+auto camera_control::UniformBuffer::Bind(const unsigned int binding) const ->
+  void {
+  glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
@@ -0,0 +1,7 @@
+// Shared by every program, updated once per frame
+layout (std140) uniform Camera {
+    mat4 mProjection;
+    mat4 mView;
+    vec3 viewPos;
+    vec3 viewFront;
+};
@@ -0,0 +1,142 @@
+// Lights of the scene and how they shade a material. Built with
+// NUM_POINT_LIGHTS point lights, 1 when it isn't defined, and reading the
+// material from textures when TEXTURED is defined.
+#include "camera.glsl"
+
+#ifndef NUM_POINT_LIGHTS
+#define NUM_POINT_LIGHTS 1
+#endif
+
+in vec2 texCoords;
+
+struct Material {
+#ifdef TEXTURED
+    sampler2D diffuse;
+    sampler2D specular;
+#else
+    vec3 diffuse;
+    vec3 specular;
+#endif
+    float shininess;
+};
+
+uniform Material material;
+
+vec3 MaterialDiffuse() {
+#ifdef TEXTURED
+    return vec3(texture(material.diffuse, texCoords));
+#else
+    return material.diffuse;
+#endif
+}
+
+vec3 MaterialSpecular() {
+#ifdef TEXTURED
+    return vec3(texture(material.specular, texCoords));
+#else
+    return material.specular;
+#endif
+}
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform DirLight dirLight;
+
+struct PointLight {
+    vec3 position;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform PointLight pointLights[NUM_POINT_LIGHTS];
+
+// Held by the camera, points where it looks
+struct SpotLight {
+    float cutOff;
+    float outerCutOff;
+
+    // Attenuation
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform SpotLight spotLight;
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normalize(normal), lightDir), 0.0);
+
+    // Specular lighting
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(reflectDir, viewDir), 0.0), material.shininess);
+
+    vec3 ambient = light.ambient * MaterialDiffuse();
+    vec3 diffuse = light.diffuse * diff * MaterialDiffuse();
+    vec3 specular = light.specular * spec * MaterialSpecular();
+
+    return (ambient + diffuse + specular);
+}
+
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
+    vec3 lightDir = normalize(light.position - fragPos);
+
+    float diff = max(dot(normalize(normal), lightDir), 0.0);
+
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(reflectDir, viewDir), 0.0), material.shininess);
+
+    float distance = length(fragPos - light.position);
+    float attenuation = 1 / (light.constant + (light.linear * distance) + (light.quadratic * distance * distance));
+
+    vec3 ambient = light.ambient * MaterialDiffuse();
+    vec3 diffuse = light.diffuse * diff * MaterialDiffuse();
+    vec3 specular = light.specular * spec * MaterialSpecular();
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+
+    return (ambient + diffuse + specular);
+}
+
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir) {
+    //    // spotlight
+    vec3 lightDir = normalize(viewPos - fragPos);
+    float diff = max(dot(normalize(normal), lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(reflectDir, viewDir), 0.0), material.shininess);
+    // Distance attenuation
+    float distance = length(viewPos - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // spot
+    float theta = dot(lightDir, normalize(-viewFront));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    vec3 ambient = light.ambient * MaterialDiffuse();
+    vec3 diffuse = light.diffuse * diff * MaterialDiffuse();
+    vec3 specular = light.specular * spec * MaterialSpecular();
+
+
+    ambient *= attenuation;
+    diffuse *= attenuation * intensity;
+    specular *= attenuation * intensity;
+
+    return (ambient + diffuse + specular);
+}
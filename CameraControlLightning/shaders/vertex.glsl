@@ -4,8 +4,7 @@ layout (location = 0) in vec3 vPos;
 layout (location = 1) in vec2 vTexPos;
 layout (location = 2) in vec3 vNormal;
 
-uniform mat4 mProjection;
-uniform mat4 mView;
+#include "camera.glsl"
 uniform mat4 mModel;
 
 out vec3 normal;
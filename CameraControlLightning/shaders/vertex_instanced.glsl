@@ -0,0 +1,20 @@
+#version 450 core
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec2 vTexPos;
+layout (location = 2) in vec3 vNormal;
+// Per instance, takes locations 3 to 6
+layout (location = 3) in mat4 iModel;
+
+#include "camera.glsl"
+
+out vec3 normal;
+out vec3 fragPos;
+out vec2 texCoords;
+
+void main() {
+    gl_Position = mProjection * mView * iModel * vec4(vPos, 1.0);
+    normal = normalize(transpose(inverse(mat3(iModel))) * vNormal); // Apply normal matrix
+    fragPos = vec3(iModel * vec4(vPos, 1.0));
+    texCoords = vTexPos;
+}
@@ -3,12 +3,27 @@
 #include <GLFW/glfw3.h>
 #include <stb_image.h>
 
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <functional>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "frustum_culling/frustum_culling.h"
 #include "mesh.h"
+#include "profiler/gpu_timer.h"
+#include "profiler/profiler.h"
 #include "program.h"
+#include "program_variants.h"
+#include "shader_reloader.h"
+#include "uniform_buffer.h"
 
 void APIENTRY glDebugCallback(GLenum source, GLenum type, GLuint error_id,
                               GLenum severity, GLsizei length,
@@ -114,7 +129,17 @@ auto get_cube_mesh()
   return camera_control::Mesh::Create(vertices, indices);
 };
 
-auto main() -> int {
+auto main(int argc, char** argv) -> int {
+  CLI::App app{"Camera control and lighting"};
+  // The scene's ten cubes by default, a field of cubes below them measures
+  // drawing many copies of a mesh
+  size_t num_field_cubes = 0;
+  app.add_option("--field-cubes", num_field_cubes,
+                 "Cubes in a field below the scene, try 100000 to compare "
+                 "instanced and per cube drawing (toggled with I)")
+      ->capture_default_str();
+  CLI11_PARSE(app, argc, argv);
+
   if (glfwInit() != GLFW_TRUE) {
     std::cerr << "Failed to initialize!\n";
     return 1;
@@ -152,25 +177,32 @@ auto main() -> int {
                           GL_TRUE);
   }
 
-  const auto program_lighting = camera_control::Program::Create(
-      "shaders/vertex.glsl", "shaders/fragment_lighting_source.glsl");
-  if (!program_lighting) {
-    std::cerr << "Failed to initialize program: "
-              << program_lighting.error().message << "\n";
-
-    glfwTerminate();
-    return 1;
+  // Rebuilds programs in place when their shaders are saved, programs are
+  // added as they are created
+  auto shader_reloader = camera_control::ShaderReloader::Create({}, {});
+  if (!shader_reloader) {
+    std::cerr << "Shader reloading disabled: "
+              << shader_reloader.error().message << "\n";
   }
 
-  const auto program_objects = camera_control::Program::Create(
-      "shaders/vertex.glsl", "shaders/fragment.glsl");
-  if (!program_objects) {
-    std::cerr << "Failed to initialize program: "
-              << program_objects.error().message << "\n";
-
+  // Matches the Camera block of the shaders, std140 gives each vec3 the space
+  // of a vec4
+  using CameraBlock = struct CameraBlock {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec4 view_position;
+    glm::vec4 view_front;
+  };
+  constexpr unsigned int camera_block_binding = 0;
+  const auto camera_buffer =
+      camera_control::UniformBuffer::Create(sizeof(CameraBlock));
+  if (!camera_buffer) {
+    std::cerr << "Failed to initialize uniform buffer: "
+              << camera_buffer.error().message << "\n";
     glfwTerminate();
     return 1;
   }
+  camera_buffer->Bind(camera_block_binding);
 
   unsigned int vao;
   glCreateVertexArrays(1, &vao);
@@ -187,8 +219,12 @@ auto main() -> int {
                             offsetof(camera_control::Vertex, u));
   glVertexArrayAttribFormat(vao, 2, 3, GL_FLOAT, GL_FALSE,
                             offsetof(camera_control::Vertex, nx));
+  // Only read by vertex_instanced.glsl
+  constexpr unsigned int instance_binding_index = 1;
+  camera_control::Mesh::SetupInstanceAttributes(vao, 3,
+                                                instance_binding_index);
 
-  const auto cube_mesh = get_cube_mesh();
+  auto cube_mesh = get_cube_mesh();
 
   if (!cube_mesh) {
     std::cerr << "Failed to initialize mesh: " << cube_mesh.error().message
@@ -359,54 +395,142 @@ auto main() -> int {
     return 1;
   }
 
-  // Material
-  program_objects->SetUniformV3("material.ambient",
-                                glm::vec3(1.0f, 0.5f, 0.31f));
   constexpr int diffuse_texture_unit = 0;
   constexpr int specular_texture_unit = 1;
-  program_objects->SetUniform1I("material.diffuse", diffuse_texture_unit);
-  program_objects->SetUniform1I("material.specular", specular_texture_unit);
-  program_objects->SetUniform1F("material.shininess", 32.0F);
-
-  // Directional light
   static constexpr auto dirlight_direction = glm::vec3(-0.2F, -1.0F, -0.3F);
-  program_objects->SetUniformV3("dirLight.ambient",
-                                glm::vec3(0.05F, 0.05F, 0.05F));
-  program_objects->SetUniformV3("dirLight.diffuse",
-                                glm::vec3(0.5F, 0.5F, 0.5F));
-  program_objects->SetUniformV3("dirLight.specular",
-                                glm::vec3(1.0F, 1.0F, 1.0F));
-  program_objects->SetUniformV3("dirLight.direction", dirlight_direction);
-
-  // Point light
-  static constexpr auto light_position = glm::vec3(0.2F, 1.0F, 0.0F);
-  constexpr auto light_source_position = light_position;
-  program_objects->SetUniformV3("pointLight.position", light_position);
-  program_objects->SetUniformV3("pointLight.ambient",
-                                glm::vec3(0.05F, 0.05F, 0.05F));
-  program_objects->SetUniformV3("pointLight.diffuse",
-                                glm::vec3(0.5F, 0.5F, 0.5F));
-  program_objects->SetUniformV3("pointLight.specular",
-                                glm::vec3(1.0F, 1.0F, 1.0F));
-  program_objects->SetUniform1F("pointLight.constant", 1.0F);
-  program_objects->SetUniform1F("pointLight.linear", 0.09F);
-  program_objects->SetUniform1F("pointLight.quadratic", 0.032F);
-
-  // Spotlight
-  program_objects->SetUniform1F("spotLight.cutOff",
-                                glm::cos(glm::radians(12.5F)));
-  program_objects->SetUniform1F("spotLight.outerCutOff",
-                                glm::cos(glm::radians(17.5F)));
-  program_objects->SetUniform1F("spotLight.constant", 1.0F);
-  program_objects->SetUniform1F("spotLight.linear", 0.09F);
-  program_objects->SetUniform1F("spotLight.quadratic", 0.032F);
-
-  program_objects->SetUniformV3("spotLight.ambient",
-                                glm::vec3(0.2F, 0.2F, 0.2F));
-  program_objects->SetUniformV3("spotLight.diffuse",
-                                glm::vec3(0.5F, 0.5F, 0.5F));
-  program_objects->SetUniformV3("spotLight.specular",
-                                glm::vec3(1.0F, 1.0F, 1.0F));
+  // The first lights the scene alone, L switches to all of them
+  static constexpr std::array point_light_positions = {
+      glm::vec3(0.2F, 1.0F, 0.0F), glm::vec3(2.3F, -3.3F, -4.0F),
+      glm::vec3(-4.0F, 2.0F, -12.0F), glm::vec3(0.0F, 0.0F, -3.0F)};
+  const auto set_lighting_uniforms = [](const camera_control::Program& program,
+                                        const int num_point_lights) {
+    // Material
+    program.SetUniformV3("material.ambient", glm::vec3(1.0f, 0.5f, 0.31f));
+    program.SetUniform1I("material.diffuse", diffuse_texture_unit);
+    program.SetUniform1I("material.specular", specular_texture_unit);
+    program.SetUniform1F("material.shininess", 32.0F);
+
+    // Directional light
+    program.SetUniformV3("dirLight.ambient", glm::vec3(0.05F, 0.05F, 0.05F));
+    program.SetUniformV3("dirLight.diffuse", glm::vec3(0.5F, 0.5F, 0.5F));
+    program.SetUniformV3("dirLight.specular", glm::vec3(1.0F, 1.0F, 1.0F));
+    program.SetUniformV3("dirLight.direction", dirlight_direction);
+
+    // Point lights
+    for (int i = 0; i < num_point_lights; i++) {
+      const auto point_light = std::format("pointLights[{}]", i);
+      program.SetUniformV3(point_light + ".position",
+                           point_light_positions[i]);
+      program.SetUniformV3(point_light + ".ambient",
+                           glm::vec3(0.05F, 0.05F, 0.05F));
+      program.SetUniformV3(point_light + ".diffuse",
+                           glm::vec3(0.5F, 0.5F, 0.5F));
+      program.SetUniformV3(point_light + ".specular",
+                           glm::vec3(1.0F, 1.0F, 1.0F));
+      program.SetUniform1F(point_light + ".constant", 1.0F);
+      program.SetUniform1F(point_light + ".linear", 0.09F);
+      program.SetUniform1F(point_light + ".quadratic", 0.032F);
+    }
+
+    // Spotlight
+    program.SetUniform1F("spotLight.cutOff", glm::cos(glm::radians(12.5F)));
+    program.SetUniform1F("spotLight.outerCutOff",
+                         glm::cos(glm::radians(17.5F)));
+    program.SetUniform1F("spotLight.constant", 1.0F);
+    program.SetUniform1F("spotLight.linear", 0.09F);
+    program.SetUniform1F("spotLight.quadratic", 0.032F);
+
+    program.SetUniformV3("spotLight.ambient", glm::vec3(0.2F, 0.2F, 0.2F));
+    program.SetUniformV3("spotLight.diffuse", glm::vec3(0.5F, 0.5F, 0.5F));
+    program.SetUniformV3("spotLight.specular", glm::vec3(1.0F, 1.0F, 1.0F));
+  };
+
+  // Sets up a program when it's built and again when it's reloaded, which
+  // brings back default uniforms and block bindings. Programs shading
+  // objects are built with NUM_POINT_LIGHTS.
+  std::unordered_map<size_t, std::function<void()>> reconfigure_reloaded;
+  camera_control::ProgramVariants program_variants(
+      [&shader_reloader, &reconfigure_reloaded, &set_lighting_uniforms](
+          camera_control::Program& program,
+          const camera_control::ProgramFiles& program_files) {
+        const auto point_lights_define = std::ranges::find(
+            program_files.defines, "NUM_POINT_LIGHTS",
+            &shader_preprocessor::Define::name);
+        const auto num_point_lights =
+            point_lights_define == program_files.defines.end()
+                ? 0
+                : std::stoi(point_lights_define->value);
+        const auto configure = [&program, num_point_lights,
+                                &set_lighting_uniforms]() {
+          if (const auto bind_camera_block_result = program.BindUniformBlock(
+                  "Camera", camera_block_binding, sizeof(CameraBlock));
+              !bind_camera_block_result) {
+            std::cerr << "Failed to bind uniform block: "
+                      << bind_camera_block_result.error().message << "\n";
+          }
+          if (num_point_lights > 0) {
+            set_lighting_uniforms(program, num_point_lights);
+          }
+        };
+        configure();
+        if (!shader_reloader) {
+          return;
+        }
+        if (const auto program_index =
+                shader_reloader->Add(program, program_files);
+            program_index) {
+          reconfigure_reloaded.emplace(*program_index, configure);
+        } else {
+          std::cerr << "Failed to watch program: "
+                    << program_index.error().message << "\n";
+        }
+      });
+  // Both shade objects with the same fragment shader, the instanced program
+  // takes each cube's model matrix from the instance buffer instead of
+  // mModel
+  const auto object_program_files = [](const int num_point_lights) {
+    const std::vector<shader_preprocessor::Define> defines = {
+        {.name = "NUM_POINT_LIGHTS",
+         .value = std::to_string(num_point_lights)},
+        {.name = "TEXTURED", .value = ""}};
+    return std::array<camera_control::ProgramFiles, 2>{{
+        {.vertex_shader_filename = "shaders/vertex.glsl",
+         .fragment_shader_filename = "shaders/fragment.glsl",
+         .defines = defines},
+        {.vertex_shader_filename = "shaders/vertex_instanced.glsl",
+         .fragment_shader_filename = "shaders/fragment.glsl",
+         .defines = defines},
+    }};
+  };
+
+  // Built together so the driver can compile them in parallel
+  int num_point_lights = 1;
+  camera_control::Program* program_lighting = nullptr;
+  camera_control::Program* program_objects = nullptr;
+  camera_control::Program* program_objects_instanced = nullptr;
+  {
+    const auto [objects_files, objects_instanced_files] =
+        object_program_files(num_point_lights);
+    const std::array<camera_control::ProgramFiles, 3> program_files = {{
+        {.vertex_shader_filename = "shaders/vertex.glsl",
+         .fragment_shader_filename = "shaders/fragment_lighting_source.glsl"},
+        objects_files,
+        objects_instanced_files,
+    }};
+    const auto programs = program_variants.Get(program_files);
+    for (const auto& program : programs) {
+      if (!program) {
+        std::cerr << "Failed to initialize program: "
+                  << program.error().message << "\n";
+
+        glfwTerminate();
+        return 1;
+      }
+    }
+    program_lighting = *programs[0];
+    program_objects = *programs[1];
+    program_objects_instanced = *programs[2];
+  }
 
   glm::vec3 cubePositions[] = {
       glm::vec3(0.0f, 0.0f, 0.0f),    glm::vec3(2.0f, 5.0f, -15.0f),
@@ -415,31 +539,115 @@ auto main() -> int {
       glm::vec3(1.3f, -2.0f, -2.5f),  glm::vec3(1.5f, 2.0f, -2.5f),
       glm::vec3(1.5f, 0.2f, -1.5f),   glm::vec3(-1.3f, 1.0f, -1.5f)};
 
+  // The scene's cubes, then the field of --field-cubes below them
+  std::vector<glm::vec3> cube_positions(std::begin(cubePositions),
+                                        std::end(cubePositions));
+  const auto field_side = static_cast<size_t>(
+      std::ceil(std::sqrt(static_cast<double>(num_field_cubes))));
+  for (size_t i = 0; i < num_field_cubes; i++) {
+    cube_positions.emplace_back(
+        (static_cast<float>(i % field_side) - field_side / 2.0F) * 1.5F,
+        -8.0F,
+        -(static_cast<float>(i / field_side)) * 1.5F);
+  }
+
+  // Cubes don't move, their model matrices are built once. They only rotate
+  // around their centers, so their bounding spheres don't change either. The
+  // cube mesh spans -0.5 to 0.5 on every axis.
+  std::vector<glm::mat4> cube_model_matrices;
+  cube_model_matrices.reserve(cube_positions.size());
+  frustum_culling::Spheres cube_bounds;
+  for (size_t i = 0; i < cube_positions.size(); i++) {
+    auto cube_model_matrix = glm::mat4(1.0F);
+    cube_model_matrix = glm::translate(cube_model_matrix, cube_positions[i]);
+    float angle = 20.0f * i;
+    cube_model_matrix = glm::rotate(cube_model_matrix, glm::radians(angle),
+                                    glm::vec3(1.0f, 0.3f, 0.5f));
+    cube_model_matrices.push_back(cube_model_matrix);
+    frustum_culling::add_sphere(cube_bounds, cube_positions[i].x,
+                                cube_positions[i].y, cube_positions[i].z,
+                                std::sqrt(3.0F) * 0.5F);
+  }
+  std::vector<uint32_t> visible_cubes;
+  visible_cubes.reserve(cube_positions.size());
+  std::vector<glm::mat4> visible_cube_model_matrices;
+  visible_cube_model_matrices.reserve(cube_positions.size());
+  // Culling is logged when the number of visible cubes changes
+  size_t last_num_visible_cubes = cube_positions.size() + 1;
+
+  // I switches between one instanced draw for every cube and a draw per cube
+  // setting mModel. Frame and cube submission times are averaged and logged
+  // every second to compare both.
+  bool draw_instanced = true;
+  bool instancing_key_pressed = false;
+  bool point_lights_key_pressed = false;
+  size_t num_timed_frames = 0;
+  double frame_time_sum = 0.0;
+  double cube_submission_time_sum = 0.0;
+  auto timing_report_time = glfwGetTime();
+
+  // Each frame's zones are written to trace.json on exit, GPU timings of
+  // the cubes and light sources are also logged with the frame time
+  profiler::set_thread_name("Main");
+  profiler::GpuTimer gpu_timer;
+
   // Rendering loop
   while (glfwWindowShouldClose(window) != GLFW_TRUE) {
+    gpu_timer.BeginFrame();
+    const profiler::Zone frame_zone("Frame");
+
+    // Between frames, so a frame draws with one version of each program
+    if (shader_reloader) {
+      const profiler::Zone reload_zone("Shader reload");
+      for (const auto program_index : shader_reloader->Poll()) {
+        reconfigure_reloaded.at(program_index)();
+      }
+    }
+
     const auto delta_time = static_cast<float>(get_delta());
     handle_input(delta_time);
-
-    if (const auto set_v_view_pos_result =
-            program_objects->SetUniformV3("viewPos", camera_position);
-        !set_v_view_pos_result) {
-      std::cerr << "Failed to set uniform: "
-                << set_v_view_pos_result.error().message << "\n";
-      glfwTerminate();
-      return 1;
+    if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS) {
+      if (!instancing_key_pressed) {
+        draw_instanced = !draw_instanced;
+        num_timed_frames = 0;
+        frame_time_sum = 0.0;
+        cube_submission_time_sum = 0.0;
+        timing_report_time = glfwGetTime();
+      }
+      instancing_key_pressed = true;
+    } else {
+      instancing_key_pressed = false;
+    }
+    // Each count is a permutation of the object programs, built the first
+    // time it's used
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) {
+      if (!point_lights_key_pressed) {
+        const auto next_num_point_lights =
+            num_point_lights == 1
+                ? static_cast<int>(point_light_positions.size())
+                : 1;
+        const auto programs =
+            program_variants.Get(object_program_files(next_num_point_lights));
+        if (programs[0] && programs[1]) {
+          num_point_lights = next_num_point_lights;
+          program_objects = *programs[0];
+          program_objects_instanced = *programs[1];
+          std::cout << "Point lights: " << num_point_lights << "\n";
+        } else {
+          std::cerr << "Failed to build program: "
+                    << (programs[0] ? programs[1] : programs[0])
+                           .error()
+                           .message
+                    << "\n";
+        }
+      }
+      point_lights_key_pressed = true;
+    } else {
+      point_lights_key_pressed = false;
     }
 
     const auto projection_matrix = glm::perspective(
         glm::radians(45.0F), window_status.aspect_ratio, 0.1F, 100.0F);
-    if (const auto set_m_projection_result =
-            program_objects->SetUniformMatrix("mProjection", projection_matrix);
-        !set_m_projection_result) {
-      std::cerr << "Failed to set uniform: "
-                << set_m_projection_result.error().message << "\n";
-      glfwTerminate();
-      return 1;
-    }
-
     const auto view_matrix = [&window, &camera_position, &camera_front,
                               &camera_up]() {
       const auto lookat_matrix = glm::lookAt(
@@ -447,82 +655,132 @@ auto main() -> int {
       return lookat_matrix;
     }();
 
-    if (const auto set_m_view_result =
-            program_objects->SetUniformMatrix("mView", view_matrix);
-        !set_m_view_result) {
-      std::cerr << "Failed to set uniform: "
-                << set_m_view_result.error().message << "\n";
+    // Read by every program, the spotlight follows the camera
+    const CameraBlock camera_block{
+        .projection = projection_matrix,
+        .view = view_matrix,
+        .view_position = glm::vec4(camera_position, 1.0F),
+        .view_front = glm::vec4(camera_front, 0.0F)};
+    if (const auto update_camera_result =
+            camera_buffer->Update(std::as_bytes(std::span(&camera_block, 1)));
+        !update_camera_result) {
+      std::cerr << "Failed to update uniform buffer: "
+                << update_camera_result.error().message << "\n";
       glfwTerminate();
       return 1;
     }
 
-    program_objects->SetUniformV3("spotLight.position", camera_position);
-    program_objects->SetUniformV3("spotLight.direction", camera_front);
+    const auto view_projection_matrix = projection_matrix * view_matrix;
+    {
+      const profiler::Zone culling_zone("Culling");
+      frustum_culling::cull_spheres(
+          frustum_culling::extract_frustum(std::span<const float, 16>(
+              glm::value_ptr(view_projection_matrix), 16)),
+          cube_bounds, visible_cubes);
+    }
+    if (visible_cubes.size() != last_num_visible_cubes) {
+      std::cout << "Cubes: " << visible_cubes.size() << " visible, "
+                << cube_positions.size() - visible_cubes.size()
+                << " culled\n";
+      last_num_visible_cubes = visible_cubes.size();
+    }
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Lighting source
-    program_lighting->Use();
-    if (const auto set_m_projection_result = program_lighting->SetUniformMatrix(
-            "mProjection", projection_matrix);
-        !set_m_projection_result) {
-      std::cerr << "Failed to set uniform: "
-                << set_m_projection_result.error().message << "\n";
-      glfwTerminate();
-      return 1;
-    }
-    if (const auto set_m_view_result =
-            program_lighting->SetUniformMatrix("mView", view_matrix);
-        !set_m_view_result) {
-      std::cerr << "Failed to set uniform: "
-                << set_m_view_result.error().message << "\n";
-      glfwTerminate();
-      return 1;
-    }
-    auto lighting_source_model_matrix = glm::mat4(1.0F);
-    lighting_source_model_matrix =
-        glm::translate(lighting_source_model_matrix, light_source_position);
-    lighting_source_model_matrix = glm::scale(lighting_source_model_matrix,
-                                              glm::vec3(0.25F, 0.25F, 0.25F));
-
-    if (const auto set_m_model_result = program_lighting->SetUniformMatrix(
-            "mModel", lighting_source_model_matrix);
-        !set_m_model_result) {
-      std::cerr << "Failed to set uniform: "
-                << set_m_model_result.error().message << "\n";
-      glfwTerminate();
-      return 1;
+    // Lighting sources
+    {
+      const profiler::Zone light_sources_zone("Light sources");
+      const profiler::GpuZone light_sources_gpu_zone(gpu_timer,
+                                                     "Light sources");
+      for (int i = 0; i < num_point_lights; i++) {
+        auto lighting_source_model_matrix = glm::mat4(1.0F);
+        lighting_source_model_matrix = glm::translate(
+            lighting_source_model_matrix, point_light_positions[i]);
+        lighting_source_model_matrix = glm::scale(
+            lighting_source_model_matrix, glm::vec3(0.25F, 0.25F, 0.25F));
+
+        if (const auto set_m_model_result = program_lighting->SetUniformMatrix(
+                "mModel", lighting_source_model_matrix);
+            !set_m_model_result) {
+          std::cerr << "Failed to set uniform: "
+                    << set_m_model_result.error().message << "\n";
+          glfwTerminate();
+          return 1;
+        }
+        lighting_source_mesh->Draw(*program_lighting, vao, 0);
+      }
     }
-    lighting_source_mesh->Draw(*program_lighting, vao, 0);
 
     // Cubes
-    for (size_t i = 0; i < std::size(cubePositions); i++) {
-      auto cube_model_matrix = glm::mat4(1.0F);
-      cube_model_matrix = glm::translate(cube_model_matrix, cubePositions[i]);
-      float angle = 20.0f * i;
-      cube_model_matrix = glm::rotate(cube_model_matrix, glm::radians(angle),
-                                      glm::vec3(1.0f, 0.3f, 0.5f));
-      if (const auto set_m_model_result =
-              program_objects->SetUniformMatrix("mModel", cube_model_matrix);
-          !set_m_model_result) {
-        std::cerr << "Failed to set uniform: "
-                  << set_m_model_result.error().message << "\n";
-        glfwTerminate();
-        return 1;
-      }
-
+    const auto cube_submission_start = glfwGetTime();
+    {
+      const profiler::Zone cubes_zone("Cubes");
+      const profiler::GpuZone cubes_gpu_zone(gpu_timer, "Cubes");
       glBindTextureUnit(diffuse_texture_unit, *texture);
       glBindTextureUnit(specular_texture_unit, *texture_specular);
-      cube_mesh->Draw(*program_objects, vao, 0);
+      if (draw_instanced) {
+        visible_cube_model_matrices.clear();
+        for (const auto i : visible_cubes) {
+          visible_cube_model_matrices.push_back(cube_model_matrices[i]);
+        }
+        cube_mesh->DrawInstanced(*program_objects_instanced, vao, 0,
+                                 instance_binding_index,
+                                 visible_cube_model_matrices);
+      } else {
+        for (const auto i : visible_cubes) {
+          if (const auto set_m_model_result =
+                  program_objects->SetUniformMatrix("mModel",
+                                                    cube_model_matrices[i]);
+              !set_m_model_result) {
+            std::cerr << "Failed to set uniform: "
+                      << set_m_model_result.error().message << "\n";
+            glfwTerminate();
+            return 1;
+          }
+          cube_mesh->Draw(*program_objects, vao, 0);
+        }
+      }
       glBindTextureUnit(diffuse_texture_unit, 0);
       glBindTextureUnit(specular_texture_unit, 0);
     }
+    // Submission doesn't wait for the GPU, the frame time does through the
+    // buffer swap
+    cube_submission_time_sum += glfwGetTime() - cube_submission_start;
 
     glUseProgram(0);
 
-    glfwSwapBuffers(window);
+    {
+      const profiler::Zone swap_zone("Swap buffers");
+      glfwSwapBuffers(window);
+    }
     glfwPollEvents();
+
+    frame_time_sum += delta_time;
+    num_timed_frames++;
+    if (const auto now = glfwGetTime(); 1.0 <= now - timing_report_time) {
+      std::cout << (draw_instanced ? "Instanced" : "Per cube") << ": "
+                << visible_cubes.size() << " cubes, frame "
+                << 1000.0 * frame_time_sum / num_timed_frames
+                << " ms, cube submission "
+                << 1000.0 * cube_submission_time_sum / num_timed_frames
+                << " ms";
+      for (const auto& [name, milliseconds] : gpu_timer.LastTimings()) {
+        std::cout << ", GPU " << name << " " << milliseconds << " ms";
+      }
+      std::cout << "\n";
+      num_timed_frames = 0;
+      frame_time_sum = 0.0;
+      cube_submission_time_sum = 0.0;
+      timing_report_time = now;
+    }
+  }
+  if (const auto profiler_stats = profiler::stats();
+      profiler::write_chrome_trace("trace.json")) {
+    std::cout << "Wrote trace.json: " << profiler_stats.num_events
+              << " events, " << profiler_stats.num_dropped << " dropped\n";
+  } else {
+    std::cerr << "Failed to write trace.json\n";
   }
   glfwTerminate();
   return 0;
-}
\ No newline at end of file
+}
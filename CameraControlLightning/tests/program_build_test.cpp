@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "program_build.h"
+
+namespace {
+using camera_control::ProgramBuildFunctions;
+using camera_control::ProgramSources;
+
+// Sources containing these fail at that step
+constexpr auto compile_error = "compile error";
+constexpr auto link_error = "link error";
+
+using Event = struct Event {
+  enum class Kind {
+    kCompileShader,
+    kLinkProgram,
+    kCompileStatus,
+    kLinkStatus,
+    kCompletionStatus,
+    kMaxShaderCompilerThreads,
+  };
+  Kind kind;
+  GLuint name;
+};
+using Kind = Event::Kind;
+
+// The driver every fake stands for
+std::vector<Event> events;
+GLuint next_name = 1;
+std::map<GLuint, std::string> shader_sources;
+std::map<GLuint, std::vector<GLuint>> attached_shaders;
+std::vector<GLuint> failed_links;
+std::vector<GLuint> deleted_shaders;
+std::vector<GLuint> deleted_programs;
+// Completion queries answered GL_FALSE before a program reports complete
+int num_incomplete_polls = 0;
+std::map<GLuint, int> completion_polls;
+
+auto contains(const std::vector<GLuint>& names, const GLuint name) -> bool {
+  return std::ranges::find(names, name) != names.end();
+}
+
+auto shader_compiles(const GLuint shader) -> bool {
+  return !shader_sources.at(shader).contains(compile_error);
+}
+
+auto program_links(const GLuint program) -> bool {
+  return std::ranges::all_of(attached_shaders.at(program),
+                             [](const GLuint shader) {
+                               return shader_compiles(shader) &&
+                                      !shader_sources.at(shader).contains(
+                                          link_error);
+                             });
+}
+
+auto write_log(const char* log, const GLsizei buf_size, GLsizei* length,
+               GLchar* info_log) -> void {
+  const auto log_length = std::min<GLsizei>(
+      static_cast<GLsizei>(std::strlen(log)), buf_size - 1);
+  std::memcpy(info_log, log, log_length);
+  info_log[log_length] = '\0';
+  *length = log_length;
+}
+
+GLuint GLAPIENTRY create_shader(GLenum) { return next_name++; }
+void GLAPIENTRY shader_source(const GLuint shader, GLsizei,
+                              const GLchar* const* string, const GLint*) {
+  shader_sources[shader] = string[0];
+}
+void GLAPIENTRY compile_shader(const GLuint shader) {
+  events.push_back({Kind::kCompileShader, shader});
+}
+void GLAPIENTRY get_shader_iv(const GLuint shader, const GLenum pname,
+                              GLint* param) {
+  ASSERT_EQ(pname, GL_COMPILE_STATUS);
+  events.push_back({Kind::kCompileStatus, shader});
+  *param = shader_compiles(shader) ? GL_TRUE : GL_FALSE;
+}
+void GLAPIENTRY get_shader_info_log(GLuint, const GLsizei buf_size,
+                                    GLsizei* length, GLchar* info_log) {
+  write_log("syntax error", buf_size, length, info_log);
+}
+void GLAPIENTRY delete_shader(const GLuint shader) {
+  deleted_shaders.push_back(shader);
+}
+GLuint GLAPIENTRY create_program() {
+  attached_shaders[next_name] = {};
+  return next_name++;
+}
+void GLAPIENTRY program_parameter_i(GLuint, GLenum, GLint) {}
+void GLAPIENTRY attach_shader(const GLuint program, const GLuint shader) {
+  attached_shaders.at(program).push_back(shader);
+}
+void GLAPIENTRY detach_shader(const GLuint program, const GLuint shader) {
+  std::erase(attached_shaders.at(program), shader);
+}
+void GLAPIENTRY link_program(const GLuint program) {
+  events.push_back({Kind::kLinkProgram, program});
+  // Checked at link time, detaching afterwards doesn't change the status
+  if (!program_links(program)) {
+    failed_links.push_back(program);
+  }
+}
+void GLAPIENTRY get_program_iv(const GLuint program, const GLenum pname,
+                               GLint* param) {
+  if (pname == GL_COMPLETION_STATUS_KHR) {
+    events.push_back({Kind::kCompletionStatus, program});
+    *param = completion_polls[program]++ < num_incomplete_polls ? GL_FALSE
+                                                                : GL_TRUE;
+    return;
+  }
+  ASSERT_EQ(pname, GL_LINK_STATUS);
+  events.push_back({Kind::kLinkStatus, program});
+  *param = contains(failed_links, program) ? GL_FALSE : GL_TRUE;
+}
+void GLAPIENTRY get_program_info_log(GLuint, const GLsizei buf_size,
+                                     GLsizei* length, GLchar* info_log) {
+  write_log("undefined reference", buf_size, length, info_log);
+}
+void GLAPIENTRY delete_program(const GLuint program) {
+  deleted_programs.push_back(program);
+}
+void GLAPIENTRY max_shader_compiler_threads(const GLuint count) {
+  EXPECT_EQ(count, 0xFFFFFFFF);
+  events.push_back({Kind::kMaxShaderCompilerThreads, 0});
+}
+
+auto fake_build_functions(const bool parallel_shader_compile)
+    -> ProgramBuildFunctions {
+  return ProgramBuildFunctions{
+      .create_shader = create_shader,
+      .shader_source = shader_source,
+      .compile_shader = compile_shader,
+      .get_shader_iv = get_shader_iv,
+      .get_shader_info_log = get_shader_info_log,
+      .delete_shader = delete_shader,
+      .create_program = create_program,
+      .program_parameter_i = program_parameter_i,
+      .attach_shader = attach_shader,
+      .detach_shader = detach_shader,
+      .link_program = link_program,
+      .get_program_iv = get_program_iv,
+      .get_program_info_log = get_program_info_log,
+      .delete_program = delete_program,
+      .max_shader_compiler_threads =
+          parallel_shader_compile ? max_shader_compiler_threads : nullptr};
+}
+
+auto count(const Kind kind) -> size_t {
+  return std::ranges::count(events, kind, &Event::kind);
+}
+
+// Of the first event matching predicate, events.size() if none does
+template <typename Predicate>
+auto first_index(const Predicate& predicate) -> size_t {
+  return std::ranges::find_if(events, predicate) - events.begin();
+}
+
+// Of the last event matching predicate, events.size() if none does
+template <typename Predicate>
+auto last_index(const Predicate& predicate) -> size_t {
+  const auto last = std::ranges::find_if(events.rbegin(), events.rend(),
+                                         predicate);
+  return last == events.rend() ? events.size()
+                               : events.rend() - last - 1;
+}
+
+auto of_kind(const Kind kind) {
+  return [kind](const Event& event) { return event.kind == kind; };
+}
+
+auto is_status_query(const Event& event) -> bool {
+  return event.kind == Kind::kCompileStatus ||
+         event.kind == Kind::kLinkStatus ||
+         event.kind == Kind::kCompletionStatus;
+}
+
+auto is_submission(const Event& event) -> bool {
+  return event.kind == Kind::kCompileShader ||
+         event.kind == Kind::kLinkProgram;
+}
+
+class ProgramBuildTest : public testing::TestWithParam<bool> {
+protected:
+  auto SetUp() -> void override {
+    events.clear();
+    shader_sources.clear();
+    attached_shaders.clear();
+    failed_links.clear();
+    deleted_shaders.clear();
+    deleted_programs.clear();
+    completion_polls.clear();
+    num_incomplete_polls = 0;
+  }
+};
+
+// With and without KHR_parallel_shader_compile
+INSTANTIATE_TEST_SUITE_P(ParallelShaderCompile, ProgramBuildTest,
+                         testing::Bool());
+
+TEST_P(ProgramBuildTest, EverythingIsSubmittedBeforeAnyStatusQuery) {
+  num_incomplete_polls = 2;
+  const std::vector<ProgramSources> sources(
+      4, ProgramSources{.vertex_shader_source = "void main() {}",
+                        .fragment_shader_source = "void main() {}"});
+
+  const auto programs =
+      camera_control::build_programs(fake_build_functions(GetParam()),
+                                     sources);
+
+  ASSERT_EQ(programs.size(), sources.size());
+  for (const auto& program : programs) {
+    EXPECT_TRUE(program.has_value());
+  }
+  EXPECT_EQ(count(Kind::kCompileShader), 2 * sources.size());
+  EXPECT_EQ(count(Kind::kLinkProgram), sources.size());
+  EXPECT_LT(last_index(is_submission), first_index(is_status_query));
+  // Every compile is submitted before the first link
+  EXPECT_LT(last_index(of_kind(Kind::kCompileShader)),
+            first_index(of_kind(Kind::kLinkProgram)));
+}
+
+TEST_P(ProgramBuildTest, CompletionIsPolledOnlyWithCompilerThreads) {
+  num_incomplete_polls = 3;
+  const std::vector<ProgramSources> sources(
+      2, ProgramSources{.vertex_shader_source = "void main() {}",
+                        .fragment_shader_source = "void main() {}"});
+
+  const auto programs =
+      camera_control::build_programs(fake_build_functions(GetParam()),
+                                     sources);
+
+  ASSERT_EQ(programs.size(), sources.size());
+  if (!GetParam()) {
+    EXPECT_EQ(count(Kind::kMaxShaderCompilerThreads), 0U);
+    EXPECT_EQ(count(Kind::kCompletionStatus), 0U);
+    return;
+  }
+  EXPECT_EQ(count(Kind::kMaxShaderCompilerThreads), 1U);
+  EXPECT_EQ(events.front().kind, Kind::kMaxShaderCompilerThreads);
+  // Polled until the last program completed, before its link status
+  for (const auto& program : programs) {
+    EXPECT_GT(completion_polls.at(*program), num_incomplete_polls);
+  }
+  EXPECT_LT(last_index(of_kind(Kind::kCompletionStatus)),
+            first_index(of_kind(Kind::kLinkStatus)));
+}
+
+TEST_P(ProgramBuildTest, FailedBuildsDeleteTheirProgramAndShaders) {
+  const std::vector<ProgramSources> sources = {
+      {.vertex_shader_source = "void main() {}",
+       .fragment_shader_source = "void main() {}"},
+      {.vertex_shader_source = compile_error,
+       .fragment_shader_source = "void main() {}"},
+      {.vertex_shader_source = "void main() {}",
+       .fragment_shader_source = compile_error},
+      {.vertex_shader_source = "void main() {}",
+       .fragment_shader_source = link_error}};
+  const auto gl = fake_build_functions(GetParam());
+
+  const auto pending = camera_control::submit_programs(gl, sources);
+  while (!camera_control::programs_completed(gl, pending)) {
+  }
+  const auto programs = camera_control::finish_programs(gl, pending);
+
+  ASSERT_EQ(programs.size(), sources.size());
+  ASSERT_TRUE(programs[0].has_value());
+  EXPECT_EQ(*programs[0], pending[0].program);
+  ASSERT_FALSE(programs[1].has_value());
+  EXPECT_EQ(programs[1].error().message,
+            "Could not compile vertex shader: syntax error");
+  ASSERT_FALSE(programs[2].has_value());
+  EXPECT_EQ(programs[2].error().message,
+            "Could not compile fragment shader: syntax error");
+  ASSERT_FALSE(programs[3].has_value());
+  EXPECT_EQ(programs[3].error().message,
+            "Could not link program: undefined reference");
+
+  EXPECT_EQ(deleted_programs,
+            (std::vector{pending[1].program, pending[2].program,
+                         pending[3].program}));
+  // Every shader, linked or not, and none is left attached
+  std::vector<GLuint> shaders;
+  for (const auto& program : pending) {
+    shaders.insert(shaders.end(),
+                   {program.vertex_shader, program.fragment_shader});
+    EXPECT_TRUE(attached_shaders.at(program.program).empty());
+  }
+  std::ranges::sort(deleted_shaders);
+  EXPECT_EQ(deleted_shaders, shaders);
+}
+}  // namespace
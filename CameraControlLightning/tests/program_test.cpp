@@ -0,0 +1,355 @@
+#include <gtest/gtest.h>
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <string>
+#include <vector>
+
+#include "program.h"
+
+namespace {
+using camera_control::Program;
+using camera_control::ProgramFunctions;
+
+constexpr int num_point_lights = 4;
+constexpr int num_cubes = 10;
+
+using FakeUniform = struct FakeUniform {
+  std::string name;
+  // -1 outside of blocks
+  GLint block_index;
+  // Elements of arrays, listed as their first one
+  GLint array_size = 1;
+};
+
+using Calls = struct Calls {
+  size_t use_program;
+  size_t get_uniform_location;
+  // glProgramUniform* of any type
+  size_t program_uniform;
+  size_t uniform_block_binding;
+};
+
+// The program every fake reflects, shaped like the lighting shaders
+std::vector<FakeUniform> uniforms;
+std::vector<std::string> blocks;
+Calls calls{};
+// Location of the last uniform set
+GLint last_location = -1;
+
+auto lighting_uniforms() -> std::vector<FakeUniform> {
+  std::vector<FakeUniform> lighting = {
+      {"mModel", -1},           {"material.ambient", -1},
+      {"material.diffuse", -1}, {"material.specular", -1},
+      {"material.shininess", -1}};
+  for (const auto* member : {"ambient", "diffuse", "specular", "direction"}) {
+    lighting.push_back({std::format("dirLight.{}", member), -1});
+  }
+  for (int i = 0; i < num_point_lights; i++) {
+    for (const auto* member : {"position", "ambient", "diffuse", "specular",
+                               "constant", "linear", "quadratic"}) {
+      lighting.push_back({std::format("pointLights[{}].{}", i, member), -1});
+    }
+  }
+  for (const auto* member : {"cutOff", "outerCutOff", "constant", "linear",
+                             "quadratic", "ambient", "diffuse", "specular"}) {
+    lighting.push_back({std::format("spotLight.{}", member), -1});
+  }
+  for (const auto* member : {"projection", "view", "viewPosition",
+                             "viewFront"}) {
+    lighting.push_back({std::format("Camera.{}", member), 0});
+  }
+  return lighting;
+}
+
+void GLAPIENTRY get_program_interface_iv(GLuint, const GLenum interface,
+                                         const GLenum pname, GLint* params) {
+  const auto num_resources = interface == GL_UNIFORM ? uniforms.size()
+                                                     : blocks.size();
+  if (pname == GL_ACTIVE_RESOURCES) {
+    *params = static_cast<GLint>(num_resources);
+    return;
+  }
+  size_t max_name_length = 0;
+  for (const auto& uniform : uniforms) {
+    max_name_length = std::max(max_name_length, uniform.name.size() + 1);
+  }
+  *params = static_cast<GLint>(max_name_length);
+}
+
+// Uniforms outside of blocks take one location per element, in order
+auto fake_location(const size_t index) -> GLint {
+  if (uniforms[index].block_index != -1) {
+    return -1;
+  }
+  GLint location = 0;
+  for (size_t i = 0; i < index; i++) {
+    if (uniforms[i].block_index == -1) {
+      location += uniforms[i].array_size;
+    }
+  }
+  return location;
+}
+
+// Blocks take 64 bytes each
+void GLAPIENTRY get_program_resource_iv(GLuint, const GLenum interface,
+                                        const GLuint index, GLsizei,
+                                        const GLenum* properties, GLsizei,
+                                        GLsizei*, GLint* params) {
+  if (interface == GL_UNIFORM_BLOCK) {
+    params[0] = 64;
+    return;
+  }
+  params[0] = uniforms[index].block_index;
+  params[1] = fake_location(index);
+  params[2] = uniforms[index].array_size;
+  EXPECT_EQ(properties[0], GL_BLOCK_INDEX);
+  EXPECT_EQ(properties[1], GL_LOCATION);
+  EXPECT_EQ(properties[2], GL_ARRAY_SIZE);
+}
+
+void GLAPIENTRY get_program_resource_name(GLuint, const GLenum interface,
+                                          const GLuint index,
+                                          const GLsizei buf_size,
+                                          GLsizei* length, GLchar* name) {
+  const auto& resource =
+      interface == GL_UNIFORM ? uniforms[index].name : blocks[index];
+  ASSERT_LT(resource.size(), static_cast<size_t>(buf_size));
+  std::memcpy(name, resource.c_str(), resource.size() + 1);
+  *length = static_cast<GLsizei>(resource.size());
+}
+
+void GLAPIENTRY use_program(GLuint) { ++calls.use_program; }
+GLint GLAPIENTRY get_uniform_location(GLuint, const GLchar* name) {
+  ++calls.get_uniform_location;
+  const auto uniform = std::ranges::find(uniforms, name, &FakeUniform::name);
+  return uniform == uniforms.end() ? -1
+                                   : fake_location(uniform - uniforms.begin());
+}
+void GLAPIENTRY program_uniform_matrix_4fv(GLuint, const GLint location,
+                                           GLsizei, GLboolean,
+                                           const GLfloat*) {
+  ++calls.program_uniform;
+  last_location = location;
+}
+void GLAPIENTRY program_uniform_3f(GLuint, const GLint location, GLfloat,
+                                   GLfloat, GLfloat) {
+  ++calls.program_uniform;
+  last_location = location;
+}
+void GLAPIENTRY program_uniform_1f(GLuint, const GLint location, GLfloat) {
+  ++calls.program_uniform;
+  last_location = location;
+}
+void GLAPIENTRY program_uniform_1i(GLuint, const GLint location, GLint) {
+  ++calls.program_uniform;
+  last_location = location;
+}
+void GLAPIENTRY uniform_block_binding(GLuint, GLuint, GLuint) {
+  ++calls.uniform_block_binding;
+}
+void GLAPIENTRY delete_program(GLuint) {}
+
+auto fake_program_functions() -> ProgramFunctions {
+  return ProgramFunctions{
+      .get_program_interface_iv = get_program_interface_iv,
+      .get_program_resource_iv = get_program_resource_iv,
+      .get_program_resource_name = get_program_resource_name,
+      .use_program = use_program,
+      .program_uniform_matrix_4fv = program_uniform_matrix_4fv,
+      .program_uniform_3f = program_uniform_3f,
+      .program_uniform_1f = program_uniform_1f,
+      .program_uniform_1i = program_uniform_1i,
+      .uniform_block_binding = uniform_block_binding,
+      .delete_program = delete_program};
+}
+
+// How Program set uniforms before it reflected their locations: bind the
+// program, look the name up, set the value and unbind it again. Through the
+// fakes, glUniform* then counts like glProgramUniform*.
+class NameLookupProgram {
+public:
+  explicit NameLookupProgram(const GLuint program_id)
+      : program_id_(program_id) {}
+
+  [[nodiscard]] auto SetUniformMatrix(const std::string& uniform_name,
+                                      const glm::mat4& matrix) const -> bool {
+    return set(uniform_name, [&](const GLint location) {
+      gl_.program_uniform_matrix_4fv(program_id_, location, 1, GL_FALSE,
+                                     &matrix[0][0]);
+    });
+  }
+
+  [[nodiscard]] auto SetUniformV3(const std::string& uniform_name,
+                                  const glm::vec3& vec) const -> bool {
+    return set(uniform_name, [&](const GLint location) {
+      gl_.program_uniform_3f(program_id_, location, vec.x, vec.y, vec.z);
+    });
+  }
+
+  [[nodiscard]] auto SetUniform1F(const std::string& uniform_name,
+                                  const float f) const -> bool {
+    return set(uniform_name, [&](const GLint location) {
+      gl_.program_uniform_1f(program_id_, location, f);
+    });
+  }
+
+  [[nodiscard]] auto SetUniform1I(const std::string& uniform_name,
+                                  const int i) const -> bool {
+    return set(uniform_name, [&](const GLint location) {
+      gl_.program_uniform_1i(program_id_, location, i);
+    });
+  }
+
+private:
+  ProgramFunctions gl_ = fake_program_functions();
+  GLuint program_id_;
+
+  template <typename SetValue>
+  auto set(const std::string& uniform_name, const SetValue& set_value) const
+      -> bool {
+    glUseProgram(program_id_);
+    const auto location = glGetUniformLocation(program_id_,
+                                               uniform_name.c_str());
+    if (location != -1) {
+      set_value(location);
+    }
+    glUseProgram(0);
+    return location != -1;
+  }
+};
+
+auto total(const Calls& counted) -> size_t {
+  return counted.use_program + counted.get_uniform_location +
+         counted.program_uniform + counted.uniform_block_binding;
+}
+
+class ProgramTest : public testing::Test {
+protected:
+  auto SetUp() -> void override {
+    uniforms = lighting_uniforms();
+    blocks = {"Camera"};
+    // Calls bypassing the functions given to Program count too
+    glUseProgram = use_program;
+    glGetUniformLocation = get_uniform_location;
+  }
+
+  auto TearDown() -> void override {
+    glUseProgram = nullptr;
+    glGetUniformLocation = nullptr;
+  }
+};
+
+// The uniforms main sets when a program is built, then the model matrix of
+// every cube drawn
+template <typename Setters>
+auto set_frame_uniforms(const Setters& program) -> bool {
+  auto ok = program.SetUniformV3("material.ambient", glm::vec3(1.0F)) &&
+            program.SetUniform1I("material.diffuse", 0) &&
+            program.SetUniform1I("material.specular", 1) &&
+            program.SetUniform1F("material.shininess", 32.0F);
+  for (const auto* member : {"ambient", "diffuse", "specular", "direction"}) {
+    ok = ok && program.SetUniformV3(std::format("dirLight.{}", member),
+                                    glm::vec3(0.5F));
+  }
+  for (int i = 0; i < num_point_lights; i++) {
+    const auto point_light = std::format("pointLights[{}]", i);
+    for (const auto* member : {".position", ".ambient", ".diffuse",
+                               ".specular"}) {
+      ok = ok && program.SetUniformV3(point_light + member, glm::vec3(0.5F));
+    }
+    for (const auto* member : {".constant", ".linear", ".quadratic"}) {
+      ok = ok && program.SetUniform1F(point_light + member, 1.0F);
+    }
+  }
+  for (const auto* member : {"cutOff", "outerCutOff", "constant", "linear",
+                             "quadratic"}) {
+    ok = ok && program.SetUniform1F(std::format("spotLight.{}", member), 1.0F);
+  }
+  for (const auto* member : {"ambient", "diffuse", "specular"}) {
+    ok = ok && program.SetUniformV3(std::format("spotLight.{}", member),
+                                    glm::vec3(0.5F));
+  }
+  for (int i = 0; i < num_cubes; i++) {
+    ok = ok && program.SetUniformMatrix("mModel", glm::mat4(1.0F));
+  }
+  return ok;
+}
+
+TEST_F(ProgramTest, FrameOfUniformUpdatesNeitherBindsNorLooksUp) {
+  const size_t num_setters = 4 + 4 + num_point_lights * 7 + 8 + num_cubes;
+  calls = {};
+  ASSERT_TRUE(set_frame_uniforms(NameLookupProgram(1)));
+  const auto name_lookup_calls = calls;
+
+  const Program program(fake_program_functions(), 1);
+  calls = {};
+  ASSERT_TRUE(set_frame_uniforms(program));
+  const auto reflected_calls = calls;
+
+  // Three calls on top of the one setting the value, for every setter
+  EXPECT_EQ(name_lookup_calls.program_uniform, num_setters);
+  EXPECT_EQ(name_lookup_calls.use_program, 2 * num_setters);
+  EXPECT_EQ(name_lookup_calls.get_uniform_location, num_setters);
+  EXPECT_EQ(reflected_calls.program_uniform, num_setters);
+  EXPECT_EQ(reflected_calls.use_program, 0U);
+  EXPECT_EQ(reflected_calls.get_uniform_location, 0U);
+  EXPECT_EQ(total(name_lookup_calls), 4 * total(reflected_calls));
+}
+
+TEST_F(ProgramTest, SettersUseReflectedLocations) {
+  const Program program(fake_program_functions(), 1);
+
+  for (size_t index = 0; index < uniforms.size(); index++) {
+    const auto& uniform = uniforms[index];
+    const auto set_result = program.SetUniform1F(uniform.name, 1.0F);
+    // Members of the camera block have no location
+    EXPECT_EQ(set_result.has_value(), uniform.block_index == -1)
+        << uniform.name;
+    if (set_result) {
+      EXPECT_EQ(last_location, fake_location(index)) << uniform.name;
+    }
+  }
+  calls = {};
+  EXPECT_FALSE(program.SetUniformV3("material.emission", glm::vec3(1.0F)));
+  EXPECT_EQ(calls.program_uniform, 0U);
+}
+
+TEST_F(ProgramTest, ArraysAreFoundByTheirNameAndEveryElement) {
+  uniforms = {{"weights[0]", -1, 3}, {"bias", -1}};
+  const Program program(fake_program_functions(), 1);
+
+  ASSERT_TRUE(program.SetUniform1F("weights", 1.0F));
+  EXPECT_EQ(last_location, 0);
+  for (GLint element = 0; element < 3; element++) {
+    ASSERT_TRUE(
+        program.SetUniform1F(std::format("weights[{}]", element), 1.0F));
+    EXPECT_EQ(last_location, element);
+  }
+  ASSERT_TRUE(program.SetUniform1F("bias", 1.0F));
+  EXPECT_EQ(last_location, 3);
+  EXPECT_FALSE(program.SetUniform1F("weights[3]", 1.0F));
+}
+
+TEST_F(ProgramTest, UniformBlockMustFitTheGivenSize) {
+  const Program program(fake_program_functions(), 1);
+  calls = {};
+
+  EXPECT_FALSE(program.BindUniformBlock("Camera", 0, 32));
+  EXPECT_FALSE(program.BindUniformBlock("Lights", 0, 64));
+  EXPECT_EQ(calls.uniform_block_binding, 0U);
+  EXPECT_TRUE(program.BindUniformBlock("Camera", 0, 64));
+  EXPECT_EQ(calls.uniform_block_binding, 1U);
+}
+
+TEST_F(ProgramTest, UseBindsOnce) {
+  const Program program(fake_program_functions(), 1);
+  calls = {};
+
+  program.Use();
+  EXPECT_EQ(calls.use_program, 1U);
+}
+}  // namespace
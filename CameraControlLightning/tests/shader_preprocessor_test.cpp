@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "shader_preprocessor/shader_preprocessor.h"
+
+namespace {
+using shader_preprocessor::Define;
+
+class ShaderPreprocessorTest : public testing::Test {
+protected:
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "shader_preprocessor_test";
+
+  auto SetUp() -> void override {
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+  }
+
+  auto TearDown() -> void override { std::filesystem::remove_all(directory); }
+
+  // Path of the written file, as preprocess reports it
+  auto write_file(const std::string& name, const std::string& contents) const
+      -> std::string {
+    const auto path = (directory / name).lexically_normal();
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    return path.string();
+  }
+};
+
+TEST_F(ShaderPreprocessorTest, NestedIncludesResolveRelativeToTheirFile) {
+  const auto main = write_file("main.glsl",
+                               "#version 450 core\n"
+                               "#include \"lights/lighting.glsl\"\n"
+                               "void main() {}\n");
+  const auto lighting = write_file("lights/lighting.glsl",
+                                   "#include \"../common/light.glsl\"\n"
+                                   "vec3 shade();\n");
+  const auto light = write_file("common/light.glsl", "struct Light {};\n");
+
+  const auto preprocessed = shader_preprocessor::preprocess(main, {});
+
+  ASSERT_TRUE(preprocessed.has_value()) << preprocessed.error();
+  EXPECT_EQ(preprocessed->files, (std::vector{main, lighting, light}));
+  EXPECT_EQ(preprocessed->source,
+            "#version 450 core\n"
+            "#line 1 1\n"
+            "#line 1 2\n"
+            "struct Light {};\n"
+            "#line 2 1\n"
+            "vec3 shade();\n"
+            "#line 3 0\n"
+            "void main() {}\n");
+}
+
+TEST_F(ShaderPreprocessorTest, FilesAreIncludedOnceEvenInCycles) {
+  const auto main = write_file("main.glsl",
+                               "#include \"a.glsl\"\n"
+                               "#include \"b.glsl\"\n"
+                               "#include \"a.glsl\"\n"
+                               "void main() {}\n");
+  // a and b include each other
+  const auto a = write_file("a.glsl", "#include \"b.glsl\"\nint a;\n");
+  const auto b = write_file("b.glsl", "#include \"a.glsl\"\nint b;\n");
+
+  const auto preprocessed = shader_preprocessor::preprocess(main, {});
+
+  ASSERT_TRUE(preprocessed.has_value()) << preprocessed.error();
+  EXPECT_EQ(preprocessed->files, (std::vector{main, a, b}));
+  // Skipped includes leave an empty line, so no #line is needed after them
+  EXPECT_EQ(preprocessed->source,
+            "#line 1 1\n"
+            "#line 1 2\n"
+            "\n"
+            "int b;\n"
+            "#line 2 1\n"
+            "int a;\n"
+            "#line 2 0\n"
+            "\n"
+            "\n"
+            "void main() {}\n");
+}
+
+TEST_F(ShaderPreprocessorTest, LineNumbersContinueAfterAnInclude) {
+  const auto main = write_file("main.glsl",
+                               "#version 450 core\n"
+                               "\n"
+                               "#include \"common.glsl\"\n"
+                               "\n"
+                               "void main() { undefined(); }\n");
+  write_file("common.glsl", "int a;\nint b;\n");
+
+  const auto preprocessed = shader_preprocessor::preprocess(main, {});
+
+  ASSERT_TRUE(preprocessed.has_value()) << preprocessed.error();
+  const auto main_line = preprocessed->source.find("void main()");
+  const auto line_directive = preprocessed->source.rfind("#line", main_line);
+  // The line after the include is the 4th of main, the 0th source string
+  EXPECT_EQ(preprocessed->source.substr(line_directive,
+                                        main_line - line_directive),
+            "#line 4 0\n\n");
+}
+
+TEST_F(ShaderPreprocessorTest, DefinesGoRightAfterVersion) {
+  const auto main = write_file("main.glsl",
+                               "// Needs #version 450 for binding layouts\n"
+                               "  #  version 450 core\n"
+                               "void main() {}\n");
+  const std::vector<Define> defines = {{"NUM_POINT_LIGHTS", "4"},
+                                       {"TEXTURED", ""}};
+
+  const auto preprocessed = shader_preprocessor::preprocess(main, defines);
+
+  ASSERT_TRUE(preprocessed.has_value()) << preprocessed.error();
+  EXPECT_EQ(preprocessed->source,
+            "// Needs #version 450 for binding layouts\n"
+            "  #  version 450 core\n"
+            "#define NUM_POINT_LIGHTS 4\n"
+            "#define TEXTURED\n"
+            "#line 3 0\n"
+            "void main() {}\n");
+}
+
+TEST_F(ShaderPreprocessorTest, DefinesGoFirstWithoutVersion) {
+  // Mentions #version only in a comment
+  const auto main = write_file("main.glsl",
+                               "// No #version, the driver's default\n"
+                               "void main() {}\n");
+  const std::vector<Define> defines = {{"TEXTURED", ""}};
+
+  const auto preprocessed = shader_preprocessor::preprocess(main, defines);
+
+  ASSERT_TRUE(preprocessed.has_value()) << preprocessed.error();
+  EXPECT_EQ(preprocessed->source,
+            "#define TEXTURED\n"
+            "#line 1 0\n"
+            "// No #version, the driver's default\n"
+            "void main() {}\n");
+}
+
+TEST_F(ShaderPreprocessorTest, MissingIncludeReportsEveryIncludingFile) {
+  const auto main = write_file("main.glsl",
+                               "#version 450 core\n"
+                               "#include \"lighting.glsl\"\n");
+  const auto lighting = write_file("lighting.glsl",
+                                   "int a;\n"
+                                   "#include \"missing.glsl\"\n");
+  const auto missing = (directory / "missing.glsl").string();
+
+  const auto preprocessed = shader_preprocessor::preprocess(main, {});
+
+  ASSERT_FALSE(preprocessed.has_value());
+  EXPECT_EQ(preprocessed.error(),
+            std::format("Could not open file '{}', included from '{}':2, "
+                        "included from '{}':2",
+                        missing, lighting, main));
+}
+
+TEST_F(ShaderPreprocessorTest, MissingFileAndUnparsableIncludeFail) {
+  const auto missing = (directory / "missing.glsl").string();
+  const auto preprocessed = shader_preprocessor::preprocess(missing, {});
+  ASSERT_FALSE(preprocessed.has_value());
+  EXPECT_EQ(preprocessed.error(),
+            std::format("Could not open file '{}'", missing));
+
+  const auto main = write_file("main.glsl", "\n#include common.glsl\n");
+  const auto unparsable = shader_preprocessor::preprocess(main, {});
+  ASSERT_FALSE(unparsable.has_value());
+  EXPECT_EQ(unparsable.error(),
+            std::format("'{}':2: Could not parse #include", main));
+}
+
+TEST(PermutationKeyTest, OrderOfDefinesDoesNotMatter) {
+  const std::vector<Define> defines = {
+      {"NUM_POINT_LIGHTS", "4"}, {"TEXTURED", ""}, {"A", "1"}, {"A", "2"}};
+  const std::vector<Define> reordered = {
+      {"A", "2"}, {"TEXTURED", ""}, {"A", "1"}, {"NUM_POINT_LIGHTS", "4"}};
+
+  EXPECT_EQ(shader_preprocessor::permutation_key(defines),
+            shader_preprocessor::permutation_key(reordered));
+}
+
+TEST(PermutationKeyTest, NamesAndValuesTellPermutationsApart) {
+  const auto key = [](const std::vector<Define>& defines) {
+    return shader_preprocessor::permutation_key(defines);
+  };
+
+  EXPECT_NE(key({{"NUM_POINT_LIGHTS", "1"}}), key({{"NUM_POINT_LIGHTS", "4"}}));
+  EXPECT_NE(key({{"TEXTURED", ""}}), key({}));
+  EXPECT_NE(key({{"TEXTURED", ""}}), key({{"TEXTURED", "1"}}));
+  // Not just the concatenation of names and values
+  EXPECT_NE(key({{"AB", ""}}), key({{"A", "B"}}));
+  EXPECT_NE(key({{"A", ""}, {"B", ""}}), key({{"A", ""}}));
+}
+}  // namespace
@@ -0,0 +1,46 @@
+#ifndef BUFFER_ALLOCATOR_H
+#define BUFFER_ALLOCATOR_H
+
+#include <cstddef>
+
+// Free range, offset and size in elements of the buffer being sub-allocated
+using BufferBlock = struct BufferBlock {
+  size_t offset;
+  size_t size;
+};
+
+using BufferAllocation = struct BufferAllocation {
+  bool valid;
+  size_t offset;
+  size_t size;
+};
+
+// Sub-allocates ranges of a fixed size buffer. Free ranges are kept sorted by
+// offset and merged with their neighbours when released, allocation picks
+// the smallest free range that fits. Doesn't touch the GPU.
+using BufferAllocator = struct BufferAllocator {
+  bool valid;
+  size_t capacity;
+  size_t used;
+  int max_num_free_blocks;
+  int num_free_blocks;
+  BufferBlock *free_blocks;
+};
+
+auto buffer_allocator_create(size_t capacity, int max_num_free_blocks)
+    -> BufferAllocator;
+
+auto buffer_allocator_destroy(BufferAllocator *allocator) -> void;
+
+auto buffer_allocator_allocate(BufferAllocator *allocator, size_t size)
+    -> BufferAllocation;
+
+// Returns false if the range can't be tracked, because it overlaps a free
+// range or the free list is full
+auto buffer_allocator_free(BufferAllocator *allocator,
+                           const BufferAllocation &allocation) -> bool;
+
+auto buffer_allocator_largest_free_block(const BufferAllocator &allocator)
+    -> size_t;
+
+#endif  // BUFFER_ALLOCATOR_H
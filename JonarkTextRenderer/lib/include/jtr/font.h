@@ -5,27 +5,31 @@
 
 #include <cstdint>
 
-using FontHandle = int;
+#include "jtr/resource_pool.h"
+
+using FontHandle = ResourceHandle;
 
 struct FontData {
   const bool valid;
+  const uint8_t* const bitmap;
   const stbtt_packedchar* const packed_chars;
   const stbtt_aligned_quad* const aligned_quads;
   const int charcode_begin;
   const int charcode_count;
 };
 
-struct FontManager {
-  bool valid;
-  int fonts_count;
-  int max_num_fonts;
+// Frees the atlas bitmap and glyph tables of a font, called by the pool
+auto font_release(uint8_t*& bitmap, stbtt_packedchar*& packed_chars,
+                  stbtt_aligned_quad*& aligned_quads, int& charcode_begin,
+                  int& charcode_count) -> void;
 
-  uint8_t** bitmaps;
-  stbtt_packedchar** packed_chars_s;
-  stbtt_aligned_quad** aligned_quads_s;
-  int* charcode_begins;
-  int* charcode_counts;
-};
+using FontManager = ResourcePool<&font_release, uint8_t*, stbtt_packedchar*,
+                                 stbtt_aligned_quad*, int, int>;
+static constexpr size_t font_field_bitmap = 0;
+static constexpr size_t font_field_packed_chars = 1;
+static constexpr size_t font_field_aligned_quads = 2;
+static constexpr size_t font_field_charcode_begin = 3;
+static constexpr size_t font_field_charcode_count = 4;
 
 auto font_manager_create(int max_num_fonts) -> FontManager;
 
@@ -40,6 +44,6 @@ auto font_create(FontManager* manager, const unsigned char* font_binary_data,
                  int charcode_begin, int charcode_count, float font_size,
                  int font_atlas_width, int font_atlas_height) -> FontHandle;
 
-auto font_destroy(const FontManager* manager, FontHandle handle) -> void;
+auto font_destroy(FontManager* manager, FontHandle handle) -> void;
 
 #endif  // FONT_H
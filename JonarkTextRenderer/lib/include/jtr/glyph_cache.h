@@ -0,0 +1,131 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <stb_truetype.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "jtr/texture.h"
+
+using GlyphCacheFont = int;
+
+using GlyphInfo = struct GlyphInfo {
+  bool valid;
+  // -1 for glyphs without pixels, like space
+  TextureHandle atlas;
+  // In pixels from the pen position, y grows down as in stb_truetype
+  float x_offset;
+  float y_offset;
+  float width;
+  float height;
+  float x_advance;
+  float s0;
+  float t0;
+  float s1;
+  float t1;
+};
+
+using GlyphCacheStats = struct GlyphCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t uploads;
+  uint64_t uploaded_bytes;
+};
+
+using GlyphCacheRect = struct GlyphCacheRect {
+  int page;
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+using GlyphCacheShelf = struct GlyphCacheShelf {
+  int y;
+  int height;
+  int next_x;
+};
+
+// Half-open, empty when x0 == x1
+using GlyphCacheDirtyRect = struct GlyphCacheDirtyRect {
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+};
+
+// Glyphs keyed by (font, pixel height, codepoint), rasterized the first time
+// they are requested into shelf packed atlas pages. When every page is full
+// the least recently used glyphs are evicted, glyphs used in the current
+// frame are never evicted. Only the rectangles written since the last upload
+// are sent to the GPU.
+using GlyphCache = struct GlyphCache {
+  bool valid;
+  TextureManager *texture_manager;
+  uint64_t frame;
+
+  int max_num_fonts;
+  int num_fonts;
+  stbtt_fontinfo *fonts;
+
+  int page_width;
+  int page_height;
+  int max_num_pages;
+  int num_pages;
+  uint8_t **page_bitmaps;
+  TextureHandle *page_textures;
+  GlyphCacheDirtyRect *page_dirty_rects;
+  int *page_num_glyphs;
+
+  int max_num_shelves_per_page;
+  GlyphCacheShelf *shelves;
+  int *page_num_shelves;
+
+  // Holes left in shelves by evicted glyphs
+  int max_num_free_rects;
+  int num_free_rects;
+  GlyphCacheRect *free_rects;
+
+  int max_num_glyphs;
+  uint64_t *glyph_keys;
+  GlyphInfo *glyph_infos;
+  GlyphCacheRect *glyph_rects;
+  uint64_t *glyph_last_used_frames;
+  // LRU list, head is the most recently used glyph
+  int *lru_prevs;
+  int *lru_nexts;
+  int lru_head;
+  int lru_tail;
+  int *free_slots;
+  int num_free_slots;
+  std::unordered_map<uint64_t, int> *lookup;
+
+  GlyphCacheStats stats;
+};
+
+auto glyph_cache_create(TextureManager *texture_manager, int page_width,
+                        int page_height, int max_num_pages, int max_num_glyphs,
+                        int max_num_fonts) -> GlyphCache;
+
+auto glyph_cache_destroy(GlyphCache *cache) -> void;
+
+// font_binary_data must outlive the cache
+auto glyph_cache_add_font(GlyphCache *cache,
+                          const unsigned char *font_binary_data)
+    -> GlyphCacheFont;
+
+// Glyphs used after this call are protected from eviction until the next one
+auto glyph_cache_begin_frame(GlyphCache *cache) -> void;
+
+// Rasterizes the glyph on a miss
+auto glyph_cache_get(GlyphCache *cache, GlyphCacheFont font, int pixel_height,
+                     char32_t codepoint) -> GlyphInfo;
+
+// Uploads the dirty rectangle of every page
+auto glyph_cache_upload(GlyphCache *cache) -> void;
+
+auto glyph_cache_get_stats(const GlyphCache &cache) -> GlyphCacheStats;
+
+#endif  // GLYPH_CACHE_H
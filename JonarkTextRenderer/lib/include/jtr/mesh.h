@@ -4,6 +4,8 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include "jtr/resource_pool.h"
+
 using Vertex = struct Vertex {
   glm::vec3 position;
   glm::vec2 uv;
@@ -17,18 +19,18 @@ using MeshData = struct MeshData {
   size_t num_indices;
 };
 
-using MeshHandle = int;
+using MeshHandle = ResourceHandle;
 
-using MeshManager = struct MeshManager {
-  bool valid;
-  // Mesh *meshes;
-  int meshes_count;
-  int max_num_meshes;
+// Releases the GL buffers of a mesh, called by the pool
+auto mesh_release(unsigned int &vbo, unsigned int &ebo, size_t &num_indices)
+    -> void;
 
-  unsigned int *vbos;
-  unsigned int *ebos;
-  size_t *num_indices_s;
-};
+// Meshes are densely packed, see ResourcePool
+using MeshManager =
+    ResourcePool<&mesh_release, unsigned int, unsigned int, size_t>;
+static constexpr size_t mesh_field_vbo = 0;
+static constexpr size_t mesh_field_ebo = 1;
+static constexpr size_t mesh_field_num_indices = 2;
 
 auto mesh_manager_create(int max_num_meshes) -> MeshManager;
 
@@ -37,12 +39,14 @@ auto mesh_manager_destroy_all(MeshManager *manager) -> void;
 auto mesh_validate_handle(const MeshManager &manager, MeshHandle handle)
     -> bool;
 
-// Causes internal fragmentation
-auto mesh_destroy(const MeshManager *manager, MeshHandle handle) -> void;
+auto mesh_destroy(MeshManager *manager, MeshHandle handle) -> void;
 
 auto mesh_create(MeshManager &manager, const MeshData &mesh_data)
     -> MeshHandle;
 
 auto mesh_draw(const MeshManager &manager, MeshHandle handle) -> void;
 
+// Walks the packed meshes in order, expects the VAO and program to be bound
+auto mesh_draw_all(const MeshManager &manager) -> void;
+
 #endif  // MESH_H
@@ -0,0 +1,112 @@
+#ifndef MESH_ARENA_H
+#define MESH_ARENA_H
+
+#include <cstddef>
+
+#include "jtr/buffer_allocator.h"
+#include "jtr/mesh.h"
+#include "jtr/resource_pool.h"
+
+// Same layout as the commands read by glMultiDrawElementsIndirect
+using DrawElementsIndirectCommand = struct DrawElementsIndirectCommand {
+  unsigned int count;
+  unsigned int instance_count;
+  unsigned int first_index;
+  int base_vertex;
+  unsigned int base_instance;
+};
+
+// Ranges go back to the arena allocators in mesh_arena_destroy_mesh, the
+// pool has nothing left to release. Inline so the pool and the command
+// builder can be used without linking GL.
+inline auto mesh_arena_release(size_t & /*first_vertex*/,
+                               size_t & /*num_vertices*/,
+                               size_t & /*first_index*/,
+                               size_t & /*num_indices*/) -> void {}
+
+using MeshArenaMeshes =
+    ResourcePool<&mesh_arena_release, size_t, size_t, size_t, size_t>;
+static constexpr size_t mesh_arena_field_first_vertex = 0;
+static constexpr size_t mesh_arena_field_num_vertices = 1;
+static constexpr size_t mesh_arena_field_first_index = 2;
+static constexpr size_t mesh_arena_field_num_indices = 3;
+
+using MeshArenaStats = struct MeshArenaStats {
+  int draws;
+  int commands;
+};
+
+// Vertices and indices of every mesh live in one vertex buffer and one index
+// buffer, sub-allocated on the CPU. Indices stay relative to their mesh, the
+// base vertex of each draw command offsets them. A list of meshes is drawn
+// with a single glMultiDrawElementsIndirect.
+using MeshArena = struct MeshArena {
+  bool valid;
+  unsigned int vbo;
+  unsigned int ebo;
+  unsigned int indirect_buffer;
+
+  BufferAllocator vertex_allocator;
+  BufferAllocator index_allocator;
+  MeshArenaMeshes meshes;
+
+  int max_num_commands;
+  DrawElementsIndirectCommand *commands;
+
+  MeshArenaStats stats;
+};
+
+auto mesh_arena_create(size_t max_num_vertices, size_t max_num_indices,
+                       int max_num_meshes) -> MeshArena;
+
+auto mesh_arena_destroy(MeshArena *arena) -> void;
+
+auto mesh_arena_create_mesh(MeshArena *arena, const MeshData &mesh_data)
+    -> MeshHandle;
+
+auto mesh_arena_destroy_mesh(MeshArena *arena, MeshHandle handle) -> void;
+
+// Writes one command per valid handle into out_commands, which must have
+// room for max_num_commands commands, stopping once it is full. Stale handles
+// are skipped without taking a command. Returns the number of commands
+// written, out_num_handles_read is set to the number of handles read, stale
+// or not, so the next call can carry on from there.
+inline auto mesh_arena_build_commands(const MeshArenaMeshes &meshes,
+                                      const MeshHandle *handles,
+                                      const size_t num_handles,
+                                      const size_t max_num_commands,
+                                      DrawElementsIndirectCommand *out_commands,
+                                      size_t *out_num_handles_read) -> size_t {
+  const auto *first_vertices =
+      resource_pool_field<mesh_arena_field_first_vertex>(meshes);
+  const auto *first_indices =
+      resource_pool_field<mesh_arena_field_first_index>(meshes);
+  const auto *num_indices_s =
+      resource_pool_field<mesh_arena_field_num_indices>(meshes);
+  size_t num_commands = 0;
+  size_t i = 0;
+  for (; i < num_handles && num_commands < max_num_commands; ++i) {
+    const int index = resource_pool_index(meshes, handles[i]);
+    if (index == -1) {
+      continue;
+    }
+    out_commands[num_commands++] = DrawElementsIndirectCommand{
+        .count = static_cast<unsigned int>(num_indices_s[index]),
+        .instance_count = 1,
+        .first_index = static_cast<unsigned int>(first_indices[index]),
+        .base_vertex = static_cast<int>(first_vertices[index]),
+        .base_instance = 0,
+    };
+  }
+  *out_num_handles_read = i;
+  return num_commands;
+}
+
+// Expects the VAO and program to be bound. Meshes are drawn with one
+// glMultiDrawElementsIndirect per max_num_commands valid handles.
+auto mesh_arena_draw(MeshArena *arena, const MeshHandle *handles,
+                     size_t num_handles) -> void;
+
+auto mesh_arena_get_stats(const MeshArena &arena) -> MeshArenaStats;
+
+#endif  // MESH_ARENA_H
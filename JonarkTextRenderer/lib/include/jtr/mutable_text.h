@@ -0,0 +1,55 @@
+#ifndef MUTABLE_TEXT_H
+#define MUTABLE_TEXT_H
+
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <string>
+
+#include "jtr/font.h"
+#include "jtr/mesh.h"
+#include "jtr/text_layout.h"
+
+using MutableTextStats = struct MutableTextStats {
+  uint64_t updates;
+  // Of the last mutable_text_set call
+  size_t bytes_uploaded;
+  uint64_t total_bytes_uploaded;
+  int reallocations;
+};
+
+// Text that changes often, like HUD counters. Owns its buffers instead of
+// taking a MeshManager slot per string. A new string is diffed against the
+// glyph quads already on the GPU and only the changed quads are uploaded.
+// Capacity grows geometrically, reallocating the buffers when exceeded.
+using MutableText = struct MutableText {
+  bool valid;
+  size_t max_num_glyphs;
+  size_t num_glyphs;
+
+  unsigned int vbo;
+  unsigned int ebo;
+
+  TextLayout layout;
+  // Quads currently in vbo
+  Vertex *vertices;
+  // Quads of the string being set
+  Vertex *staging_vertices;
+
+  MutableTextStats stats;
+};
+
+auto mutable_text_create(size_t initial_max_num_glyphs) -> MutableText;
+
+auto mutable_text_destroy(MutableText *text) -> void;
+
+// text is UTF-8
+auto mutable_text_set(MutableText *mutable_text, const FontData &font_data,
+                      glm::vec2 position, const std::string &text, float size,
+                      float pixel_scale) -> bool;
+
+// Expects the VAO, program and font atlas to be bound
+auto mutable_text_draw(const MutableText &text) -> void;
+
+auto mutable_text_get_stats(const MutableText &text) -> MutableTextStats;
+
+#endif  // MUTABLE_TEXT_H
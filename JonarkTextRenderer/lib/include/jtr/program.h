@@ -1,14 +1,15 @@
 #ifndef PROGRAM_H
 #define PROGRAM_H
 
-using ProgramHandle = int;
+#include "jtr/resource_pool.h"
 
-using ProgramManager = struct ProgramManager {
-  bool valid;
-  int programs_count;
-  int max_num_programs;
-  unsigned int *program_ids;
-};
+using ProgramHandle = ResourceHandle;
+
+// Deletes the GL program, called by the pool
+auto program_release(unsigned int &program_id) -> void;
+
+using ProgramManager = ResourcePool<&program_release, unsigned int>;
+static constexpr size_t program_field_id = 0;
 
 auto program_manager_create(int max_num_programs) -> ProgramManager;
 
@@ -17,9 +18,7 @@ auto program_manager_destroy_all(ProgramManager *program_manager) -> void;
 auto program_validate_handle(const ProgramManager &program_manager, ProgramHandle handle)
     -> bool;
 
-// Causes internal fragmentation
-auto program_destroy(const ProgramManager &manager,
-                     ProgramHandle handle) -> void;
+auto program_destroy(ProgramManager &manager, ProgramHandle handle) -> void;
 
 auto program_create(ProgramManager &program_manager,
                     const char *vertex_shader_source,
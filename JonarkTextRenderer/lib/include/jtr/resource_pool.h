@@ -0,0 +1,254 @@
+#ifndef RESOURCE_POOL_H
+#define RESOURCE_POOL_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <print>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Slot index in the low 32 bits, slot generation in the 31 bits above. A
+// handle goes stale when its resource is destroyed, even if the slot is
+// reused afterwards. A slot whose generation would wrap is retired instead,
+// so a stale handle can never validate again. Handles stay positive so -1 is
+// free to signal errors.
+using ResourceHandle = int64_t;
+
+static constexpr int resource_handle_index_bits = 32;
+static constexpr int64_t resource_handle_index_mask =
+    (int64_t{1} << resource_handle_index_bits) - 1;
+static constexpr int resource_handle_max_generation = INT32_MAX;
+// Generation of retired slots, no handle has it
+static constexpr int resource_slot_retired = -1;
+static constexpr int resource_pool_max_capacity = 1 << 20;
+
+// Fixed capacity pool storing one array per field, all of them carved out of
+// a single allocation. Resources are densely packed in [0, count), removing
+// one moves the last resource into its place. Slots map handles to packed
+// resources and are reused through a free list, so insert and remove are
+// O(1). destroy_hook releases the resource and is called with a reference to
+// each of its fields.
+template <auto destroy_hook, typename... Fields>
+struct ResourcePool {
+  static_assert((std::is_trivially_copyable_v<Fields> && ...),
+                "Resource pool fields are moved around with plain copies");
+
+  static constexpr size_t num_fields = sizeof...(Fields);
+  static constexpr std::array<size_t, num_fields> field_sizes = {
+      sizeof(Fields)...};
+  static constexpr std::array<size_t, num_fields> field_alignments = {
+      alignof(Fields)...};
+  static constexpr size_t arena_alignment =
+      std::max({alignof(int), alignof(Fields)...});
+
+  bool valid;
+  int count;
+  int capacity;
+
+  void *arena;
+  std::tuple<Fields *...> fields;
+  int *dense_slots;
+
+  // Slots ever used, including retired ones
+  int num_slots;
+  // Packed resource index of live slots, next free slot of free ones
+  int *slot_dense_indices;
+  int *slot_generations;
+  int free_slots_head;
+};
+
+inline auto resource_handle_index(const ResourceHandle handle) -> int {
+  return static_cast<int>(handle & resource_handle_index_mask);
+}
+
+inline auto resource_handle_generation(const ResourceHandle handle) -> int {
+  return static_cast<int>(handle >> resource_handle_index_bits);
+}
+
+inline auto resource_pool_align(const size_t offset, const size_t alignment)
+    -> size_t {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Field arrays first, in declaration order, followed by the slot bookkeeping
+template <typename Pool>
+auto resource_pool_create(const int capacity) -> Pool {
+  if (capacity <= 0 || resource_pool_max_capacity < capacity) {
+    std::println(std::cerr, "Invalid resource pool capacity {}", capacity);
+    return Pool{.valid = false};
+  }
+  size_t size = 0;
+  std::array<size_t, Pool::num_fields> offsets;
+  for (size_t i = 0; i < Pool::num_fields; ++i) {
+    offsets[i] = resource_pool_align(size, Pool::field_alignments[i]);
+    size = offsets[i] + Pool::field_sizes[i] * capacity;
+  }
+  const size_t dense_slots_offset = resource_pool_align(size, alignof(int));
+  const size_t slot_dense_indices_offset =
+      dense_slots_offset + sizeof(int) * capacity;
+  const size_t slot_generations_offset =
+      slot_dense_indices_offset + sizeof(int) * capacity;
+  size = slot_generations_offset + sizeof(int) * capacity;
+
+  auto *arena = static_cast<std::byte *>(
+      ::operator new(size, std::align_val_t{Pool::arena_alignment}));
+  decltype(Pool::fields) fields;
+  std::apply(
+      [arena, &offsets](auto &...field) {
+        size_t i = 0;
+        ((field = reinterpret_cast<std::remove_reference_t<decltype(field)>>(
+              &arena[offsets[i++]])),
+         ...);
+      },
+      fields);
+
+  return Pool{
+      .valid = true,
+      .count = 0,
+      .capacity = capacity,
+      .arena = arena,
+      .fields = fields,
+      .dense_slots = reinterpret_cast<int *>(&arena[dense_slots_offset]),
+      .num_slots = 0,
+      .slot_dense_indices =
+          reinterpret_cast<int *>(&arena[slot_dense_indices_offset]),
+      .slot_generations =
+          reinterpret_cast<int *>(&arena[slot_generations_offset]),
+      .free_slots_head = -1,
+  };
+}
+
+template <auto destroy_hook, typename... Fields>
+auto resource_pool_destroy_all(ResourcePool<destroy_hook, Fields...> *pool)
+    -> void {
+  if (pool == nullptr || !pool->valid) {
+    std::println(std::cerr, "Resource pool not valid");
+    return;
+  }
+  for (int i = 0; i < pool->count; ++i) {
+    std::apply([i](auto... field) { destroy_hook(field[i]...); },
+               pool->fields);
+  }
+  ::operator delete(pool->arena,
+                    std::align_val_t{pool->arena_alignment});
+  *pool = ResourcePool<destroy_hook, Fields...>{.valid = false};
+}
+
+// Packed index of the resource, -1 if the handle is not valid
+template <auto destroy_hook, typename... Fields>
+auto resource_pool_index(const ResourcePool<destroy_hook, Fields...> &pool,
+                         const ResourceHandle handle) -> int {
+  if (!pool.valid) {
+    std::println(std::cerr, "Resource pool not valid");
+    return -1;
+  }
+  const int slot = resource_handle_index(handle);
+  if (handle < 0 || pool.num_slots <= slot) {
+    std::println(std::cerr, "Invalid handle");
+    return -1;
+  }
+  if (pool.slot_generations[slot] != resource_handle_generation(handle)) {
+    std::println(std::cerr, "Resource for handle was destroyed");
+    return -1;
+  }
+  return pool.slot_dense_indices[slot];
+}
+
+template <auto destroy_hook, typename... Fields>
+auto resource_pool_validate_handle(
+    const ResourcePool<destroy_hook, Fields...> &pool,
+    const ResourceHandle handle) -> bool {
+  return resource_pool_index(pool, handle) != -1;
+}
+
+// Array of the field_index-th field, indexed by packed index
+template <size_t field_index, auto destroy_hook, typename... Fields>
+auto resource_pool_field(const ResourcePool<destroy_hook, Fields...> &pool) {
+  return std::get<field_index>(pool.fields);
+}
+
+// nullptr if the handle is not valid
+template <size_t field_index, auto destroy_hook, typename... Fields>
+auto resource_pool_get(const ResourcePool<destroy_hook, Fields...> &pool,
+                       const ResourceHandle handle) {
+  const int index = resource_pool_index(pool, handle);
+  auto *field = std::get<field_index>(pool.fields);
+  return index == -1 ? nullptr : &field[index];
+}
+
+template <auto destroy_hook, typename... Fields>
+auto resource_pool_insert(ResourcePool<destroy_hook, Fields...> *pool,
+                          const Fields &...values) -> ResourceHandle {
+  if (!pool->valid) {
+    std::println(std::cerr, "Resource pool not valid");
+    return -1;
+  }
+  if (pool->capacity <= pool->count) {
+    std::println(std::cerr, "Maximum number of resources ({}) exceeded",
+                 pool->capacity);
+    return -1;
+  }
+
+  int slot;
+  if (pool->free_slots_head != -1) {
+    slot = pool->free_slots_head;
+    pool->free_slots_head = pool->slot_dense_indices[slot];
+  } else {
+    if (pool->capacity <= pool->num_slots) {
+      std::println(std::cerr, "No resource pool slots left, all were retired");
+      return -1;
+    }
+    slot = pool->num_slots++;
+    pool->slot_generations[slot] = 0;
+  }
+  const int index = pool->count++;
+  std::apply(
+      [index, &values...](auto... field) { ((field[index] = values), ...); },
+      pool->fields);
+  pool->dense_slots[index] = slot;
+  pool->slot_dense_indices[slot] = index;
+  return (static_cast<ResourceHandle>(pool->slot_generations[slot])
+          << resource_handle_index_bits) |
+         slot;
+}
+
+template <auto destroy_hook, typename... Fields>
+auto resource_pool_remove(ResourcePool<destroy_hook, Fields...> *pool,
+                          const ResourceHandle handle) -> bool {
+  const int index = resource_pool_index(*pool, handle);
+  if (index == -1) {
+    return false;
+  }
+  std::apply([index](auto... field) { destroy_hook(field[index]...); },
+             pool->fields);
+
+  // Move the last resource into the hole to keep resources packed
+  const int last_index = --pool->count;
+  if (index != last_index) {
+    std::apply(
+        [index, last_index](auto... field) {
+          ((field[index] = field[last_index]), ...);
+        },
+        pool->fields);
+    const int last_slot = pool->dense_slots[last_index];
+    pool->dense_slots[index] = last_slot;
+    pool->slot_dense_indices[last_slot] = index;
+  }
+
+  const int slot = resource_handle_index(handle);
+  if (pool->slot_generations[slot] == resource_handle_max_generation) {
+    pool->slot_generations[slot] = resource_slot_retired;
+    return true;
+  }
+  ++pool->slot_generations[slot];
+  pool->slot_dense_indices[slot] = pool->free_slots_head;
+  pool->free_slots_head = slot;
+  return true;
+}
+
+#endif  // RESOURCE_POOL_H
@@ -6,6 +6,7 @@
 #include <print>
 
 #include "jtr/font.h"
+#include "jtr/text_layout.h"
 
 inline auto text_create_mesh(const FontData& font_data, MeshManager* manager,
                              const glm::vec2 position, const std::string& text,
@@ -15,64 +16,30 @@ inline auto text_create_mesh(const FontData& font_data, MeshManager* manager,
     std::println(stderr, "Font data not valid");
     return -1;
   }
-  glm::vec2 cursor_position = position;
-  const unsigned int num_vertices = text.length() * 4;
+  if (text.empty()) {
+    std::println(stderr, "Text is empty");
+    return -1;
+  }
+  auto layout = text_layout_create(text.length());
+  if (!text_layout_build(&layout, font_data, position, text.data(),
+                         text.length(), size, pixel_scale)) {
+    text_layout_destroy(&layout);
+    return -1;
+  }
+  const size_t num_glyphs = layout.num_glyphs;
+  const auto num_vertices = static_cast<unsigned int>(num_glyphs * 4);
   auto* vertices = new Vertex[num_vertices];
-  size_t vertices_index = 0;
-  auto* indices = new unsigned int[text.length() * 6];
+  text_layout_write_vertices(layout, vertices);
+  text_layout_destroy(&layout);
+  auto* indices = new unsigned int[num_glyphs * 6];
   size_t indices_index = 0;
-  for (const auto character : text) {
-    const int index = character - font_data.charcode_begin;
-    if (index < 0 || font_data.charcode_count <= index) {
-      std::println(stderr, "Could not find character {}", character);
-      return -1;
-    }
-    const auto packed_char = font_data.packed_chars[index];
-    const auto aligned_quad = font_data.aligned_quads[index];
-
-    const auto glyph_size =
-        glm::vec2(static_cast<float>(packed_char.x1 - packed_char.x0) *
-                      pixel_scale * size,
-                  static_cast<float>(packed_char.y1 - packed_char.y0) *
-                      pixel_scale * size);
-
-    const auto bounding_box_top_left_position =
-        glm::vec2(cursor_position.x + (packed_char.xoff * pixel_scale * size),
-                  cursor_position.y +
-                      ((packed_char.yoff + packed_char.y1 - packed_char.y0) *
-                       pixel_scale * size));
-
-    // Top-right, top-left, bottom-left, bottom-right
-    const Vertex character_vertices[4] = {
-        {.position =
-             glm::vec3(bounding_box_top_left_position.x + glyph_size.x,
-                       bounding_box_top_left_position.y + glyph_size.y, 0.0F),
-         .uv = glm::vec2(aligned_quad.s1, aligned_quad.t0)},
-        {.position =
-             glm::vec3(bounding_box_top_left_position.x,
-                       bounding_box_top_left_position.y + glyph_size.y, 0.0F),
-         .uv = glm::vec2(aligned_quad.s0, aligned_quad.t0)},
-        {.position = glm::vec3(bounding_box_top_left_position.x,
-                               bounding_box_top_left_position.y, 0.0F),
-         .uv = glm::vec2(aligned_quad.s0, aligned_quad.t1)},
-        {.position = glm::vec3(bounding_box_top_left_position.x + glyph_size.x,
-                               bounding_box_top_left_position.y, 0.0F),
-         .uv = glm::vec2(aligned_quad.s1, aligned_quad.t1)},
-    };
-
-    vertices[vertices_index++] = character_vertices[0];
-    vertices[vertices_index++] = character_vertices[1];
-    vertices[vertices_index++] = character_vertices[2];
-    vertices[vertices_index++] = character_vertices[3];
-
-    unsigned int base = vertices_index - 4;  // We just added 4 vertices
+  for (unsigned int base = 0; base < num_vertices; base += 4) {
     indices[indices_index++] = base + 0;
     indices[indices_index++] = base + 1;
     indices[indices_index++] = base + 2;
     indices[indices_index++] = base + 0;
     indices[indices_index++] = base + 2;
     indices[indices_index++] = base + 3;
-    cursor_position.x += packed_char.xadvance * pixel_scale * size;
   }
 
   const auto mesh_data = MeshData{
@@ -80,11 +47,11 @@ inline auto text_create_mesh(const FontData& font_data, MeshManager* manager,
       .vertices = vertices,
       .num_vertices = num_vertices,
       .indices = indices,
-      .num_indices = 6 * text.length(),
+      .num_indices = 6 * num_glyphs,
   };
   const auto mesh_handle = mesh_create(*manager, mesh_data);
-  delete vertices;
-  delete indices;
+  delete[] vertices;
+  delete[] indices;
   if (mesh_handle < 0) {
     std::println("Could not create mesh for text");
     return -1;
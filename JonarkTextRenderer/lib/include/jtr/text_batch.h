@@ -0,0 +1,55 @@
+#ifndef TEXT_BATCH_H
+#define TEXT_BATCH_H
+
+#include <glm/vec2.hpp>
+#include <string>
+
+#include "jtr/font.h"
+#include "jtr/glyph_cache.h"
+#include "jtr/mesh.h"
+#include "jtr/text_batch_queue.h"
+#include "jtr/texture.h"
+
+// Collects the glyph quads of every string queued in a frame and draws them
+// with one glDrawElements per font atlas. The vertex and index buffers are
+// sized once at creation, the index buffer never changes. Queuing and
+// grouping by atlas is done by a TextBatchQueue, this uploads and draws what
+// it hands out.
+using TextBatch = struct TextBatch {
+  bool valid;
+  const TextureManager *texture_manager;
+  int texture_unit;
+
+  unsigned int vbo;
+  unsigned int ebo;
+
+  TextBatchQueue queue;
+};
+
+auto text_batch_create(const TextureManager &texture_manager, int texture_unit,
+                       size_t max_num_glyphs, int max_num_runs) -> TextBatch;
+
+auto text_batch_destroy(TextBatch *batch) -> void;
+
+// Resets queued glyphs and stats, call once per frame
+auto text_batch_begin(TextBatch *batch) -> void;
+
+// text is UTF-8. Flushes on its own when the batch is full.
+auto text_batch_push(TextBatch *batch, const FontData &font_data,
+                     TextureHandle atlas, glm::vec2 position,
+                     const std::string &text, float size, float pixel_scale)
+    -> bool;
+
+// Glyphs come from the cache, each one is queued with the atlas page it lives
+// in. Dirty glyph cache pages are uploaded before anything is drawn.
+auto text_batch_push_cached(TextBatch *batch, GlyphCache *cache,
+                            GlyphCacheFont font, int pixel_height,
+                            glm::vec2 position, const char32_t *codepoints,
+                            size_t num_codepoints, float pixel_scale) -> bool;
+
+// Expects the VAO and program to be bound
+auto text_batch_flush(TextBatch *batch) -> void;
+
+auto text_batch_get_stats(const TextBatch &batch) -> TextBatchStats;
+
+#endif  // TEXT_BATCH_H
@@ -0,0 +1,88 @@
+#ifndef TEXT_BATCH_QUEUE_H
+#define TEXT_BATCH_QUEUE_H
+
+#include <glm/vec2.hpp>
+#include <string>
+
+#include "jtr/font.h"
+#include "jtr/mesh.h"
+#include "jtr/resource_pool.h"
+#include "jtr/text_layout.h"
+
+// Glyphs queued with the same font atlas texture
+using TextBatchRun = struct TextBatchRun {
+  // TextureHandle of the atlas
+  ResourceHandle atlas;
+  size_t first_glyph;
+  size_t num_glyphs;
+};
+
+// Reset by text_batch_queue_begin
+using TextBatchStats = struct TextBatchStats {
+  int flushes;
+  int draws;
+  size_t num_glyphs;
+};
+
+// What a flush has to upload and draw, one draw per run. Valid until the
+// next glyphs are queued.
+using TextBatchDraws = struct TextBatchDraws {
+  const Vertex *vertices;
+  size_t num_glyphs;
+  const TextBatchRun *runs;
+  int num_runs;
+};
+
+// The CPU side of TextBatch: glyph quads of every string queued in a frame,
+// grouped by font atlas when taken for a flush. Doesn't touch GL, so the
+// number of flushes and draws a frame needs can be checked without a
+// context.
+using TextBatchQueue = struct TextBatchQueue {
+  bool valid;
+  size_t max_num_glyphs;
+  int max_num_runs;
+
+  // Scratch for text_batch_queue_layout
+  TextLayout layout;
+
+  Vertex *vertices;
+  // Staging used to make glyphs of the same atlas contiguous before upload
+  Vertex *sorted_vertices;
+  size_t num_glyphs;
+
+  TextBatchRun *runs;
+  TextBatchRun *sorted_runs;
+  int num_runs;
+
+  TextBatchStats stats;
+};
+
+auto text_batch_queue_create(size_t max_num_glyphs, int max_num_runs)
+    -> TextBatchQueue;
+
+auto text_batch_queue_destroy(TextBatchQueue *queue) -> void;
+
+// Resets queued glyphs and stats, call once per frame
+auto text_batch_queue_begin(TextBatchQueue *queue) -> void;
+
+// Lays out UTF-8 text into the queue's scratch layout, queued by
+// text_batch_queue_append_layout
+auto text_batch_queue_layout(TextBatchQueue *queue, const FontData &font_data,
+                             glm::vec2 position, const std::string &text,
+                             float size, float pixel_scale) -> bool;
+
+// Queues the glyphs of the last layout. Returns false without queuing them
+// when the queue has to be flushed first.
+auto text_batch_queue_append_layout(TextBatchQueue *queue,
+                                    ResourceHandle atlas) -> bool;
+
+// Queues one glyph quad, 4 vertices in text_layout_write_vertices order.
+// Returns false without queuing it when the queue has to be flushed first.
+auto text_batch_queue_append_quad(TextBatchQueue *queue, ResourceHandle atlas,
+                                  const Vertex *quad_vertices) -> bool;
+
+// Groups the queued glyphs by atlas, counts the flush and its draws and
+// empties the queue. Nothing to draw if no glyph was queued.
+auto text_batch_queue_take(TextBatchQueue *queue) -> TextBatchDraws;
+
+#endif  // TEXT_BATCH_QUEUE_H
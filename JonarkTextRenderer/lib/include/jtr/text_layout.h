@@ -0,0 +1,52 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <glm/vec2.hpp>
+
+#include "jtr/font.h"
+#include "jtr/mesh.h"
+
+// Glyph quads of a laid out string, one entry per glyph in each array so the
+// position math runs across glyphs with SIMD. Quad corners are
+// (x0, y0)-(x1, y1) with y1 at the top.
+using TextLayout = struct TextLayout {
+  bool valid;
+  size_t max_num_glyphs;
+  size_t num_glyphs;
+
+  // Decoded text
+  char32_t *codepoints;
+
+  // Gathered from the font in atlas pixels, pen positions are already scaled
+  float *pen_xs;
+  float *x_offsets;
+  float *y_offsets;
+  float *widths;
+  float *heights;
+
+  float *x0s;
+  float *y0s;
+  float *x1s;
+  float *y1s;
+  float *s0s;
+  float *t0s;
+  float *s1s;
+  float *t1s;
+};
+
+auto text_layout_create(size_t max_num_glyphs) -> TextLayout;
+
+auto text_layout_destroy(TextLayout *layout) -> void;
+
+// Decodes length bytes of UTF-8 text and lays it out from position. Returns
+// false if the text is not valid UTF-8, does not fit or uses a codepoint
+// that is not in the font.
+auto text_layout_build(TextLayout *layout, const FontData &font_data,
+                       glm::vec2 position, const char *text, size_t length,
+                       float size, float pixel_scale) -> bool;
+
+// Writes 4 vertices per glyph, top-right, top-left, bottom-left, bottom-right
+auto text_layout_write_vertices(const TextLayout &layout, Vertex *out_vertices)
+    -> void;
+
+#endif  // TEXT_LAYOUT_H
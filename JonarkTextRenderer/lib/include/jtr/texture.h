@@ -5,15 +5,15 @@
 #include <iostream>
 #include <print>
 
-using TextureHandle = int;
+#include "jtr/resource_pool.h"
 
-using TextureManager = struct TextureManager {
-  bool valid;
-  int num_textures;
-  int max_num_textures;
+using TextureHandle = ResourceHandle;
 
-  unsigned int* texture_ids;
-};
+// Deletes the GL texture, called by the pool
+auto texture_release(unsigned int& texture_id) -> void;
+
+using TextureManager = ResourcePool<&texture_release, unsigned int>;
+static constexpr size_t texture_field_id = 0;
 
 auto texture_manager_create(int max_num_textures) -> TextureManager;
 
@@ -25,8 +25,14 @@ auto texture_validate_handle(const TextureManager& manager,
 auto texture_create(TextureManager& texture_manager, const uint8_t* image_data,
                     int width, int height) -> TextureHandle;
 
-auto texture_destroy(const TextureManager& texture_manager,
-                     TextureHandle handle) -> void;
+// Uploads the width x height rectangle at (x, y) of an R8 image whose rows
+// are row_length pixels long
+auto texture_update(const TextureManager& manager, TextureHandle handle, int x,
+                    int y, int width, int height, int row_length,
+                    const uint8_t* image_data) -> void;
+
+auto texture_destroy(TextureManager& texture_manager, TextureHandle handle)
+    -> void;
 
 auto texture_bind(const TextureManager& manager, TextureHandle handle,
                   int texture_unit) -> void;
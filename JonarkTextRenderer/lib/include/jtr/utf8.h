@@ -0,0 +1,13 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+
+// Decodes length bytes of UTF-8 into out_codepoints, which must have room for
+// length codepoints. Overlong encodings, surrogates, codepoints above U+10FFFF
+// and truncated sequences are rejected. Returns the number of codepoints
+// written or -1 if text is not valid UTF-8.
+auto utf8_decode(const char *text, size_t length, char32_t *out_codepoints)
+    -> ptrdiff_t;
+
+#endif  // UTF8_H
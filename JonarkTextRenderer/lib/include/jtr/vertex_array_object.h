@@ -2,15 +2,16 @@
 #define VERTEX_ARRAY_OBJECT_H
 #include <GL/glew.h>
 
-using VertexArrayObjectHandle = int;
+#include "jtr/resource_pool.h"
 
-using VertexArrayObjectManager = struct VertexArrayObjectManager {
-  bool valid;
-  int vao_count;
-  int max_num_vaos;
+using VertexArrayObjectHandle = ResourceHandle;
 
-  unsigned int *vao_ids;
-};
+// Deletes the GL vertex array, called by the pool
+auto vertex_array_object_release(unsigned int &vao_id) -> void;
+
+using VertexArrayObjectManager =
+    ResourcePool<&vertex_array_object_release, unsigned int>;
+static constexpr size_t vertex_array_object_field_id = 0;
 
 using VertexArrayAttributeEntry = struct {
   int index;
@@ -31,7 +32,7 @@ auto vertex_array_object_validate_handle(const VertexArrayObjectManager &manager
                              VertexArrayObjectHandle handle)
     -> bool;
 
-auto vertex_array_object_destroy(const VertexArrayObjectManager &manager,
+auto vertex_array_object_destroy(VertexArrayObjectManager &manager,
                                  VertexArrayObjectHandle handle) -> void;
 
 auto vertex_array_object_create(VertexArrayObjectManager *manager,
@@ -0,0 +1,153 @@
+#include "jtr/buffer_allocator.h"
+
+#include <algorithm>
+#include <iostream>
+#include <print>
+
+auto buffer_allocator_create(const size_t capacity,
+                             const int max_num_free_blocks)
+    -> BufferAllocator {
+  if (capacity == 0 || max_num_free_blocks <= 0) {
+    std::println(std::cerr, "Invalid buffer allocator capacity");
+    return BufferAllocator{.valid = false};
+  }
+  auto *free_blocks = new BufferBlock[max_num_free_blocks];
+  free_blocks[0] = BufferBlock{.offset = 0, .size = capacity};
+  return BufferAllocator{
+      .valid = true,
+      .capacity = capacity,
+      .used = 0,
+      .max_num_free_blocks = max_num_free_blocks,
+      .num_free_blocks = 1,
+      .free_blocks = free_blocks,
+  };
+}
+
+auto buffer_allocator_destroy(BufferAllocator *allocator) -> void {
+  if (allocator == nullptr || !allocator->valid) {
+    std::println(std::cerr, "Buffer allocator not valid");
+    return;
+  }
+  delete[] allocator->free_blocks;
+  *allocator = BufferAllocator{.valid = false};
+}
+
+auto buffer_allocator_allocate(BufferAllocator *allocator, const size_t size)
+    -> BufferAllocation {
+  if (!allocator->valid) {
+    std::println(std::cerr, "Buffer allocator not valid");
+    return BufferAllocation{.valid = false};
+  }
+  if (size == 0) {
+    std::println(std::cerr, "Can't allocate an empty range");
+    return BufferAllocation{.valid = false};
+  }
+
+  int best = -1;
+  for (int i = 0; i < allocator->num_free_blocks; ++i) {
+    const auto &block = allocator->free_blocks[i];
+    if (size <= block.size &&
+        (best == -1 || block.size < allocator->free_blocks[best].size)) {
+      best = i;
+    }
+  }
+  if (best == -1) {
+    std::println(std::cerr,
+                 "No free range of size {} in buffer ({} of {} used)", size,
+                 allocator->used, allocator->capacity);
+    return BufferAllocation{.valid = false};
+  }
+
+  auto &block = allocator->free_blocks[best];
+  const auto allocation =
+      BufferAllocation{.valid = true, .offset = block.offset, .size = size};
+  block.offset += size;
+  block.size -= size;
+  if (block.size == 0) {
+    std::copy(&allocator->free_blocks[best + 1],
+              &allocator->free_blocks[allocator->num_free_blocks],
+              &allocator->free_blocks[best]);
+    --allocator->num_free_blocks;
+  }
+  allocator->used += size;
+  return allocation;
+}
+
+auto buffer_allocator_free(BufferAllocator *allocator,
+                           const BufferAllocation &allocation) -> bool {
+  if (!allocator->valid) {
+    std::println(std::cerr, "Buffer allocator not valid");
+    return false;
+  }
+  if (!allocation.valid || allocator->capacity < allocation.offset ||
+      allocator->capacity - allocation.offset < allocation.size) {
+    std::println(std::cerr, "Invalid buffer allocation");
+    return false;
+  }
+
+  // First free block after the allocation
+  const auto *next_block = std::lower_bound(
+      allocator->free_blocks,
+      allocator->free_blocks + allocator->num_free_blocks, allocation.offset,
+      [](const BufferBlock &block, const size_t offset) {
+        return block.offset < offset;
+      });
+  const int next = static_cast<int>(next_block - allocator->free_blocks);
+  const int previous = next - 1;
+  const size_t end = allocation.offset + allocation.size;
+
+  const bool overlaps_previous =
+      0 <= previous &&
+      allocation.offset < allocator->free_blocks[previous].offset +
+                              allocator->free_blocks[previous].size;
+  const bool overlaps_next = next < allocator->num_free_blocks &&
+                             allocator->free_blocks[next].offset < end;
+  if (overlaps_previous || overlaps_next) {
+    std::println(std::cerr, "Buffer allocation at {} already freed",
+                 allocation.offset);
+    return false;
+  }
+
+  const bool merges_previous =
+      0 <= previous && allocator->free_blocks[previous].offset +
+                               allocator->free_blocks[previous].size ==
+                           allocation.offset;
+  const bool merges_next = next < allocator->num_free_blocks &&
+                           allocator->free_blocks[next].offset == end;
+  if (merges_previous && merges_next) {
+    allocator->free_blocks[previous].size +=
+        allocation.size + allocator->free_blocks[next].size;
+    std::copy(&allocator->free_blocks[next + 1],
+              &allocator->free_blocks[allocator->num_free_blocks],
+              &allocator->free_blocks[next]);
+    --allocator->num_free_blocks;
+  } else if (merges_previous) {
+    allocator->free_blocks[previous].size += allocation.size;
+  } else if (merges_next) {
+    allocator->free_blocks[next].offset = allocation.offset;
+    allocator->free_blocks[next].size += allocation.size;
+  } else {
+    if (allocator->max_num_free_blocks <= allocator->num_free_blocks) {
+      std::println(std::cerr, "Maximum number of free blocks ({}) exceeded",
+                   allocator->max_num_free_blocks);
+      return false;
+    }
+    std::copy_backward(&allocator->free_blocks[next],
+                       &allocator->free_blocks[allocator->num_free_blocks],
+                       &allocator->free_blocks[allocator->num_free_blocks + 1]);
+    allocator->free_blocks[next] =
+        BufferBlock{.offset = allocation.offset, .size = allocation.size};
+    ++allocator->num_free_blocks;
+  }
+  allocator->used -= allocation.size;
+  return true;
+}
+
+auto buffer_allocator_largest_free_block(const BufferAllocator &allocator)
+    -> size_t {
+  size_t largest = 0;
+  for (int i = 0; i < allocator.num_free_blocks; ++i) {
+    largest = std::max(largest, allocator.free_blocks[i].size);
+  }
+  return largest;
+}
@@ -3,21 +3,23 @@
 #include <iostream>
 #include <print>
 
+auto font_release(uint8_t*& bitmap, stbtt_packedchar*& packed_chars,
+                  stbtt_aligned_quad*& aligned_quads, int& /*charcode_begin*/,
+                  int& /*charcode_count*/) -> void {
+  delete[] bitmap;
+  delete[] packed_chars;
+  delete[] aligned_quads;
+  bitmap = nullptr;
+  packed_chars = nullptr;
+  aligned_quads = nullptr;
+}
+
 auto font_manager_create(const int max_num_fonts) -> FontManager {
   if (max_num_fonts <= 0) {
     std::println(std::cerr, "Invalid max number of fonts");
     return FontManager{.valid = false};
   }
-  return FontManager{
-      .valid = true,
-      .fonts_count = 0,
-      .max_num_fonts = max_num_fonts,
-      .bitmaps = new uint8_t*[max_num_fonts],
-      .packed_chars_s = new stbtt_packedchar*[max_num_fonts],
-      .aligned_quads_s = new stbtt_aligned_quad*[max_num_fonts],
-      .charcode_begins = new int[max_num_fonts],
-      .charcode_counts = new int[max_num_fonts],
-  };
+  return resource_pool_create<FontManager>(max_num_fonts);
 }
 
 auto font_manager_destroy_all(FontManager* const manager) -> void {
@@ -25,19 +27,7 @@ auto font_manager_destroy_all(FontManager* const manager) -> void {
     std::println(std::cerr, "Invalid font manager");
     return;
   }
-
-  for (FontHandle handle = 0; handle < manager->fonts_count; ++handle) {
-    font_destroy(manager, handle);
-  }
-
-  manager->valid = false;
-  manager->fonts_count = 0;
-  manager->max_num_fonts = 0;
-  delete manager->bitmaps;
-  delete manager->packed_chars_s;
-  delete manager->aligned_quads_s;
-  delete manager->charcode_begins;
-  delete manager->charcode_counts;
+  resource_pool_destroy_all(manager);
 }
 
 auto font_validate_handle(const FontManager& manager, const FontHandle handle)
@@ -46,28 +36,31 @@ auto font_validate_handle(const FontManager& manager, const FontHandle handle)
     std::println(std::cerr, "Invalid font manager");
     return false;
   }
-  if (handle < 0 || manager.fonts_count <= handle) {
+  if (!resource_pool_validate_handle(manager, handle)) {
     std::println(std::cerr, "Invalid font handle");
     return false;
   }
-  if (manager.bitmaps[handle] == nullptr) {
-    std::println(std::cerr, "Font for handle not valid");
-    return false;
-  }
   return true;
 }
 
 auto font_get_data(const FontManager& manager, const FontHandle handle)
     -> FontData {
-  if (!font_validate_handle(manager, handle)) {
+  const int index = resource_pool_index(manager, handle);
+  if (index == -1) {
     std::println(stderr, "Invalid font handle");
     return FontData{.valid = false};
   }
-  return FontData{.valid = true,
-                  .packed_chars = manager.packed_chars_s[handle],
-                  .aligned_quads = manager.aligned_quads_s[handle],
-                  .charcode_begin = manager.charcode_begins[handle],
-                  .charcode_count = manager.charcode_counts[handle]};
+  return FontData{
+      .valid = true,
+      .bitmap = resource_pool_field<font_field_bitmap>(manager)[index],
+      .packed_chars =
+          resource_pool_field<font_field_packed_chars>(manager)[index],
+      .aligned_quads =
+          resource_pool_field<font_field_aligned_quads>(manager)[index],
+      .charcode_begin =
+          resource_pool_field<font_field_charcode_begin>(manager)[index],
+      .charcode_count =
+          resource_pool_field<font_field_charcode_count>(manager)[index]};
 }
 
 auto font_create(FontManager* const manager,
@@ -81,6 +74,11 @@ auto font_create(FontManager* const manager,
     std::println(stderr, "File doesn't have 1 font.");
     return -1;
   }
+  if (manager->capacity <= manager->count) {
+    std::println(stderr, "Maximum number of fonts ({}) exceeded",
+                 manager->capacity);
+    return -1;
+  }
 
   stbtt_pack_context pack_context;
   auto* bitmap =
@@ -106,27 +104,12 @@ auto font_create(FontManager* const manager,
 
   stbtt_PackEnd(&pack_context);
 
-  const FontHandle handle = manager->fonts_count++;
-  manager->bitmaps[handle] = bitmap;
-  manager->packed_chars_s[handle] = packed_chars;
-  manager->aligned_quads_s[handle] = aligned_quads;
-  manager->charcode_begins[handle] = charcode_begin;
-  manager->charcode_counts[handle] = charcode_count;
-  return handle;
+  return resource_pool_insert(manager, bitmap, packed_chars, aligned_quads,
+                              charcode_begin, charcode_count);
 }
 
-auto font_destroy(const FontManager* manager, const FontHandle handle) -> void {
-  if (!font_validate_handle(*manager, handle)) {
+auto font_destroy(FontManager* manager, const FontHandle handle) -> void {
+  if (!resource_pool_remove(manager, handle)) {
     std::println(std::cerr, "Invalid font handle");
-    return;
   }
-
-  delete manager->bitmaps[handle];
-  manager->bitmaps[handle] = nullptr;
-  delete manager->packed_chars_s[handle];
-  manager->packed_chars_s[handle] = nullptr;
-  delete manager->aligned_quads_s[handle];
-  manager->aligned_quads_s[handle] = nullptr;
-  manager->charcode_begins[handle] = 0;
-  manager->charcode_counts[handle] = 0;
 }
@@ -0,0 +1,477 @@
+#include "jtr/glyph_cache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <print>
+
+// Empty pixels around every glyph so linear filtering doesn't bleed
+static constexpr int glyph_padding = 1;
+// Shelf heights are rounded up so glyphs of similar height share shelves
+static constexpr int shelf_height_granularity = 4;
+
+static auto glyph_cache_key(const GlyphCacheFont font, const int pixel_height,
+                            const char32_t codepoint) -> uint64_t {
+  return (static_cast<uint64_t>(font) << 48) |
+         (static_cast<uint64_t>(pixel_height & 0xFFFF) << 32) |
+         static_cast<uint64_t>(codepoint);
+}
+
+auto glyph_cache_create(TextureManager *texture_manager, const int page_width,
+                        const int page_height, const int max_num_pages,
+                        const int max_num_glyphs, const int max_num_fonts)
+    -> GlyphCache {
+  if (texture_manager == nullptr || !texture_manager->valid) {
+    std::println(std::cerr, "Texture Manager not valid");
+    return GlyphCache{.valid = false};
+  }
+  if (page_width <= 0 || page_height <= 0 || max_num_pages <= 0 ||
+      max_num_glyphs <= 0 || max_num_fonts <= 0) {
+    std::println(std::cerr, "Invalid glyph cache capacity");
+    return GlyphCache{.valid = false};
+  }
+
+  const int max_num_shelves_per_page = page_height / shelf_height_granularity;
+  auto cache = GlyphCache{
+      .valid = true,
+      .texture_manager = texture_manager,
+      .frame = 0,
+      .max_num_fonts = max_num_fonts,
+      .num_fonts = 0,
+      .fonts = new stbtt_fontinfo[max_num_fonts],
+      .page_width = page_width,
+      .page_height = page_height,
+      .max_num_pages = max_num_pages,
+      .num_pages = 0,
+      .page_bitmaps = new uint8_t *[max_num_pages],
+      .page_textures = new TextureHandle[max_num_pages],
+      .page_dirty_rects = new GlyphCacheDirtyRect[max_num_pages],
+      .page_num_glyphs = new int[max_num_pages],
+      .max_num_shelves_per_page = max_num_shelves_per_page,
+      .shelves = new GlyphCacheShelf[max_num_pages * max_num_shelves_per_page],
+      .page_num_shelves = new int[max_num_pages],
+      .max_num_free_rects = max_num_glyphs,
+      .num_free_rects = 0,
+      .free_rects = new GlyphCacheRect[max_num_glyphs],
+      .max_num_glyphs = max_num_glyphs,
+      .glyph_keys = new uint64_t[max_num_glyphs],
+      .glyph_infos = new GlyphInfo[max_num_glyphs],
+      .glyph_rects = new GlyphCacheRect[max_num_glyphs],
+      .glyph_last_used_frames = new uint64_t[max_num_glyphs],
+      .lru_prevs = new int[max_num_glyphs],
+      .lru_nexts = new int[max_num_glyphs],
+      .lru_head = -1,
+      .lru_tail = -1,
+      .free_slots = new int[max_num_glyphs],
+      .num_free_slots = max_num_glyphs,
+      .lookup = new std::unordered_map<uint64_t, int>(),
+      .stats = GlyphCacheStats{},
+  };
+  // Slot 0 is handed out first
+  for (int i = 0; i < max_num_glyphs; ++i) {
+    cache.free_slots[i] = max_num_glyphs - 1 - i;
+  }
+  cache.lookup->reserve(max_num_glyphs);
+  return cache;
+}
+
+auto glyph_cache_destroy(GlyphCache *cache) -> void {
+  if (cache == nullptr || !cache->valid) {
+    std::println(std::cerr, "Glyph cache not valid");
+    return;
+  }
+  for (int page = 0; page < cache->num_pages; ++page) {
+    texture_destroy(*cache->texture_manager, cache->page_textures[page]);
+    delete[] cache->page_bitmaps[page];
+  }
+  delete[] cache->fonts;
+  delete[] cache->page_bitmaps;
+  delete[] cache->page_textures;
+  delete[] cache->page_dirty_rects;
+  delete[] cache->page_num_glyphs;
+  delete[] cache->shelves;
+  delete[] cache->page_num_shelves;
+  delete[] cache->free_rects;
+  delete[] cache->glyph_keys;
+  delete[] cache->glyph_infos;
+  delete[] cache->glyph_rects;
+  delete[] cache->glyph_last_used_frames;
+  delete[] cache->lru_prevs;
+  delete[] cache->lru_nexts;
+  delete[] cache->free_slots;
+  delete cache->lookup;
+  cache->lookup = nullptr;
+  cache->num_fonts = 0;
+  cache->num_pages = 0;
+  cache->valid = false;
+}
+
+auto glyph_cache_add_font(GlyphCache *cache,
+                          const unsigned char *font_binary_data)
+    -> GlyphCacheFont {
+  if (!cache->valid) {
+    std::println(std::cerr, "Glyph cache not valid");
+    return -1;
+  }
+  if (cache->max_num_fonts <= cache->num_fonts) {
+    std::println(std::cerr, "Maximum number of glyph cache fonts ({}) exceeded",
+                 cache->max_num_fonts);
+    return -1;
+  }
+  const GlyphCacheFont font = cache->num_fonts;
+  if (stbtt_InitFont(&cache->fonts[font], font_binary_data,
+                     stbtt_GetFontOffsetForIndex(font_binary_data, 0)) == 0) {
+    std::println(std::cerr, "Could not initialize font");
+    return -1;
+  }
+  ++cache->num_fonts;
+  return font;
+}
+
+auto glyph_cache_begin_frame(GlyphCache *cache) -> void { ++cache->frame; }
+
+static auto lru_unlink(GlyphCache *cache, const int slot) -> void {
+  const int prev = cache->lru_prevs[slot];
+  const int next = cache->lru_nexts[slot];
+  if (prev != -1) {
+    cache->lru_nexts[prev] = next;
+  } else {
+    cache->lru_head = next;
+  }
+  if (next != -1) {
+    cache->lru_prevs[next] = prev;
+  } else {
+    cache->lru_tail = prev;
+  }
+}
+
+static auto lru_push_front(GlyphCache *cache, const int slot) -> void {
+  cache->lru_prevs[slot] = -1;
+  cache->lru_nexts[slot] = cache->lru_head;
+  if (cache->lru_head != -1) {
+    cache->lru_prevs[cache->lru_head] = slot;
+  }
+  cache->lru_head = slot;
+  if (cache->lru_tail == -1) {
+    cache->lru_tail = slot;
+  }
+}
+
+static auto mark_dirty(GlyphCache *cache, const GlyphCacheRect &rect) -> void {
+  auto &dirty = cache->page_dirty_rects[rect.page];
+  if (dirty.x0 == dirty.x1) {
+    dirty = GlyphCacheDirtyRect{.x0 = rect.x,
+                                .y0 = rect.y,
+                                .x1 = rect.x + rect.width,
+                                .y1 = rect.y + rect.height};
+    return;
+  }
+  dirty.x0 = std::min(dirty.x0, rect.x);
+  dirty.y0 = std::min(dirty.y0, rect.y);
+  dirty.x1 = std::max(dirty.x1, rect.x + rect.width);
+  dirty.y1 = std::max(dirty.y1, rect.y + rect.height);
+}
+
+static auto release_rect(GlyphCache *cache, const GlyphCacheRect &rect)
+    -> void {
+  if (--cache->page_num_glyphs[rect.page] == 0) {
+    // Empty pages are packed again from scratch
+    cache->page_num_shelves[rect.page] = 0;
+    for (int i = 0; i < cache->num_free_rects;) {
+      if (cache->free_rects[i].page == rect.page) {
+        cache->free_rects[i] = cache->free_rects[--cache->num_free_rects];
+      } else {
+        ++i;
+      }
+    }
+    return;
+  }
+  // Without room the hole stays unused until its page empties
+  if (cache->num_free_rects < cache->max_num_free_rects) {
+    cache->free_rects[cache->num_free_rects++] = rect;
+  }
+}
+
+// Evicts the least recently used glyph unless it was used this frame
+static auto evict_one(GlyphCache *cache) -> bool {
+  const int slot = cache->lru_tail;
+  if (slot == -1 || cache->glyph_last_used_frames[slot] == cache->frame) {
+    return false;
+  }
+  lru_unlink(cache, slot);
+  cache->lookup->erase(cache->glyph_keys[slot]);
+  if (cache->glyph_rects[slot].page != -1) {
+    release_rect(cache, cache->glyph_rects[slot]);
+  }
+  cache->free_slots[cache->num_free_slots++] = slot;
+  ++cache->stats.evictions;
+  return true;
+}
+
+static auto acquire_slot(GlyphCache *cache) -> int {
+  while (cache->num_free_slots == 0) {
+    if (!evict_one(cache)) {
+      return -1;
+    }
+  }
+  return cache->free_slots[--cache->num_free_slots];
+}
+
+static auto add_page(GlyphCache *cache) -> bool {
+  const auto page_size =
+      static_cast<size_t>(cache->page_width) * cache->page_height;
+  auto *bitmap = new uint8_t[page_size]();
+  const auto texture = texture_create(*cache->texture_manager, bitmap,
+                                      cache->page_width, cache->page_height);
+  if (texture < 0) {
+    std::println(std::cerr, "Could not create glyph cache page texture");
+    delete[] bitmap;
+    return false;
+  }
+  const int page = cache->num_pages++;
+  cache->page_bitmaps[page] = bitmap;
+  cache->page_textures[page] = texture;
+  cache->page_dirty_rects[page] = GlyphCacheDirtyRect{};
+  cache->page_num_glyphs[page] = 0;
+  cache->page_num_shelves[page] = 0;
+  return true;
+}
+
+static auto try_allocate_free_rect(GlyphCache *cache, const int width,
+                                   const int height) -> GlyphCacheRect {
+  int best = -1;
+  for (int i = 0; i < cache->num_free_rects; ++i) {
+    const auto &free_rect = cache->free_rects[i];
+    if (free_rect.width < width || free_rect.height < height) {
+      continue;
+    }
+    if (best == -1 || free_rect.height < cache->free_rects[best].height ||
+        (free_rect.height == cache->free_rects[best].height &&
+         free_rect.width < cache->free_rects[best].width)) {
+      best = i;
+    }
+  }
+  if (best == -1) {
+    return GlyphCacheRect{.page = -1};
+  }
+  auto &free_rect = cache->free_rects[best];
+  const auto rect = GlyphCacheRect{.page = free_rect.page,
+                                   .x = free_rect.x,
+                                   .y = free_rect.y,
+                                   .width = width,
+                                   .height = free_rect.height};
+  // The remainder to the right stays free
+  free_rect.x += width;
+  free_rect.width -= width;
+  if (free_rect.width == 0) {
+    free_rect = cache->free_rects[--cache->num_free_rects];
+  }
+  return rect;
+}
+
+static auto try_allocate_shelf_rect(GlyphCache *cache, const int width,
+                                    const int height) -> GlyphCacheRect {
+  GlyphCacheShelf *best = nullptr;
+  int best_page = -1;
+  for (int page = 0; page < cache->num_pages; ++page) {
+    GlyphCacheShelf *page_shelves =
+        &cache->shelves[page * cache->max_num_shelves_per_page];
+    for (int i = 0; i < cache->page_num_shelves[page]; ++i) {
+      auto &shelf = page_shelves[i];
+      if (shelf.height < height || cache->page_width < shelf.next_x + width) {
+        continue;
+      }
+      if (best == nullptr || shelf.height < best->height) {
+        best = &shelf;
+        best_page = page;
+      }
+    }
+  }
+
+  // Open a new shelf when the best one would waste more than a third
+  if (best == nullptr || height + height / 2 < best->height) {
+    const int shelf_height = (height + shelf_height_granularity - 1) /
+                             shelf_height_granularity *
+                             shelf_height_granularity;
+    for (int page = 0; page < cache->num_pages; ++page) {
+      const int num_shelves = cache->page_num_shelves[page];
+      GlyphCacheShelf *page_shelves =
+          &cache->shelves[page * cache->max_num_shelves_per_page];
+      const int shelf_y =
+          num_shelves == 0 ? 0
+                           : page_shelves[num_shelves - 1].y +
+                                 page_shelves[num_shelves - 1].height;
+      if (cache->max_num_shelves_per_page <= num_shelves ||
+          cache->page_height < shelf_y + shelf_height) {
+        continue;
+      }
+      best = &page_shelves[cache->page_num_shelves[page]++];
+      *best =
+          GlyphCacheShelf{.y = shelf_y, .height = shelf_height, .next_x = 0};
+      best_page = page;
+      break;
+    }
+  }
+  if (best == nullptr) {
+    return GlyphCacheRect{.page = -1};
+  }
+
+  const auto rect = GlyphCacheRect{.page = best_page,
+                                   .x = best->next_x,
+                                   .y = best->y,
+                                   .width = width,
+                                   .height = best->height};
+  best->next_x += width;
+  return rect;
+}
+
+static auto allocate_rect(GlyphCache *cache, const int width, const int height)
+    -> GlyphCacheRect {
+  if (cache->page_width < width || cache->page_height < height) {
+    return GlyphCacheRect{.page = -1};
+  }
+  while (true) {
+    if (const auto rect = try_allocate_free_rect(cache, width, height);
+        rect.page != -1) {
+      return rect;
+    }
+    if (const auto rect = try_allocate_shelf_rect(cache, width, height);
+        rect.page != -1) {
+      return rect;
+    }
+    if (cache->num_pages < cache->max_num_pages) {
+      if (!add_page(cache)) {
+        return GlyphCacheRect{.page = -1};
+      }
+      continue;
+    }
+    if (!evict_one(cache)) {
+      return GlyphCacheRect{.page = -1};
+    }
+  }
+}
+
+auto glyph_cache_get(GlyphCache *cache, const GlyphCacheFont font,
+                     const int pixel_height, const char32_t codepoint)
+    -> GlyphInfo {
+  if (!cache->valid) {
+    std::println(std::cerr, "Glyph cache not valid");
+    return GlyphInfo{.valid = false};
+  }
+  if (font < 0 || cache->num_fonts <= font || pixel_height <= 0) {
+    std::println(std::cerr, "Invalid glyph cache font or size");
+    return GlyphInfo{.valid = false};
+  }
+
+  const auto key = glyph_cache_key(font, pixel_height, codepoint);
+  if (const auto found = cache->lookup->find(key);
+      found != cache->lookup->end()) {
+    const int slot = found->second;
+    ++cache->stats.hits;
+    cache->glyph_last_used_frames[slot] = cache->frame;
+    lru_unlink(cache, slot);
+    lru_push_front(cache, slot);
+    return cache->glyph_infos[slot];
+  }
+  ++cache->stats.misses;
+
+  const stbtt_fontinfo *font_info = &cache->fonts[font];
+  const float scale =
+      stbtt_ScaleForPixelHeight(font_info, static_cast<float>(pixel_height));
+  const int glyph_index =
+      stbtt_FindGlyphIndex(font_info, static_cast<int>(codepoint));
+  int advance_width;
+  int left_side_bearing;
+  stbtt_GetGlyphHMetrics(font_info, glyph_index, &advance_width,
+                         &left_side_bearing);
+  int x0;
+  int y0;
+  int x1;
+  int y1;
+  stbtt_GetGlyphBitmapBox(font_info, glyph_index, scale, scale, &x0, &y0, &x1,
+                          &y1);
+  const int width = x1 - x0;
+  const int height = y1 - y0;
+
+  const int slot = acquire_slot(cache);
+  if (slot == -1) {
+    std::println(std::cerr, "Glyph cache full, every glyph used this frame");
+    return GlyphInfo{.valid = false};
+  }
+
+  auto info = GlyphInfo{.valid = true,
+                        .atlas = -1,
+                        .x_offset = static_cast<float>(x0),
+                        .y_offset = static_cast<float>(y0),
+                        .width = static_cast<float>(width),
+                        .height = static_cast<float>(height),
+                        .x_advance = static_cast<float>(advance_width) * scale,
+                        .s0 = 0.0F,
+                        .t0 = 0.0F,
+                        .s1 = 0.0F,
+                        .t1 = 0.0F};
+  auto rect = GlyphCacheRect{.page = -1};
+  if (0 < width && 0 < height) {
+    rect = allocate_rect(cache, width + 2 * glyph_padding,
+                         height + 2 * glyph_padding);
+    if (rect.page == -1) {
+      std::println(std::cerr, "No room in glyph cache for codepoint {}",
+                   static_cast<uint32_t>(codepoint));
+      cache->free_slots[cache->num_free_slots++] = slot;
+      return GlyphInfo{.valid = false};
+    }
+    uint8_t *bitmap = cache->page_bitmaps[rect.page];
+    // Reused holes still hold the pixels of the evicted glyph
+    for (int row = rect.y; row < rect.y + rect.height; ++row) {
+      std::fill_n(
+          &bitmap[static_cast<size_t>(row) * cache->page_width + rect.x],
+          rect.width, 0);
+    }
+    const int glyph_x = rect.x + glyph_padding;
+    const int glyph_y = rect.y + glyph_padding;
+    stbtt_MakeGlyphBitmap(
+        font_info,
+        &bitmap[static_cast<size_t>(glyph_y) * cache->page_width + glyph_x],
+        width, height, cache->page_width, scale, scale, glyph_index);
+    mark_dirty(cache, rect);
+    ++cache->page_num_glyphs[rect.page];
+
+    info.atlas = cache->page_textures[rect.page];
+    info.s0 = static_cast<float>(glyph_x) / cache->page_width;
+    info.t0 = static_cast<float>(glyph_y) / cache->page_height;
+    info.s1 = static_cast<float>(glyph_x + width) / cache->page_width;
+    info.t1 = static_cast<float>(glyph_y + height) / cache->page_height;
+  }
+
+  cache->glyph_keys[slot] = key;
+  cache->glyph_infos[slot] = info;
+  cache->glyph_rects[slot] = rect;
+  cache->glyph_last_used_frames[slot] = cache->frame;
+  lru_push_front(cache, slot);
+  (*cache->lookup)[key] = slot;
+  return info;
+}
+
+auto glyph_cache_upload(GlyphCache *cache) -> void {
+  if (!cache->valid) {
+    std::println(std::cerr, "Glyph cache not valid");
+    return;
+  }
+  for (int page = 0; page < cache->num_pages; ++page) {
+    auto &dirty = cache->page_dirty_rects[page];
+    if (dirty.x0 == dirty.x1) {
+      continue;
+    }
+    const int width = dirty.x1 - dirty.x0;
+    const int height = dirty.y1 - dirty.y0;
+    texture_update(*cache->texture_manager, cache->page_textures[page],
+                   dirty.x0, dirty.y0, width, height, cache->page_width,
+                   cache->page_bitmaps[page]);
+    ++cache->stats.uploads;
+    cache->stats.uploaded_bytes += static_cast<uint64_t>(width) * height;
+    dirty = GlyphCacheDirtyRect{};
+  }
+}
+
+auto glyph_cache_get_stats(const GlyphCache &cache) -> GlyphCacheStats {
+  return cache.stats;
+}
@@ -3,18 +3,27 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <array>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <print>
+#include <string>
+#include <string_view>
 
 #include "jtr/font.h"
+#include "jtr/glyph_cache.h"
 #include "jtr/graphic_context.h"
 #include "jtr/mesh.h"
+#include "jtr/mesh_arena.h"
+#include "jtr/mutable_text.h"
 #include "jtr/program.h"
 #include "jtr/text.h"
+#include "jtr/text_batch.h"
 #include "jtr/texture.h"
 #include "jtr/vertex_array_object.h"
+#include "profiler/gpu_timer.h"
+#include "profiler/profiler.h"
 
 auto glfw_error_callback(int error, const char *description) -> void {
   std::println(std::cerr, "GLFW error {}: {}", error, description);
@@ -96,27 +105,54 @@ auto main() -> int {
   static constexpr int font_atlas_height = 1024;
   auto font_manager = get_smart_manager<FontManager>(font_manager_create, 1,
                                                      font_manager_destroy_all);
-  const auto font_handle = [&font_manager]() {
-    const auto font_data = read_file("fonts/arial.ttf");
-    return font_create(font_manager.get(),
-                       reinterpret_cast<const unsigned char *>(font_data.get()),
-                       32, 95, 64.0F, font_atlas_width, font_atlas_height);
-  }();
+  // Kept alive for the glyph cache, which rasterizes on demand
+  const auto font_binary_data = read_file("fonts/arial.ttf");
+  const auto font_handle = font_create(
+      font_manager.get(),
+      reinterpret_cast<const unsigned char *>(font_binary_data.get()), 32, 95,
+      64.0F, font_atlas_width, font_atlas_height);
   if (font_handle < 0) {
     std::println(stderr, "Could not load font");
     return 1;
   }
+  const auto font_data = font_get_data(*font_manager, font_handle);
+  if (!font_data.valid) {
+    std::println(std::cerr, "Font data not valid");
+    return 1;
+  }
 
+  static constexpr int glyph_cache_page_size = 512;
+  static constexpr int glyph_cache_max_num_pages = 4;
   const auto texture_manager = get_smart_manager<TextureManager>(
-      texture_manager_create, 2, texture_manager_destroy_all);
-  const auto font_atlas_texture_handle =
-      texture_create(*texture_manager, font_manager->bitmaps[font_handle],
-                     font_atlas_width, font_atlas_height);
+      texture_manager_create, 1 + glyph_cache_max_num_pages,
+      texture_manager_destroy_all);
+  const auto font_atlas_texture_handle = texture_create(
+      *texture_manager, font_data.bitmap, font_atlas_width, font_atlas_height);
   if (font_atlas_texture_handle < 0) {
     std::println(std::cerr, "Could not create Texture");
     return 1;
   }
 
+  static constexpr int glyph_cache_max_num_glyphs = 1024;
+  const auto glyph_cache =
+      std::unique_ptr<GlyphCache, decltype(&glyph_cache_destroy)>(
+          new GlyphCache(glyph_cache_create(
+              texture_manager.get(), glyph_cache_page_size,
+              glyph_cache_page_size, glyph_cache_max_num_pages,
+              glyph_cache_max_num_glyphs, 1)),
+          glyph_cache_destroy);
+  if (!glyph_cache->valid) {
+    std::println(std::cerr, "Could not create Glyph cache");
+    return 1;
+  }
+  const auto glyph_cache_font = glyph_cache_add_font(
+      glyph_cache.get(),
+      reinterpret_cast<const unsigned char *>(font_binary_data.get()));
+  if (glyph_cache_font < 0) {
+    std::println(std::cerr, "Could not add font to Glyph cache");
+    return 1;
+  }
+
   const auto program_handle = [&program_manager]() {
     const auto vertex_shader_source =
         std::unique_ptr<const char[]>(read_file("shaders/vertex.glsl"));
@@ -155,20 +191,28 @@ auto main() -> int {
     return 1;
   }
 
-  const auto mesh_manager = get_smart_manager<MeshManager>(
-      mesh_manager_create, 3, mesh_manager_destroy_all);
-  if (!mesh_manager->valid) {
-    std::println(std::cerr, "Could not create Mesh manager");
+  // Every mesh of the sample is drawn with one multi-draw from the arena
+  static constexpr size_t mesh_arena_max_num_vertices = 1024;
+  static constexpr size_t mesh_arena_max_num_indices = 1536;
+  static constexpr int mesh_arena_max_num_meshes = 8;
+  const auto mesh_arena =
+      std::unique_ptr<MeshArena, decltype(&mesh_arena_destroy)>(
+          new MeshArena(mesh_arena_create(mesh_arena_max_num_vertices,
+                                          mesh_arena_max_num_indices,
+                                          mesh_arena_max_num_meshes)),
+          mesh_arena_destroy);
+  if (!mesh_arena->valid) {
+    std::println(std::cerr, "Could not create Mesh arena");
     return 1;
   }
 
+  // Font atlas preview in the bottom-right corner
   // Top-right, top-left, bottom-left, bottom-right
-  /*
   static constexpr Vertex vertices[] = {
-      {.position = glm::vec3(0.5F, 0.5F, 0.0F), .uv = glm::vec2(1.0F, 0.0F)},
-      {.position = glm::vec3(-0.5F, 0.5F, 0.0F), .uv = glm::vec2(0.0F, 0.0F)},
-      {.position = glm::vec3(-0.5F, -0.5F, 0.0F), .uv = glm::vec2(0.0F, 1.0F)},
-      {.position = glm::vec3(0.5F, -0.5F, 0.0F), .uv = glm::vec2(1.0F, 1.0F)}};
+      {.position = glm::vec3(0.9F, -0.5F, 0.0F), .uv = glm::vec2(1.0F, 0.0F)},
+      {.position = glm::vec3(0.5F, -0.5F, 0.0F), .uv = glm::vec2(0.0F, 0.0F)},
+      {.position = glm::vec3(0.5F, -0.9F, 0.0F), .uv = glm::vec2(0.0F, 1.0F)},
+      {.position = glm::vec3(0.9F, -0.9F, 0.0F), .uv = glm::vec2(1.0F, 1.0F)}};
   static constexpr unsigned int indices[] = {0, 1, 2, 0, 2, 3};
   constexpr MeshData font_atlas_mesh_data = {
       .valid = true,
@@ -177,30 +221,40 @@ auto main() -> int {
       .indices = indices,
       .num_indices = sizeof(indices) / sizeof(unsigned int),
   };
-  const auto font_atlas_mesh_handle = mesh_create(*mesh_manager,
-  font_atlas_mesh_data);
-  */
-
-  static constexpr float pixel_scale = 2.0F / 600.0F;
-  const auto font_data = font_get_data(*font_manager, font_handle);
-  if (!font_data.valid) {
-    std::println(std::cerr, "Font data not valid");
+  const std::array mesh_handles = {
+      mesh_arena_create_mesh(mesh_arena.get(), font_atlas_mesh_data)};
+  if (mesh_handles[0] < 0) {
+    std::println(std::cerr, "Could not create font atlas Mesh");
     return 1;
   }
-  const auto text_mesh_handle =
-      text_create_mesh(font_data, mesh_manager.get(), glm::vec2(0.0F, 0.0F),
-                       "Hola", 1.0F, pixel_scale);
-  if (text_mesh_handle < 0) {
-    std::println(stderr, "Could not create text_mesh");
+
+  static constexpr float pixel_scale = 2.0F / 600.0F;
+  static constexpr int font_atlas_texture_unit = 0;
+  static constexpr size_t max_num_batched_glyphs = 16384;
+  static constexpr int max_num_batched_runs = 64;
+  const auto text_batch =
+      std::unique_ptr<TextBatch, decltype(&text_batch_destroy)>(
+          new TextBatch(text_batch_create(
+              *texture_manager, font_atlas_texture_unit,
+              max_num_batched_glyphs, max_num_batched_runs)),
+          text_batch_destroy);
+  if (!text_batch->valid) {
+    std::println(std::cerr, "Could not create Text batch");
     return 1;
   }
-  const auto second_text_mesh_handle =
-      text_create_mesh(font_data, mesh_manager.get(), glm::vec2(0.0F, 0.5F),
-                       "XDDDD", 1.0F, pixel_scale);
-  if (second_text_mesh_handle < 0) {
-    std::println(stderr, "Could not create second_text_mesh");
+
+  // Rewritten every frame, only the quads of digits that change are uploaded
+  static constexpr size_t frame_counter_initial_max_num_glyphs = 8;
+  const auto frame_counter_text =
+      std::unique_ptr<MutableText, decltype(&mutable_text_destroy)>(
+          new MutableText(
+              mutable_text_create(frame_counter_initial_max_num_glyphs)),
+          mutable_text_destroy);
+  if (!frame_counter_text->valid) {
+    std::println(std::cerr, "Could not create Mutable text");
     return 1;
   }
+  uint64_t frame_count = 0;
 
   glEnable(GL_DEPTH_TEST);
   /* Enable alpha blend for font */
@@ -208,33 +262,99 @@ auto main() -> int {
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   glBlendEquation(GL_FUNC_ADD);
   glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
+  // Written to trace.json on exit
+  profiler::set_thread_name("Main");
+  profiler::GpuTimer gpu_timer;
   while (glfwWindowShouldClose(graphic_context->window) == 0) {
+    gpu_timer.BeginFrame();
+    const profiler::Zone frame_zone("Frame");
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     program_use(*program_manager, program_handle);
 
-    // Draw font atlas
-    // const auto *const mesh = mesh_get(*mesh_manager, mesh_handle);
-    // glBindVertexArray(vao->vao_id);
-    // glBindVertexBuffer(0, mesh->vbo, 0, sizeof(Vertex));
-    // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
-
-    static constexpr int font_atlas_texture_unit = 0;
     static constexpr auto font_atlas_texture_uniform_name = "font_atlas";
-    texture_bind(*texture_manager, font_atlas_texture_handle,
-                 font_atlas_texture_unit);
     program_set_uniform(*program_manager, program_handle,
                         font_atlas_texture_uniform_name,
                         font_atlas_texture_unit);
 
     vertex_array_object_bind(*vao_manager, vao_handle);
-    mesh_draw(*mesh_manager, text_mesh_handle);
-    mesh_draw(*mesh_manager, second_text_mesh_handle);
+    {
+      const profiler::Zone meshes_zone("Meshes");
+      texture_bind(*texture_manager, font_atlas_texture_handle,
+                   font_atlas_texture_unit);
+      mesh_arena_draw(mesh_arena.get(), mesh_handles.data(),
+                      mesh_handles.size());
+    }
+    {
+      const profiler::Zone text_batch_zone("Text batch");
+      const profiler::GpuZone text_batch_gpu_zone(gpu_timer, "Text batch");
+      glyph_cache_begin_frame(glyph_cache.get());
+      text_batch_begin(text_batch.get());
+      text_batch_push(text_batch.get(), font_data, font_atlas_texture_handle,
+                      glm::vec2(0.0F, 0.0F), "Hola", 1.0F, pixel_scale);
+      text_batch_push(text_batch.get(), font_data, font_atlas_texture_handle,
+                      glm::vec2(0.0F, 0.5F), "XDDDD", 1.0F, pixel_scale);
+      // Outside of the baked 32-126 range, rasterized by the glyph cache
+      static constexpr std::u32string_view cached_text = U"Canción ñandú €";
+      text_batch_push_cached(text_batch.get(), glyph_cache.get(),
+                             glyph_cache_font, 48, glm::vec2(-0.9F, -0.5F),
+                             cached_text.data(), cached_text.size(),
+                             pixel_scale);
+      text_batch_flush(text_batch.get());
+    }
+
+    {
+      const profiler::Zone frame_counter_zone("Frame counter");
+      const profiler::GpuZone frame_counter_gpu_zone(gpu_timer,
+                                                     "Frame counter");
+      mutable_text_set(frame_counter_text.get(), font_data,
+                       glm::vec2(-0.9F, 0.8F),
+                       "Frame " + std::to_string(frame_count++), 0.5F,
+                       pixel_scale);
+      texture_bind(*texture_manager, font_atlas_texture_handle,
+                   font_atlas_texture_unit);
+      mutable_text_draw(*frame_counter_text);
+    }
+
+    // Only log when the batching behavior changes
+    static TextBatchStats last_text_batch_stats{};
+    if (const auto stats = text_batch_get_stats(*text_batch);
+        stats.flushes != last_text_batch_stats.flushes ||
+        stats.draws != last_text_batch_stats.draws) {
+      std::println("Text batch: {} glyphs, {} flushes, {} draws",
+                   stats.num_glyphs, stats.flushes, stats.draws);
+      last_text_batch_stats = stats;
+    }
+    static GlyphCacheStats last_glyph_cache_stats{};
+    if (const auto stats = glyph_cache_get_stats(*glyph_cache);
+        stats.misses != last_glyph_cache_stats.misses ||
+        stats.evictions != last_glyph_cache_stats.evictions) {
+      std::println("Glyph cache: {} misses, {} evictions, {} bytes uploaded",
+                   stats.misses, stats.evictions, stats.uploaded_bytes);
+      last_glyph_cache_stats = stats;
+    }
+    if (const auto stats = mutable_text_get_stats(*frame_counter_text);
+        stats.updates % 1000 == 0) {
+      std::println("Frame counter: {} bytes last update, {} bytes in {} "
+                   "updates, {} reallocations",
+                   stats.bytes_uploaded, stats.total_bytes_uploaded,
+                   stats.updates, stats.reallocations);
+    }
 
     // Render
-    glfwSwapBuffers(graphic_context->window);
+    {
+      const profiler::Zone swap_zone("Swap buffers");
+      glfwSwapBuffers(graphic_context->window);
+    }
     glfwPollEvents();
   }
 
+  if (const auto profiler_stats = profiler::stats();
+      profiler::write_chrome_trace("trace.json")) {
+    std::println("Wrote trace.json: {} events, {} dropped",
+                 profiler_stats.num_events, profiler_stats.num_dropped);
+  } else {
+    std::println(std::cerr, "Could not write trace.json");
+  }
   return 0;
 }
@@ -5,20 +5,18 @@
 #include <iostream>
 #include <print>
 
+auto mesh_release(unsigned int &vbo, unsigned int &ebo,
+                  size_t & /*num_indices*/) -> void {
+  glDeleteBuffers(1, &vbo);
+  glDeleteBuffers(1, &ebo);
+}
+
 auto mesh_manager_create(int max_num_meshes) -> MeshManager {
   if (max_num_meshes <= 0) {
     std::println(std::cerr, "Invalid max number of meshes");
     return {.valid = false};
   }
-  return MeshManager{
-      .valid = true,
-      // .meshes = meshes_ptr,
-      .meshes_count = 0,
-      .max_num_meshes = max_num_meshes,
-      .vbos = new unsigned int[max_num_meshes],
-      .ebos = new unsigned int[max_num_meshes],
-      .num_indices_s = new size_t[max_num_meshes],
-  };
+  return resource_pool_create<MeshManager>(max_num_meshes);
 }
 
 auto mesh_manager_destroy_all(MeshManager *manager) -> void {
@@ -26,18 +24,7 @@ auto mesh_manager_destroy_all(MeshManager *manager) -> void {
     std::println(std::cerr, "Mesh manager not valid");
     return;
   }
-  for (int i = 0; i < manager->meshes_count; ++i) {
-    glDeleteBuffers(1, &manager->vbos[i]);
-    glDeleteBuffers(1, &manager->ebos[i]);
-  }
-  delete[] manager->vbos;
-  delete[] manager->ebos;
-  delete[] manager->num_indices_s;
-  manager->vbos = nullptr;
-  manager->ebos = nullptr;
-  manager->num_indices_s = nullptr;
-  manager->meshes_count = 0;
-  manager->valid = false;
+  resource_pool_destroy_all(manager);
 }
 
 auto mesh_validate_handle(const MeshManager &manager, const MeshHandle handle)
@@ -46,32 +33,13 @@ auto mesh_validate_handle(const MeshManager &manager, const MeshHandle handle)
     std::println(std::cerr, "Mesh manager not valid");
     return false;
   }
-  if (handle < 0 || manager.meshes_count <= handle) {
-    std::println(std::cerr, "Invalid handle");
-    return false;
-  }
-  if (manager.vbos[handle] < 0) {
-    std::println(std::cerr, "Mesh for handle not valid");
-    return false;
-  }
-  return true;
+  return resource_pool_validate_handle(manager, handle);
 }
 
-// Causes internal fragmentation
-auto mesh_destroy(const MeshManager *manager, const MeshHandle handle) -> void {
-  if (!manager->valid) {
-    std::println(std::cerr, "Mesh manager not valid");
-    return;
-  }
-  if (!mesh_validate_handle(*manager, handle)) {
+auto mesh_destroy(MeshManager *manager, const MeshHandle handle) -> void {
+  if (!resource_pool_remove(manager, handle)) {
     std::println(std::cerr, "Invalid handle");
-    return;
   }
-  glDeleteBuffers(1, &manager->vbos[handle]);
-  glDeleteBuffers(1, &manager->ebos[handle]);
-  manager->vbos[handle] = -1;
-  manager->ebos[handle] = -1;
-  manager->num_indices_s[handle] = 0;
 }
 
 auto mesh_create(MeshManager &manager, const MeshData &mesh_data)
@@ -92,9 +60,9 @@ auto mesh_create(MeshManager &manager, const MeshData &mesh_data)
     std::println(std::cerr, "No indices specified to create mesh");
     return -1;
   }
-  if (manager.max_num_meshes <= manager.meshes_count) {
+  if (manager.capacity <= manager.count) {
     std::println(std::cerr, "Maximum number of meshes ({}) exceeded",
-                 manager.max_num_meshes);
+                 manager.capacity);
     return -1;
   }
 
@@ -109,23 +77,40 @@ auto mesh_create(MeshManager &manager, const MeshData &mesh_data)
   glNamedBufferStorage(ebo, sizeof(unsigned int) * mesh_data.num_indices,
                        mesh_data.indices, GL_DYNAMIC_STORAGE_BIT);
 
-  const auto handle = manager.meshes_count++;
-  manager.vbos[handle] = vbo;
-  manager.ebos[handle] = ebo;
-  manager.num_indices_s[handle] = mesh_data.num_indices;
-  return handle;
+  return resource_pool_insert(&manager, vbo, ebo, mesh_data.num_indices);
+}
+
+// Hard coded binding index, should come from a VAO manager/object
+static auto mesh_draw_packed(const MeshManager &manager, const int index)
+    -> void {
+  glBindVertexBuffer(0, resource_pool_field<mesh_field_vbo>(manager)[index], 0,
+                     sizeof(Vertex));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+               resource_pool_field<mesh_field_ebo>(manager)[index]);
+  glDrawElements(
+      GL_TRIANGLES,
+      static_cast<int>(
+          resource_pool_field<mesh_field_num_indices>(manager)[index]),
+      GL_UNSIGNED_INT, nullptr);
 }
 
 auto mesh_draw(const MeshManager &manager, const MeshHandle handle) -> void {
-  if (!mesh_validate_handle(manager, handle)) {
+  const int index = resource_pool_index(manager, handle);
+  if (index == -1) {
     std::println(std::cerr, "Invalid handle");
     return;
   }
-  // Hard coded binding index, should come from a VAO manager/object
-  glBindVertexBuffer(0, manager.vbos[handle], 0, sizeof(Vertex));
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, manager.ebos[handle]);
+  mesh_draw_packed(manager, index);
+  glBindVertexBuffer(0, 0, 0, sizeof(Vertex));
+}
 
-  glDrawElements(GL_TRIANGLES, static_cast<int>(manager.num_indices_s[handle]),
-                 GL_UNSIGNED_INT, nullptr);
+auto mesh_draw_all(const MeshManager &manager) -> void {
+  if (!manager.valid) {
+    std::println(std::cerr, "Mesh manager not valid");
+    return;
+  }
+  for (int i = 0; i < manager.count; ++i) {
+    mesh_draw_packed(manager, i);
+  }
   glBindVertexBuffer(0, 0, 0, sizeof(Vertex));
 }
@@ -0,0 +1,177 @@
+#include "jtr/mesh_arena.h"
+
+#include <GL/glew.h>
+
+#include <iostream>
+#include <print>
+
+auto mesh_arena_create(const size_t max_num_vertices,
+                       const size_t max_num_indices, const int max_num_meshes)
+    -> MeshArena {
+  if (max_num_vertices == 0 || max_num_indices == 0 || max_num_meshes <= 0) {
+    std::println(std::cerr, "Invalid mesh arena capacity");
+    return MeshArena{.valid = false};
+  }
+
+  unsigned int vbo;
+  glCreateBuffers(1, &vbo);
+  glNamedBufferStorage(vbo, sizeof(Vertex) * max_num_vertices, nullptr,
+                       GL_DYNAMIC_STORAGE_BIT);
+  unsigned int ebo;
+  glCreateBuffers(1, &ebo);
+  glNamedBufferStorage(ebo, sizeof(unsigned int) * max_num_indices, nullptr,
+                       GL_DYNAMIC_STORAGE_BIT);
+  unsigned int indirect_buffer;
+  glCreateBuffers(1, &indirect_buffer);
+  glNamedBufferStorage(indirect_buffer,
+                       sizeof(DrawElementsIndirectCommand) * max_num_meshes,
+                       nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  // Every mesh can leave at most one hole behind
+  return MeshArena{
+      .valid = true,
+      .vbo = vbo,
+      .ebo = ebo,
+      .indirect_buffer = indirect_buffer,
+      .vertex_allocator =
+          buffer_allocator_create(max_num_vertices, max_num_meshes + 1),
+      .index_allocator =
+          buffer_allocator_create(max_num_indices, max_num_meshes + 1),
+      .meshes = resource_pool_create<MeshArenaMeshes>(max_num_meshes),
+      .max_num_commands = max_num_meshes,
+      .commands = new DrawElementsIndirectCommand[max_num_meshes],
+      .stats = MeshArenaStats{.draws = 0, .commands = 0},
+  };
+}
+
+auto mesh_arena_destroy(MeshArena *arena) -> void {
+  if (arena == nullptr || !arena->valid) {
+    std::println(std::cerr, "Mesh arena not valid");
+    return;
+  }
+  glDeleteBuffers(1, &arena->vbo);
+  glDeleteBuffers(1, &arena->ebo);
+  glDeleteBuffers(1, &arena->indirect_buffer);
+  buffer_allocator_destroy(&arena->vertex_allocator);
+  buffer_allocator_destroy(&arena->index_allocator);
+  resource_pool_destroy_all(&arena->meshes);
+  delete[] arena->commands;
+  arena->commands = nullptr;
+  arena->valid = false;
+}
+
+auto mesh_arena_create_mesh(MeshArena *arena, const MeshData &mesh_data)
+    -> MeshHandle {
+  if (!arena->valid) {
+    std::println(std::cerr, "Mesh arena not valid");
+    return -1;
+  }
+  if (!mesh_data.valid) {
+    std::println(std::cerr, "Mesh data not valid");
+    return -1;
+  }
+  if (mesh_data.num_vertices == 0 || mesh_data.vertices == nullptr) {
+    std::println(std::cerr, "No vertices specified to create mesh");
+    return -1;
+  }
+  if (mesh_data.num_indices == 0 || mesh_data.indices == nullptr) {
+    std::println(std::cerr, "No indices specified to create mesh");
+    return -1;
+  }
+  if (arena->meshes.capacity <= arena->meshes.count) {
+    std::println(std::cerr, "Maximum number of meshes ({}) exceeded",
+                 arena->meshes.capacity);
+    return -1;
+  }
+
+  const auto vertices = buffer_allocator_allocate(&arena->vertex_allocator,
+                                                  mesh_data.num_vertices);
+  if (!vertices.valid) {
+    std::println(std::cerr, "Mesh arena out of vertex space");
+    return -1;
+  }
+  const auto indices =
+      buffer_allocator_allocate(&arena->index_allocator, mesh_data.num_indices);
+  if (!indices.valid) {
+    std::println(std::cerr, "Mesh arena out of index space");
+    buffer_allocator_free(&arena->vertex_allocator, vertices);
+    return -1;
+  }
+
+  glNamedBufferSubData(
+      arena->vbo, static_cast<GLintptr>(sizeof(Vertex) * vertices.offset),
+      static_cast<GLsizeiptr>(sizeof(Vertex) * vertices.size),
+      mesh_data.vertices);
+  glNamedBufferSubData(
+      arena->ebo, static_cast<GLintptr>(sizeof(unsigned int) * indices.offset),
+      static_cast<GLsizeiptr>(sizeof(unsigned int) * indices.size),
+      mesh_data.indices);
+
+  return resource_pool_insert(&arena->meshes, vertices.offset, vertices.size,
+                              indices.offset, indices.size);
+}
+
+auto mesh_arena_destroy_mesh(MeshArena *arena, const MeshHandle handle)
+    -> void {
+  const int index = resource_pool_index(arena->meshes, handle);
+  if (index == -1) {
+    std::println(std::cerr, "Invalid handle");
+    return;
+  }
+  buffer_allocator_free(
+      &arena->vertex_allocator,
+      BufferAllocation{
+          .valid = true,
+          .offset = resource_pool_field<mesh_arena_field_first_vertex>(
+              arena->meshes)[index],
+          .size = resource_pool_field<mesh_arena_field_num_vertices>(
+              arena->meshes)[index]});
+  buffer_allocator_free(
+      &arena->index_allocator,
+      BufferAllocation{
+          .valid = true,
+          .offset = resource_pool_field<mesh_arena_field_first_index>(
+              arena->meshes)[index],
+          .size = resource_pool_field<mesh_arena_field_num_indices>(
+              arena->meshes)[index]});
+  resource_pool_remove(&arena->meshes, handle);
+}
+
+auto mesh_arena_draw(MeshArena *arena, const MeshHandle *handles,
+                     const size_t num_handles) -> void {
+  if (!arena->valid) {
+    std::println(std::cerr, "Mesh arena not valid");
+    return;
+  }
+  // Hard coded binding index, should come from a VAO manager/object
+  glBindVertexBuffer(0, arena->vbo, 0, sizeof(Vertex));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena->ebo);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, arena->indirect_buffer);
+  size_t first_handle = 0;
+  while (first_handle < num_handles) {
+    size_t num_handles_read = 0;
+    const size_t num_commands = mesh_arena_build_commands(
+        arena->meshes, &handles[first_handle], num_handles - first_handle,
+        static_cast<size_t>(arena->max_num_commands), arena->commands,
+        &num_handles_read);
+    first_handle += num_handles_read;
+    if (num_commands == 0) {
+      break;
+    }
+    glNamedBufferSubData(
+        arena->indirect_buffer, 0,
+        static_cast<GLsizeiptr>(sizeof(DrawElementsIndirectCommand) *
+                                num_commands),
+        arena->commands);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                                static_cast<GLsizei>(num_commands), 0);
+    ++arena->stats.draws;
+    arena->stats.commands += static_cast<int>(num_commands);
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexBuffer(0, 0, 0, sizeof(Vertex));
+}
+
+auto mesh_arena_get_stats(const MeshArena &arena) -> MeshArenaStats {
+  return arena.stats;
+}
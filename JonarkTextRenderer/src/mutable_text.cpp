@@ -0,0 +1,201 @@
+#include "jtr/mutable_text.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <print>
+#include <utility>
+
+static constexpr size_t vertices_per_glyph = 4;
+static constexpr size_t indices_per_glyph = 6;
+
+// Immutable storage can't be resized, so buffers are recreated on growth
+static auto mutable_text_create_buffers(const size_t max_num_glyphs,
+                                        unsigned int *vbo, unsigned int *ebo)
+    -> void {
+  auto *indices = new unsigned int[max_num_glyphs * indices_per_glyph];
+  for (size_t glyph = 0; glyph < max_num_glyphs; ++glyph) {
+    const auto base = static_cast<unsigned int>(glyph * vertices_per_glyph);
+    unsigned int *glyph_indices = &indices[glyph * indices_per_glyph];
+    glyph_indices[0] = base + 0;
+    glyph_indices[1] = base + 1;
+    glyph_indices[2] = base + 2;
+    glyph_indices[3] = base + 0;
+    glyph_indices[4] = base + 2;
+    glyph_indices[5] = base + 3;
+  }
+
+  glCreateBuffers(1, vbo);
+  glNamedBufferStorage(*vbo,
+                       sizeof(Vertex) * vertices_per_glyph * max_num_glyphs,
+                       nullptr, GL_DYNAMIC_STORAGE_BIT);
+  glCreateBuffers(1, ebo);
+  glNamedBufferStorage(
+      *ebo, sizeof(unsigned int) * indices_per_glyph * max_num_glyphs, indices,
+      0);
+  delete[] indices;
+}
+
+auto mutable_text_create(const size_t initial_max_num_glyphs) -> MutableText {
+  if (initial_max_num_glyphs == 0) {
+    std::println(std::cerr, "Invalid mutable text capacity");
+    return MutableText{.valid = false};
+  }
+  unsigned int vbo;
+  unsigned int ebo;
+  mutable_text_create_buffers(initial_max_num_glyphs, &vbo, &ebo);
+  return MutableText{
+      .valid = true,
+      .max_num_glyphs = initial_max_num_glyphs,
+      .num_glyphs = 0,
+      .vbo = vbo,
+      .ebo = ebo,
+      .layout = text_layout_create(initial_max_num_glyphs),
+      .vertices = new Vertex[initial_max_num_glyphs * vertices_per_glyph],
+      .staging_vertices =
+          new Vertex[initial_max_num_glyphs * vertices_per_glyph],
+      .stats = MutableTextStats{.updates = 0,
+                                .bytes_uploaded = 0,
+                                .total_bytes_uploaded = 0,
+                                .reallocations = 0},
+  };
+}
+
+auto mutable_text_destroy(MutableText *text) -> void {
+  if (text == nullptr || !text->valid) {
+    std::println(std::cerr, "Mutable text not valid");
+    return;
+  }
+  glDeleteBuffers(1, &text->vbo);
+  glDeleteBuffers(1, &text->ebo);
+  text_layout_destroy(&text->layout);
+  delete[] text->vertices;
+  delete[] text->staging_vertices;
+  text->vertices = nullptr;
+  text->staging_vertices = nullptr;
+  text->num_glyphs = 0;
+  text->valid = false;
+}
+
+// Keeps the glyphs already uploaded, they are diffed against afterwards
+static auto mutable_text_grow(MutableText *text, const size_t min_num_glyphs)
+    -> void {
+  const size_t max_num_glyphs =
+      std::max(min_num_glyphs, text->max_num_glyphs * 2);
+
+  unsigned int vbo;
+  unsigned int ebo;
+  mutable_text_create_buffers(max_num_glyphs, &vbo, &ebo);
+  glCopyNamedBufferSubData(
+      text->vbo, vbo, 0, 0,
+      static_cast<GLsizeiptr>(sizeof(Vertex) * vertices_per_glyph *
+                              text->num_glyphs));
+  glDeleteBuffers(1, &text->vbo);
+  glDeleteBuffers(1, &text->ebo);
+  text->vbo = vbo;
+  text->ebo = ebo;
+
+  auto *vertices = new Vertex[max_num_glyphs * vertices_per_glyph];
+  std::copy(text->vertices,
+            text->vertices + text->num_glyphs * vertices_per_glyph, vertices);
+  delete[] text->vertices;
+  delete[] text->staging_vertices;
+  text->vertices = vertices;
+  text->staging_vertices = new Vertex[max_num_glyphs * vertices_per_glyph];
+
+  text->max_num_glyphs = max_num_glyphs;
+  ++text->stats.reallocations;
+}
+
+// Uploads glyphs [first_glyph, last_glyph) of the staging quads
+static auto mutable_text_upload(MutableText *text, const size_t first_glyph,
+                                const size_t last_glyph) -> void {
+  const size_t offset = sizeof(Vertex) * vertices_per_glyph * first_glyph;
+  const size_t size =
+      sizeof(Vertex) * vertices_per_glyph * (last_glyph - first_glyph);
+  glNamedBufferSubData(text->vbo, static_cast<GLintptr>(offset),
+                       static_cast<GLsizeiptr>(size),
+                       &text->staging_vertices[first_glyph *
+                                               vertices_per_glyph]);
+  text->stats.bytes_uploaded += size;
+}
+
+auto mutable_text_set(MutableText *mutable_text, const FontData &font_data,
+                      const glm::vec2 position, const std::string &text,
+                      const float size, const float pixel_scale) -> bool {
+  if (!mutable_text->valid) {
+    std::println(std::cerr, "Mutable text not valid");
+    return false;
+  }
+  // The layout is sized in bytes of UTF-8, which bounds the glyph count
+  if (mutable_text->layout.max_num_glyphs < text.length()) {
+    const size_t max_num_glyphs =
+        std::max(text.length(), mutable_text->layout.max_num_glyphs * 2);
+    text_layout_destroy(&mutable_text->layout);
+    mutable_text->layout = text_layout_create(max_num_glyphs);
+  }
+  if (!text_layout_build(&mutable_text->layout, font_data, position,
+                         text.data(), text.length(), size, pixel_scale)) {
+    std::println(std::cerr, "Could not lay out text");
+    return false;
+  }
+
+  const size_t num_glyphs = mutable_text->layout.num_glyphs;
+  if (mutable_text->max_num_glyphs < num_glyphs) {
+    mutable_text_grow(mutable_text, num_glyphs);
+  }
+  text_layout_write_vertices(mutable_text->layout,
+                             mutable_text->staging_vertices);
+
+  // Upload each run of glyphs whose quads differ from the ones in the buffer
+  mutable_text->stats.bytes_uploaded = 0;
+  static constexpr size_t glyph_bytes = sizeof(Vertex) * vertices_per_glyph;
+  size_t dirty_begin = num_glyphs;
+  for (size_t glyph = 0; glyph < num_glyphs; ++glyph) {
+    const bool changed =
+        mutable_text->num_glyphs <= glyph ||
+        std::memcmp(
+            &mutable_text->vertices[glyph * vertices_per_glyph],
+            &mutable_text->staging_vertices[glyph * vertices_per_glyph],
+            glyph_bytes) != 0;
+    if (changed && dirty_begin == num_glyphs) {
+      dirty_begin = glyph;
+    } else if (!changed && dirty_begin != num_glyphs) {
+      mutable_text_upload(mutable_text, dirty_begin, glyph);
+      dirty_begin = num_glyphs;
+    }
+  }
+  if (dirty_begin != num_glyphs) {
+    mutable_text_upload(mutable_text, dirty_begin, num_glyphs);
+  }
+
+  std::swap(mutable_text->vertices, mutable_text->staging_vertices);
+  mutable_text->num_glyphs = num_glyphs;
+  ++mutable_text->stats.updates;
+  mutable_text->stats.total_bytes_uploaded +=
+      mutable_text->stats.bytes_uploaded;
+  return true;
+}
+
+auto mutable_text_draw(const MutableText &text) -> void {
+  if (!text.valid) {
+    std::println(std::cerr, "Mutable text not valid");
+    return;
+  }
+  if (text.num_glyphs == 0) {
+    return;
+  }
+  // Hard coded binding index, should come from a VAO manager/object
+  glBindVertexBuffer(0, text.vbo, 0, sizeof(Vertex));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, text.ebo);
+  glDrawElements(GL_TRIANGLES,
+                 static_cast<int>(text.num_glyphs * indices_per_glyph),
+                 GL_UNSIGNED_INT, nullptr);
+  glBindVertexBuffer(0, 0, 0, sizeof(Vertex));
+}
+
+auto mutable_text_get_stats(const MutableText &text) -> MutableTextStats {
+  return text.stats;
+}
@@ -2,20 +2,24 @@
 
 #include <gl/glew.h>
 
+#include <chrono>
 #include <print>
 
+#include "program_cache/program_cache.h"
+
+// Relative to the working directory, next to the shaders
+static constexpr auto program_cache_directory = "shader_cache";
+
+auto program_release(unsigned int &program_id) -> void {
+  glDeleteProgram(program_id);
+}
+
 auto program_manager_create(const int max_num_programs) -> ProgramManager {
   if (max_num_programs <= 0) {
     std::println(stderr, "Invalid max number of programs");
     return ProgramManager{.valid = false};
   }
-  auto *programs_ids_ptr = new unsigned int[max_num_programs];
-  return ProgramManager{.valid = true,
-                        .programs_count = 0,
-                        .max_num_programs = max_num_programs,
-                        .program_ids = programs_ids_ptr
-
-  };
+  return resource_pool_create<ProgramManager>(max_num_programs);
 }
 
 auto program_manager_destroy_all(ProgramManager *program_manager) -> void {
@@ -23,14 +27,7 @@ auto program_manager_destroy_all(ProgramManager *program_manager) -> void {
     std::println(stderr, "Invalid program manager");
     return;
   }
-  for (ProgramHandle i = 0; i < program_manager->programs_count; ++i) {
-    program_destroy(*program_manager, i);
-  }
-  delete[] program_manager->program_ids;
-  program_manager->program_ids = nullptr;
-  program_manager->programs_count = 0;
-  program_manager->max_num_programs = 0;
-  program_manager->valid = false;
+  resource_pool_destroy_all(program_manager);
 }
 
 auto program_validate_handle(const ProgramManager &program_manager,
@@ -39,22 +36,14 @@ auto program_validate_handle(const ProgramManager &program_manager,
     std::println(stderr, "Invalid program manager");
     return false;
   }
-  if (handle < 0 || program_manager.programs_count <= handle) {
-    std::println(stderr, "Invalid handle");
-    return false;
-  }
-  return true;
+  return resource_pool_validate_handle(program_manager, handle);
 }
 
-// Causes internal fragmentation
-auto program_destroy(const ProgramManager &manager, const ProgramHandle handle)
+auto program_destroy(ProgramManager &manager, const ProgramHandle handle)
     -> void {
-  if (!program_validate_handle(manager, handle)) {
+  if (!resource_pool_remove(&manager, handle)) {
     std::println(stderr, "Invalid program");
-    return;
   }
-  glDeleteProgram(manager.program_ids[handle]);
-  manager.program_ids[handle] = 0;
 }
 
 auto compile_shader(const GLenum shader_type, const char *source)
@@ -72,6 +61,7 @@ auto compile_shader(const GLenum shader_type, const char *source)
     glGetShaderInfoLog(shader_id, compile_err_message_len, &log_length,
                        message);
     std::println(stderr, "Could not compile shader {}: {}", shader_id, message);
+    glDeleteShader(shader_id);
     return 0;
   }
   return shader_id;
@@ -81,9 +71,15 @@ auto compile_and_link_program(const unsigned int vertex_shader,
                               const unsigned int fragment_shader)
     -> unsigned int {
   const auto program_id = glCreateProgram();
+  program_cache::prepare_for_link(program_id);
   glAttachShader(program_id, vertex_shader);
   glAttachShader(program_id, fragment_shader);
   glLinkProgram(program_id);
+  // The program keeps what it needs once linked
+  glDetachShader(program_id, vertex_shader);
+  glDetachShader(program_id, fragment_shader);
+  glDeleteShader(vertex_shader);
+  glDeleteShader(fragment_shader);
   int linked;
   glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
   if (linked != GL_TRUE) {
@@ -92,7 +88,8 @@ auto compile_and_link_program(const unsigned int vertex_shader,
     GLchar message[link_err_message_len];
     glGetProgramInfoLog(program_id, link_err_message_len, &log_length, message);
     std::println(stderr, "Could not link program {}: {}", program_id,
-                 log_length);
+                 message);
+    glDeleteProgram(program_id);
     return 0;
   }
   return program_id;
@@ -105,39 +102,56 @@ auto program_create(ProgramManager &program_manager,
     std::println(stderr, "Invalid program manager");
     return -1;
   }
-
-  const auto vertex_shader =
-      compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
-  if (vertex_shader == 0) {
-    std::println(stderr, "Could not compile vertex shader");
-    return -1;
-  }
-  const auto fragment_shader =
-      compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
-  if (fragment_shader == 0) {
-    std::println(stderr, "Could not compile fragment shader");
+  if (vertex_shader_source == nullptr || fragment_shader_source == nullptr) {
+    std::println(stderr, "Missing shader source");
     return -1;
   }
 
-  const auto program_id =
-      compile_and_link_program(vertex_shader, fragment_shader);
-  if (program_id == 0) {
-    std::println(stderr, "Could not link program");
-    return -1;
+  const auto link_start = std::chrono::steady_clock::now();
+  const auto cache_key =
+      program_cache::key_for(vertex_shader_source, fragment_shader_source);
+  auto program_id = program_cache::load(program_cache_directory, cache_key);
+  const auto cache_hit = program_id != 0;
+  if (!cache_hit) {
+    const auto vertex_shader =
+        compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
+    if (vertex_shader == 0) {
+      std::println(stderr, "Could not compile vertex shader");
+      return -1;
+    }
+    const auto fragment_shader =
+        compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+    if (fragment_shader == 0) {
+      std::println(stderr, "Could not compile fragment shader");
+      glDeleteShader(vertex_shader);
+      return -1;
+    }
+
+    program_id = compile_and_link_program(vertex_shader, fragment_shader);
+    if (program_id == 0) {
+      std::println(stderr, "Could not link program");
+      return -1;
+    }
+    program_cache::store(program_cache_directory, cache_key, program_id);
   }
-
-  const int handle = program_manager.programs_count++;
-  program_manager.program_ids[handle] = program_id;
-  return handle;
+  const std::chrono::duration<double, std::milli> link_time =
+      std::chrono::steady_clock::now() - link_start;
+  const auto cache_stats = program_cache::stats();
+  std::println("Program cache {}, {:.2f} ms ({} hits, {} misses)",
+               cache_hit ? "hit" : "miss", link_time.count(), cache_stats.hits,
+               cache_stats.misses);
+
+  return resource_pool_insert(&program_manager, program_id);
 }
 
 auto program_use(const ProgramManager &manager, const ProgramHandle handle)
     -> void {
-  if (!program_validate_handle(manager, handle)) {
+  const auto *program_id = resource_pool_get<program_field_id>(manager, handle);
+  if (program_id == nullptr) {
     std::println(stderr, "Invalid program");
     return;
   }
-  glUseProgram(manager.program_ids[handle]);
+  glUseProgram(*program_id);
 }
 
 template <>
@@ -145,11 +159,11 @@ auto program_set_uniform<int>(const ProgramManager &program_manager,
                               const ProgramHandle handle,
                               const char *uniform_name, const int value)
     -> void {
-  if (!program_validate_handle(program_manager, handle)) {
+  const auto *program_id =
+      resource_pool_get<program_field_id>(program_manager, handle);
+  if (program_id == nullptr) {
     std::println(stderr, "Invalid program");
     return;
   }
-  glUniform1i(
-      glGetUniformLocation(program_manager.program_ids[handle], uniform_name),
-      value);
+  glUniform1i(glGetUniformLocation(*program_id, uniform_name), value);
 }
@@ -0,0 +1,185 @@
+#include "jtr/text_batch.h"
+
+#include <GL/glew.h>
+
+#include <iostream>
+#include <print>
+
+
+static constexpr size_t vertices_per_glyph = 4;
+static constexpr size_t indices_per_glyph = 6;
+
+auto text_batch_create(const TextureManager &texture_manager,
+                       const int texture_unit, const size_t max_num_glyphs,
+                       const int max_num_runs) -> TextBatch {
+  if (!texture_manager.valid) {
+    std::println(std::cerr, "Texture Manager not valid");
+    return TextBatch{.valid = false};
+  }
+  auto queue = text_batch_queue_create(max_num_glyphs, max_num_runs);
+  if (!queue.valid) {
+    return TextBatch{.valid = false};
+  }
+
+  // Every glyph uses the same quad layout, so the index buffer is built once
+  auto *indices = new unsigned int[max_num_glyphs * indices_per_glyph];
+  for (size_t glyph = 0; glyph < max_num_glyphs; ++glyph) {
+    const auto base = static_cast<unsigned int>(glyph * vertices_per_glyph);
+    unsigned int *glyph_indices = &indices[glyph * indices_per_glyph];
+    glyph_indices[0] = base + 0;
+    glyph_indices[1] = base + 1;
+    glyph_indices[2] = base + 2;
+    glyph_indices[3] = base + 0;
+    glyph_indices[4] = base + 2;
+    glyph_indices[5] = base + 3;
+  }
+
+  unsigned int vbo;
+  glCreateBuffers(1, &vbo);
+  glNamedBufferStorage(vbo,
+                       sizeof(Vertex) * vertices_per_glyph * max_num_glyphs,
+                       nullptr, GL_DYNAMIC_STORAGE_BIT);
+  unsigned int ebo;
+  glCreateBuffers(1, &ebo);
+  glNamedBufferStorage(
+      ebo, sizeof(unsigned int) * indices_per_glyph * max_num_glyphs, indices,
+      0);
+  delete[] indices;
+
+  return TextBatch{
+      .valid = true,
+      .texture_manager = &texture_manager,
+      .texture_unit = texture_unit,
+      .vbo = vbo,
+      .ebo = ebo,
+      .queue = queue,
+  };
+}
+
+auto text_batch_destroy(TextBatch *batch) -> void {
+  if (batch == nullptr || !batch->valid) {
+    std::println(std::cerr, "Text batch not valid");
+    return;
+  }
+  glDeleteBuffers(1, &batch->vbo);
+  glDeleteBuffers(1, &batch->ebo);
+  text_batch_queue_destroy(&batch->queue);
+  batch->valid = false;
+}
+
+auto text_batch_begin(TextBatch *batch) -> void {
+  if (!batch->valid) {
+    std::println(std::cerr, "Text batch not valid");
+    return;
+  }
+  text_batch_queue_begin(&batch->queue);
+}
+
+auto text_batch_push(TextBatch *batch, const FontData &font_data,
+                     const TextureHandle atlas, const glm::vec2 position,
+                     const std::string &text, const float size,
+                     const float pixel_scale) -> bool {
+  if (!batch->valid) {
+    std::println(std::cerr, "Text batch not valid");
+    return false;
+  }
+  if (!text_batch_queue_layout(&batch->queue, font_data, position, text,
+                               size, pixel_scale)) {
+    return false;
+  }
+  if (!text_batch_queue_append_layout(&batch->queue, atlas)) {
+    text_batch_flush(batch);
+    if (!text_batch_queue_append_layout(&batch->queue, atlas)) {
+      std::println(std::cerr, "Text does not fit in the batch");
+      return false;
+    }
+  }
+  return true;
+}
+
+auto text_batch_push_cached(TextBatch *batch, GlyphCache *cache,
+                            const GlyphCacheFont font, const int pixel_height,
+                            const glm::vec2 position,
+                            const char32_t *codepoints,
+                            const size_t num_codepoints,
+                            const float pixel_scale) -> bool {
+  if (!batch->valid) {
+    std::println(std::cerr, "Text batch not valid");
+    return false;
+  }
+
+  glm::vec2 cursor_position = position;
+  for (size_t i = 0; i < num_codepoints; ++i) {
+    const auto glyph =
+        glyph_cache_get(cache, font, pixel_height, codepoints[i]);
+    if (!glyph.valid) {
+      std::println(std::cerr, "Could not get glyph for codepoint {}",
+                   static_cast<uint32_t>(codepoints[i]));
+      glyph_cache_upload(cache);
+      return false;
+    }
+    if (glyph.atlas != -1) {
+      const float left = cursor_position.x + glyph.x_offset * pixel_scale;
+      const float right = left + glyph.width * pixel_scale;
+      // Glyph offsets grow down, positions grow up
+      const float top = cursor_position.y - glyph.y_offset * pixel_scale;
+      const float bottom = top - glyph.height * pixel_scale;
+
+      // Top-right, top-left, bottom-left, bottom-right
+      const Vertex quad_vertices[] = {
+          {.position = glm::vec3(right, top, 0.0F),
+           .uv = glm::vec2(glyph.s1, glyph.t0)},
+          {.position = glm::vec3(left, top, 0.0F),
+           .uv = glm::vec2(glyph.s0, glyph.t0)},
+          {.position = glm::vec3(left, bottom, 0.0F),
+           .uv = glm::vec2(glyph.s0, glyph.t1)},
+          {.position = glm::vec3(right, bottom, 0.0F),
+           .uv = glm::vec2(glyph.s1, glyph.t1)},
+      };
+      if (!text_batch_queue_append_quad(&batch->queue, glyph.atlas,
+                                        quad_vertices)) {
+        glyph_cache_upload(cache);
+        text_batch_flush(batch);
+        text_batch_queue_append_quad(&batch->queue, glyph.atlas,
+                                     quad_vertices);
+      }
+    }
+    cursor_position.x += glyph.x_advance * pixel_scale;
+  }
+  glyph_cache_upload(cache);
+  return true;
+}
+
+auto text_batch_flush(TextBatch *batch) -> void {
+  if (!batch->valid) {
+    std::println(std::cerr, "Text batch not valid");
+    return;
+  }
+  const auto draws = text_batch_queue_take(&batch->queue);
+  if (draws.num_glyphs == 0) {
+    return;
+  }
+  glNamedBufferSubData(
+      batch->vbo, 0,
+      static_cast<GLsizeiptr>(sizeof(Vertex) * vertices_per_glyph *
+                              draws.num_glyphs),
+      draws.vertices);
+
+  // Hard coded binding index, should come from a VAO manager/object
+  glBindVertexBuffer(0, batch->vbo, 0, sizeof(Vertex));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch->ebo);
+  for (int i = 0; i < draws.num_runs; ++i) {
+    const auto run = draws.runs[i];
+    texture_bind(*batch->texture_manager, run.atlas, batch->texture_unit);
+    glDrawElements(
+        GL_TRIANGLES, static_cast<int>(run.num_glyphs * indices_per_glyph),
+        GL_UNSIGNED_INT,
+        reinterpret_cast<const void *>(run.first_glyph * indices_per_glyph *
+                                       sizeof(unsigned int)));
+  }
+  glBindVertexBuffer(0, 0, 0, sizeof(Vertex));
+}
+
+auto text_batch_get_stats(const TextBatch &batch) -> TextBatchStats {
+  return batch.queue.stats;
+}
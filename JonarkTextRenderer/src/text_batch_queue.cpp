@@ -0,0 +1,182 @@
+#include "jtr/text_batch_queue.h"
+
+#include <algorithm>
+#include <iostream>
+#include <print>
+
+static constexpr size_t vertices_per_glyph = 4;
+
+auto text_batch_queue_create(const size_t max_num_glyphs,
+                             const int max_num_runs) -> TextBatchQueue {
+  if (max_num_glyphs == 0 || max_num_runs <= 0) {
+    std::println(std::cerr, "Invalid text batch capacity");
+    return TextBatchQueue{.valid = false};
+  }
+  return TextBatchQueue{
+      .valid = true,
+      .max_num_glyphs = max_num_glyphs,
+      .max_num_runs = max_num_runs,
+      .layout = text_layout_create(max_num_glyphs),
+      .vertices = new Vertex[max_num_glyphs * vertices_per_glyph],
+      .sorted_vertices = new Vertex[max_num_glyphs * vertices_per_glyph],
+      .num_glyphs = 0,
+      .runs = new TextBatchRun[max_num_runs],
+      .sorted_runs = new TextBatchRun[max_num_runs],
+      .num_runs = 0,
+      .stats = TextBatchStats{.flushes = 0, .draws = 0, .num_glyphs = 0},
+  };
+}
+
+auto text_batch_queue_destroy(TextBatchQueue *queue) -> void {
+  if (queue == nullptr || !queue->valid) {
+    std::println(std::cerr, "Text batch queue not valid");
+    return;
+  }
+  text_layout_destroy(&queue->layout);
+  delete[] queue->vertices;
+  delete[] queue->sorted_vertices;
+  delete[] queue->runs;
+  delete[] queue->sorted_runs;
+  queue->vertices = nullptr;
+  queue->sorted_vertices = nullptr;
+  queue->runs = nullptr;
+  queue->sorted_runs = nullptr;
+  queue->num_glyphs = 0;
+  queue->num_runs = 0;
+  queue->valid = false;
+}
+
+auto text_batch_queue_begin(TextBatchQueue *queue) -> void {
+  queue->num_glyphs = 0;
+  queue->num_runs = 0;
+  queue->stats = TextBatchStats{.flushes = 0, .draws = 0, .num_glyphs = 0};
+}
+
+// Whether the glyphs can't be queued for atlas without flushing first
+static auto text_batch_queue_is_full(const TextBatchQueue &queue,
+                                     const ResourceHandle atlas,
+                                     const size_t num_glyphs) -> bool {
+  const bool extends_last_run =
+      0 < queue.num_runs && queue.runs[queue.num_runs - 1].atlas == atlas;
+  return queue.max_num_glyphs < queue.num_glyphs + num_glyphs ||
+         (!extends_last_run && queue.max_num_runs <= queue.num_runs);
+}
+
+// Counts glyphs already written at the end of the vertex arena
+static auto text_batch_queue_append_run(TextBatchQueue *queue,
+                                        const ResourceHandle atlas,
+                                        const size_t num_glyphs) -> void {
+  if (0 < queue->num_runs && queue->runs[queue->num_runs - 1].atlas == atlas) {
+    queue->runs[queue->num_runs - 1].num_glyphs += num_glyphs;
+  } else {
+    queue->runs[queue->num_runs++] =
+        TextBatchRun{.atlas = atlas,
+                     .first_glyph = queue->num_glyphs,
+                     .num_glyphs = num_glyphs};
+  }
+  queue->num_glyphs += num_glyphs;
+}
+
+auto text_batch_queue_layout(TextBatchQueue *queue, const FontData &font_data,
+                             const glm::vec2 position, const std::string &text,
+                             const float size, const float pixel_scale)
+    -> bool {
+  if (!font_data.valid) {
+    std::println(std::cerr, "Font data not valid");
+    return false;
+  }
+  if (!text_layout_build(&queue->layout, font_data, position, text.data(),
+                         text.length(), size, pixel_scale)) {
+    std::println(std::cerr, "Could not lay out text");
+    return false;
+  }
+  return true;
+}
+
+auto text_batch_queue_append_layout(TextBatchQueue *queue,
+                                    const ResourceHandle atlas) -> bool {
+  const size_t num_glyphs = queue->layout.num_glyphs;
+  if (text_batch_queue_is_full(*queue, atlas, num_glyphs)) {
+    return false;
+  }
+  text_layout_write_vertices(
+      queue->layout, &queue->vertices[queue->num_glyphs * vertices_per_glyph]);
+  text_batch_queue_append_run(queue, atlas, num_glyphs);
+  return true;
+}
+
+auto text_batch_queue_append_quad(TextBatchQueue *queue,
+                                  const ResourceHandle atlas,
+                                  const Vertex *quad_vertices) -> bool {
+  if (text_batch_queue_is_full(*queue, atlas, 1)) {
+    return false;
+  }
+  std::copy(quad_vertices, quad_vertices + vertices_per_glyph,
+            &queue->vertices[queue->num_glyphs * vertices_per_glyph]);
+  text_batch_queue_append_run(queue, atlas, 1);
+  return true;
+}
+
+// Groups runs by atlas so each atlas ends up in one contiguous glyph range.
+// Returns the vertices to upload and leaves the merged runs in sorted_runs.
+static auto text_batch_queue_sort_runs(TextBatchQueue *queue,
+                                       int *num_sorted_runs) -> const Vertex * {
+  *num_sorted_runs = 0;
+  bool single_atlas = true;
+  for (int i = 1; i < queue->num_runs; ++i) {
+    single_atlas = single_atlas && queue->runs[i].atlas == queue->runs[0].atlas;
+  }
+  if (single_atlas) {
+    queue->sorted_runs[(*num_sorted_runs)++] =
+        TextBatchRun{.atlas = queue->runs[0].atlas,
+                     .first_glyph = 0,
+                     .num_glyphs = queue->num_glyphs};
+    return queue->vertices;
+  }
+
+  std::copy(queue->runs, queue->runs + queue->num_runs, queue->sorted_runs);
+  std::stable_sort(queue->sorted_runs, queue->sorted_runs + queue->num_runs,
+                   [](const TextBatchRun &a, const TextBatchRun &b) {
+                     return a.atlas < b.atlas;
+                   });
+
+  size_t sorted_glyph = 0;
+  for (int i = 0; i < queue->num_runs; ++i) {
+    const auto run = queue->sorted_runs[i];
+    std::copy(&queue->vertices[run.first_glyph * vertices_per_glyph],
+              &queue->vertices[(run.first_glyph + run.num_glyphs) *
+                               vertices_per_glyph],
+              &queue->sorted_vertices[sorted_glyph * vertices_per_glyph]);
+    if (0 < *num_sorted_runs &&
+        queue->sorted_runs[*num_sorted_runs - 1].atlas == run.atlas) {
+      queue->sorted_runs[*num_sorted_runs - 1].num_glyphs += run.num_glyphs;
+    } else {
+      queue->sorted_runs[(*num_sorted_runs)++] =
+          TextBatchRun{.atlas = run.atlas,
+                       .first_glyph = sorted_glyph,
+                       .num_glyphs = run.num_glyphs};
+    }
+    sorted_glyph += run.num_glyphs;
+  }
+  return queue->sorted_vertices;
+}
+
+auto text_batch_queue_take(TextBatchQueue *queue) -> TextBatchDraws {
+  if (queue->num_glyphs == 0) {
+    return TextBatchDraws{
+        .vertices = nullptr, .num_glyphs = 0, .runs = nullptr, .num_runs = 0};
+  }
+
+  int num_sorted_runs;
+  const Vertex *vertices = text_batch_queue_sort_runs(queue, &num_sorted_runs);
+  const auto draws = TextBatchDraws{.vertices = vertices,
+                                    .num_glyphs = queue->num_glyphs,
+                                    .runs = queue->sorted_runs,
+                                    .num_runs = num_sorted_runs};
+  ++queue->stats.flushes;
+  queue->stats.draws += num_sorted_runs;
+  queue->stats.num_glyphs += queue->num_glyphs;
+  queue->num_glyphs = 0;
+  queue->num_runs = 0;
+  return draws;
+}
@@ -0,0 +1,194 @@
+#include "jtr/text_layout.h"
+
+#include <cstdint>
+#include <iostream>
+#include <print>
+
+#include "jtr/utf8.h"
+
+#if defined(__AVX2__)
+#define TEXT_LAYOUT_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXT_LAYOUT_SSE2
+#include <emmintrin.h>
+#endif
+
+auto text_layout_create(const size_t max_num_glyphs) -> TextLayout {
+  if (max_num_glyphs == 0) {
+    std::println(std::cerr, "Invalid text layout capacity");
+    return TextLayout{.valid = false};
+  }
+  return TextLayout{
+      .valid = true,
+      .max_num_glyphs = max_num_glyphs,
+      .num_glyphs = 0,
+      .codepoints = new char32_t[max_num_glyphs],
+      .pen_xs = new float[max_num_glyphs],
+      .x_offsets = new float[max_num_glyphs],
+      .y_offsets = new float[max_num_glyphs],
+      .widths = new float[max_num_glyphs],
+      .heights = new float[max_num_glyphs],
+      .x0s = new float[max_num_glyphs],
+      .y0s = new float[max_num_glyphs],
+      .x1s = new float[max_num_glyphs],
+      .y1s = new float[max_num_glyphs],
+      .s0s = new float[max_num_glyphs],
+      .t0s = new float[max_num_glyphs],
+      .s1s = new float[max_num_glyphs],
+      .t1s = new float[max_num_glyphs],
+  };
+}
+
+auto text_layout_destroy(TextLayout *layout) -> void {
+  if (layout == nullptr || !layout->valid) {
+    std::println(std::cerr, "Text layout not valid");
+    return;
+  }
+  delete[] layout->codepoints;
+  delete[] layout->pen_xs;
+  delete[] layout->x_offsets;
+  delete[] layout->y_offsets;
+  delete[] layout->widths;
+  delete[] layout->heights;
+  delete[] layout->x0s;
+  delete[] layout->y0s;
+  delete[] layout->x1s;
+  delete[] layout->y1s;
+  delete[] layout->s0s;
+  delete[] layout->t0s;
+  delete[] layout->s1s;
+  delete[] layout->t1s;
+  *layout = TextLayout{.valid = false};
+}
+
+// x0 = pen + x_offset * scale, x1 = x0 + width * scale
+// y0 = y + (y_offset + height) * scale, y1 = y0 + height * scale
+static auto text_layout_compute_positions(TextLayout *layout, const float y,
+                                          const float scale) -> void {
+  size_t i = 0;
+#if defined(TEXT_LAYOUT_AVX2)
+  const __m256 scales = _mm256_set1_ps(scale);
+  const __m256 ys = _mm256_set1_ps(y);
+  for (; i + 8 <= layout->num_glyphs; i += 8) {
+    const __m256 pen_xs = _mm256_loadu_ps(&layout->pen_xs[i]);
+    const __m256 x_offsets = _mm256_loadu_ps(&layout->x_offsets[i]);
+    const __m256 y_offsets = _mm256_loadu_ps(&layout->y_offsets[i]);
+    const __m256 widths = _mm256_mul_ps(_mm256_loadu_ps(&layout->widths[i]),
+                                        scales);
+    const __m256 heights = _mm256_loadu_ps(&layout->heights[i]);
+    const __m256 x0s =
+        _mm256_add_ps(pen_xs, _mm256_mul_ps(x_offsets, scales));
+    const __m256 y0s = _mm256_add_ps(
+        ys, _mm256_mul_ps(_mm256_add_ps(y_offsets, heights), scales));
+    _mm256_storeu_ps(&layout->x0s[i], x0s);
+    _mm256_storeu_ps(&layout->x1s[i], _mm256_add_ps(x0s, widths));
+    _mm256_storeu_ps(&layout->y0s[i], y0s);
+    _mm256_storeu_ps(&layout->y1s[i],
+                     _mm256_add_ps(y0s, _mm256_mul_ps(heights, scales)));
+  }
+#elif defined(TEXT_LAYOUT_SSE2)
+  const __m128 scales = _mm_set1_ps(scale);
+  const __m128 ys = _mm_set1_ps(y);
+  for (; i + 4 <= layout->num_glyphs; i += 4) {
+    const __m128 pen_xs = _mm_loadu_ps(&layout->pen_xs[i]);
+    const __m128 x_offsets = _mm_loadu_ps(&layout->x_offsets[i]);
+    const __m128 y_offsets = _mm_loadu_ps(&layout->y_offsets[i]);
+    const __m128 widths = _mm_mul_ps(_mm_loadu_ps(&layout->widths[i]), scales);
+    const __m128 heights = _mm_loadu_ps(&layout->heights[i]);
+    const __m128 x0s = _mm_add_ps(pen_xs, _mm_mul_ps(x_offsets, scales));
+    const __m128 y0s =
+        _mm_add_ps(ys, _mm_mul_ps(_mm_add_ps(y_offsets, heights), scales));
+    _mm_storeu_ps(&layout->x0s[i], x0s);
+    _mm_storeu_ps(&layout->x1s[i], _mm_add_ps(x0s, widths));
+    _mm_storeu_ps(&layout->y0s[i], y0s);
+    _mm_storeu_ps(&layout->y1s[i],
+                  _mm_add_ps(y0s, _mm_mul_ps(heights, scales)));
+  }
+#endif
+  // Scalar tail, or everything when no SIMD is available
+  for (; i < layout->num_glyphs; ++i) {
+    layout->x0s[i] = layout->pen_xs[i] + layout->x_offsets[i] * scale;
+    layout->x1s[i] = layout->x0s[i] + layout->widths[i] * scale;
+    layout->y0s[i] = y + (layout->y_offsets[i] + layout->heights[i]) * scale;
+    layout->y1s[i] = layout->y0s[i] + layout->heights[i] * scale;
+  }
+}
+
+auto text_layout_build(TextLayout *layout, const FontData &font_data,
+                       const glm::vec2 position, const char *text,
+                       const size_t length, const float size,
+                       const float pixel_scale) -> bool {
+  layout->num_glyphs = 0;
+  if (!layout->valid) {
+    std::println(std::cerr, "Text layout not valid");
+    return false;
+  }
+  if (!font_data.valid) {
+    std::println(std::cerr, "Font data not valid");
+    return false;
+  }
+  // A codepoint takes at least one byte
+  if (layout->max_num_glyphs < length) {
+    std::println(std::cerr,
+                 "Text of length {} exceeds text layout capacity ({})", length,
+                 layout->max_num_glyphs);
+    return false;
+  }
+  const ptrdiff_t num_codepoints =
+      utf8_decode(text, length, layout->codepoints);
+  if (num_codepoints < 0) {
+    std::println(std::cerr, "Text is not valid UTF-8");
+    return false;
+  }
+
+  // The pen position depends on every previous advance, so gathering stays
+  // scalar
+  const float scale = pixel_scale * size;
+  float pen_x = position.x;
+  for (ptrdiff_t i = 0; i < num_codepoints; ++i) {
+    const auto index =
+        static_cast<int64_t>(layout->codepoints[i]) - font_data.charcode_begin;
+    if (index < 0 || font_data.charcode_count <= index) {
+      std::println(std::cerr, "Could not find codepoint {}",
+                   static_cast<uint32_t>(layout->codepoints[i]));
+      return false;
+    }
+    const auto &packed_char = font_data.packed_chars[index];
+    const auto &aligned_quad = font_data.aligned_quads[index];
+    layout->pen_xs[i] = pen_x;
+    layout->x_offsets[i] = packed_char.xoff;
+    layout->y_offsets[i] = packed_char.yoff;
+    layout->widths[i] = static_cast<float>(packed_char.x1 - packed_char.x0);
+    layout->heights[i] = static_cast<float>(packed_char.y1 - packed_char.y0);
+    layout->s0s[i] = aligned_quad.s0;
+    layout->t0s[i] = aligned_quad.t0;
+    layout->s1s[i] = aligned_quad.s1;
+    layout->t1s[i] = aligned_quad.t1;
+    pen_x += packed_char.xadvance * scale;
+  }
+  layout->num_glyphs = static_cast<size_t>(num_codepoints);
+
+  text_layout_compute_positions(layout, position.y, scale);
+  return true;
+}
+
+auto text_layout_write_vertices(const TextLayout &layout,
+                                Vertex *out_vertices) -> void {
+  for (size_t i = 0; i < layout.num_glyphs; ++i) {
+    Vertex *glyph_vertices = &out_vertices[i * 4];
+    glyph_vertices[0] =
+        Vertex{.position = glm::vec3(layout.x1s[i], layout.y1s[i], 0.0F),
+               .uv = glm::vec2(layout.s1s[i], layout.t0s[i])};
+    glyph_vertices[1] =
+        Vertex{.position = glm::vec3(layout.x0s[i], layout.y1s[i], 0.0F),
+               .uv = glm::vec2(layout.s0s[i], layout.t0s[i])};
+    glyph_vertices[2] =
+        Vertex{.position = glm::vec3(layout.x0s[i], layout.y0s[i], 0.0F),
+               .uv = glm::vec2(layout.s0s[i], layout.t1s[i])};
+    glyph_vertices[3] =
+        Vertex{.position = glm::vec3(layout.x1s[i], layout.y0s[i], 0.0F),
+               .uv = glm::vec2(layout.s1s[i], layout.t1s[i])};
+  }
+}
@@ -1,26 +1,19 @@
 #include "jtr/texture.h"
 
+auto texture_release(unsigned int& texture_id) -> void {
+  glDeleteTextures(1, &texture_id);
+}
+
 auto texture_manager_create(const int max_num_textures) -> TextureManager {
   if (max_num_textures <= 0) {
     std::println(stderr, "Invalid max_num_textures");
     return TextureManager{.valid = false};
   }
-  return TextureManager{
-      .valid = true,
-      .num_textures = 0,
-      .max_num_textures = max_num_textures,
-      .texture_ids = new unsigned int[max_num_textures],
-  };
+  return resource_pool_create<TextureManager>(max_num_textures);
 }
 
 auto texture_manager_destroy_all(TextureManager* manager) -> void {
-  for (int i = 0; i < manager->num_textures; ++i) {
-    texture_destroy(*manager, static_cast<TextureHandle>(i));
-  }
-  delete[] manager->texture_ids;
-  manager->texture_ids = nullptr;
-  manager->num_textures = 0;
-  manager->valid = false;
+  resource_pool_destroy_all(manager);
 }
 
 auto texture_validate_handle(const TextureManager& manager,
@@ -29,8 +22,7 @@ auto texture_validate_handle(const TextureManager& manager,
     std::println(stderr, "Texture Manager not valid");
     return false;
   }
-  if (handle < 0 || manager.max_num_textures <= handle ||
-      manager.texture_ids[handle] < 0) {
+  if (!resource_pool_validate_handle(manager, handle)) {
     std::println(stderr, "Invalid Texture handle");
     return false;
   }
@@ -39,6 +31,11 @@ auto texture_validate_handle(const TextureManager& manager,
 
 auto texture_create(TextureManager& texture_manager, const uint8_t* image_data,
                     const int width, const int height) -> TextureHandle {
+  if (texture_manager.capacity <= texture_manager.count) {
+    std::println(stderr, "Maximum number of textures ({}) exceeded",
+                 texture_manager.capacity);
+    return -1;
+  }
   unsigned int texture_id;
   glCreateTextures(GL_TEXTURE_2D, 1, &texture_id);
   if (texture_id == 0) {
@@ -57,31 +54,44 @@ auto texture_create(TextureManager& texture_manager, const uint8_t* image_data,
 
   glGenerateTextureMipmap(texture_id);
 
-  const auto handle = texture_manager.num_textures++;
-  texture_manager.texture_ids[handle] = texture_id;
-  return handle;
+  return resource_pool_insert(&texture_manager, texture_id);
 }
 
-auto texture_destroy(const TextureManager& texture_manager,
+auto texture_update(const TextureManager& manager, const TextureHandle handle,
+                    const int x, const int y, const int width, const int height,
+                    const int row_length, const uint8_t* image_data) -> void {
+  const auto* texture_id = resource_pool_get<texture_field_id>(manager, handle);
+  if (texture_id == nullptr) {
+    std::println(stderr, "Invalid texture handle");
+    return;
+  }
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTextureSubImage2D(*texture_id, 0, x, y, width, height, GL_RED,
+                      GL_UNSIGNED_BYTE,
+                      &image_data[static_cast<size_t>(y) * row_length + x]);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+auto texture_destroy(TextureManager& texture_manager,
                      const TextureHandle handle) -> void {
   if (!texture_manager.valid) {
     std::println(stderr, "Texture Manager not valid");
     return;
   }
-  if (handle < 0 || texture_manager.max_num_textures <= handle) {
+  if (!resource_pool_remove(&texture_manager, handle)) {
     std::println(stderr, "Invalid handle");
-    return;
   }
-  glDeleteTextures(1, &texture_manager.texture_ids[handle]);
-  texture_manager.texture_ids[handle] = -1;
 }
 
 auto texture_bind(const TextureManager& manager, const TextureHandle handle,
                   const int texture_unit) -> void {
-  if (!texture_validate_handle(manager, handle)) {
+  const auto* texture_id = resource_pool_get<texture_field_id>(manager, handle);
+  if (texture_id == nullptr) {
     std::println(stderr, "Invalid texture handle");
     return;
   }
   glActiveTexture(GL_TEXTURE0 + texture_unit);
-  glBindTexture(GL_TEXTURE_2D, manager.texture_ids[handle]);
+  glBindTexture(GL_TEXTURE_2D, *texture_id);
 }
@@ -0,0 +1,96 @@
+#include "jtr/utf8.h"
+
+#include <cstdint>
+#include <iostream>
+#include <print>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF8_SSE2
+#include <emmintrin.h>
+#endif
+
+static auto utf8_is_continuation(const uint8_t byte) -> bool {
+  return (byte & 0xC0) == 0x80;
+}
+
+auto utf8_decode(const char *text, const size_t length,
+                 char32_t *out_codepoints) -> ptrdiff_t {
+  const auto *bytes = reinterpret_cast<const uint8_t *>(text);
+  size_t i = 0;
+  ptrdiff_t num_codepoints = 0;
+  while (i < length) {
+#ifdef UTF8_SSE2
+    // Most text is ASCII, widen 16 bytes at a time while no high bit is set
+    while (i + 16 <= length) {
+      const __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bytes[i]));
+      if (_mm_movemask_epi8(chunk) != 0) {
+        break;
+      }
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i low = _mm_unpacklo_epi8(chunk, zero);
+      const __m128i high = _mm_unpackhi_epi8(chunk, zero);
+      auto *out = reinterpret_cast<__m128i *>(&out_codepoints[num_codepoints]);
+      _mm_storeu_si128(&out[0], _mm_unpacklo_epi16(low, zero));
+      _mm_storeu_si128(&out[1], _mm_unpackhi_epi16(low, zero));
+      _mm_storeu_si128(&out[2], _mm_unpacklo_epi16(high, zero));
+      _mm_storeu_si128(&out[3], _mm_unpackhi_epi16(high, zero));
+      i += 16;
+      num_codepoints += 16;
+    }
+    if (length <= i) {
+      break;
+    }
+#endif
+
+    const uint8_t lead = bytes[i];
+    if (lead < 0x80) {
+      out_codepoints[num_codepoints++] = lead;
+      ++i;
+      continue;
+    }
+
+    size_t sequence_length;
+    char32_t codepoint;
+    char32_t min_codepoint;
+    if ((lead & 0xE0) == 0xC0) {
+      sequence_length = 2;
+      codepoint = lead & 0x1F;
+      min_codepoint = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+      sequence_length = 3;
+      codepoint = lead & 0x0F;
+      min_codepoint = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+      sequence_length = 4;
+      codepoint = lead & 0x07;
+      min_codepoint = 0x10000;
+    } else {
+      std::println(std::cerr, "Invalid UTF-8 lead byte {:#x} at offset {}",
+                   lead, i);
+      return -1;
+    }
+    if (length - i < sequence_length) {
+      std::println(std::cerr, "Truncated UTF-8 sequence at offset {}", i);
+      return -1;
+    }
+    for (size_t j = 1; j < sequence_length; ++j) {
+      if (!utf8_is_continuation(bytes[i + j])) {
+        std::println(std::cerr, "Invalid UTF-8 continuation byte at offset {}",
+                     i + j);
+        return -1;
+      }
+      codepoint = (codepoint << 6) | (bytes[i + j] & 0x3F);
+    }
+    if (codepoint < min_codepoint || 0x10FFFF < codepoint ||
+        (0xD800 <= codepoint && codepoint <= 0xDFFF)) {
+      std::println(std::cerr, "Invalid UTF-8 codepoint {:#x} at offset {}",
+                   static_cast<uint32_t>(codepoint), i);
+      return -1;
+    }
+    out_codepoints[num_codepoints++] = codepoint;
+    i += sequence_length;
+  }
+  return num_codepoints;
+}
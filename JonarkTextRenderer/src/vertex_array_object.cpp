@@ -5,14 +5,13 @@
 #include <iostream>
 #include <print>
 
+auto vertex_array_object_release(unsigned int& vao_id) -> void {
+  glDeleteVertexArrays(1, &vao_id);
+}
+
 auto vertex_array_object_manager_create(const int max_num_vaos)
     -> VertexArrayObjectManager {
-  auto* vao_ids = new unsigned int[max_num_vaos];
-
-  return VertexArrayObjectManager{.valid = true,
-                                  .vao_count = 0,
-                                  .max_num_vaos = max_num_vaos,
-                                  .vao_ids = vao_ids};
+  return resource_pool_create<VertexArrayObjectManager>(max_num_vaos);
 }
 
 auto vertex_array_object_manager_destroy_all(VertexArrayObjectManager* manager)
@@ -21,16 +20,7 @@ auto vertex_array_object_manager_destroy_all(VertexArrayObjectManager* manager)
     std::println("VertexArrayObjectManager not valid");
     return;
   }
-  for (VertexArrayObjectHandle handle = 0; handle < manager->max_num_vaos;
-       ++handle) {
-    vertex_array_object_destroy(*manager, handle);
-  }
-  delete manager->vao_ids;
-  ;
-  manager->vao_ids = nullptr;
-  manager->vao_count = 0;
-  manager->max_num_vaos = 0;
-  manager->valid = false;
+  resource_pool_destroy_all(manager);
 }
 
 auto vertex_array_object_validate_handle(
@@ -40,35 +30,33 @@ auto vertex_array_object_validate_handle(
     std::println("VertexArrayObjectManager not valid");
     return false;
   }
-  if (manager.vao_ids == nullptr || manager.vao_count == 0) {
-    std::println("VertexArrayObjectManager not valid");
-    return false;
-  }
-  if (manager.vao_count <= handle || manager.vao_ids[handle] < 0) {
+  if (!resource_pool_validate_handle(manager, handle)) {
     std::println(std::cerr, "VertexArrayObjectHandle not valid");
     return false;
   }
   return true;
 }
 
-auto vertex_array_object_destroy(const VertexArrayObjectManager& manager,
+auto vertex_array_object_destroy(VertexArrayObjectManager& manager,
                                  const VertexArrayObjectHandle handle) -> void {
   if (!manager.valid) {
     std::println(std::cerr, "Mesh manager not valid");
     return;
   }
-  if (!vertex_array_object_validate_handle(manager, handle)) {
+  if (!resource_pool_remove(&manager, handle)) {
     std::println(std::cerr, "Invalid handle");
-    return;
   }
-  glDeleteVertexArrays(1, &manager.vao_ids[handle]);
-  manager.vao_ids[handle] = -1;
 }
 
 auto vertex_array_object_create(VertexArrayObjectManager* manager,
                                 const VertexArrayAttributeEntry* attributes,
                                 const size_t attributes_len)
     -> VertexArrayObjectHandle {
+  if (manager->capacity <= manager->count) {
+    std::println(std::cerr, "Maximum number of VAOs ({}) exceeded",
+                 manager->capacity);
+    return -1;
+  }
   unsigned int vao;
   glCreateVertexArrays(1, &vao);
   for (size_t i = 0; i < attributes_len; ++i) {
@@ -80,20 +68,16 @@ auto vertex_array_object_create(VertexArrayObjectManager* manager,
     glEnableVertexArrayAttrib(vao, index);
   }
 
-  const auto handle = manager->vao_count++;
-  manager->vao_ids[handle] = vao;
-  return handle;
+  return resource_pool_insert(manager, vao);
 }
 
 auto vertex_array_object_bind(const VertexArrayObjectManager& manager,
                               const VertexArrayObjectHandle handle) -> void {
-  if (!manager.valid) {
-    std::println(std::cerr, "Mesh manager not valid");
-    return;
-  }
-  if (!vertex_array_object_validate_handle(manager, handle)) {
+  const auto* vao_id =
+      resource_pool_get<vertex_array_object_field_id>(manager, handle);
+  if (vao_id == nullptr) {
     std::println(std::cerr, "Invalid handle");
     return;
   }
-  glBindVertexArray(manager.vao_ids[handle]);
+  glBindVertexArray(*vao_id);
 }
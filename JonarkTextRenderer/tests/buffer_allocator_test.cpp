@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "jtr/buffer_allocator.h"
+
+namespace {
+class BufferAllocatorTest : public testing::Test {
+ protected:
+  BufferAllocator allocator{};
+
+  auto create(const size_t capacity, const int max_num_free_blocks) -> void {
+    allocator = buffer_allocator_create(capacity, max_num_free_blocks);
+    ASSERT_TRUE(allocator.valid);
+  }
+
+  auto TearDown() -> void override {
+    if (allocator.valid) {
+      buffer_allocator_destroy(&allocator);
+    }
+  }
+
+  // Failures are reported on stderr, keep it out of the test output
+  auto allocate_quietly(const size_t size) -> BufferAllocation {
+    testing::internal::CaptureStderr();
+    const auto allocation = buffer_allocator_allocate(&allocator, size);
+    testing::internal::GetCapturedStderr();
+    return allocation;
+  }
+
+  auto free_quietly(const BufferAllocation &allocation) -> bool {
+    testing::internal::CaptureStderr();
+    const bool freed = buffer_allocator_free(&allocator, allocation);
+    testing::internal::GetCapturedStderr();
+    return freed;
+  }
+
+  // Sorted, not touching and adding up to everything not used
+  auto expect_free_list_consistent() -> void {
+    size_t free = 0;
+    for (int i = 0; i < allocator.num_free_blocks; ++i) {
+      const auto &block = allocator.free_blocks[i];
+      ASSERT_GT(block.size, 0U);
+      ASSERT_LE(block.offset + block.size, allocator.capacity);
+      if (0 < i) {
+        const auto &previous = allocator.free_blocks[i - 1];
+        ASSERT_LT(previous.offset + previous.size, block.offset);
+      }
+      free += block.size;
+    }
+    ASSERT_EQ(free, allocator.capacity - allocator.used);
+  }
+};
+
+TEST_F(BufferAllocatorTest, AllocatesBackToBack) {
+  create(100, 8);
+  const auto first = buffer_allocator_allocate(&allocator, 10);
+  const auto second = buffer_allocator_allocate(&allocator, 20);
+  ASSERT_TRUE(first.valid && second.valid);
+  EXPECT_EQ(first.offset, 0U);
+  EXPECT_EQ(second.offset, 10U);
+  EXPECT_EQ(allocator.used, 30U);
+  EXPECT_EQ(buffer_allocator_largest_free_block(allocator), 70U);
+}
+
+TEST_F(BufferAllocatorTest, PicksSmallestFreeRangeThatFits) {
+  create(100, 8);
+  // Holes of 10, 4 and 6 between kept ranges
+  std::vector<BufferAllocation> allocations;
+  for (const size_t size : {10, 1, 4, 1, 6, 1}) {
+    allocations.push_back(buffer_allocator_allocate(&allocator, size));
+  }
+  ASSERT_TRUE(buffer_allocator_free(&allocator, allocations[0]));
+  ASSERT_TRUE(buffer_allocator_free(&allocator, allocations[2]));
+  ASSERT_TRUE(buffer_allocator_free(&allocator, allocations[4]));
+
+  EXPECT_EQ(buffer_allocator_allocate(&allocator, 5).offset,
+            allocations[4].offset);
+  EXPECT_EQ(buffer_allocator_allocate(&allocator, 4).offset,
+            allocations[2].offset);
+  EXPECT_EQ(buffer_allocator_allocate(&allocator, 7).offset, 0U);
+  expect_free_list_consistent();
+}
+
+TEST_F(BufferAllocatorTest, FreeMergesNeighbours) {
+  create(30, 8);
+  const auto first = buffer_allocator_allocate(&allocator, 10);
+  const auto second = buffer_allocator_allocate(&allocator, 10);
+  const auto third = buffer_allocator_allocate(&allocator, 10);
+  ASSERT_EQ(allocator.num_free_blocks, 0);
+
+  ASSERT_TRUE(buffer_allocator_free(&allocator, first));
+  ASSERT_TRUE(buffer_allocator_free(&allocator, third));
+  EXPECT_EQ(allocator.num_free_blocks, 2);
+  ASSERT_TRUE(buffer_allocator_free(&allocator, second));
+  ASSERT_EQ(allocator.num_free_blocks, 1);
+  EXPECT_EQ(allocator.free_blocks[0].offset, 0U);
+  EXPECT_EQ(allocator.free_blocks[0].size, 30U);
+  EXPECT_EQ(allocator.used, 0U);
+}
+
+TEST_F(BufferAllocatorTest, RejectsDoubleFreeAndOutOfRange) {
+  create(30, 8);
+  const auto allocation = buffer_allocator_allocate(&allocator, 10);
+  ASSERT_TRUE(buffer_allocator_free(&allocator, allocation));
+  EXPECT_FALSE(free_quietly(allocation));
+  EXPECT_FALSE(free_quietly(
+      BufferAllocation{.valid = true, .offset = 25, .size = 10}));
+  EXPECT_FALSE(allocate_quietly(0).valid);
+  EXPECT_FALSE(allocate_quietly(31).valid);
+  expect_free_list_consistent();
+}
+
+TEST_F(BufferAllocatorTest, FailsWhenFragmented) {
+  create(30, 8);
+  const auto first = buffer_allocator_allocate(&allocator, 10);
+  buffer_allocator_allocate(&allocator, 10);
+  const auto third = buffer_allocator_allocate(&allocator, 10);
+  buffer_allocator_free(&allocator, first);
+  buffer_allocator_free(&allocator, third);
+  // 20 free, but not in one range
+  EXPECT_FALSE(allocate_quietly(20).valid);
+  EXPECT_EQ(buffer_allocator_largest_free_block(allocator), 10U);
+}
+
+TEST_F(BufferAllocatorTest, FailsWhenFreeListIsFull) {
+  create(30, 1);
+  const auto first = buffer_allocator_allocate(&allocator, 10);
+  buffer_allocator_allocate(&allocator, 10);
+  const auto third = buffer_allocator_allocate(&allocator, 10);
+  ASSERT_TRUE(buffer_allocator_free(&allocator, first));
+  EXPECT_FALSE(free_quietly(third));
+  EXPECT_EQ(allocator.used, 20U);
+}
+
+// Random allocations and frees checked against a map of used elements
+TEST_F(BufferAllocatorTest, RandomAllocationsNeverOverlap) {
+  static constexpr size_t capacity = 1 << 16;
+  static constexpr int max_num_live = 512;
+  create(capacity, max_num_live + 1);
+
+  std::mt19937 random(7);
+  std::vector<bool> used(capacity, false);
+  std::vector<BufferAllocation> live;
+  for (int operation = 0; operation < 200'000; ++operation) {
+    const bool allocate = live.empty() ||
+                          (static_cast<int>(live.size()) < max_num_live &&
+                           random() % 2 == 0);
+    if (allocate) {
+      const size_t size = 1 + random() % 256;
+      if (buffer_allocator_largest_free_block(allocator) < size) {
+        ASSERT_FALSE(allocate_quietly(size).valid);
+        continue;
+      }
+      const auto allocation = buffer_allocator_allocate(&allocator, size);
+      ASSERT_TRUE(allocation.valid);
+      ASSERT_EQ(allocation.size, size);
+      for (size_t i = allocation.offset; i < allocation.offset + size; ++i) {
+        ASSERT_FALSE(used[i]) << "element " << i << " allocated twice";
+        used[i] = true;
+      }
+      live.push_back(allocation);
+    } else {
+      const auto i = random() % live.size();
+      const auto allocation = live[i];
+      live[i] = live.back();
+      live.pop_back();
+      ASSERT_TRUE(buffer_allocator_free(&allocator, allocation));
+      const size_t end = allocation.offset + allocation.size;
+      for (size_t j = allocation.offset; j < end; ++j) {
+        used[j] = false;
+      }
+    }
+    if (operation % 1000 == 0) {
+      expect_free_list_consistent();
+    }
+  }
+
+  for (const auto &allocation : live) {
+    ASSERT_TRUE(buffer_allocator_free(&allocator, allocation));
+  }
+  ASSERT_EQ(allocator.num_free_blocks, 1);
+  EXPECT_EQ(allocator.free_blocks[0].size, capacity);
+}
+}  // namespace
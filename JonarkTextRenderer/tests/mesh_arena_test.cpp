@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+
+#include "jtr/mesh_arena.h"
+
+namespace {
+class MeshArenaCommandsTest : public testing::Test {
+ protected:
+  MeshArenaMeshes meshes{};
+
+  auto SetUp() -> void override {
+    meshes = resource_pool_create<MeshArenaMeshes>(8);
+    ASSERT_TRUE(meshes.valid);
+  }
+
+  auto TearDown() -> void override { resource_pool_destroy_all(&meshes); }
+};
+
+TEST_F(MeshArenaCommandsTest, OneCommandPerMeshWithBaseVertex) {
+  // First vertex, number of vertices, first index, number of indices
+  const auto quad = resource_pool_insert(&meshes, size_t{0}, size_t{4},
+                                         size_t{0}, size_t{6});
+  const auto triangle = resource_pool_insert(&meshes, size_t{4}, size_t{3},
+                                             size_t{6}, size_t{3});
+  const std::array handles = {triangle, quad};
+  std::array<DrawElementsIndirectCommand, 2> commands{};
+  size_t num_handles_read = 0;
+
+  ASSERT_EQ(mesh_arena_build_commands(meshes, handles.data(), handles.size(),
+                                      commands.size(), commands.data(),
+                                      &num_handles_read),
+            2U);
+  EXPECT_EQ(num_handles_read, 2U);
+  EXPECT_EQ(commands[0].count, 3U);
+  EXPECT_EQ(commands[0].instance_count, 1U);
+  EXPECT_EQ(commands[0].first_index, 6U);
+  EXPECT_EQ(commands[0].base_vertex, 4);
+  EXPECT_EQ(commands[0].base_instance, 0U);
+  EXPECT_EQ(commands[1].count, 6U);
+  EXPECT_EQ(commands[1].first_index, 0U);
+  EXPECT_EQ(commands[1].base_vertex, 0);
+}
+
+TEST_F(MeshArenaCommandsTest, SkipsStaleHandles) {
+  const auto removed = resource_pool_insert(&meshes, size_t{0}, size_t{4},
+                                            size_t{0}, size_t{6});
+  const auto kept = resource_pool_insert(&meshes, size_t{4}, size_t{4},
+                                         size_t{6}, size_t{6});
+  ASSERT_TRUE(resource_pool_remove(&meshes, removed));
+  const std::array handles = {removed, kept};
+  std::array<DrawElementsIndirectCommand, 2> commands{};
+  size_t num_handles_read = 0;
+
+  testing::internal::CaptureStderr();
+  const auto num_commands = mesh_arena_build_commands(
+      meshes, handles.data(), handles.size(), commands.size(), commands.data(),
+      &num_handles_read);
+  testing::internal::GetCapturedStderr();
+  ASSERT_EQ(num_commands, 1U);
+  EXPECT_EQ(num_handles_read, 2U);
+  EXPECT_EQ(commands[0].base_vertex, 4);
+  EXPECT_EQ(commands[0].first_index, 6U);
+}
+
+// Stale handles don't take a command, so they don't push valid meshes out of
+// a batch, and the next batch carries on after the last handle read
+TEST_F(MeshArenaCommandsTest, StopsOnceFullAfterSkippingStaleHandles) {
+  const auto removed = resource_pool_insert(&meshes, size_t{0}, size_t{4},
+                                            size_t{0}, size_t{6});
+  std::array<MeshHandle, 5> handles{};
+  handles[0] = removed;
+  for (size_t i = 1; i < handles.size(); ++i) {
+    handles[i] = resource_pool_insert(&meshes, 4 * i, size_t{4}, 6 * i,
+                                      size_t{6});
+  }
+  ASSERT_TRUE(resource_pool_remove(&meshes, removed));
+  std::array<DrawElementsIndirectCommand, 2> commands{};
+  size_t num_handles_read = 0;
+
+  testing::internal::CaptureStderr();
+  const auto num_commands = mesh_arena_build_commands(
+      meshes, handles.data(), handles.size(), commands.size(), commands.data(),
+      &num_handles_read);
+  testing::internal::GetCapturedStderr();
+  ASSERT_EQ(num_commands, 2U);
+  EXPECT_EQ(num_handles_read, 3U);
+  EXPECT_EQ(commands[0].base_vertex, 4);
+  EXPECT_EQ(commands[1].base_vertex, 8);
+
+  ASSERT_EQ(mesh_arena_build_commands(
+                meshes, &handles[num_handles_read],
+                handles.size() - num_handles_read, commands.size(),
+                commands.data(), &num_handles_read),
+            2U);
+  EXPECT_EQ(num_handles_read, 2U);
+  EXPECT_EQ(commands[0].base_vertex, 12);
+  EXPECT_EQ(commands[1].base_vertex, 16);
+}
+
+TEST(DrawElementsIndirectCommandTest, MatchesTheGlLayout) {
+  EXPECT_EQ(sizeof(DrawElementsIndirectCommand), 5 * sizeof(unsigned int));
+  EXPECT_EQ(offsetof(DrawElementsIndirectCommand, base_vertex),
+            3 * sizeof(unsigned int));
+}
+}  // namespace
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "jtr/resource_pool.h"
+
+namespace {
+int num_released = 0;
+
+auto count_release(unsigned int & /*vbo*/, unsigned int & /*ebo*/,
+                   size_t & /*num_indices*/) -> void {
+  ++num_released;
+}
+
+// MeshManager's layout with a release hook that doesn't need GL
+using TestMeshPool =
+    ResourcePool<&count_release, unsigned int, unsigned int, size_t>;
+
+struct LiveMesh {
+  ResourceHandle handle;
+  unsigned int vbo;
+};
+
+class ResourcePoolTest : public testing::Test {
+ protected:
+  TestMeshPool pool{};
+
+  auto SetUp() -> void override { num_released = 0; }
+
+  auto create(const int capacity) -> void {
+    pool = resource_pool_create<TestMeshPool>(capacity);
+    ASSERT_TRUE(pool.valid);
+  }
+
+  auto TearDown() -> void override {
+    if (pool.valid) {
+      resource_pool_destroy_all(&pool);
+    }
+  }
+
+  // Invalid handles are reported on stderr, keep it out of the test output
+  auto is_valid(const ResourceHandle handle) -> bool {
+    testing::internal::CaptureStderr();
+    const bool valid = resource_pool_validate_handle(pool, handle);
+    testing::internal::GetCapturedStderr();
+    return valid;
+  }
+};
+
+TEST_F(ResourcePoolTest, ReusesSlotsOfDestroyedResources) {
+  create(4);
+  const auto first = resource_pool_insert(&pool, 1U, 1U, size_t{3});
+  const auto second = resource_pool_insert(&pool, 2U, 2U, size_t{3});
+  ASSERT_TRUE(resource_pool_remove(&pool, first));
+  const auto third = resource_pool_insert(&pool, 3U, 3U, size_t{3});
+
+  EXPECT_EQ(resource_handle_index(third), resource_handle_index(first));
+  EXPECT_NE(third, first);
+  EXPECT_FALSE(is_valid(first));
+  EXPECT_EQ(*resource_pool_get<0>(pool, second), 2U);
+  EXPECT_EQ(*resource_pool_get<0>(pool, third), 3U);
+  EXPECT_EQ(pool.num_slots, 2);
+  EXPECT_EQ(num_released, 1);
+}
+
+TEST_F(ResourcePoolTest, RemoveKeepsResourcesPacked) {
+  create(8);
+  std::vector<ResourceHandle> handles;
+  for (unsigned int i = 0; i < 8; ++i) {
+    handles.push_back(resource_pool_insert(&pool, i, i, size_t{0}));
+  }
+  ASSERT_TRUE(resource_pool_remove(&pool, handles[2]));
+  ASSERT_TRUE(resource_pool_remove(&pool, handles[0]));
+
+  ASSERT_EQ(pool.count, 6);
+  const auto *vbos = resource_pool_field<0>(pool);
+  std::vector<unsigned int> packed(vbos, vbos + pool.count);
+  std::ranges::sort(packed);
+  EXPECT_EQ(packed, (std::vector<unsigned int>{1, 3, 4, 5, 6, 7}));
+  for (unsigned int i = 1; i < 8; ++i) {
+    if (i != 2) {
+      EXPECT_EQ(*resource_pool_get<0>(pool, handles[i]), i);
+    }
+  }
+}
+
+TEST_F(ResourcePoolTest, FullPoolRefusesInserts) {
+  create(2);
+  resource_pool_insert(&pool, 0U, 0U, size_t{0});
+  resource_pool_insert(&pool, 1U, 1U, size_t{0});
+  testing::internal::CaptureStderr();
+  EXPECT_EQ(resource_pool_insert(&pool, 2U, 2U, size_t{0}), -1);
+  testing::internal::GetCapturedStderr();
+}
+
+// An 11 bit generation used to wrap after 2048 reuses of a slot
+TEST_F(ResourcePoolTest, StaleHandleStaysInvalidAfterManyReuses) {
+  create(1);
+  const auto stale = resource_pool_insert(&pool, 0U, 0U, size_t{0});
+  ASSERT_TRUE(resource_pool_remove(&pool, stale));
+  for (unsigned int i = 1; i <= 5000; ++i) {
+    const auto handle = resource_pool_insert(&pool, i, i, size_t{0});
+    ASSERT_EQ(resource_handle_index(handle), resource_handle_index(stale));
+    ASSERT_FALSE(is_valid(stale)) << "after " << i << " reuses";
+    ASSERT_TRUE(resource_pool_remove(&pool, handle));
+  }
+}
+
+TEST_F(ResourcePoolTest, RetiresSlotInsteadOfWrappingGeneration) {
+  create(2);
+  const auto first = resource_pool_insert(&pool, 0U, 0U, size_t{0});
+  ASSERT_TRUE(resource_pool_remove(&pool, first));
+  // Skip the 2^31 reuses it takes to get here
+  pool.slot_generations[0] = resource_handle_max_generation;
+  const auto last = resource_pool_insert(&pool, 1U, 1U, size_t{0});
+  ASSERT_EQ(resource_handle_index(last), 0);
+  EXPECT_GT(last, 0);
+  EXPECT_TRUE(is_valid(last));
+  ASSERT_TRUE(resource_pool_remove(&pool, last));
+
+  EXPECT_FALSE(is_valid(first));
+  EXPECT_FALSE(is_valid(last));
+  const auto next = resource_pool_insert(&pool, 2U, 2U, size_t{0});
+  EXPECT_EQ(resource_handle_index(next), 1);
+  EXPECT_EQ(resource_handle_generation(next), 0);
+
+  // Both slots used, one of them retired, so only one resource fits now
+  ASSERT_TRUE(resource_pool_remove(&pool, next));
+  ASSERT_NE(resource_pool_insert(&pool, 3U, 3U, size_t{0}), -1);
+  testing::internal::CaptureStderr();
+  EXPECT_EQ(resource_pool_insert(&pool, 4U, 4U, size_t{0}), -1);
+  testing::internal::GetCapturedStderr();
+}
+
+// Millions of random creates and destroys checked against a plain list of
+// live resources
+TEST_F(ResourcePoolTest, StressCreateAndDestroy) {
+  static constexpr int capacity = 4096;
+  static constexpr int num_operations = 4'000'000;
+  create(capacity);
+
+  std::mt19937 random(42);
+  std::vector<LiveMesh> live;
+  unsigned int next_vbo = 1;
+  int num_created = 0;
+  int num_destroyed = 0;
+  for (int operation = 0; operation < num_operations; ++operation) {
+    const bool create_mesh =
+        live.empty() ||
+        (static_cast<int>(live.size()) < capacity && random() % 2 == 0);
+    if (create_mesh) {
+      const auto handle =
+          resource_pool_insert(&pool, next_vbo, next_vbo, size_t{6});
+      ASSERT_NE(handle, -1);
+      live.push_back(LiveMesh{.handle = handle, .vbo = next_vbo});
+      ++next_vbo;
+      ++num_created;
+    } else {
+      const auto i = random() % live.size();
+      const auto mesh = live[i];
+      live[i] = live.back();
+      live.pop_back();
+      ASSERT_TRUE(resource_pool_remove(&pool, mesh.handle));
+      ++num_destroyed;
+      if (operation % 1024 == 0) {
+        ASSERT_FALSE(is_valid(mesh.handle));
+      }
+    }
+
+    if (operation % 100'000 == 0) {
+      ASSERT_EQ(pool.count, static_cast<int>(live.size()));
+      for (const auto &mesh : live) {
+        const auto *vbo = resource_pool_get<0>(pool, mesh.handle);
+        ASSERT_NE(vbo, nullptr);
+        ASSERT_EQ(*vbo, mesh.vbo);
+      }
+    }
+  }
+
+  EXPECT_GE(num_created, 1'000'000);
+  EXPECT_EQ(num_released, num_destroyed);
+  EXPECT_LE(pool.num_slots, capacity);
+  EXPECT_EQ(pool.count, static_cast<int>(live.size()));
+}
+}  // namespace
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <string>
+
+#include "jtr/text_batch_queue.h"
+
+namespace {
+constexpr int charcode_begin = 32;
+constexpr int charcode_count = 95;
+
+// Printable ASCII with every glyph 8x10 atlas pixels advancing by 9
+auto make_font_data(std::array<stbtt_packedchar, charcode_count> &packed_chars,
+                    std::array<stbtt_aligned_quad, charcode_count>
+                        &aligned_quads) -> FontData {
+  for (int i = 0; i < charcode_count; ++i) {
+    packed_chars[i] = stbtt_packedchar{};
+    packed_chars[i].x1 = 8;
+    packed_chars[i].y1 = 10;
+    packed_chars[i].yoff = -10.0F;
+    packed_chars[i].xadvance = 9.0F;
+    aligned_quads[i] = stbtt_aligned_quad{};
+    aligned_quads[i].s1 = 0.1F;
+    aligned_quads[i].t1 = 0.1F;
+  }
+  return FontData{.valid = true,
+                  .bitmap = nullptr,
+                  .packed_chars = packed_chars.data(),
+                  .aligned_quads = aligned_quads.data(),
+                  .charcode_begin = charcode_begin,
+                  .charcode_count = charcode_count};
+}
+
+class TextBatchQueueTest : public testing::Test {
+ protected:
+  std::array<stbtt_packedchar, charcode_count> packed_chars{};
+  std::array<stbtt_aligned_quad, charcode_count> aligned_quads{};
+  FontData font_data = make_font_data(packed_chars, aligned_quads);
+  TextBatchQueue queue{};
+
+  auto create(const size_t max_num_glyphs, const int max_num_runs) -> void {
+    queue = text_batch_queue_create(max_num_glyphs, max_num_runs);
+    ASSERT_TRUE(queue.valid);
+  }
+
+  auto TearDown() -> void override {
+    if (queue.valid) {
+      text_batch_queue_destroy(&queue);
+    }
+  }
+
+  // What text_batch_push does, taking the queue where it would flush
+  auto push(const std::string &text, const ResourceHandle atlas) -> void {
+    ASSERT_TRUE(text_batch_queue_layout(&queue, font_data, glm::vec2(0.0F),
+                                        text, 1.0F, 1.0F));
+    if (!text_batch_queue_append_layout(&queue, atlas)) {
+      text_batch_queue_take(&queue);
+      ASSERT_TRUE(text_batch_queue_append_layout(&queue, atlas));
+    }
+  }
+};
+
+TEST_F(TextBatchQueueTest, ThousandsOfStringsInOneAtlasDrawOnce) {
+  create(16384, 64);
+  text_batch_queue_begin(&queue);
+  size_t num_glyphs = 0;
+  for (int i = 0; i < 1000; ++i) {
+    const auto text = "Label " + std::to_string(i);
+    push(text, 1);
+    num_glyphs += text.size();
+  }
+  const auto draws = text_batch_queue_take(&queue);
+
+  ASSERT_EQ(draws.num_runs, 1);
+  EXPECT_EQ(draws.runs[0].atlas, 1);
+  EXPECT_EQ(draws.runs[0].first_glyph, 0U);
+  EXPECT_EQ(draws.runs[0].num_glyphs, num_glyphs);
+  EXPECT_EQ(draws.num_glyphs, num_glyphs);
+  EXPECT_EQ(queue.stats.flushes, 1);
+  EXPECT_EQ(queue.stats.draws, 1);
+  EXPECT_EQ(queue.stats.num_glyphs, num_glyphs);
+}
+
+TEST_F(TextBatchQueueTest, DrawsPerFrameDontGrowWithStrings) {
+  create(16384, 64);
+  for (const int num_strings : {10, 100, 1000}) {
+    text_batch_queue_begin(&queue);
+    // Every atlas change starts a run, they're only limited by max_num_runs
+    for (int i = 0; i < num_strings; ++i) {
+      push("Label", i < num_strings / 2 ? 1 : 2);
+    }
+    text_batch_queue_take(&queue);
+
+    EXPECT_EQ(queue.stats.flushes, 1) << num_strings << " strings";
+    EXPECT_EQ(queue.stats.draws, 2) << num_strings << " strings";
+  }
+}
+
+TEST_F(TextBatchQueueTest, InterleavedAtlasesAreGroupedIntoOneRangeEach) {
+  create(16384, 512);
+  text_batch_queue_begin(&queue);
+  // Each string starts at a different x, so its quads can be told apart
+  for (int i = 0; i < 300; ++i) {
+    ASSERT_TRUE(text_batch_queue_layout(
+        &queue, font_data, glm::vec2(static_cast<float>(i), 0.0F), "ab", 1.0F,
+        1.0F));
+    ASSERT_TRUE(text_batch_queue_append_layout(&queue, 3 - i % 3));
+  }
+  const auto draws = text_batch_queue_take(&queue);
+
+  ASSERT_EQ(draws.num_runs, 3);
+  size_t first_glyph = 0;
+  for (int run = 0; run < draws.num_runs; ++run) {
+    const auto atlas = run + 1;
+    EXPECT_EQ(draws.runs[run].atlas, atlas);
+    EXPECT_EQ(draws.runs[run].first_glyph, first_glyph);
+    EXPECT_EQ(draws.runs[run].num_glyphs, 200U);
+    // Strings of an atlas keep the order they were queued in
+    for (size_t string = 0; string < 100; ++string) {
+      const auto i = static_cast<float>(string * 3 + (3 - atlas));
+      const auto &top_left =
+          draws.vertices[(first_glyph + string * 2) * 4 + 1];
+      EXPECT_EQ(top_left.position.x, i);
+    }
+    first_glyph += draws.runs[run].num_glyphs;
+  }
+  EXPECT_EQ(queue.stats.draws, 3);
+}
+
+TEST_F(TextBatchQueueTest, FullQueueRefusesGlyphsUntilTaken) {
+  create(8, 64);
+  text_batch_queue_begin(&queue);
+  ASSERT_TRUE(text_batch_queue_layout(&queue, font_data, glm::vec2(0.0F),
+                                      "hello", 1.0F, 1.0F));
+  EXPECT_TRUE(text_batch_queue_append_layout(&queue, 1));
+  EXPECT_FALSE(text_batch_queue_append_layout(&queue, 1));
+  EXPECT_EQ(queue.num_glyphs, 5U);
+
+  EXPECT_EQ(text_batch_queue_take(&queue).num_glyphs, 5U);
+  EXPECT_TRUE(text_batch_queue_append_layout(&queue, 1));
+  text_batch_queue_take(&queue);
+  EXPECT_EQ(queue.stats.flushes, 2);
+  EXPECT_EQ(queue.stats.draws, 2);
+}
+
+TEST_F(TextBatchQueueTest, RunLimitOnlyCountsNewAtlases) {
+  create(64, 2);
+  text_batch_queue_begin(&queue);
+  const Vertex quad_vertices[4] = {};
+  EXPECT_TRUE(text_batch_queue_append_quad(&queue, 1, quad_vertices));
+  EXPECT_TRUE(text_batch_queue_append_quad(&queue, 2, quad_vertices));
+  // Extends the last run
+  EXPECT_TRUE(text_batch_queue_append_quad(&queue, 2, quad_vertices));
+  EXPECT_FALSE(text_batch_queue_append_quad(&queue, 3, quad_vertices));
+
+  const auto draws = text_batch_queue_take(&queue);
+  EXPECT_EQ(draws.num_glyphs, 3U);
+  EXPECT_EQ(draws.num_runs, 2);
+}
+
+TEST_F(TextBatchQueueTest, EmptyQueueDoesntCountAFlush) {
+  create(64, 2);
+  text_batch_queue_begin(&queue);
+  const auto draws = text_batch_queue_take(&queue);
+  EXPECT_EQ(draws.num_glyphs, 0U);
+  EXPECT_EQ(draws.num_runs, 0);
+  EXPECT_EQ(queue.stats.flushes, 0);
+}
+}  // namespace
@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "jtr/text_layout.h"
+#include "jtr/utf8.h"
+
+namespace {
+constexpr int charcode_begin = 32;
+// Up to the end of Cyrillic, so the corpus has 2 byte sequences too
+constexpr int charcode_count = 0x500 - charcode_begin;
+constexpr size_t corpus_size = 1 << 20;
+
+// Every glyph 8x10 atlas pixels advancing by 9
+struct FakeFont {
+  std::vector<stbtt_packedchar> packed_chars;
+  std::vector<stbtt_aligned_quad> aligned_quads;
+
+  FakeFont()
+      : packed_chars(charcode_count), aligned_quads(charcode_count) {
+    for (auto &packed_char : packed_chars) {
+      packed_char = stbtt_packedchar{};
+      packed_char.x1 = 8;
+      packed_char.y1 = 10;
+      packed_char.yoff = -10.0F;
+      packed_char.xadvance = 9.0F;
+    }
+    for (auto &aligned_quad : aligned_quads) {
+      aligned_quad = stbtt_aligned_quad{};
+      aligned_quad.s1 = 0.1F;
+      aligned_quad.t1 = 0.1F;
+    }
+  }
+
+  [[nodiscard]] auto data() const -> FontData {
+    return FontData{.valid = true,
+                    .bitmap = nullptr,
+                    .packed_chars = packed_chars.data(),
+                    .aligned_quads = aligned_quads.data(),
+                    .charcode_begin = charcode_begin,
+                    .charcode_count = charcode_count};
+  }
+};
+
+// 1 MB of mixed ASCII, Latin-1, Greek and Cyrillic, cut at a codepoint
+auto make_corpus() -> std::string {
+  static const std::string paragraph =
+      "The quick brown fox jumps over the lazy dog. Größe café naïve "
+      "façade. λόγος και ήθος. Съешь же ещё этих мягких французских "
+      "булок. ";
+  std::string corpus;
+  corpus.reserve(corpus_size + paragraph.size());
+  while (corpus.size() + paragraph.size() <= corpus_size) {
+    corpus += paragraph;
+  }
+  return corpus;
+}
+
+auto BM_Utf8Decode(benchmark::State &state) -> void {
+  const auto corpus = make_corpus();
+  std::vector<char32_t> codepoints(corpus.size());
+  ptrdiff_t num_codepoints = 0;
+  for (auto _ : state) {
+    num_codepoints =
+        utf8_decode(corpus.data(), corpus.size(), codepoints.data());
+    benchmark::DoNotOptimize(codepoints.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() *
+                                               corpus.size()));
+  state.counters["codepoints/s"] = benchmark::Counter(
+      static_cast<double>(num_codepoints) *
+          static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Utf8Decode);
+
+auto BM_TextLayoutBuild(benchmark::State &state) -> void {
+  const FakeFont font;
+  const auto corpus = make_corpus();
+  auto layout = text_layout_create(corpus.size());
+  for (auto _ : state) {
+    if (!text_layout_build(&layout, font.data(), glm::vec2(0.0F),
+                           corpus.data(), corpus.size(), 1.0F, 1.0F)) {
+      state.SkipWithError("Could not lay out corpus");
+      break;
+    }
+    benchmark::DoNotOptimize(layout.x0s);
+  }
+  state.counters["glyphs/s"] = benchmark::Counter(
+      static_cast<double>(layout.num_glyphs) *
+          static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  text_layout_destroy(&layout);
+}
+BENCHMARK(BM_TextLayoutBuild);
+
+// Layout plus the AoS vertices the batch uploads
+auto BM_TextLayoutBuildAndWrite(benchmark::State &state) -> void {
+  const FakeFont font;
+  const auto corpus = make_corpus();
+  auto layout = text_layout_create(corpus.size());
+  std::vector<Vertex> vertices(corpus.size() * 4);
+  for (auto _ : state) {
+    if (!text_layout_build(&layout, font.data(), glm::vec2(0.0F),
+                           corpus.data(), corpus.size(), 1.0F, 1.0F)) {
+      state.SkipWithError("Could not lay out corpus");
+      break;
+    }
+    text_layout_write_vertices(layout, vertices.data());
+    benchmark::DoNotOptimize(vertices.data());
+  }
+  state.counters["glyphs/s"] = benchmark::Counter(
+      static_cast<double>(layout.num_glyphs) *
+          static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  text_layout_destroy(&layout);
+}
+BENCHMARK(BM_TextLayoutBuildAndWrite);
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "jtr/text_layout.h"
+
+namespace {
+constexpr int charcode_begin = 32;
+constexpr int charcode_count = 95;
+constexpr float size = 1.7F;
+constexpr float pixel_scale = 0.013F;
+
+// Printable ASCII, every glyph with its own metrics so rounding differs
+struct FakeFont {
+  std::vector<stbtt_packedchar> packed_chars;
+  std::vector<stbtt_aligned_quad> aligned_quads;
+
+  FakeFont()
+      : packed_chars(charcode_count), aligned_quads(charcode_count) {
+    for (int i = 0; i < charcode_count; ++i) {
+      auto &packed_char = packed_chars[i];
+      packed_char = stbtt_packedchar{};
+      packed_char.x1 = static_cast<unsigned short>(3 + i % 7);
+      packed_char.y1 = static_cast<unsigned short>(5 + i % 11);
+      packed_char.xoff = 0.3F * static_cast<float>(i % 5);
+      packed_char.yoff = -0.5F - static_cast<float>(i % 13);
+      packed_char.xadvance = 4.1F + 0.7F * static_cast<float>(i % 3);
+      auto &aligned_quad = aligned_quads[i];
+      aligned_quad = stbtt_aligned_quad{};
+      aligned_quad.s0 = 0.01F * static_cast<float>(i);
+      aligned_quad.s1 = aligned_quad.s0 + 0.01F;
+      aligned_quad.t1 = 0.1F;
+    }
+  }
+
+  [[nodiscard]] auto data() const -> FontData {
+    return FontData{.valid = true,
+                    .bitmap = nullptr,
+                    .packed_chars = packed_chars.data(),
+                    .aligned_quads = aligned_quads.data(),
+                    .charcode_begin = charcode_begin,
+                    .charcode_count = charcode_count};
+  }
+};
+
+auto same_bytes(const float a, const float b) -> bool {
+  return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+class TextLayoutTest : public testing::Test {
+ protected:
+  FakeFont font;
+  TextLayout layout{};
+  TextLayout glyph_layout{};
+
+  auto SetUp() -> void override {
+    layout = text_layout_create(64);
+    glyph_layout = text_layout_create(1);
+    ASSERT_TRUE(layout.valid && glyph_layout.valid);
+  }
+
+  auto TearDown() -> void override {
+    text_layout_destroy(&layout);
+    text_layout_destroy(&glyph_layout);
+  }
+};
+
+// Lengths up to several SIMD blocks, each with every tail length. A layout
+// of a single glyph never fills a block, so it runs the scalar path only.
+TEST_F(TextLayoutTest, SimdPositionsMatchTheScalarPath) {
+  const glm::vec2 position(-0.93F, 0.41F);
+  for (size_t length = 1; length <= 40; ++length) {
+    std::string text;
+    for (size_t i = 0; i < length; ++i) {
+      text += static_cast<char>(charcode_begin + (i * 37) % charcode_count);
+    }
+    ASSERT_TRUE(text_layout_build(&layout, font.data(), position, text.data(),
+                                  text.size(), size, pixel_scale));
+    ASSERT_EQ(layout.num_glyphs, length);
+
+    for (size_t i = 0; i < length; ++i) {
+      ASSERT_TRUE(text_layout_build(
+          &glyph_layout, font.data(),
+          glm::vec2(layout.pen_xs[i], position.y), &text[i], 1, size,
+          pixel_scale));
+      EXPECT_TRUE(same_bytes(layout.x0s[i], glyph_layout.x0s[0]))
+          << "glyph " << i << " of " << length;
+      EXPECT_TRUE(same_bytes(layout.y0s[i], glyph_layout.y0s[0]))
+          << "glyph " << i << " of " << length;
+      EXPECT_TRUE(same_bytes(layout.x1s[i], glyph_layout.x1s[0]))
+          << "glyph " << i << " of " << length;
+      EXPECT_TRUE(same_bytes(layout.y1s[i], glyph_layout.y1s[0]))
+          << "glyph " << i << " of " << length;
+    }
+  }
+}
+
+TEST_F(TextLayoutTest, PenAdvancesByEveryPreviousGlyph) {
+  const std::string text = "Ab!";
+  ASSERT_TRUE(text_layout_build(&layout, font.data(), glm::vec2(0.0F),
+                                text.data(), text.size(), size, pixel_scale));
+
+  const float scale = pixel_scale * size;
+  float pen_x = 0.0F;
+  for (size_t i = 0; i < text.size(); ++i) {
+    EXPECT_FLOAT_EQ(layout.pen_xs[i], pen_x);
+    pen_x += font.packed_chars[text[i] - charcode_begin].xadvance * scale;
+  }
+}
+
+TEST_F(TextLayoutTest, RejectsTextNotInTheFont) {
+  testing::internal::CaptureStderr();
+  const std::string invalid = "A\xC3";
+  const bool built_invalid =
+      text_layout_build(&layout, font.data(), glm::vec2(0.0F), invalid.data(),
+                        invalid.size(), size, pixel_scale);
+  const std::string missing = "A\xC3\xA9";
+  const bool built_missing =
+      text_layout_build(&layout, font.data(), glm::vec2(0.0F), missing.data(),
+                        missing.size(), size, pixel_scale);
+  testing::internal::GetCapturedStderr();
+
+  EXPECT_FALSE(built_invalid);
+  EXPECT_FALSE(built_missing);
+  EXPECT_EQ(layout.num_glyphs, 0U);
+}
+}  // namespace
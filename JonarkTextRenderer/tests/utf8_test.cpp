@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "jtr/utf8.h"
+
+namespace {
+// Codepoints of the text, none if it isn't valid
+struct Decoded {
+  bool valid;
+  std::vector<char32_t> codepoints;
+};
+
+auto decode(const std::string &text) -> Decoded {
+  std::vector<char32_t> codepoints(text.size());
+  const auto num_codepoints =
+      utf8_decode(text.data(), text.size(), codepoints.data());
+  if (num_codepoints < 0) {
+    return Decoded{.valid = false, .codepoints = {}};
+  }
+  codepoints.resize(static_cast<size_t>(num_codepoints));
+  return Decoded{.valid = true, .codepoints = codepoints};
+}
+
+// Failures are reported on stderr, keep it out of the test output
+auto decode_quietly(const std::string &text) -> Decoded {
+  testing::internal::CaptureStderr();
+  auto decoded = decode(text);
+  testing::internal::GetCapturedStderr();
+  return decoded;
+}
+
+TEST(Utf8DecodeTest, DecodesEverySequenceLength) {
+  const auto decoded = decode("A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+
+  ASSERT_TRUE(decoded.valid);
+  EXPECT_EQ(decoded.codepoints,
+            (std::vector<char32_t>{U'A', U'é', U'€', U'\U0001F600'}));
+}
+
+TEST(Utf8DecodeTest, AcceptsTheEdgesOfEveryRange) {
+  const std::vector<std::pair<std::string, char32_t>> edges = {
+      {"\x7F", 0x7F},
+      {"\xC2\x80", 0x80},
+      {"\xDF\xBF", 0x7FF},
+      {"\xE0\xA0\x80", 0x800},
+      {"\xED\x9F\xBF", 0xD7FF},
+      {"\xEE\x80\x80", 0xE000},
+      {"\xEF\xBF\xBF", 0xFFFF},
+      {"\xF0\x90\x80\x80", 0x10000},
+      {"\xF4\x8F\xBF\xBF", 0x10FFFF}};
+  for (const auto &[text, codepoint] : edges) {
+    const auto decoded = decode(text);
+    ASSERT_TRUE(decoded.valid) << std::hex << static_cast<uint32_t>(codepoint);
+    EXPECT_EQ(decoded.codepoints, std::vector{codepoint});
+  }
+}
+
+TEST(Utf8DecodeTest, RejectsOverlongEncodings) {
+  // '/' and U+0000 in more bytes than needed
+  for (const auto *text : {"\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF",
+                           "\xE0\x9F\xBF", "\xF0\x80\x80\xAF",
+                           "\xF0\x8F\xBF\xBF"}) {
+    EXPECT_FALSE(decode_quietly(text).valid);
+  }
+  EXPECT_FALSE(decode_quietly(std::string("\xC0\x80", 2)).valid);
+}
+
+TEST(Utf8DecodeTest, RejectsSurrogates) {
+  for (const auto *text : {"\xED\xA0\x80", "\xED\xAF\xBF", "\xED\xB0\x80",
+                           "\xED\xBF\xBF"}) {
+    EXPECT_FALSE(decode_quietly(text).valid);
+  }
+}
+
+TEST(Utf8DecodeTest, RejectsCodepointsAboveTheLast) {
+  // U+110000 and lead bytes that can only start one
+  for (const auto *text : {"\xF4\x90\x80\x80", "\xF7\xBF\xBF\xBF",
+                           "\xF8\x88\x80\x80\x80", "\xFF"}) {
+    EXPECT_FALSE(decode_quietly(text).valid);
+  }
+}
+
+TEST(Utf8DecodeTest, RejectsTruncatedSequences) {
+  for (const auto *text : {"\xC3", "\xE2\x82", "\xF0\x9F\x98", "A\xE2\x82",
+                           "\xE2\x82" "A", "\x80"}) {
+    EXPECT_FALSE(decode_quietly(text).valid);
+  }
+}
+
+// The ASCII fast path widens whole blocks, the rest is decoded one byte at a
+// time
+TEST(Utf8DecodeTest, AsciiBlocksAndTailDecodeTheSame) {
+  for (size_t length = 0; length <= 40; ++length) {
+    std::string text;
+    std::vector<char32_t> expected;
+    for (size_t i = 0; i < length; ++i) {
+      text += static_cast<char>('!' + i);
+      expected.push_back(static_cast<char32_t>('!' + i));
+    }
+    const auto ascii = decode(text);
+    ASSERT_TRUE(ascii.valid) << length;
+    EXPECT_EQ(ascii.codepoints, expected) << length;
+
+    // A sequence right after the blocks, and one cut off at the end
+    text += "\xC3\xA9";
+    expected.push_back(U'é');
+    const auto mixed = decode(text);
+    ASSERT_TRUE(mixed.valid) << length;
+    EXPECT_EQ(mixed.codepoints, expected) << length;
+    EXPECT_FALSE(decode_quietly(text + "\xE2\x82").valid) << length;
+  }
+}
+}  // namespace
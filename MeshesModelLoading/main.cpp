@@ -1,8 +1,10 @@
+#include <chrono>
 #include <cstdlib>
 #include <exception>
 #include <fstream>
 #include <iostream>
 #include <optional>
+#include <span>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -21,6 +23,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "gl_strings/gl_strings.h"
+#include "mesh_cache/mesh_cache.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 
@@ -173,10 +176,11 @@ using Texture = struct Texture {
 
 class Mesh {
  public:
-  std::vector<Vertex> vertices;
+  size_t num_vertices;
   std::vector<Texture> textures;
   unsigned int vao, vbo;
-  auto setup() -> void;
+  // vertices are only read during setup, they can point into a mesh cache
+  auto setup(std::span<const Vertex> vertices) -> void;
   auto draw(Shader& shader) -> void;
 };
 
@@ -191,8 +195,13 @@ class Model {
   std::vector<Texture> textures_loaded;
 
   auto load_model(const std::string& path) -> void;
-  auto process_node(aiNode* node, const aiScene* scene) -> void;
-  static auto process_mesh(aiMesh* mesh, const aiScene* scene) -> Mesh;
+  // Skips Assimp if the mesh cache of path is up to date, false otherwise
+  auto load_from_cache(const std::string& path) -> bool;
+  // Keeps the vertices of each mesh in mesh_vertices to write the cache
+  auto process_node(aiNode* node, const aiScene* scene,
+                    std::vector<std::vector<Vertex>>& mesh_vertices) -> void;
+  static auto process_mesh(aiMesh* mesh, const aiScene* scene,
+                           std::vector<Vertex>& vertices) -> Mesh;
 
   static auto load_material_textures(aiMaterial* mat, aiTextureType type,
                                      const std::string& type_name)
@@ -205,6 +214,19 @@ class Model {
 Model::Model(const std::string& path) { load_model(path); }
 
 auto Model::load_model(const std::string& path) -> void {
+  const auto start = std::chrono::steady_clock::now();
+  const auto print_elapsed = [&path, &start](const char* source) {
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "Loaded " << path << " " << source << " in "
+              << elapsed.count() << " ms\n";
+  };
+  directory = path.substr(0, path.find_last_of('/'));
+  if (load_from_cache(path)) {
+    print_elapsed("from mesh cache");
+    return;
+  }
+
   Assimp::Importer importer;
 
   const aiScene* scene = importer.ReadFile(
@@ -216,23 +238,65 @@ auto Model::load_model(const std::string& path) -> void {
     printError("ERROR::ASSIMP::", importer.GetErrorString());
     return;
   }
-  directory = path.substr(0, path.find_last_of('/'));
-  process_node(scene->mRootNode, scene);
+  std::vector<std::vector<Vertex>> mesh_vertices;
+  process_node(scene->mRootNode, scene, mesh_vertices);
+
+  std::vector<mesh_cache::MeshData> cache_meshes;
+  for (size_t i = 0; i < meshes.size(); i++) {
+    mesh_cache::MeshData mesh_data;
+    mesh_data.vertices = std::as_bytes(std::span(mesh_vertices[i]));
+    mesh_data.num_vertices = mesh_vertices[i].size();
+    for (const auto& texture : meshes[i].textures) {
+      mesh_data.textures.push_back({texture.type, texture.path});
+    }
+    cache_meshes.push_back(std::move(mesh_data));
+  }
+  if (!mesh_cache::write(mesh_cache::cache_path_for(path), path,
+                         sizeof(Vertex), cache_meshes)) {
+    printError("Could not write mesh cache of ", path, "\n");
+  }
+  print_elapsed("with Assimp");
 }
 
-auto Model::process_node(aiNode* node, const aiScene* scene) -> void {
+auto Model::load_from_cache(const std::string& path) -> bool {
+  const auto cache = mesh_cache::MeshCache::open(
+      mesh_cache::cache_path_for(path), path, sizeof(Vertex));
+  if (!cache) {
+    return false;
+  }
+  for (const auto& cached_mesh : cache->meshes()) {
+    Mesh mesh;
+    mesh.num_vertices = cached_mesh.num_vertices;
+    for (const auto& cached_texture : cached_mesh.textures) {
+      Texture texture;
+      texture.id = create_texture_from_file("models/" + cached_texture.path);
+      texture.type = cached_texture.type;
+      texture.path = cached_texture.path;
+      mesh.textures.push_back(texture);
+    }
+    // Straight from the mapping, nothing is parsed
+    mesh.setup(std::span(static_cast<const Vertex*>(cached_mesh.vertices),
+                         cached_mesh.num_vertices));
+    meshes.push_back(mesh);
+  }
+  return true;
+}
+
+auto Model::process_node(aiNode* node, const aiScene* scene,
+                         std::vector<std::vector<Vertex>>& mesh_vertices)
+    -> void {
   for (unsigned int i = 0; i < node->mNumMeshes; i++) {
     aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-    meshes.push_back(process_mesh(mesh, scene));
+    meshes.push_back(process_mesh(mesh, scene, mesh_vertices.emplace_back()));
   }
 
   for (unsigned int i = 0; i < node->mNumChildren; i++) {
-    process_node(node->mChildren[i], scene);
+    process_node(node->mChildren[i], scene, mesh_vertices);
   }
 }
 
-auto Model::process_mesh(aiMesh* mesh, const aiScene* scene) -> Mesh {
-  std::vector<Vertex> vertices;
+auto Model::process_mesh(aiMesh* mesh, const aiScene* scene,
+                         std::vector<Vertex>& vertices) -> Mesh {
   // std::vector<unsigned int> indices;
   std::vector<Texture> textures;
 
@@ -269,9 +333,9 @@ auto Model::process_mesh(aiMesh* mesh, const aiScene* scene) -> Mesh {
   }
 
   Mesh processed_mesh;
-  processed_mesh.vertices = vertices;
+  processed_mesh.num_vertices = vertices.size();
   processed_mesh.textures = textures;
-  processed_mesh.setup();
+  processed_mesh.setup(vertices);
   return processed_mesh;
 }
 
@@ -327,15 +391,14 @@ auto Model::create_texture_from_file(const std::string& filename)
   return textures[0];
 }
 
-auto Mesh::setup() -> void {
+auto Mesh::setup(std::span<const Vertex> vertices) -> void {
   glCreateVertexArrays(1, &vao);
   glCreateBuffers(1, &vbo);
 
   // Load Model
   stbi_set_flip_vertically_on_load(1);
 
-  glNamedBufferStorage(vbo,
-                       static_cast<long long>(vertices.size() * sizeof(Vertex)),
+  glNamedBufferStorage(vbo, static_cast<long long>(vertices.size_bytes()),
                        vertices.data(), 0);
 
   glBindVertexArray(vao);
@@ -371,7 +434,7 @@ auto Mesh::draw(Shader& shader) -> void {
   }
 
   glBindVertexArray(vao);
-  glDrawArrays(GL_TRIANGLES, 0, static_cast<int>(vertices.size()));
+  glDrawArrays(GL_TRIANGLES, 0, static_cast<int>(num_vertices));
   glBindVertexArray(0);
   glActiveTexture(GL_TEXTURE0);
 }
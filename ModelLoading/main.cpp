@@ -1,8 +1,10 @@
+#include <chrono>
 #include <cstdlib>
 #include <exception>
 #include <fstream>
 #include <iostream>
 #include <optional>
+#include <span>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -19,6 +21,8 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "gl_strings/gl_strings.h"
+#include "mesh_cache/mesh_cache.h"
+#include "mesh_optimizer/mesh_optimizer.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 
@@ -111,6 +115,11 @@ using Vertex = struct Vertex {
   float tex_v;
 };
 
+// Only floats, welded byte for byte by the mesh optimizer
+template <>
+constexpr bool mesh_optimizer::has_no_padding<Vertex> =
+    sizeof(Vertex) == 5 * sizeof(float);
+
 using Texture = struct Texture {
   unsigned int id;
   std::string type;
@@ -186,7 +195,8 @@ auto load_model(const std::string& path)
     aiMesh* mesh = scene->mMeshes[i];
 
     for (unsigned int j = 0; j < mesh->mNumVertices; j++) {
-      Vertex vertex;
+      // Zeroed so vertices without texture coordinates weld
+      Vertex vertex{};
       vertex.x = mesh->mVertices[j].x;
       vertex.y = mesh->mVertices[j].y;
       vertex.z = mesh->mVertices[j].z;
@@ -216,6 +226,84 @@ auto load_model(const std::string& path)
   return {vertices, textures};
 }
 
+// Uploads the vertices and indices of the model at path into vbo and ebo,
+// from its mesh cache if it is up to date or through Assimp otherwise. A cold
+// load welds the flat vertex list into an indexed mesh, reorders it for the
+// vertex caches and writes the mesh cache for the next run. Returns the
+// number of indices and the textures.
+auto upload_model(const std::string& path, unsigned int vbo, unsigned int ebo)
+    -> std::pair<size_t, std::vector<Texture>> {
+  const auto start = std::chrono::steady_clock::now();
+  const auto cache_path = mesh_cache::cache_path_for(path);
+  size_t num_indices = 0;
+  std::vector<Texture> textures;
+
+  const auto cache =
+      mesh_cache::MeshCache::open(cache_path, path, sizeof(Vertex));
+  const bool from_cache = cache && cache->meshes().size() == 1;
+  if (from_cache) {
+    // Straight from the mapping, nothing is parsed
+    const auto& mesh = cache->meshes()[0];
+    num_indices = mesh.num_indices;
+    glNamedBufferStorage(
+        vbo, static_cast<long long>(mesh.num_vertices * sizeof(Vertex)),
+        mesh.vertices, 0);
+    glNamedBufferStorage(
+        ebo, static_cast<long long>(num_indices * sizeof(unsigned int)),
+        mesh.indices, 0);
+    for (const auto& cached_texture : mesh.textures) {
+      Texture texture;
+      texture.id = create_texture_from_file("models/" + cached_texture.path);
+      texture.type = cached_texture.type;
+      texture.path = cached_texture.path;
+      textures.push_back(texture);
+    }
+  } else {
+    auto [vertices, model_textures] = load_model(path);
+    textures = std::move(model_textures);
+    std::vector<unsigned int> indices;
+    const auto optimize_stats =
+        mesh_optimizer::optimize_mesh(vertices, indices);
+    num_indices = indices.size();
+    if (optimize_stats.num_triangles != 0) {
+      std::cout << "Optimized " << path << ": "
+                << optimize_stats.num_vertices_before << " -> "
+                << optimize_stats.num_vertices_after << " vertices, ACMR "
+                << static_cast<double>(optimize_stats.cache_misses_before) /
+                       static_cast<double>(optimize_stats.num_triangles)
+                << " -> "
+                << static_cast<double>(optimize_stats.cache_misses_after) /
+                       static_cast<double>(optimize_stats.num_triangles)
+                << "\n";
+    }
+    glNamedBufferStorage(
+        vbo, static_cast<long long>(vertices.size() * sizeof(Vertex)),
+        vertices.data(), 0);
+    glNamedBufferStorage(
+        ebo, static_cast<long long>(indices.size() * sizeof(unsigned int)),
+        indices.data(), 0);
+
+    // All meshes are drawn as a single triangle list
+    mesh_cache::MeshData mesh_data;
+    mesh_data.vertices = std::as_bytes(std::span(vertices));
+    mesh_data.num_vertices = vertices.size();
+    mesh_data.indices = indices;
+    for (const auto& texture : textures) {
+      mesh_data.textures.push_back({texture.type, texture.path});
+    }
+    if (!mesh_cache::write(cache_path, path, sizeof(Vertex), {mesh_data})) {
+      printError("Could not write mesh cache ", cache_path, "\n");
+    }
+  }
+
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "Loaded " << path
+            << (from_cache ? " from mesh cache" : " with Assimp") << " in "
+            << elapsed.count() << " ms\n";
+  return {num_indices, textures};
+}
+
 auto main() -> int {
   if (glfwInit() != GLFW_TRUE) {
     printError("Initialization failed\n");
@@ -281,17 +369,17 @@ auto main() -> int {
   glCreateVertexArrays(1, vaos);
   unsigned int vbos[1];
   glCreateBuffers(1, vbos);
+  unsigned int ebos[1];
+  glCreateBuffers(1, ebos);
 
   // Load Model
   stbi_set_flip_vertically_on_load(1);
-  const auto [vertices, textures] = load_model("models/spider.obj");
-
-  glNamedBufferStorage(vbos[0],
-                       static_cast<long long>(vertices.size() * sizeof(Vertex)),
-                       vertices.data(), 0);
+  const auto [num_indices, textures] =
+      upload_model("models/spider.obj", vbos[0], ebos[0]);
 
   glBindVertexArray(vaos[0]);
   glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebos[0]);
 
   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
   glEnableVertexAttribArray(0);
@@ -361,7 +449,8 @@ auto main() -> int {
     set_model_matrix(program, y_rotation);
 
     // Draw and swap buffers
-    glDrawArrays(GL_TRIANGLES, 0, static_cast<int>(vertices.size()));
+    glDrawElements(GL_TRIANGLES, static_cast<int>(num_indices),
+                   GL_UNSIGNED_INT, nullptr);
     glfwSwapBuffers(window);
     glfwPollEvents();
   }
@@ -370,6 +459,7 @@ auto main() -> int {
   for (const auto& texture : textures) {
     glDeleteTextures(1, &texture.id);
   }
+  glDeleteBuffers(1, ebos);
   glDeleteBuffers(1, vbos);
   glDeleteVertexArrays(1, vaos);
   glfwDestroyWindow(window);
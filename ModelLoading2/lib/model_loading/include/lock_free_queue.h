@@ -0,0 +1,94 @@
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace model_loading {
+// Bounded multi-producer multi-consumer queue. Each cell carries a sequence
+// number telling whether it is ready to be written or read on the current
+// lap, so producers and consumers only contend on their own position counter.
+template <typename T>
+class LockFreeQueue {
+ private:
+  using Cell = struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  static constexpr size_t cache_line_size = 64;
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  alignas(cache_line_size) std::atomic<size_t> enqueue_position_ = 0;
+  alignas(cache_line_size) std::atomic<size_t> dequeue_position_ = 0;
+
+ public:
+  // capacity is rounded up to a power of two
+  explicit LockFreeQueue(size_t capacity) {
+    size_t rounded_capacity = 2;
+    while (rounded_capacity < capacity) {
+      rounded_capacity *= 2;
+    }
+    cells_ = std::make_unique<Cell[]>(rounded_capacity);
+    mask_ = rounded_capacity - 1;
+    for (size_t i = 0; i < rounded_capacity; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Delete copy constructors
+  LockFreeQueue(const LockFreeQueue&) = delete;
+  auto operator=(const LockFreeQueue&) -> LockFreeQueue& = delete;
+
+  // Returns false if the queue is full, value is left untouched then
+  [[nodiscard]] auto TryPush(T& value) -> bool {
+    size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[position & mask_];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence) -
+                              static_cast<std::ptrdiff_t>(position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          cell.value = std::move(value);
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  [[nodiscard]] auto TryPop() -> std::optional<T> {
+    size_t position = dequeue_position_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[position & mask_];
+      const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence) -
+                              static_cast<std::ptrdiff_t>(position + 1);
+      if (difference == 0) {
+        if (dequeue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          T value = std::move(cell.value);
+          cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+          return value;
+        }
+      } else if (difference < 0) {
+        return std::nullopt;
+      } else {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+};
+}  // namespace model_loading
+
+#endif  // LOCK_FREE_QUEUE_H
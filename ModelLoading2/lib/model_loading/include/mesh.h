@@ -3,44 +3,184 @@
 
 #include <GL/glew.h>
 
+#include <array>
+#include <cstdint>
 #include <expected>
+#include <glm/mat4x4.hpp>
+#include <optional>
+#include <span>
 #include <vector>
 
 #include "error.h"
 #include "program.h"
+#include "vertex.h"
 
 namespace model_loading {
-using Vertex = struct Vertex {
-  glm::vec3 position;
-  glm::vec3 normal;
-  glm::vec2 uv;
-};
-
 using Texture = struct Texture {
-  unsigned int id;
+  // Slot owned by the TextureLoader, holds a placeholder until uploaded
+  const unsigned int *id;
   std::string type;
   std::string path;
 };
 
+// Sampler uniform of a mesh texture, resolved once for a program
+using MaterialBinding = struct MaterialBinding {
+  GLint location;
+  GLuint texture_unit;
+  const GLuint *texture_id;
+};
+
+// What a mesh keeps in CPU memory once its vertices and indices are uploaded
+enum class MeshResidency {
+  // Nothing, the GPU copy is the only one
+  kUploadAndRelease,
+  // Positions and indices, enough to pick triangles
+  kKeepForPicking,
+  // Positions quantized to 16 bits within the mesh bounds, indices in 16
+  // bits when the mesh is small enough
+  kKeepCompressed,
+};
+
+// Layout of the vertex buffer, the VAO attributes follow it
+enum class VertexFormat {
+  // Vertex, 32 bytes of floats
+  kFloat,
+  // PackedVertex, 16 bytes. Needs a vertex shader decoding the attributes,
+  // like shaders/vertex_packed.glsl.
+  kPacked,
+};
+
+// Range of the mesh indices drawing one level of detail, every level uses
+// the same vertices
+using MeshLod = struct MeshLod {
+  size_t first_index;
+  size_t num_indices;
+  // How far the level strays from the full mesh, in model units
+  float error;
+};
+
+// Computed at load, in model space
+using MeshBounds = struct MeshBounds {
+  glm::vec3 min;
+  glm::vec3 max;
+  // Sphere around the center of the box through the furthest vertex
+  glm::vec3 center;
+  float radius;
+};
+
+// Camera a level of detail is selected for
+using LodCamera = struct LodCamera {
+  glm::vec3 position;
+  // Pixels covered by one unit at a distance of one,
+  // viewport height / (2 tan(vertical fov / 2))
+  float projection_scale;
+  // The coarsest level whose error projects to at most this many pixels is
+  // drawn
+  float max_error_pixels;
+};
+
+using MeshMemory = struct MeshMemory {
+  size_t cpu_bytes;
+  size_t gpu_bytes;
+};
+
 class Mesh {
  private:
-  unsigned int vao_;
-  unsigned int vbo_;
-  unsigned int ebo_;
+  unsigned int vao_ = 0;
+  unsigned int vbo_ = 0;
+  unsigned int ebo_ = 0;
+  size_t num_vertices_ = 0;
+  size_t num_indices_ = 0;
+  MeshResidency residency_ = MeshResidency::kUploadAndRelease;
+  VertexFormat format_ = VertexFormat::kFloat;
+  glm::vec3 bounds_min_ = glm::vec3(0.0f);
+  glm::vec3 bounds_max_ = glm::vec3(0.0f);
+  float bounding_radius_ = 0.0f;
+  // kPacked, decoded on the CPU right after packing
+  PackingError packing_error_{};
 
-  void setupMesh();
+  // Finest first, never empty
+  std::vector<MeshLod> lods_;
+  size_t lod_ = 0;
+
+  // Program the material bindings were resolved for
+  unsigned int material_program_id_ = 0;
+  std::vector<MaterialBinding> material_bindings_;
+  // kPacked, bounds the positions are quantized within
+  GLint position_min_location_ = -1;
+  GLint position_extent_location_ = -1;
+
+  // kKeepForPicking
+  std::vector<glm::vec3> positions_;
+  std::vector<unsigned int> indices_;
+  // kKeepCompressed
+  std::vector<std::array<uint16_t, 3>> compressed_positions_;
+  std::vector<uint16_t> compressed_indices_;
+
+  void setupMesh(std::span<const Vertex> vertices,
+                 std::span<const unsigned int> indices);
+  void keepResident(std::span<const Vertex> vertices,
+                    std::span<const unsigned int> indices);
+  [[nodiscard]] auto position(size_t vertex) const -> glm::vec3;
+  [[nodiscard]] auto index(size_t i) const -> unsigned int;
 
  public:
-  std::vector<Vertex> vertices;
-  std::vector<unsigned int> indices;
   std::vector<Texture> textures;
 
-  Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-       std::vector<Texture> textures);
+  // vertices and indices are only read during construction, they can point
+  // into a mapped mesh cache. indices holds every level in lods, a single
+  // level covering all of them if lods is empty.
+  Mesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices,
+       std::vector<MeshLod> lods, std::vector<Texture> textures,
+       MeshResidency residency = MeshResidency::kUploadAndRelease,
+       VertexFormat format = VertexFormat::kFloat);
+
+  // Delete copy constructors
+  Mesh(const Mesh&) = delete;
+  auto operator=(const Mesh&) -> Mesh& = delete;
+
+  // Take ownership of the GL objects
+  Mesh(Mesh&& other) noexcept;
+
+  ~Mesh();
+
+  // Resolves the sampler uniforms of textures in program, and the position
+  // bounds uniforms of packed meshes. Call once after loading, Draw only uses
+  // the resolved bindings.
+  auto BindMaterials(const Program& program) -> void;
+
+  // Picks the level Draw uses from the size its error projects to on screen.
+  // Returns the selected level.
+  auto SelectLod(const glm::mat4& model_matrix, const LodCamera& camera)
+      -> size_t;
+
+  // Expects program to be in use, draws the selected level
+  auto Draw(const Program& program) const -> void;
+
+  [[nodiscard]] auto Residency() const -> MeshResidency;
+
+  [[nodiscard]] auto Bounds() const -> MeshBounds;
+
+  [[nodiscard]] auto Format() const -> VertexFormat;
+
+  // Zero for kFloat meshes
+  [[nodiscard]] auto QuantizationError() const -> PackingError;
+
+  // Of the full resolution level
+  [[nodiscard]] auto NumTriangles() const -> size_t;
+
+  // Of the selected level
+  [[nodiscard]] auto NumDrawnTriangles() const -> size_t;
+
+  [[nodiscard]] auto Lods() const -> const std::vector<MeshLod>&;
+
+  // Corners of a triangle, nullopt if the mesh didn't keep its geometry
+  [[nodiscard]] auto Triangle(size_t triangle) const
+      -> std::optional<std::array<glm::vec3, 3>>;
 
-  auto Draw(const Program& program) -> void;
+  [[nodiscard]] auto Memory() const -> MeshMemory;
 };
 
 }  // namespace model_loading
 
-#endif  // MESH_H
\ No newline at end of file
+#endif  // MESH_H
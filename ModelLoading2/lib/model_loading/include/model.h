@@ -3,27 +3,134 @@
 
 #include <assimp/scene.h>
 
+#include <array>
 #include <vector>
 
+#include "frustum_culling/frustum_culling.h"
 #include "mesh.h"
+#include "mesh_optimizer/mesh_optimizer.h"
+#include "texture_loader.h"
 
 namespace model_loading {
 
+using ModelMemoryReport = struct ModelMemoryReport {
+  size_t num_meshes;
+  size_t num_triangles;
+  // Geometry kept after upload, depends on the residency policy
+  size_t cpu_bytes;
+  // Vertex and index buffers
+  size_t gpu_bytes;
+};
+
+using ModelLoadTimings = struct ModelLoadTimings {
+  // Meshes came from the binary mesh cache, Assimp wasn't used
+  bool from_cache;
+  // Hashing the model file and mapping its mesh cache, on warm loads
+  double cache_read_ms;
+  // Assimp reading and post-processing the file
+  double import_ms;
+  // aiMesh to Vertex and index conversion and optimization, on the thread
+  // pool
+  double convert_ms;
+  // Texture requests and buffer uploads, on the context thread
+  double upload_ms;
+  // Writing the mesh cache, on cold loads
+  double cache_write_ms;
+};
+
+using ModelCullStats = struct ModelCullStats {
+  size_t num_visible;
+  size_t num_culled;
+};
+
+using ModelLodStats = struct ModelLodStats {
+  // Of the visible meshes, with the selected levels of detail
+  size_t num_drawn_triangles;
+  // Of every mesh at full resolution
+  size_t num_triangles;
+  // Meshes drawing each level, finest first
+  std::array<size_t, mesh_optimizer::default_max_num_lods> num_meshes_per_lod;
+};
+
+// Vertices and indices converted from an aiMesh, not uploaded yet
+using MeshGeometry = struct MeshGeometry {
+  std::vector<Vertex> vertices;
+  // Every level of detail one after another
+  std::vector<unsigned int> indices;
+  std::vector<MeshLod> lods;
+  mesh_optimizer::OptimizeStats optimize_stats;
+};
+
 class Model {
  public:
-  explicit Model(const char *path);
+  // Textures keep loading through texture_loader after the constructor
+  // returns, it must outlive the model
+  Model(const char *path, TextureLoader &texture_loader,
+        MeshResidency residency = MeshResidency::kUploadAndRelease,
+        VertexFormat vertex_format = VertexFormat::kFloat);
+
+  // Delete copy constructors
+  Model(const Model &) = delete;
+  auto operator=(const Model &) -> Model & = delete;
+
+  // Releases the textures of the model
+  ~Model();
+  // Resolves material bindings of every mesh, call before Draw
+  auto BindMaterials(const Program &program) -> void;
+  // Keeps the meshes whose bounding box intersects the view frustum for
+  // SelectLods and Draw. clip_from_model is projection * view * model. Until
+  // the first call every mesh is drawn.
+  auto Cull(const glm::mat4 &clip_from_model) -> ModelCullStats;
+  // Selects the level of detail of the meshes kept by Cull, call each frame
+  // before Draw
+  auto SelectLods(const glm::mat4 &model_matrix, const LodCamera &camera)
+      -> ModelLodStats;
+  // Expects program to be in use, draws the meshes kept by Cull, doesn't
+  // allocate
   auto Draw(const Program &program) const -> void;
 
+  [[nodiscard]] auto MemoryReport() const -> ModelMemoryReport;
+
+  [[nodiscard]] auto LoadTimings() const -> ModelLoadTimings;
+
+  // Totals over every mesh, zero on warm loads since the mesh cache stores
+  // meshes already optimized
+  [[nodiscard]] auto OptimizeReport() const -> mesh_optimizer::OptimizeStats;
+
+  // Worst error of the packed vertices over every mesh, zero for
+  // VertexFormat::kFloat
+  [[nodiscard]] auto PackingReport() const -> PackingError;
+
  private:
   std::vector<Mesh> meshes;
   std::string directory;
-  std::vector<Texture> textures_loaded;
+  TextureLoader *texture_loader;
+  // Cache slots this model holds a reference to
+  std::vector<size_t> texture_slots;
+  MeshResidency residency;
+  VertexFormat vertex_format;
+  ModelLoadTimings load_timings{};
+  mesh_optimizer::OptimizeStats optimize_report{};
+  // Bounds of every mesh in model space, computed once loaded
+  frustum_culling::Boxes mesh_bounds;
+  std::vector<uint32_t> visible_meshes;
 
   auto loadModel(const std::string &path) -> void;
-  auto processNode(aiNode *node, const aiScene *scene) -> void;
-  auto processMesh(aiMesh *mesh, const aiScene *scene) -> Mesh;
+  // Skips Assimp if the mesh cache of path is up to date, false otherwise
+  auto loadFromCache(const std::string &path) -> bool;
+  // Flattens the node tree into the meshes to load, in depth first order
+  auto processNode(aiNode *node, const aiScene *scene,
+                   std::vector<aiMesh *> &scene_meshes) -> void;
+  // Welds duplicate vertices, reorders for the vertex caches and builds the
+  // levels of detail. Safe to call from any thread, doesn't touch GL.
+  static auto convertMesh(const aiMesh *mesh) -> MeshGeometry;
+  // Queues textures and uploads, must run on the context thread
+  auto processMesh(aiMesh *mesh, const aiScene *scene,
+                   const MeshGeometry &geometry) -> Mesh;
   auto loadMaterialTextures(aiMaterial *mat, aiTextureType type,
                             std::string typeName) -> std::vector<Texture>;
+  // path is relative to the model, as referenced by its materials
+  auto loadTexture(const std::string &path, std::string type) -> Texture;
 };
 
 }  // namespace model_loading
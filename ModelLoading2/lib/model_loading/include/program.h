@@ -23,9 +23,15 @@ private:
       const std::string& filename) -> std::expected<std::string, Error>;
 
   static auto compile_shader(const GLenum type,
-                             const std::string& filename) -> std::expected<
+                             const std::string& source) -> std::expected<
     GLuint, Error>;
 
+  // Compiles both shaders and links them into a program whose binary can be
+  // cached
+  static auto link_program(const std::string& vertex_shader_source,
+                           const std::string& fragment_shader_source) ->
+    std::expected<GLuint, Error>;
+
 public:
   // Delete copy constructors
   Program(const Program&) = delete;
@@ -36,12 +42,20 @@ public:
 
   ~Program();
 
+  // Loads the program from the binary cache when it was built from the same
+  // sources before, compiles them otherwise
   static auto Create(const std::string& vertex_shader_filename,
                      const std::string& fragment_shader_filename) ->
     std::expected<Program, Error>;
 
   auto Use() const -> void;
 
+  [[nodiscard]] auto Id() const -> unsigned int;
+
+  // Doesn't change the program in use
+  [[nodiscard]] auto UniformLocation(const std::string& uniform_name) const
+      -> std::expected<GLint, Error>;
+
   [[nodiscard]] auto SetUniformMatrix(const std::string& uniform_name,
                                       const glm::mat4& matrix) const ->
     std::expected<
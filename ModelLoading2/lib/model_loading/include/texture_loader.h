@@ -0,0 +1,141 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lock_free_queue.h"
+#include "thread_pool.h"
+
+namespace model_loading {
+using TextureLoaderStats = struct TextureLoaderStats {
+  // Load calls
+  size_t requested;
+  // Loads of a path already in the cache
+  size_t path_hits;
+  // Files with the same content as a cached one under another path
+  size_t content_hits;
+  // Images decoded successfully, one per distinct content
+  size_t decoded;
+  size_t uploaded;
+  size_t failed;
+  size_t uploaded_bytes;
+  // Textures alive on the GPU
+  size_t num_textures;
+};
+
+using TextureReference = struct TextureReference {
+  // Pass to Release once the texture isn't needed anymore
+  size_t slot;
+  // Holds a placeholder until the texture is uploaded, stays valid until the
+  // reference is released
+  const unsigned int *id;
+};
+
+// Process wide texture cache. Decodes images on worker threads and uploads
+// them on the GL thread in Update, within a time budget per call. Textures
+// are shared by canonical path and by content hash, so each distinct image
+// is decoded and uploaded once no matter how many models use it, and deleted
+// when the last reference is released.
+class TextureLoader {
+ private:
+  using DecodedImage = struct DecodedImage {
+    size_t slot;
+    std::string filename;
+    // Slot with the same content, nothing was decoded
+    std::optional<size_t> alias_of;
+    // nullptr if decoding failed
+    std::unique_ptr<unsigned char, void (*)(void *)> data{nullptr, nullptr};
+    int width;
+    int height;
+    std::string error;
+  };
+
+  using TextureSlot = struct TextureSlot {
+    // Canonical path, empty for free slots
+    std::string path;
+    // Load references, plus one per slot aliasing this one
+    size_t num_references;
+    std::optional<uint64_t> content_hash;
+    // Slot whose texture this one shares
+    std::optional<size_t> alias_of;
+    // Result not received by the GL thread yet
+    bool decoding;
+    // Neither uploaded nor failed yet
+    bool pending;
+    bool uploaded;
+    // Aliases received before this slot's texture was uploaded
+    std::vector<size_t> waiting_aliases;
+  };
+
+  unsigned int placeholder_texture_ = 0;
+  // deque keeps slot addresses stable as slots are added, only touched by
+  // the GL thread
+  std::deque<unsigned int> texture_ids_;
+
+  // Guards the slot bookkeeping below and stats_, workers look up and
+  // reference slots by content hash
+  mutable std::mutex mutex_;
+  std::deque<TextureSlot> slots_;
+  std::vector<size_t> free_slots_;
+  std::unordered_map<std::string, size_t> slots_by_path_;
+  std::unordered_map<uint64_t, size_t> slots_by_content_hash_;
+  TextureLoaderStats stats_{};
+  // Slots waiting for their texture, GL thread only
+  size_t num_pending_ = 0;
+
+  // Decoded images the GL thread hasn't uploaded yet
+  LockFreeQueue<std::unique_ptr<DecodedImage>> decoded_;
+  // Makes workers drop images instead of waiting for room in decoded_
+  std::atomic<bool> stopping_ = false;
+  ThreadPool thread_pool_;
+
+  // Reads, hashes and decodes filename, runs on the workers
+  auto decode(size_t slot, const std::string &filename) -> void;
+  auto upload(const DecodedImage &image) -> void;
+  // Expects mutex_ to be held
+  auto releaseLocked(size_t slot) -> void;
+  auto freeSlotLocked(size_t slot) -> void;
+
+ public:
+  // Creates the placeholder texture, the GL context must be current
+  TextureLoader(size_t num_threads, size_t max_num_decoded_in_flight);
+
+  // Delete copy constructors
+  TextureLoader(const TextureLoader &) = delete;
+  auto operator=(const TextureLoader &) -> TextureLoader & = delete;
+
+  // Waits for pending decodes and deletes every texture
+  ~TextureLoader();
+
+  // Returns the cached texture for filename, queueing it for decoding the
+  // first time. Every call takes a reference. Load, Release and Update must
+  // be called from the GL thread.
+  auto Load(const std::string &filename) -> TextureReference;
+
+  // Drops a reference taken by Load, the texture is deleted with the last one
+  auto Release(size_t slot) -> void;
+
+  // Uploads decoded images until budget runs out, at least one per call.
+  // Call once per frame on the GL thread.
+  auto Update(std::chrono::microseconds budget) -> void;
+
+  // Textures requested but not uploaded or failed yet
+  [[nodiscard]] auto NumPending() const -> size_t;
+
+  [[nodiscard]] auto Stats() const -> TextureLoaderStats;
+};
+}  // namespace model_loading
+
+#endif  // TEXTURE_LOADER_H
@@ -0,0 +1,75 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace model_loading {
+// Each worker owns a queue, it takes tasks from the front of its own queue and
+// steals from the back of the others when it runs out. Submitted tasks are
+// spread over the queues round robin.
+class ThreadPool {
+ private:
+  using Task = std::function<void()>;
+
+  using WorkerQueue = struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::atomic<size_t> next_queue_ = 0;
+
+  // Tasks pushed to a queue and not taken yet. Workers only look at it to
+  // decide whether to sleep, pushing and taking tasks doesn't lock anything
+  // but the queue it touches.
+  std::atomic<size_t> queued_ = 0;
+  std::atomic<size_t> num_sleeping_ = 0;
+  // Only taken to sleep and wake up
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+
+  // Queued plus running tasks, done_mutex_ is only taken by Wait and when
+  // the last one finishes
+  std::atomic<size_t> pending_ = 0;
+  std::mutex done_mutex_;
+  std::condition_variable done_;
+
+  std::vector<std::jthread> workers_;
+
+  auto workerLoop(size_t worker) -> void;
+  auto tryPop(size_t worker) -> std::optional<Task>;
+
+ public:
+  explicit ThreadPool(size_t num_threads);
+
+  // Delete copy constructors
+  ThreadPool(const ThreadPool&) = delete;
+  auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+  // Finishes queued tasks before joining the workers
+  ~ThreadPool();
+
+  auto Submit(Task task) -> void;
+
+  // Blocks until every submitted task has run
+  auto Wait() -> void;
+
+  // Runs body(i) for i in [0, count) on the workers and waits for all of them
+  auto ParallelFor(size_t count, const std::function<void(size_t)>& body)
+      -> void;
+
+  [[nodiscard]] auto NumThreads() const -> size_t;
+};
+}  // namespace model_loading
+
+#endif  // THREAD_POOL_H
@@ -0,0 +1,63 @@
+#ifndef VERTEX_H
+#define VERTEX_H
+
+#include <array>
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <span>
+#include <vector>
+
+namespace model_loading {
+using Vertex = struct Vertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 uv;
+};
+
+// 16 bytes instead of the 32 of Vertex, attributes stay 4 byte aligned
+using PackedVertex = struct PackedVertex {
+  // Unsigned normalized within the mesh bounds, the last one is padding
+  std::array<uint16_t, 4> position;
+  // Octahedral encoding, signed normalized
+  std::array<int16_t, 2> normal;
+  // Half floats
+  std::array<uint16_t, 2> uv;
+};
+
+static_assert(sizeof(PackedVertex) == 16);
+
+// Worst decoded error over a set of vertices
+using PackingError = struct PackingError {
+  // In model units
+  float max_position_error;
+  // Angle between the original and decoded normal
+  float max_normal_error_degrees;
+  float max_uv_error;
+};
+
+// normal doesn't need to be normalized, a zero normal is encoded as +Z
+auto EncodeOctahedral(glm::vec3 normal) -> std::array<int16_t, 2>;
+
+auto DecodeOctahedral(std::array<int16_t, 2> encoded) -> glm::vec3;
+
+auto PackVertex(const Vertex& vertex, glm::vec3 bounds_min,
+                glm::vec3 bounds_max) -> PackedVertex;
+
+auto UnpackVertex(const PackedVertex& packed, glm::vec3 bounds_min,
+                  glm::vec3 bounds_max) -> Vertex;
+
+auto PackVertices(std::span<const Vertex> vertices, glm::vec3 bounds_min,
+                  glm::vec3 bounds_max) -> std::vector<PackedVertex>;
+
+// Decodes every packed vertex on the CPU and compares it with the original.
+// Zero normals, used for meshes without normals, can't be packed and are
+// skipped.
+auto MeasurePackingError(std::span<const Vertex> vertices,
+                         std::span<const PackedVertex> packed,
+                         glm::vec3 bounds_min, glm::vec3 bounds_max)
+    -> PackingError;
+
+}  // namespace model_loading
+
+#endif  // VERTEX_H
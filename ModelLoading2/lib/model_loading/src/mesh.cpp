@@ -1,52 +1,178 @@
 #include "mesh.h"
-void model_loading::Mesh::setupMesh() {
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <print>
+#include <utility>
+
+void model_loading::Mesh::setupMesh(
+    const std::span<const Vertex> vertices,
+    const std::span<const unsigned int> indices) {
   glGenVertexArrays(1, &vao_);
-  glGenBuffers(1, &vbo_);
-  glGenBuffers(1, &ebo_);
+  glCreateBuffers(1, &vbo_);
+  glCreateBuffers(1, &ebo_);
+
+  // Immutable storage, filled straight from the source memory. Empty
+  // storage is not allowed.
+  if (format_ == VertexFormat::kPacked) {
+    const auto packed = PackVertices(vertices, bounds_min_, bounds_max_);
+    packing_error_ =
+        MeasurePackingError(vertices, packed, bounds_min_, bounds_max_);
+    if (!packed.empty()) {
+      glNamedBufferStorage(
+          vbo_, static_cast<GLsizeiptr>(packed.size() * sizeof(PackedVertex)),
+          packed.data(), 0);
+    }
+  } else if (!vertices.empty()) {
+    glNamedBufferStorage(vbo_, static_cast<GLsizeiptr>(vertices.size_bytes()),
+                         vertices.data(), 0);
+  }
+  if (!indices.empty()) {
+    glNamedBufferStorage(ebo_, static_cast<GLsizeiptr>(indices.size_bytes()),
+                         indices.data(), 0);
+  }
 
   glBindVertexArray(vao_);
   glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0],
-               GL_STATIC_DRAW);
-
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
-               &indices[0], GL_STATIC_DRAW);
 
-  // vertex positions
   glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-  // vertex normals
   glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                        (void*)offsetof(Vertex, normal));
-  // vertex texture coords
   glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                        (void*)offsetof(Vertex, uv));
+  if (format_ == VertexFormat::kPacked) {
+    // Positions in [0, 1] within the bounds, normals in [-1, 1] on the
+    // octahedron, both decoded by the vertex shader
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE,
+                          sizeof(PackedVertex),
+                          (void*)offsetof(PackedVertex, position));
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex),
+                          (void*)offsetof(PackedVertex, normal));
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+                          (void*)offsetof(PackedVertex, uv));
+  } else {
+    // vertex positions
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    // vertex normals
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void*)offsetof(Vertex, normal));
+    // vertex texture coords
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                          (void*)offsetof(Vertex, uv));
+  }
 
   glBindVertexArray(0);
 }
 
-model_loading::Mesh::Mesh(std::vector<Vertex> vertices,
-                          std::vector<unsigned int> indices,
-                          std::vector<Texture> textures)
-    : vertices(vertices),
-      indices(indices),
-      textures(textures),
-      vao_(0),
-      vbo_(0),
-      ebo_(0) {
-  setupMesh();
+void model_loading::Mesh::keepResident(
+    const std::span<const Vertex> vertices,
+    const std::span<const unsigned int> indices) {
+  switch (residency_) {
+    case MeshResidency::kUploadAndRelease:
+      break;
+    case MeshResidency::kKeepForPicking:
+      positions_.reserve(vertices.size());
+      for (const auto& vertex : vertices) {
+        positions_.push_back(vertex.position);
+      }
+      indices_.assign(indices.begin(), indices.end());
+      break;
+    case MeshResidency::kKeepCompressed: {
+      const auto extent = bounds_max_ - bounds_min_;
+      compressed_positions_.reserve(vertices.size());
+      for (const auto& vertex : vertices) {
+        std::array<uint16_t, 3> quantized{};
+        for (int axis = 0; axis < 3; ++axis) {
+          const float t = extent[axis] > 0.0f
+                              ? (vertex.position[axis] - bounds_min_[axis]) /
+                                    extent[axis]
+                              : 0.0f;
+          quantized[axis] = static_cast<uint16_t>(t * 65535.0f + 0.5f);
+        }
+        compressed_positions_.push_back(quantized);
+      }
+      if (vertices.size() <= std::numeric_limits<uint16_t>::max() + 1u) {
+        compressed_indices_.assign(indices.begin(), indices.end());
+      } else {
+        indices_.assign(indices.begin(), indices.end());
+      }
+      break;
+    }
+  }
 }
 
-auto model_loading::Mesh::Draw(const Program& program)
-    -> void {
+model_loading::Mesh::Mesh(const std::span<const Vertex> vertices,
+                          const std::span<const unsigned int> indices,
+                          std::vector<MeshLod> lods,
+                          std::vector<Texture> textures,
+                          const MeshResidency residency,
+                          const VertexFormat format)
+    : num_vertices_(vertices.size()),
+      num_indices_(indices.size()),
+      residency_(residency),
+      format_(format),
+      lods_(std::move(lods)),
+      textures(std::move(textures)) {
+  if (lods_.empty()) {
+    lods_.push_back(MeshLod{
+        .first_index = 0, .num_indices = indices.size(), .error = 0.0f});
+  }
+  if (!vertices.empty()) {
+    bounds_min_ = vertices[0].position;
+    bounds_max_ = vertices[0].position;
+  }
+  for (const auto& vertex : vertices) {
+    bounds_min_ = glm::min(bounds_min_, vertex.position);
+    bounds_max_ = glm::max(bounds_max_, vertex.position);
+  }
+  const glm::vec3 center = (bounds_min_ + bounds_max_) * 0.5f;
+  for (const auto& vertex : vertices) {
+    bounding_radius_ =
+        std::max(bounding_radius_, glm::length(vertex.position - center));
+  }
+  setupMesh(vertices, indices);
+  // Picking only needs the full resolution level
+  keepResident(vertices,
+               indices.subspan(lods_[0].first_index, lods_[0].num_indices));
+}
+
+model_loading::Mesh::Mesh(Mesh&& other) noexcept
+    : num_vertices_(other.num_vertices_),
+      num_indices_(other.num_indices_),
+      residency_(other.residency_),
+      format_(other.format_),
+      bounds_min_(other.bounds_min_),
+      bounds_max_(other.bounds_max_),
+      bounding_radius_(other.bounding_radius_),
+      packing_error_(other.packing_error_),
+      lods_(std::move(other.lods_)),
+      lod_(other.lod_),
+      material_bindings_(std::move(other.material_bindings_)),
+      position_min_location_(other.position_min_location_),
+      position_extent_location_(other.position_extent_location_),
+      positions_(std::move(other.positions_)),
+      indices_(std::move(other.indices_)),
+      compressed_positions_(std::move(other.compressed_positions_)),
+      compressed_indices_(std::move(other.compressed_indices_)),
+      textures(std::move(other.textures)) {
+  std::swap(vao_, other.vao_);
+  std::swap(vbo_, other.vbo_);
+  std::swap(ebo_, other.ebo_);
+  std::swap(material_program_id_, other.material_program_id_);
+}
+
+model_loading::Mesh::~Mesh() {
+  glDeleteVertexArrays(1, &vao_);
+  glDeleteBuffers(1, &vbo_);
+  glDeleteBuffers(1, &ebo_);
+}
+
+auto model_loading::Mesh::BindMaterials(const Program& program) -> void {
+  material_bindings_.clear();
+  material_bindings_.reserve(textures.size());
   unsigned int diffuseNbr = 0;
   unsigned int specularNbr = 0;
   for (unsigned int i = 0; i < textures.size(); i++) {
-    glActiveTexture(GL_TEXTURE0 + i);  // Set texture unit before binding
     std::string number;
     std::string name = textures[i].type;
     if (name == "texture_diffuse") {
@@ -54,12 +180,147 @@ auto model_loading::Mesh::Draw(const Program& program)
     } else if (name == "texture_specular")
       number = std::to_string(specularNbr++);
 
-    program.SetUniform1I(("material." + name + number).c_str(), i);
-    glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    // Samplers the program doesn't use are skipped
+    const auto location = program.UniformLocation("material." + name + number);
+    if (!location) {
+      continue;
+    }
+    material_bindings_.push_back(MaterialBinding{.location = *location,
+                                                 .texture_unit = i,
+                                                 .texture_id = textures[i].id});
+  }
+  if (format_ == VertexFormat::kPacked) {
+    const auto position_min = program.UniformLocation("uPositionMin");
+    const auto position_extent = program.UniformLocation("uPositionExtent");
+    if (!position_min || !position_extent) {
+      std::println(std::cerr,
+                   "Program {} can't decode packed vertices, it lacks "
+                   "uPositionMin or uPositionExtent",
+                   program.Id());
+    }
+    position_min_location_ = position_min.value_or(-1);
+    position_extent_location_ = position_extent.value_or(-1);
+  }
+  material_program_id_ = program.Id();
+}
+
+auto model_loading::Mesh::SelectLod(const glm::mat4& model_matrix,
+                                    const LodCamera& camera) -> size_t {
+  // Distance to the closest point of the bounding sphere, errors scale with
+  // the largest scale of the model matrix
+  const glm::vec3 center = (bounds_min_ + bounds_max_) * 0.5f;
+  const float scale = std::max({glm::length(glm::vec3(model_matrix[0])),
+                                glm::length(glm::vec3(model_matrix[1])),
+                                glm::length(glm::vec3(model_matrix[2]))});
+  const float radius = bounding_radius_ * scale;
+  const float distance =
+      glm::length(glm::vec3(model_matrix * glm::vec4(center, 1.0f)) -
+                  camera.position) -
+      radius;
+
+  lod_ = 0;
+  if (0.0f < distance) {
+    const float pixels_per_unit = camera.projection_scale * scale / distance;
+    while (lod_ + 1 < lods_.size() &&
+           lods_[lod_ + 1].error * pixels_per_unit <= camera.max_error_pixels) {
+      ++lod_;
+    }
+  }
+  return lod_;
+}
+
+auto model_loading::Mesh::Draw(const Program& program) const -> void {
+  if (material_program_id_ != program.Id()) {
+    std::println(std::cerr, "Materials of mesh not bound for program {}",
+                 program.Id());
+    return;
+  }
+  for (const auto& binding : material_bindings_) {
+    glUniform1i(binding.location, static_cast<GLint>(binding.texture_unit));
+    glBindTextureUnit(binding.texture_unit, *binding.texture_id);
+  }
+
+  if (format_ == VertexFormat::kPacked) {
+    const auto extent = bounds_max_ - bounds_min_;
+    glUniform3fv(position_min_location_, 1, &bounds_min_.x);
+    glUniform3fv(position_extent_location_, 1, &extent.x);
   }
-  glActiveTexture(GL_TEXTURE0);
 
+  const auto& lod = lods_[lod_];
   glBindVertexArray(vao_);
-  glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+  glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(lod.num_indices),
+                 GL_UNSIGNED_INT,
+                 (void*)(lod.first_index * sizeof(unsigned int)));
   glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+auto model_loading::Mesh::Residency() const -> MeshResidency {
+  return residency_;
+}
+
+auto model_loading::Mesh::Bounds() const -> MeshBounds {
+  return MeshBounds{.min = bounds_min_,
+                    .max = bounds_max_,
+                    .center = (bounds_min_ + bounds_max_) * 0.5f,
+                    .radius = bounding_radius_};
+}
+
+auto model_loading::Mesh::Format() const -> VertexFormat { return format_; }
+
+auto model_loading::Mesh::QuantizationError() const -> PackingError {
+  return packing_error_;
+}
+
+auto model_loading::Mesh::NumTriangles() const -> size_t {
+  return lods_[0].num_indices / 3;
+}
+
+auto model_loading::Mesh::NumDrawnTriangles() const -> size_t {
+  return lods_[lod_].num_indices / 3;
+}
+
+auto model_loading::Mesh::Lods() const -> const std::vector<MeshLod>& {
+  return lods_;
+}
+
+auto model_loading::Mesh::position(const size_t vertex) const -> glm::vec3 {
+  if (residency_ == MeshResidency::kKeepForPicking) {
+    return positions_[vertex];
+  }
+  const auto& quantized = compressed_positions_[vertex];
+  const auto extent = bounds_max_ - bounds_min_;
+  return bounds_min_ + extent * glm::vec3(quantized[0] / 65535.0f,
+                                          quantized[1] / 65535.0f,
+                                          quantized[2] / 65535.0f);
+}
+
+auto model_loading::Mesh::index(const size_t i) const -> unsigned int {
+  return compressed_indices_.empty() ? indices_[i] : compressed_indices_[i];
+}
+
+auto model_loading::Mesh::Triangle(const size_t triangle) const
+    -> std::optional<std::array<glm::vec3, 3>> {
+  if (residency_ == MeshResidency::kUploadAndRelease ||
+      NumTriangles() <= triangle) {
+    return std::nullopt;
+  }
+  return std::array{position(index(triangle * 3 + 0)),
+                    position(index(triangle * 3 + 1)),
+                    position(index(triangle * 3 + 2))};
+}
+
+auto model_loading::Mesh::Memory() const -> MeshMemory {
+  const size_t cpu_bytes =
+      positions_.capacity() * sizeof(glm::vec3) +
+      indices_.capacity() * sizeof(unsigned int) +
+      compressed_positions_.capacity() * sizeof(std::array<uint16_t, 3>) +
+      compressed_indices_.capacity() * sizeof(uint16_t) +
+      material_bindings_.capacity() * sizeof(MaterialBinding) +
+      lods_.capacity() * sizeof(MeshLod);
+  const size_t vertex_size = format_ == VertexFormat::kPacked
+                                 ? sizeof(PackedVertex)
+                                 : sizeof(Vertex);
+  const size_t gpu_bytes =
+      num_vertices_ * vertex_size + num_indices_ * sizeof(unsigned int);
+  return MeshMemory{.cpu_bytes = cpu_bytes, .gpu_bytes = gpu_bytes};
+}
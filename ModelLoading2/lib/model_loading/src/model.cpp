@@ -1,59 +1,148 @@
 #include "model.h"
 
 #include <assimp/postprocess.h>
-#include <stb_image.h>
 
+#include <algorithm>
 #include <assimp/Importer.hpp>
+#include <chrono>
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <ostream>
+#include <print>
+#include <span>
+#include <type_traits>
 
-static auto get_image_data(const std::string& filename, int n_components)
-    -> std::expected<
-        std::tuple<std::unique_ptr<unsigned char, decltype(&stbi_image_free)>,
-                   int, int>,
-        std::string> {
-  stbi_set_flip_vertically_on_load(true);
-  int x, y, n;
-  unsigned char* data = stbi_load(filename.c_str(), &x, &y, &n, n_components);
-  if (data == nullptr) {
-    return std::unexpected(std::format("Could not load texture '{}': {}",
-                                       filename, stbi_failure_reason()));
-  }
-
-  std::unique_ptr<unsigned char, decltype(&stbi_image_free)> tex_data(
-      data, &stbi_image_free);
-  return {{std::move(tex_data), x, y}};
-};
-
-static auto get_texture(const std::string& filename)
-    -> std::expected<unsigned int, std::string> {
-  const auto image_data = get_image_data(filename, 3);
-  if (!image_data) {
-    return std::unexpected(std::format("Could not load texture '{}': {}",
-                                       filename, image_data.error()));
-  }
-  const auto& [data, width, height] = *image_data;
-
-  unsigned int texture;
-  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-  glTextureStorage2D(texture, 1, GL_RGB8, width, height);
-  glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE,
-                      data.get());
-  return {texture};
-}
-
-model_loading::Model::Model(const char* path) { loadModel(path); }
+#include "mesh_cache/mesh_cache.h"
+#include "profiler/profiler.h"
+#include "thread_pool.h"
+
+// Vertices are written to and mapped from the mesh cache byte for byte
+static_assert(std::is_trivially_copyable_v<model_loading::Vertex>);
+
+// Only floats, welded byte for byte by the mesh optimizer
+template <>
+constexpr bool mesh_optimizer::has_no_padding<model_loading::Vertex> =
+    sizeof(model_loading::Vertex) ==
+    2 * sizeof(glm::vec3) + sizeof(glm::vec2);
+
+model_loading::Model::Model(const char* path, TextureLoader& texture_loader,
+                            const MeshResidency residency,
+                            const VertexFormat vertex_format)
+    : texture_loader(&texture_loader),
+      residency(residency),
+      vertex_format(vertex_format) {
+  loadModel(path);
+  for (uint32_t i = 0; i < meshes.size(); i++) {
+    const auto bounds = meshes[i].Bounds();
+    frustum_culling::add_box(mesh_bounds,
+                             {bounds.min.x, bounds.min.y, bounds.min.z},
+                             {bounds.max.x, bounds.max.y, bounds.max.z});
+    visible_meshes.push_back(i);
+  }
+}
+
+model_loading::Model::~Model() {
+  for (const auto slot : texture_slots) {
+    texture_loader->Release(slot);
+  }
+}
+
+auto model_loading::Model::BindMaterials(const Program& program) -> void {
+  for (auto& mesh : meshes) {
+    mesh.BindMaterials(program);
+  }
+}
+
+auto model_loading::Model::Cull(const glm::mat4& clip_from_model)
+    -> ModelCullStats {
+  const profiler::Zone zone("Model cull");
+  // Planes in model space, so the bounds are tested as loaded
+  const auto frustum = frustum_culling::extract_frustum(
+      std::span<const float, 16>(glm::value_ptr(clip_from_model), 16));
+  frustum_culling::cull_boxes(frustum, mesh_bounds, visible_meshes);
+  return ModelCullStats{
+      .num_visible = visible_meshes.size(),
+      .num_culled = meshes.size() - visible_meshes.size()};
+}
+
+auto model_loading::Model::SelectLods(const glm::mat4& model_matrix,
+                                      const LodCamera& camera)
+    -> ModelLodStats {
+  const profiler::Zone zone("Model LOD selection");
+  ModelLodStats stats{};
+  for (const auto i : visible_meshes) {
+    auto& mesh = meshes[i];
+    const auto lod = mesh.SelectLod(model_matrix, camera);
+    stats.num_drawn_triangles += mesh.NumDrawnTriangles();
+    ++stats.num_meshes_per_lod[std::min(lod,
+                                        stats.num_meshes_per_lod.size() - 1)];
+  }
+  for (const auto& mesh : meshes) {
+    stats.num_triangles += mesh.NumTriangles();
+  }
+  return stats;
+}
 
 auto model_loading::Model::Draw(const Program& program) const -> void {
-  for (auto mesh : meshes) {
-    mesh.Draw(program);
+  for (const auto i : visible_meshes) {
+    meshes[i].Draw(program);
+  }
+}
+auto model_loading::Model::MemoryReport() const -> ModelMemoryReport {
+  auto report = ModelMemoryReport{.num_meshes = meshes.size(),
+                                  .num_triangles = 0,
+                                  .cpu_bytes = 0,
+                                  .gpu_bytes = 0};
+  for (const auto& mesh : meshes) {
+    const auto memory = mesh.Memory();
+    report.num_triangles += mesh.NumTriangles();
+    report.cpu_bytes += memory.cpu_bytes;
+    report.gpu_bytes += memory.gpu_bytes;
   }
+  return report;
 }
+
+auto model_loading::Model::LoadTimings() const -> ModelLoadTimings {
+  return load_timings;
+}
+
+auto model_loading::Model::OptimizeReport() const
+    -> mesh_optimizer::OptimizeStats {
+  return optimize_report;
+}
+
+auto model_loading::Model::PackingReport() const -> PackingError {
+  PackingError report{};
+  for (const auto& mesh : meshes) {
+    const auto error = mesh.QuantizationError();
+    report.max_position_error =
+        std::max(report.max_position_error, error.max_position_error);
+    report.max_normal_error_degrees = std::max(
+        report.max_normal_error_degrees, error.max_normal_error_degrees);
+    report.max_uv_error = std::max(report.max_uv_error, error.max_uv_error);
+  }
+  return report;
+}
+
 auto model_loading::Model::loadModel(const std::string& path) -> void {
+  const profiler::Zone zone("Model load");
+  using Clock = std::chrono::steady_clock;
+  const auto elapsed_ms = [](const Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+  };
+
+  auto dirnameOf = [](const std::string& fname) -> std::string {
+    size_t pos = fname.find_last_of("\\/");
+    return (std::string::npos == pos) ? "" : fname.substr(0, pos);
+  };
+  directory = dirnameOf(path);
+
+  if (loadFromCache(path)) {
+    return;
+  }
+
+  auto stage_start = Clock::now();
   Assimp::Importer importer;
   const aiScene* scene = importer.ReadFile(
       path.c_str(), aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -62,40 +151,132 @@ auto model_loading::Model::loadModel(const std::string& path) -> void {
     std::println(std::cerr, "Could not open model file '{}'", path);
     return;
   }
+  load_timings.import_ms = elapsed_ms(stage_start);
 
-  auto dirnameOf = [](const std::string& fname) -> std::string {
-    size_t pos = fname.find_last_of("\\/");
-    return (std::string::npos == pos) ? "" : fname.substr(0, pos);
+  stage_start = Clock::now();
+  std::vector<aiMesh*> scene_meshes;
+  processNode(scene->mRootNode, scene, scene_meshes);
+  std::vector<MeshGeometry> geometries(scene_meshes.size());
+  {
+    ThreadPool thread_pool(std::thread::hardware_concurrency());
+    thread_pool.ParallelFor(scene_meshes.size(), [&](const size_t i) {
+      geometries[i] = convertMesh(scene_meshes[i]);
+    });
+  }
+  load_timings.convert_ms = elapsed_ms(stage_start);
+  for (const auto& geometry : geometries) {
+    const auto& stats = geometry.optimize_stats;
+    optimize_report.num_vertices_before += stats.num_vertices_before;
+    optimize_report.num_vertices_after += stats.num_vertices_after;
+    optimize_report.num_triangles += stats.num_triangles;
+    optimize_report.cache_misses_before += stats.cache_misses_before;
+    optimize_report.cache_misses_after += stats.cache_misses_after;
+  }
+
+  stage_start = Clock::now();
+  meshes.reserve(meshes.size() + scene_meshes.size());
+  for (size_t i = 0; i < scene_meshes.size(); i++) {
+    meshes.emplace_back(processMesh(scene_meshes[i], scene, geometries[i]));
+  }
+  load_timings.upload_ms = elapsed_ms(stage_start);
+
+  stage_start = Clock::now();
+  std::vector<mesh_cache::MeshData> cache_meshes;
+  cache_meshes.reserve(geometries.size());
+  for (size_t i = 0; i < geometries.size(); i++) {
+    std::vector<mesh_cache::MaterialTexture> textures;
+    for (const auto& texture : meshes[i].textures) {
+      textures.push_back({.type = texture.type, .path = texture.path});
+    }
+    std::vector<mesh_cache::Lod> lods;
+    for (const auto& lod : geometries[i].lods) {
+      lods.push_back({.first_index = lod.first_index,
+                      .num_indices = lod.num_indices,
+                      .error = lod.error});
+    }
+    cache_meshes.push_back(mesh_cache::MeshData{
+        .vertices = std::as_bytes(std::span(geometries[i].vertices)),
+        .num_vertices = geometries[i].vertices.size(),
+        .indices = geometries[i].indices,
+        .textures = std::move(textures),
+        .lods = std::move(lods)});
+  }
+  if (!mesh_cache::write(mesh_cache::cache_path_for(path), path,
+                         sizeof(Vertex), cache_meshes)) {
+    std::println(std::cerr, "Could not write mesh cache of '{}'", path);
+  }
+  load_timings.cache_write_ms = elapsed_ms(stage_start);
+}
+
+auto model_loading::Model::loadFromCache(const std::string& path) -> bool {
+  const profiler::Zone zone("Model load from cache");
+  using Clock = std::chrono::steady_clock;
+  const auto elapsed_ms = [](const Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
   };
-  directory = dirnameOf(path);
-  processNode(scene->mRootNode, scene);
+
+  auto stage_start = Clock::now();
+  const auto cache = mesh_cache::MeshCache::open(
+      mesh_cache::cache_path_for(path), path, sizeof(Vertex));
+  if (!cache) {
+    return false;
+  }
+  load_timings.from_cache = true;
+  load_timings.cache_read_ms = elapsed_ms(stage_start);
+
+  // Vertices and indices are uploaded from the mapping, no copies
+  stage_start = Clock::now();
+  meshes.reserve(meshes.size() + cache->meshes().size());
+  for (const auto& cached_mesh : cache->meshes()) {
+    std::vector<Texture> textures;
+    for (const auto& texture : cached_mesh.textures) {
+      textures.push_back(loadTexture(texture.path, texture.type));
+    }
+    std::vector<MeshLod> lods;
+    for (const auto& lod : cached_mesh.lods) {
+      lods.push_back(MeshLod{.first_index = lod.first_index,
+                             .num_indices = lod.num_indices,
+                             .error = lod.error});
+    }
+    meshes.emplace_back(
+        std::span(static_cast<const Vertex*>(cached_mesh.vertices),
+                  cached_mesh.num_vertices),
+        std::span(cached_mesh.indices, cached_mesh.num_indices),
+        std::move(lods), std::move(textures), residency, vertex_format);
+  }
+  load_timings.upload_ms = elapsed_ms(stage_start);
+  return true;
 }
 
-auto model_loading::Model::processNode(aiNode* node, const aiScene* scene)
+auto model_loading::Model::processNode(aiNode* node, const aiScene* scene,
+                                       std::vector<aiMesh*>& scene_meshes)
     -> void {
   for (size_t i = 0; i < node->mNumMeshes; i++) {
-    aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-    meshes.emplace_back(processMesh(mesh, scene));
+    scene_meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
   }
 
   for (size_t i = 0; i < node->mNumChildren; i++) {
-    processNode(node->mChildren[i], scene);
+    processNode(node->mChildren[i], scene, scene_meshes);
   }
 }
-auto model_loading::Model::processMesh(aiMesh* mesh, const aiScene* scene)
-    -> Mesh {
-  std::vector<Vertex> vertices;
-  std::vector<unsigned int> indices;
-  std::vector<Texture> textures;
+
+auto model_loading::Model::convertMesh(const aiMesh* mesh) -> MeshGeometry {
+  MeshGeometry geometry;
+  geometry.vertices.resize(mesh->mNumVertices);
   for (size_t i = 0; i < mesh->mNumVertices; i++) {
-    Vertex vertex;
+    Vertex& vertex = geometry.vertices[i];
     vertex.position.x = mesh->mVertices[i].x;
     vertex.position.y = mesh->mVertices[i].y;
     vertex.position.z = mesh->mVertices[i].z;
 
-    vertex.normal.x = mesh->mNormals[i].x;
-    vertex.normal.y = mesh->mNormals[i].y;
-    vertex.normal.z = mesh->mNormals[i].z;
+    if (mesh->mNormals) {
+      vertex.normal.x = mesh->mNormals[i].x;
+      vertex.normal.y = mesh->mNormals[i].y;
+      vertex.normal.z = mesh->mNormals[i].z;
+    } else {
+      vertex.normal = glm::vec3(0.0f, 0.0f, 0.0f);
+    }
 
     if (mesh->mTextureCoords[0]) {
       vertex.uv.x = mesh->mTextureCoords[0][i].x;
@@ -103,16 +284,41 @@ auto model_loading::Model::processMesh(aiMesh* mesh, const aiScene* scene)
     } else {
       vertex.uv = glm::vec2(0.0f, 0.0f);
     }
-    vertices.emplace_back(vertex);
   }
 
+  size_t num_indices = 0;
+  for (size_t i = 0; i < mesh->mNumFaces; i++) {
+    num_indices += mesh->mFaces[i].mNumIndices;
+  }
+  geometry.indices.resize(num_indices);
+  size_t index = 0;
   for (size_t i = 0; i < mesh->mNumFaces; i++) {
-    aiFace face = mesh->mFaces[i];
+    const aiFace& face = mesh->mFaces[i];
     for (size_t j = 0; j < face.mNumIndices; j++) {
-      indices.push_back(face.mIndices[j]);
+      geometry.indices[index++] = face.mIndices[j];
     }
   }
+  geometry.optimize_stats =
+      mesh_optimizer::optimize_mesh(geometry.vertices, geometry.indices);
+  if (geometry.indices.empty()) {
+    return geometry;
+  }
 
+  auto chain = mesh_optimizer::build_lod_chain(
+      geometry.indices, &geometry.vertices[0].position.x,
+      geometry.vertices.size(), sizeof(Vertex));
+  geometry.indices = std::move(chain.indices);
+  for (const auto& lod : chain.lods) {
+    geometry.lods.push_back(MeshLod{.first_index = lod.first_index,
+                                    .num_indices = lod.num_indices,
+                                    .error = lod.error});
+  }
+  return geometry;
+}
+
+auto model_loading::Model::processMesh(aiMesh* mesh, const aiScene* scene,
+                                       const MeshGeometry& geometry) -> Mesh {
+  std::vector<Texture> textures;
   if (mesh->mMaterialIndex >= 0) {
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
@@ -124,7 +330,8 @@ auto model_loading::Model::processMesh(aiMesh* mesh, const aiScene* scene)
     textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
   }
 
-  return Mesh(vertices, indices, textures);
+  return Mesh(geometry.vertices, geometry.indices, geometry.lods,
+              std::move(textures), residency, vertex_format);
 }
 auto model_loading::Model::loadMaterialTextures(aiMaterial* mat,
                                                 aiTextureType type,
@@ -134,27 +341,15 @@ auto model_loading::Model::loadMaterialTextures(aiMaterial* mat,
   for (size_t i = 0; i < mat->GetTextureCount(type); i++) {
     aiString texturePath;
     mat->GetTexture(type, i, &texturePath);
-    bool skip = false;
-    for (size_t j = 0; j < textures_loaded.size(); j++) {
-      if (std::strcmp(textures_loaded[j].path.c_str(), texturePath.C_Str()) ==
-          0) {
-        textures.emplace_back(textures_loaded[j]);
-        skip = true;
-        break;
-      }
-    }
-    if (!skip) {
-      Texture texture;
-      auto tex_id = get_texture(directory + "/" + texturePath.C_Str());
-      if (!tex_id) {
-        std::println(std::cerr, "Could not load texture");
-        continue;
-      }
-      texture.id = tex_id.value();
-      texture.type = typeName;
-      texture.path = texturePath.C_Str();
-      textures.emplace_back(texture);
-    }
+    textures.emplace_back(loadTexture(texturePath.C_Str(), typeName));
   }
   return textures;
 }
+
+auto model_loading::Model::loadTexture(const std::string& path,
+                                       std::string type) -> Texture {
+  // The loader decodes each image once, across materials and models
+  const auto reference = texture_loader->Load(directory + "/" + path);
+  texture_slots.push_back(reference.slot);
+  return Texture{.id = reference.id, .type = std::move(type), .path = path};
+}
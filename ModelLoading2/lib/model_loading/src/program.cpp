@@ -1,9 +1,18 @@
 #include "program.h"
 
+#include <chrono>
 #include <fstream>
+#include <iostream>
 #include <sstream>
 
+#include "program_cache/program_cache.h"
+
 namespace model_loading {
+namespace {
+// Relative to the working directory, next to the shaders
+constexpr auto program_cache_directory = "shader_cache";
+}  // namespace
+
 Program::Program(unsigned int program_id) : program_id_(program_id) {}
 
 auto Program::read_file(const std::string& filename)
@@ -19,17 +28,10 @@ auto Program::read_file(const std::string& filename)
   return {file_contents_stream.str()};
 }
 
-auto Program::compile_shader(const GLenum type, const std::string& filename)
+auto Program::compile_shader(const GLenum type, const std::string& source)
     -> std::expected<GLuint, Error> {
-  const auto source = read_file(filename);
-  if (!source) {
-    return std::unexpected(with_context(
-        source.error(),
-        std::format("Error getting source for vertex type {}", type)));
-  }
-
   const auto shader = glCreateShader(type);
-  const auto source_ptr = source->c_str();
+  const auto source_ptr = source.c_str();
   glShaderSource(shader, 1, &source_ptr, nullptr);
 
   glCompileShader(shader);
@@ -39,6 +41,7 @@ auto Program::compile_shader(const GLenum type, const std::string& filename)
     char message[1024] = {0};
     GLsizei message_len = 0;
     glGetShaderInfoLog(shader, sizeof(message), &message_len, message);
+    glDeleteShader(shader);
     return std::unexpected(
         Error{.message = std::format("Could not compile shader type {}: {}",
                                      type, message)});
@@ -46,45 +49,107 @@ auto Program::compile_shader(const GLenum type, const std::string& filename)
   return shader;
 }
 
-Program::Program(Program&& other) noexcept {
-  std::swap(program_id_, other.program_id_);
-}
-
-Program::~Program() { glDeleteProgram(program_id_); }
-
-auto Program::Create(const std::string& vertex_shader_filename,
-                     const std::string& fragment_shader_filename)
-    -> std::expected<Program, Error> {
+auto Program::link_program(const std::string& vertex_shader_source,
+                           const std::string& fragment_shader_source)
+    -> std::expected<GLuint, Error> {
   const auto vertex_shader =
-      compile_shader(GL_VERTEX_SHADER, vertex_shader_filename);
+      compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
   if (!vertex_shader) {
     return std::unexpected(
         with_context(vertex_shader.error(), "Could not compile vertex shader"));
   }
   const auto fragment_shader =
-      compile_shader(GL_FRAGMENT_SHADER, fragment_shader_filename);
+      compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
   if (!fragment_shader) {
+    glDeleteShader(*vertex_shader);
     return std::unexpected(with_context(fragment_shader.error(),
                                         "Could not compile fragment shader"));
   }
 
   const auto program_id = glCreateProgram();
+  program_cache::prepare_for_link(program_id);
   glAttachShader(program_id, *vertex_shader);
   glAttachShader(program_id, *fragment_shader);
   glLinkProgram(program_id);
+  // The program keeps what it needs once linked
+  glDetachShader(program_id, *vertex_shader);
+  glDetachShader(program_id, *fragment_shader);
+  glDeleteShader(*vertex_shader);
+  glDeleteShader(*fragment_shader);
   auto program_link_status = GL_FALSE;
   glGetProgramiv(program_id, GL_LINK_STATUS, &program_link_status);
   if (program_link_status != GL_TRUE) {
+    char message[1024] = {0};
+    GLsizei message_len = 0;
+    glGetProgramInfoLog(program_id, sizeof(message), &message_len, message);
+    glDeleteProgram(program_id);
     return std::unexpected(
-        Error{.message = std::format("Could not link program status: {}",
-                                     program_link_status)});
+        Error{.message = std::format("Could not link program: {}", message)});
+  }
+  return program_id;
+}
+
+Program::Program(Program&& other) noexcept {
+  std::swap(program_id_, other.program_id_);
+}
+
+Program::~Program() { glDeleteProgram(program_id_); }
+
+auto Program::Create(const std::string& vertex_shader_filename,
+                     const std::string& fragment_shader_filename)
+    -> std::expected<Program, Error> {
+  const auto vertex_shader_source = read_file(vertex_shader_filename);
+  if (!vertex_shader_source) {
+    return std::unexpected(with_context(vertex_shader_source.error(),
+                                        "Could not read vertex shader"));
+  }
+  const auto fragment_shader_source = read_file(fragment_shader_filename);
+  if (!fragment_shader_source) {
+    return std::unexpected(with_context(fragment_shader_source.error(),
+                                        "Could not read fragment shader"));
+  }
+
+  const auto link_start = std::chrono::steady_clock::now();
+  const auto cache_key =
+      program_cache::key_for(*vertex_shader_source, *fragment_shader_source);
+  auto program_id = program_cache::load(program_cache_directory, cache_key);
+  const auto cache_hit = program_id != 0;
+  if (!cache_hit) {
+    const auto linked_program_id =
+        link_program(*vertex_shader_source, *fragment_shader_source);
+    if (!linked_program_id) {
+      return std::unexpected(linked_program_id.error());
+    }
+    program_id = *linked_program_id;
+    program_cache::store(program_cache_directory, cache_key, program_id);
   }
+  const std::chrono::duration<double, std::milli> link_time =
+      std::chrono::steady_clock::now() - link_start;
+  const auto cache_stats = program_cache::stats();
+  std::cout << std::format(
+      "Program '{}' + '{}': cache {}, {:.2f} ms ({} hits, {} misses)\n",
+      vertex_shader_filename, fragment_shader_filename,
+      cache_hit ? "hit" : "miss", link_time.count(), cache_stats.hits,
+      cache_stats.misses);
 
   return Program{program_id};
 }
 
 auto Program::Use() const -> void { glUseProgram(program_id_); }
 
+auto Program::Id() const -> unsigned int { return program_id_; }
+
+auto Program::UniformLocation(const std::string& uniform_name) const
+    -> std::expected<GLint, Error> {
+  const auto location = glGetUniformLocation(program_id_, uniform_name.c_str());
+  if (location == -1) {
+    return std::unexpected(
+        Error{.message = std::format("Could not get uniform location of '{}'",
+                                     uniform_name)});
+  }
+  return location;
+}
+
 auto Program::SetUniformMatrix(const std::string& uniform_name,
                                const glm::mat4& matrix) const
     -> std::expected<void, Error> {
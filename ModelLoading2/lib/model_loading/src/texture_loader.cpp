@@ -0,0 +1,285 @@
+#include "texture_loader.h"
+
+#include <stb_image.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <print>
+#include <thread>
+
+#include "profiler/profiler.h"
+
+// FNV-1a, only used to find files with the same content
+static auto content_hash(const std::vector<unsigned char>& bytes) -> uint64_t {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const auto byte : bytes) {
+    hash = (hash ^ byte) * 0x100000001b3;
+  }
+  return hash;
+}
+
+static auto read_file(const std::string& filename)
+    -> std::optional<std::vector<unsigned char>> {
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return std::nullopt;
+  }
+  std::vector<unsigned char> bytes(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char*>(bytes.data()),
+                 static_cast<std::streamsize>(bytes.size()))) {
+    return std::nullopt;
+  }
+  return bytes;
+}
+
+model_loading::TextureLoader::TextureLoader(
+    const size_t num_threads, const size_t max_num_decoded_in_flight)
+    : decoded_(max_num_decoded_in_flight), thread_pool_(num_threads) {
+  static constexpr unsigned char grey[] = {128, 128, 128};
+  glCreateTextures(GL_TEXTURE_2D, 1, &placeholder_texture_);
+  glTextureStorage2D(placeholder_texture_, 1, GL_RGB8, 1, 1);
+  glTextureSubImage2D(placeholder_texture_, 0, 0, 0, 1, 1, GL_RGB,
+                      GL_UNSIGNED_BYTE, grey);
+}
+
+model_loading::TextureLoader::~TextureLoader() {
+  stopping_ = true;
+  thread_pool_.Wait();
+  while (decoded_.TryPop()) {
+  }
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (slots_[i].uploaded && !slots_[i].alias_of) {
+      glDeleteTextures(1, &texture_ids_[i]);
+    }
+  }
+  glDeleteTextures(1, &placeholder_texture_);
+}
+
+auto model_loading::TextureLoader::Load(const std::string& filename)
+    -> TextureReference {
+  std::error_code error;
+  auto path = std::filesystem::weakly_canonical(filename, error).string();
+  if (error) {
+    path = filename;
+  }
+
+  std::lock_guard lock(mutex_);
+  ++stats_.requested;
+  if (const auto it = slots_by_path_.find(path); it != slots_by_path_.end()) {
+    ++slots_[it->second].num_references;
+    ++stats_.path_hits;
+    return {.slot = it->second, .id = &texture_ids_[it->second]};
+  }
+
+  size_t slot;
+  if (!free_slots_.empty()) {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    slot = slots_.size();
+    slots_.emplace_back();
+    texture_ids_.push_back(placeholder_texture_);
+  }
+  slots_[slot] = TextureSlot{.path = path,
+                             .num_references = 1,
+                             .content_hash = std::nullopt,
+                             .alias_of = std::nullopt,
+                             .decoding = true,
+                             .pending = true,
+                             .uploaded = false,
+                             .waiting_aliases = {}};
+  slots_by_path_.emplace(path, slot);
+  ++num_pending_;
+  thread_pool_.Submit([this, slot, path] { decode(slot, path); });
+  return {.slot = slot, .id = &texture_ids_[slot]};
+}
+
+auto model_loading::TextureLoader::Release(const size_t slot) -> void {
+  std::lock_guard lock(mutex_);
+  releaseLocked(slot);
+}
+
+auto model_loading::TextureLoader::Update(
+    const std::chrono::microseconds budget) -> void {
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  do {
+    auto image = decoded_.TryPop();
+    if (!image) {
+      return;
+    }
+    upload(**image);
+  } while (Clock::now() - start < budget);
+}
+
+auto model_loading::TextureLoader::NumPending() const -> size_t {
+  return num_pending_;
+}
+
+auto model_loading::TextureLoader::Stats() const -> TextureLoaderStats {
+  std::lock_guard lock(mutex_);
+  return stats_;
+}
+
+auto model_loading::TextureLoader::decode(const size_t slot,
+                                          const std::string& filename)
+    -> void {
+  const profiler::Zone zone("Texture decode");
+  auto image = std::make_unique<DecodedImage>();
+  image->slot = slot;
+  image->filename = filename;
+  if (const auto bytes = read_file(filename); !bytes) {
+    image->error = "could not read file";
+  } else {
+    const auto hash = content_hash(*bytes);
+    {
+      std::lock_guard lock(mutex_);
+      if (const auto it = slots_by_content_hash_.find(hash);
+          it != slots_by_content_hash_.end()) {
+        // The alias keeps the slot it shares alive
+        ++slots_[it->second].num_references;
+        slots_[slot].alias_of = it->second;
+        image->alias_of = it->second;
+        ++stats_.content_hits;
+      } else {
+        slots_by_content_hash_.emplace(hash, slot);
+        slots_[slot].content_hash = hash;
+      }
+    }
+    if (!image->alias_of) {
+      // The flip flag set by stbi_set_flip_vertically_on_load is shared by
+      // all threads, this one only applies to the calling thread
+      stbi_set_flip_vertically_on_load_thread(true);
+      int n;
+      image->data = {
+          stbi_load_from_memory(bytes->data(), static_cast<int>(bytes->size()),
+                                &image->width, &image->height, &n, 3),
+          &stbi_image_free};
+      if (image->data == nullptr) {
+        image->error = stbi_failure_reason();
+      } else {
+        std::lock_guard lock(mutex_);
+        ++stats_.decoded;
+      }
+    }
+  }
+
+  // Wait for the GL thread to make room, decoded images can be large
+  while (!decoded_.TryPush(image)) {
+    if (stopping_) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+auto model_loading::TextureLoader::upload(const DecodedImage& image) -> void {
+  std::lock_guard lock(mutex_);
+  auto& slot = slots_[image.slot];
+  slot.decoding = false;
+  if (slot.num_references == 0) {
+    // Released while decoding
+    freeSlotLocked(image.slot);
+    return;
+  }
+
+  const auto fail = [this](TextureSlot& failed_slot) {
+    // The slot keeps the placeholder
+    failed_slot.pending = false;
+    --num_pending_;
+    ++stats_.failed;
+  };
+
+  if (image.alias_of) {
+    const auto& shared_slot = slots_[*image.alias_of];
+    if (shared_slot.uploaded) {
+      texture_ids_[image.slot] = texture_ids_[*image.alias_of];
+      slot.pending = false;
+      --num_pending_;
+    } else if (shared_slot.decoding) {
+      slots_[*image.alias_of].waiting_aliases.push_back(image.slot);
+    } else {
+      std::println(std::cerr,
+                   "Could not load texture '{}': same content as '{}', which "
+                   "failed",
+                   image.filename, shared_slot.path);
+      fail(slot);
+    }
+    return;
+  }
+
+  if (image.data == nullptr) {
+    std::println(std::cerr, "Could not load texture '{}': {}", image.filename,
+                 image.error);
+    fail(slot);
+    for (const auto alias : slot.waiting_aliases) {
+      fail(slots_[alias]);
+    }
+    slot.waiting_aliases.clear();
+    if (slot.content_hash) {
+      // Let files with the same content try again
+      slots_by_content_hash_.erase(*slot.content_hash);
+      slot.content_hash = std::nullopt;
+    }
+    return;
+  }
+
+  unsigned int texture;
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+  glTextureStorage2D(texture, 1, GL_RGB8, image.width, image.height);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTextureSubImage2D(texture, 0, 0, 0, image.width, image.height, GL_RGB,
+                      GL_UNSIGNED_BYTE, image.data.get());
+  texture_ids_[image.slot] = texture;
+  slot.uploaded = true;
+  slot.pending = false;
+  --num_pending_;
+  for (const auto alias : slot.waiting_aliases) {
+    texture_ids_[alias] = texture;
+    slots_[alias].pending = false;
+    --num_pending_;
+  }
+  slot.waiting_aliases.clear();
+  ++stats_.uploaded;
+  ++stats_.num_textures;
+  stats_.uploaded_bytes += static_cast<size_t>(image.width) * image.height * 3;
+}
+
+auto model_loading::TextureLoader::releaseLocked(const size_t slot) -> void {
+  if (--slots_[slot].num_references != 0 || slots_[slot].decoding) {
+    return;
+  }
+  freeSlotLocked(slot);
+}
+
+auto model_loading::TextureLoader::freeSlotLocked(const size_t slot) -> void {
+  auto& freed_slot = slots_[slot];
+  if (freed_slot.pending) {
+    --num_pending_;
+  }
+  slots_by_path_.erase(freed_slot.path);
+  const auto alias_of = freed_slot.alias_of;
+  if (alias_of) {
+    std::erase(slots_[*alias_of].waiting_aliases, slot);
+  } else {
+    if (freed_slot.uploaded) {
+      glDeleteTextures(1, &texture_ids_[slot]);
+      --stats_.num_textures;
+    }
+    if (freed_slot.content_hash) {
+      slots_by_content_hash_.erase(*freed_slot.content_hash);
+    }
+  }
+  texture_ids_[slot] = placeholder_texture_;
+  freed_slot = TextureSlot{};
+  free_slots_.push_back(slot);
+  if (alias_of) {
+    releaseLocked(*alias_of);
+  }
+}
@@ -0,0 +1,113 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <format>
+
+#include "profiler/profiler.h"
+
+namespace model_loading {
+ThreadPool::ThreadPool(const size_t num_threads) {
+  const size_t num_workers = std::max<size_t>(num_threads, 1);
+  queues_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    queues_.push_back(std::make_unique<WorkerQueue>());
+  }
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(wake_mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  workers_.clear();
+}
+
+auto ThreadPool::tryPop(const size_t worker) -> std::optional<Task> {
+  {
+    auto& own = *queues_[worker];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      auto task = std::move(own.tasks.front());
+      own.tasks.pop_front();
+      return task;
+    }
+  }
+  for (size_t offset = 1; offset < queues_.size(); ++offset) {
+    auto& victim = *queues_[(worker + offset) % queues_.size()];
+    std::lock_guard lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      auto task = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      return task;
+    }
+  }
+  return std::nullopt;
+}
+
+auto ThreadPool::workerLoop(const size_t worker) -> void {
+  profiler::set_thread_name(std::format("Worker {}", worker));
+  while (true) {
+    if (auto task = tryPop(worker)) {
+      --queued_;
+      (*task)();
+      if (--pending_ == 0) {
+        // Wait checks pending_ under the lock, so it either sees 0 or is
+        // already waiting when notified
+        { std::lock_guard lock(done_mutex_); }
+        done_.notify_all();
+      }
+      continue;
+    }
+    // Submit increments queued_ before looking at num_sleeping_, a worker
+    // increments num_sleeping_ before looking at queued_. One of them sees
+    // the other, so a task can't be left queued with every worker asleep.
+    std::unique_lock lock(wake_mutex_);
+    ++num_sleeping_;
+    wake_.wait(lock, [this]() { return stopping_ || 0 < queued_; });
+    --num_sleeping_;
+    if (stopping_ && queued_ == 0) {
+      return;
+    }
+  }
+}
+
+auto ThreadPool::Submit(Task task) -> void {
+  ++pending_;
+  // Counted before it's pushed so queued_ can't drop below 0 when a worker
+  // takes the task right away. A worker seeing it early retries until the
+  // push lands.
+  ++queued_;
+  auto& queue = *queues_[next_queue_++ % queues_.size()];
+  {
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  if (0 < num_sleeping_) {
+    // A worker between checking queued_ and waiting holds the lock, taking
+    // it makes sure the worker is waiting before it's notified
+    { std::lock_guard lock(wake_mutex_); }
+    wake_.notify_one();
+  }
+}
+
+auto ThreadPool::Wait() -> void {
+  std::unique_lock lock(done_mutex_);
+  done_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+auto ThreadPool::ParallelFor(const size_t count,
+                             const std::function<void(size_t)>& body)
+    -> void {
+  for (size_t i = 0; i < count; ++i) {
+    Submit([&body, i]() { body(i); });
+  }
+  Wait();
+}
+
+auto ThreadPool::NumThreads() const -> size_t { return workers_.size(); }
+}  // namespace model_loading
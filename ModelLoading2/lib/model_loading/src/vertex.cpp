@@ -0,0 +1,113 @@
+#include "vertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace model_loading {
+
+static auto sign_not_zero(const glm::vec2 v) -> glm::vec2 {
+  return {v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f};
+}
+
+auto EncodeOctahedral(const glm::vec3 normal) -> std::array<int16_t, 2> {
+  const float l1_norm =
+      std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  if (l1_norm == 0.0f) {
+    // Same as +Z, there is no code left for a zero normal
+    return {0, 0};
+  }
+  // Project onto the octahedron, then fold the lower half over the upper one
+  glm::vec2 projected = glm::vec2(normal.x, normal.y) / l1_norm;
+  if (normal.z < 0.0f) {
+    projected = (1.0f - glm::abs(glm::vec2(projected.y, projected.x))) *
+                sign_not_zero(projected);
+  }
+  return {static_cast<int16_t>(glm::packSnorm1x16(projected.x)),
+          static_cast<int16_t>(glm::packSnorm1x16(projected.y))};
+}
+
+auto DecodeOctahedral(const std::array<int16_t, 2> encoded) -> glm::vec3 {
+  const glm::vec2 projected(
+      glm::unpackSnorm1x16(static_cast<uint16_t>(encoded[0])),
+      glm::unpackSnorm1x16(static_cast<uint16_t>(encoded[1])));
+  glm::vec3 normal(projected.x, projected.y,
+                   1.0f - std::abs(projected.x) - std::abs(projected.y));
+  if (normal.z < 0.0f) {
+    const glm::vec2 unfolded =
+        (1.0f - glm::abs(glm::vec2(normal.y, normal.x))) *
+        sign_not_zero(glm::vec2(normal.x, normal.y));
+    normal.x = unfolded.x;
+    normal.y = unfolded.y;
+  }
+  return glm::normalize(normal);
+}
+
+auto PackVertex(const Vertex& vertex, const glm::vec3 bounds_min,
+                const glm::vec3 bounds_max) -> PackedVertex {
+  const glm::vec3 extent = bounds_max - bounds_min;
+  PackedVertex packed{};
+  for (int axis = 0; axis < 3; ++axis) {
+    const float t =
+        extent[axis] > 0.0f
+            ? (vertex.position[axis] - bounds_min[axis]) / extent[axis]
+            : 0.0f;
+    packed.position[axis] = glm::packUnorm1x16(t);
+  }
+  packed.normal = EncodeOctahedral(vertex.normal);
+  packed.uv = {glm::packHalf1x16(vertex.uv.x), glm::packHalf1x16(vertex.uv.y)};
+  return packed;
+}
+
+auto UnpackVertex(const PackedVertex& packed, const glm::vec3 bounds_min,
+                  const glm::vec3 bounds_max) -> Vertex {
+  const glm::vec3 t(glm::unpackUnorm1x16(packed.position[0]),
+                    glm::unpackUnorm1x16(packed.position[1]),
+                    glm::unpackUnorm1x16(packed.position[2]));
+  return Vertex{
+      .position = bounds_min + t * (bounds_max - bounds_min),
+      .normal = DecodeOctahedral(packed.normal),
+      .uv = glm::vec2(glm::unpackHalf1x16(packed.uv[0]),
+                      glm::unpackHalf1x16(packed.uv[1])),
+  };
+}
+
+auto PackVertices(const std::span<const Vertex> vertices,
+                  const glm::vec3 bounds_min, const glm::vec3 bounds_max)
+    -> std::vector<PackedVertex> {
+  std::vector<PackedVertex> packed(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    packed[i] = PackVertex(vertices[i], bounds_min, bounds_max);
+  }
+  return packed;
+}
+
+auto MeasurePackingError(const std::span<const Vertex> vertices,
+                         const std::span<const PackedVertex> packed,
+                         const glm::vec3 bounds_min,
+                         const glm::vec3 bounds_max) -> PackingError {
+  PackingError error{};
+  for (size_t i = 0; i < std::min(vertices.size(), packed.size()); ++i) {
+    const Vertex& original = vertices[i];
+    const Vertex decoded = UnpackVertex(packed[i], bounds_min, bounds_max);
+    error.max_position_error =
+        std::max(error.max_position_error,
+                 glm::length(decoded.position - original.position));
+    error.max_uv_error = std::max(
+        error.max_uv_error, glm::length(decoded.uv - original.uv));
+    if (const float length = glm::length(original.normal); length > 0.0f) {
+      // acos of the dot product can't resolve angles below 0.02 degrees in
+      // floats, the normals are that close
+      const glm::vec3 normal = original.normal / length;
+      const float angle =
+          std::atan2(glm::length(glm::cross(normal, decoded.normal)),
+                     glm::dot(normal, decoded.normal));
+      error.max_normal_error_degrees =
+          std::max(error.max_normal_error_degrees, glm::degrees(angle));
+    }
+  }
+  return error;
+}
+
+}  // namespace model_loading
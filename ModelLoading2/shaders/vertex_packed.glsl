@@ -0,0 +1,34 @@
+#version 450 core
+
+// Attributes of model_loading::PackedVertex
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec2 vNormal;
+layout (location = 2) in vec2 vTexPos;
+
+uniform mat4 mProjection;
+uniform mat4 mView;
+uniform mat4 mModel;
+
+// Bounds of the mesh, vPos is normalized within them
+uniform vec3 uPositionMin;
+uniform vec3 uPositionExtent;
+
+out vec3 normal;
+out vec3 fragPos;
+out vec2 texCoords;
+
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+void main() {
+    vec3 position = uPositionMin + vPos * uPositionExtent;
+    gl_Position = mProjection * mView * mModel * vec4(position, 1.0);
+    normal = normalize(transpose(inverse(mat3(mModel))) * decodeOctahedral(vNormal)); // Apply normal matrix
+    fragPos = vec3(mModel * vec4(position, 1.0));
+    texCoords = vTexPos;
+}
@@ -3,12 +3,18 @@
 #include <GLFW/glfw3.h>
 #include <stb_image.h>
 
+#include <algorithm>
+#include <chrono>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <thread>
 
 #include "mesh.h"
 #include "model.h"
+#include "profiler/gpu_timer.h"
+#include "profiler/profiler.h"
 #include "program.h"
+#include "texture_loader.h"
 
 void APIENTRY glDebugCallback(GLenum source, GLenum type, GLuint error_id,
                               GLenum severity, GLsizei length,
@@ -98,8 +104,13 @@ auto main() -> int {
                           GL_TRUE);
   }
 
-  const auto program = model_loading::Program::Create("shaders/vertex.glsl",
-                                                      "shaders/fragment.glsl");
+  // Packed vertices take half the memory, decoded in their own vertex shader
+  constexpr auto vertex_format = model_loading::VertexFormat::kPacked;
+  const auto program = model_loading::Program::Create(
+      vertex_format == model_loading::VertexFormat::kPacked
+          ? "shaders/vertex_packed.glsl"
+          : "shaders/vertex.glsl",
+      "shaders/fragment.glsl");
   if (!program) {
     std::cerr << "Failed to initialize program: " << program.error().message
               << "\n";
@@ -110,6 +121,7 @@ auto main() -> int {
 
   using WindowStatus = struct WindowStatus {
     float aspect_ratio;
+    float height;
   };
 
   WindowStatus window_status = [&window]() {
@@ -120,6 +132,7 @@ auto main() -> int {
     return WindowStatus{
         .aspect_ratio = static_cast<float>(window_width) /
                         static_cast<float>(window_height),
+        .height = static_cast<float>(window_height),
     };
   }();
   glfwSetWindowUserPointer(window, &window_status);
@@ -133,6 +146,7 @@ auto main() -> int {
     }
     window_status_ptr->aspect_ratio =
         static_cast<float>(width) / static_cast<float>(height);
+    window_status_ptr->height = static_cast<float>(height);
     glViewport(0, 0, width, height);
   };
   glfwSetWindowSizeCallback(window, window_size_callback);
@@ -205,21 +219,102 @@ auto main() -> int {
     return delta_time;
   };
 
-  // model_loading::Model backpack_model("models/backpack/backpack.obj");
-  model_loading::Model backpack_model("models/bunny/bunny.obj");
-  // model_loading::Model backpack_model("models/holodeck/holodeck.obj");
-  // model_loading::Model backpack_model("models/dragon/dragon.obj");
+  // Shared by every model, decoded images wait in a bounded queue for the
+  // rendering loop to upload them, a few milliseconds each frame
+  model_loading::TextureLoader texture_loader(
+      std::max(2U, std::thread::hardware_concurrency()) - 1, 16);
+  constexpr auto texture_upload_budget = std::chrono::microseconds(2000);
+
+  // model_loading::Model backpack_model("models/backpack/backpack.obj",
+  //                                     texture_loader);
+  model_loading::Model backpack_model(
+      "models/bunny/bunny.obj", texture_loader,
+      model_loading::MeshResidency::kUploadAndRelease, vertex_format);
+  // model_loading::Model backpack_model("models/holodeck/holodeck.obj",
+  //                                     texture_loader);
+  // model_loading::Model backpack_model("models/dragon/dragon.obj",
+  //                                     texture_loader);
+  backpack_model.BindMaterials(*program);
+  const auto memory_report = backpack_model.MemoryReport();
+  std::cout << "Model: " << memory_report.num_meshes << " meshes, "
+            << memory_report.num_triangles << " triangles, "
+            << memory_report.cpu_bytes << " CPU bytes, "
+            << memory_report.gpu_bytes << " GPU bytes\n";
+  const auto load_timings = backpack_model.LoadTimings();
+  if (const auto optimize_report = backpack_model.OptimizeReport();
+      optimize_report.num_triangles != 0) {
+    std::cout << "Model optimization: " << optimize_report.num_vertices_before
+              << " -> " << optimize_report.num_vertices_after
+              << " vertices, ACMR "
+              << static_cast<double>(optimize_report.cache_misses_before) /
+                     static_cast<double>(optimize_report.num_triangles)
+              << " -> "
+              << static_cast<double>(optimize_report.cache_misses_after) /
+                     static_cast<double>(optimize_report.num_triangles)
+              << "\n";
+  }
+  if (vertex_format == model_loading::VertexFormat::kPacked) {
+    const auto packing_report = backpack_model.PackingReport();
+    std::cout << "Vertex packing error: position "
+              << packing_report.max_position_error << ", normal "
+              << packing_report.max_normal_error_degrees << " degrees, uv "
+              << packing_report.max_uv_error << "\n";
+  }
+  // A cold load imports with Assimp and writes the mesh cache, a warm one
+  // maps the cache instead
+  if (load_timings.from_cache) {
+    std::cout << "Model load (warm): cache read " << load_timings.cache_read_ms
+              << " ms, upload " << load_timings.upload_ms << " ms\n";
+  } else {
+    std::cout << "Model load (cold): import " << load_timings.import_ms
+              << " ms, convert " << load_timings.convert_ms << " ms, upload "
+              << load_timings.upload_ms << " ms, cache write "
+              << load_timings.cache_write_ms << " ms\n";
+  }
 
   glEnable(GL_DEPTH_TEST);
   glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
 
+  // Meshes outside the view are culled and the rest draw the coarsest level
+  // of detail whose error stays under a pixel. Drawn triangles are averaged
+  // and logged every second along with the last frame's culling.
+  constexpr auto field_of_view = 45.0F;
+  constexpr auto max_lod_error_pixels = 1.0F;
+  size_t num_lod_frames = 0;
+  size_t num_lod_drawn_triangles = 0;
+  auto lod_report_time = glfwGetTime();
+
+  // Written to trace.json on exit along with the texture decoding on the
+  // loader's threads, the model's GPU time is also logged every second
+  profiler::set_thread_name("Main");
+  profiler::GpuTimer gpu_timer;
+
   // Rendering loop
   while (glfwWindowShouldClose(window) != GLFW_TRUE) {
+    gpu_timer.BeginFrame();
+    const profiler::Zone frame_zone("Frame");
     const auto delta_time = static_cast<float>(get_delta());
     handle_input(delta_time);
 
+    if (texture_loader.NumPending() != 0) {
+      {
+        const profiler::Zone texture_upload_zone("Texture upload");
+        texture_loader.Update(texture_upload_budget);
+      }
+      if (texture_loader.NumPending() == 0) {
+        const auto texture_stats = texture_loader.Stats();
+        std::cout << "Textures: " << texture_stats.requested << " requested, "
+                  << texture_stats.path_hits << " path hits, "
+                  << texture_stats.content_hits << " content hits, "
+                  << texture_stats.decoded << " decoded, "
+                  << texture_stats.uploaded << " uploaded, "
+                  << texture_stats.failed << " failed, "
+                  << texture_stats.uploaded_bytes << " bytes\n";
+      }
+    }
+
     const auto projection_matrix = glm::perspective(
-        glm::radians(45.0F), window_status.aspect_ratio, 0.1F, 100.0F);
+        glm::radians(field_of_view), window_status.aspect_ratio, 0.1F, 100.0F);
     if (const auto set_m_projection_result =
             program->SetUniformMatrix("mProjection", projection_matrix);
         !set_m_projection_result) {
@@ -250,14 +345,59 @@ auto main() -> int {
     }
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    program->Use();
-    backpack_model.Draw(*program);
+    const auto cull_stats =
+        backpack_model.Cull(projection_matrix * view_matrix * model_matrix);
+    const auto lod_stats = backpack_model.SelectLods(
+        model_matrix,
+        model_loading::LodCamera{
+            .position = camera_position,
+            .projection_scale =
+                window_status.height /
+                (2.0F * glm::tan(glm::radians(field_of_view) / 2.0F)),
+            .max_error_pixels = max_lod_error_pixels,
+        });
+    ++num_lod_frames;
+    num_lod_drawn_triangles += lod_stats.num_drawn_triangles;
+    if (const auto now = glfwGetTime(); 1.0 <= now - lod_report_time) {
+      std::cout << "Triangles per frame: "
+                << num_lod_drawn_triangles / num_lod_frames << " of "
+                << lod_stats.num_triangles << ", meshes visible "
+                << cull_stats.num_visible << ", culled "
+                << cull_stats.num_culled << ", per LOD:";
+      for (const auto num_meshes : lod_stats.num_meshes_per_lod) {
+        std::cout << " " << num_meshes;
+      }
+      for (const auto& [name, milliseconds] : gpu_timer.LastTimings()) {
+        std::cout << ", GPU " << name << " " << milliseconds << " ms";
+      }
+      std::cout << "\n";
+      num_lod_frames = 0;
+      num_lod_drawn_triangles = 0;
+      lod_report_time = now;
+    }
+
+    {
+      const profiler::Zone model_zone("Model draw");
+      const profiler::GpuZone model_gpu_zone(gpu_timer, "Model draw");
+      program->Use();
+      backpack_model.Draw(*program);
+    }
 
     glUseProgram(0);
 
-    glfwSwapBuffers(window);
+    {
+      const profiler::Zone swap_zone("Swap buffers");
+      glfwSwapBuffers(window);
+    }
     glfwPollEvents();
   }
+  if (const auto profiler_stats = profiler::stats();
+      profiler::write_chrome_trace("trace.json")) {
+    std::cout << "Wrote trace.json: " << profiler_stats.num_events
+              << " events, " << profiler_stats.num_dropped << " dropped\n";
+  } else {
+    std::cerr << "Failed to write trace.json\n";
+  }
   glfwTerminate();
   return 0;
 }
\ No newline at end of file
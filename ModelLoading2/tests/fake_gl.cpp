@@ -0,0 +1,139 @@
+#include "fake_gl.h"
+
+#include <GL/glew.h>
+
+namespace fake_gl {
+namespace {
+Calls calls_{};
+GLuint next_name = 1;
+GLint next_uniform_location = 0;
+
+auto create_name() -> GLuint { return next_name++; }
+
+auto create_names(const GLsizei n, GLuint* names) -> void {
+  for (GLsizei i = 0; i < n; ++i) {
+    names[i] = create_name();
+  }
+}
+
+GLuint GLAPIENTRY create_shader(GLenum) { return create_name(); }
+GLuint GLAPIENTRY create_program() { return create_name(); }
+void GLAPIENTRY create_buffers(const GLsizei n, GLuint* buffers) {
+  create_names(n, buffers);
+}
+void GLAPIENTRY create_textures(GLenum, const GLsizei n, GLuint* textures) {
+  create_names(n, textures);
+}
+void GLAPIENTRY gen_vertex_arrays(const GLsizei n, GLuint* arrays) {
+  create_names(n, arrays);
+}
+
+void GLAPIENTRY get_shader_iv(GLuint, const GLenum pname, GLint* param) {
+  *param = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+// No binary, so nothing is written to the program cache
+void GLAPIENTRY get_program_iv(GLuint, const GLenum pname, GLint* param) {
+  *param = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+void GLAPIENTRY get_info_log(GLuint, const GLsizei buf_size, GLsizei* length,
+                             GLchar* info_log) {
+  if (length != nullptr) {
+    *length = 0;
+  }
+  if (0 < buf_size) {
+    info_log[0] = '\0';
+  }
+}
+void GLAPIENTRY get_program_binary(GLuint, GLsizei, GLsizei* length,
+                                   GLenum* binary_format, void*) {
+  *length = 0;
+  *binary_format = 0;
+}
+
+GLint GLAPIENTRY get_uniform_location(GLuint, const GLchar*) {
+  ++calls_.get_uniform_location;
+  return next_uniform_location++;
+}
+void GLAPIENTRY use_program(GLuint) { ++calls_.use_program; }
+void GLAPIENTRY uniform_1i(GLint, GLint) { ++calls_.uniform; }
+void GLAPIENTRY uniform_1f(GLint, GLfloat) { ++calls_.uniform; }
+void GLAPIENTRY uniform_3f(GLint, GLfloat, GLfloat, GLfloat) {
+  ++calls_.uniform;
+}
+void GLAPIENTRY uniform_3fv(GLint, GLsizei, const GLfloat*) {
+  ++calls_.uniform;
+}
+void GLAPIENTRY uniform_matrix_4fv(GLint, GLsizei, GLboolean,
+                                   const GLfloat*) {
+  ++calls_.uniform;
+}
+void GLAPIENTRY bind_texture_unit(GLuint, GLuint) {
+  ++calls_.bind_texture_unit;
+}
+void GLAPIENTRY bind_vertex_array(GLuint) { ++calls_.bind_vertex_array; }
+
+void GLAPIENTRY shader_source(GLuint, GLsizei, const GLchar* const*,
+                              const GLint*) {}
+void GLAPIENTRY object(GLuint) {}
+void GLAPIENTRY attach_detach_shader(GLuint, GLuint) {}
+void GLAPIENTRY delete_names(GLsizei, const GLuint*) {}
+void GLAPIENTRY bind_buffer(GLenum, GLuint) {}
+void GLAPIENTRY named_buffer_storage(GLuint, GLsizeiptr, const void*,
+                                     GLbitfield) {}
+void GLAPIENTRY vertex_attrib_pointer(GLuint, GLint, GLenum, GLboolean,
+                                      GLsizei, const void*) {}
+void GLAPIENTRY texture_storage_2d(GLuint, GLsizei, GLenum, GLsizei,
+                                   GLsizei) {}
+void GLAPIENTRY texture_parameter_i(GLuint, GLenum, GLint) {}
+void GLAPIENTRY texture_sub_image_2d(GLuint, GLint, GLint, GLint, GLsizei,
+                                     GLsizei, GLenum, GLenum, const void*) {}
+void GLAPIENTRY program_binary(GLuint, GLenum, const void*, GLsizei) {}
+void GLAPIENTRY program_parameter_i(GLuint, GLenum, GLint) {}
+}  // namespace
+
+auto install() -> void {
+  glCreateShader = create_shader;
+  glCreateProgram = create_program;
+  glCreateBuffers = create_buffers;
+  glCreateTextures = create_textures;
+  glGenVertexArrays = gen_vertex_arrays;
+  glGetShaderiv = get_shader_iv;
+  glGetProgramiv = get_program_iv;
+  glGetShaderInfoLog = get_info_log;
+  glGetProgramInfoLog = get_info_log;
+  glGetProgramBinary = get_program_binary;
+  glGetUniformLocation = get_uniform_location;
+  glUseProgram = use_program;
+  glUniform1i = uniform_1i;
+  glUniform1f = uniform_1f;
+  glUniform3f = uniform_3f;
+  glUniform3fv = uniform_3fv;
+  glUniformMatrix4fv = uniform_matrix_4fv;
+  glBindTextureUnit = bind_texture_unit;
+  glBindVertexArray = bind_vertex_array;
+  glShaderSource = shader_source;
+  glCompileShader = object;
+  glLinkProgram = object;
+  glDeleteShader = object;
+  glDeleteProgram = object;
+  glAttachShader = attach_detach_shader;
+  glDetachShader = attach_detach_shader;
+  glDeleteBuffers = delete_names;
+  glDeleteVertexArrays = delete_names;
+  glEnableVertexAttribArray = object;
+  glBindBuffer = bind_buffer;
+  glNamedBufferStorage = named_buffer_storage;
+  glVertexAttribPointer = vertex_attrib_pointer;
+  glTextureStorage2D = texture_storage_2d;
+  glTextureParameteri = texture_parameter_i;
+  glTextureSubImage2D = texture_sub_image_2d;
+  glProgramBinary = program_binary;
+  glProgramParameteri = program_parameter_i;
+  reset_calls();
+}
+
+auto calls() -> const Calls& { return calls_; }
+
+auto reset_calls() -> void { calls_ = Calls{}; }
+
+}  // namespace fake_gl
@@ -0,0 +1,29 @@
+#ifndef FAKE_GL_H
+#define FAKE_GL_H
+
+#include <cstddef>
+
+// Points the GL entry points GLEW loads at fakes that accept everything, so
+// programs, meshes and textures can be created without a context. Shaders
+// compile, programs link and every uniform exists. GL 1.1 functions like
+// glDrawElements aren't loaded by GLEW, without a context they do nothing.
+namespace fake_gl {
+
+using Calls = struct Calls {
+  size_t use_program;
+  size_t get_uniform_location;
+  // glUniform* of any type
+  size_t uniform;
+  size_t bind_texture_unit;
+  size_t bind_vertex_array;
+};
+
+auto install() -> void;
+
+// Since install or the last reset
+auto calls() -> const Calls&;
+auto reset_calls() -> void;
+
+}  // namespace fake_gl
+
+#endif  // FAKE_GL_H
@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <random>
+#include <vector>
+
+#include "frustum_culling/frustum_culling.h"
+
+// Culls a million bounds scattered around the view, with the SIMD batches
+// and one bound at a time
+namespace {
+constexpr size_t num_bounds = 1'000'000;
+
+auto make_frustum() -> frustum_culling::Frustum {
+  const auto projection =
+      glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+  const auto view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f),
+                                glm::vec3(0.0f, 1.0f, 0.0f));
+  const auto clip_from_world = projection * view;
+  return frustum_culling::extract_frustum(
+      std::span<const float, 16>(glm::value_ptr(clip_from_world), 16));
+}
+
+auto make_spheres() -> frustum_culling::Spheres {
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> coordinate(-120.0f, 120.0f);
+  frustum_culling::Spheres spheres;
+  for (size_t i = 0; i < num_bounds; ++i) {
+    frustum_culling::add_sphere(spheres, coordinate(random),
+                                coordinate(random), coordinate(random), 1.0f);
+  }
+  return spheres;
+}
+
+auto make_boxes() -> frustum_culling::Boxes {
+  std::mt19937 random(2);
+  std::uniform_real_distribution<float> coordinate(-120.0f, 120.0f);
+  frustum_culling::Boxes boxes;
+  for (size_t i = 0; i < num_bounds; ++i) {
+    const std::array min = {coordinate(random), coordinate(random),
+                            coordinate(random)};
+    frustum_culling::add_box(boxes, min,
+                             {min[0] + 1.0f, min[1] + 1.0f, min[2] + 1.0f});
+  }
+  return boxes;
+}
+
+template <auto cull, typename Bounds>
+auto run(benchmark::State& state, const Bounds& bounds) -> void {
+  const auto frustum = make_frustum();
+  std::vector<uint32_t> visible;
+  visible.reserve(num_bounds);
+  for (auto _ : state) {
+    cull(frustum, bounds, visible);
+    benchmark::DoNotOptimize(visible.data());
+  }
+  state.counters["bounds/s"] = benchmark::Counter(
+      static_cast<double>(num_bounds) *
+          static_cast<double>(state.iterations()),
+      benchmark::Counter::kIsRate);
+  state.counters["visible"] = static_cast<double>(visible.size());
+  state.counters["simd_width"] =
+      static_cast<double>(frustum_culling::simd_width);
+}
+
+auto BM_CullSpheres(benchmark::State& state) -> void {
+  run<frustum_culling::cull_spheres>(state, make_spheres());
+}
+BENCHMARK(BM_CullSpheres)->Unit(benchmark::kMillisecond);
+
+auto BM_CullSpheresScalar(benchmark::State& state) -> void {
+  run<frustum_culling::cull_spheres_scalar>(state, make_spheres());
+}
+BENCHMARK(BM_CullSpheresScalar)->Unit(benchmark::kMillisecond);
+
+auto BM_CullBoxes(benchmark::State& state) -> void {
+  run<frustum_culling::cull_boxes>(state, make_boxes());
+}
+BENCHMARK(BM_CullBoxes)->Unit(benchmark::kMillisecond);
+
+auto BM_CullBoxesScalar(benchmark::State& state) -> void {
+  run<frustum_culling::cull_boxes_scalar>(state, make_boxes());
+}
+BENCHMARK(BM_CullBoxesScalar)->Unit(benchmark::kMillisecond);
+}  // namespace
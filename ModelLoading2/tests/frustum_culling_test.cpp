@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <random>
+#include <vector>
+
+#include "frustum_culling/frustum_culling.h"
+
+namespace {
+// Looking down -z from (0, 0, 10), like the demos' starting camera
+auto make_frustum() -> frustum_culling::Frustum {
+  const auto projection =
+      glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+  const auto view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f),
+                                glm::vec3(0.0f, 1.0f, 0.0f));
+  const auto clip_from_world = projection * view;
+  return frustum_culling::extract_frustum(
+      std::span<const float, 16>(glm::value_ptr(clip_from_world), 16));
+}
+
+// Not a multiple of any SIMD width, so the last bounds go through the
+// scalar tail. Scattered around the frustum, many cross one of its planes.
+constexpr size_t num_bounds = 100'003;
+
+auto random_spheres() -> frustum_culling::Spheres {
+  std::mt19937 random(3);
+  std::uniform_real_distribution<float> coordinate(-120.0f, 120.0f);
+  std::uniform_real_distribution<float> radius(0.0f, 5.0f);
+  frustum_culling::Spheres spheres;
+  for (size_t i = 0; i < num_bounds; ++i) {
+    frustum_culling::add_sphere(spheres, coordinate(random),
+                                coordinate(random), coordinate(random),
+                                radius(random));
+  }
+  return spheres;
+}
+
+auto random_boxes() -> frustum_culling::Boxes {
+  std::mt19937 random(4);
+  std::uniform_real_distribution<float> coordinate(-120.0f, 120.0f);
+  std::uniform_real_distribution<float> size(0.0f, 10.0f);
+  frustum_culling::Boxes boxes;
+  for (size_t i = 0; i < num_bounds; ++i) {
+    const std::array min = {coordinate(random), coordinate(random),
+                            coordinate(random)};
+    frustum_culling::add_box(
+        boxes, min,
+        {min[0] + size(random), min[1] + size(random), min[2] + size(random)});
+  }
+  return boxes;
+}
+
+TEST(FrustumCullingTest, SimdSpheresMatchScalar) {
+  const auto frustum = make_frustum();
+  const auto spheres = random_spheres();
+  std::vector<uint32_t> visible;
+  std::vector<uint32_t> visible_scalar;
+  frustum_culling::cull_spheres(frustum, spheres, visible);
+  frustum_culling::cull_spheres_scalar(frustum, spheres, visible_scalar);
+  EXPECT_EQ(visible, visible_scalar);
+  // Neither everything nor nothing, or the comparison says little
+  EXPECT_GT(visible.size(), num_bounds / 100);
+  EXPECT_LT(visible.size(), num_bounds / 2);
+}
+
+TEST(FrustumCullingTest, SimdBoxesMatchScalar) {
+  const auto frustum = make_frustum();
+  const auto boxes = random_boxes();
+  std::vector<uint32_t> visible;
+  std::vector<uint32_t> visible_scalar;
+  frustum_culling::cull_boxes(frustum, boxes, visible);
+  frustum_culling::cull_boxes_scalar(frustum, boxes, visible_scalar);
+  EXPECT_EQ(visible, visible_scalar);
+  EXPECT_GT(visible.size(), num_bounds / 100);
+  EXPECT_LT(visible.size(), num_bounds / 2);
+}
+
+TEST(FrustumCullingTest, BoundsAreCulledByTheirSide) {
+  const auto frustum = make_frustum();
+  frustum_culling::Spheres spheres;
+  // In front, behind the camera, past the far plane, crossing the near
+  // plane and crossing the left plane
+  frustum_culling::add_sphere(spheres, 0.0f, 0.0f, 0.0f, 1.0f);
+  frustum_culling::add_sphere(spheres, 0.0f, 0.0f, 20.0f, 1.0f);
+  frustum_culling::add_sphere(spheres, 0.0f, 0.0f, -95.0f, 1.0f);
+  frustum_culling::add_sphere(spheres, 0.0f, 0.0f, 10.5f, 1.0f);
+  frustum_culling::add_sphere(spheres, -7.5f, 0.0f, 0.0f, 1.0f);
+  std::vector<uint32_t> visible;
+  frustum_culling::cull_spheres(frustum, spheres, visible);
+  EXPECT_EQ(visible, (std::vector<uint32_t>{0, 3, 4}));
+  frustum_culling::cull_spheres_scalar(frustum, spheres, visible);
+  EXPECT_EQ(visible, (std::vector<uint32_t>{0, 3, 4}));
+}
+}  // namespace
@@ -0,0 +1,110 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <benchmark/benchmark.h>
+#include <stb_image.h>
+
+#include <filesystem>
+#include <iostream>
+#include <print>
+#include <string>
+#include <vector>
+
+#include "fake_gl.h"
+#include "mesh_cache/mesh_cache.h"
+#include "model.h"
+#include "texture_loader.h"
+
+// Loads models the way main does, cold through Assimp and warm from their
+// mesh cache. GL calls go to fake_gl, so uploads only cost their CPU side.
+// Run from ModelLoading2 like model_loading, or pass model paths after the
+// benchmark flags.
+namespace {
+using model_loading::Model;
+using model_loading::ModelLoadTimings;
+using model_loading::TextureLoader;
+
+auto add_timings(ModelLoadTimings& total, const ModelLoadTimings& timings)
+    -> void {
+  total.cache_read_ms += timings.cache_read_ms;
+  total.import_ms += timings.import_ms;
+  total.convert_ms += timings.convert_ms;
+  total.upload_ms += timings.upload_ms;
+  total.cache_write_ms += timings.cache_write_ms;
+}
+
+// Milliseconds per load spent in each stage
+auto report_timings(benchmark::State& state, const ModelLoadTimings& total)
+    -> void {
+  const auto average = [](const double ms) {
+    return benchmark::Counter(ms, benchmark::Counter::kAvgIterations);
+  };
+  state.counters["cache_read_ms"] = average(total.cache_read_ms);
+  state.counters["import_ms"] = average(total.import_ms);
+  state.counters["convert_ms"] = average(total.convert_ms);
+  state.counters["upload_ms"] = average(total.upload_ms);
+  state.counters["cache_write_ms"] = average(total.cache_write_ms);
+}
+
+// Textures stay referenced by the first model, so every load after it only
+// hits the texture cache and the benchmarks time the meshes
+auto BM_ModelLoadCold(benchmark::State& state, const std::string& path)
+    -> void {
+  TextureLoader texture_loader(2, 16);
+  const Model first_model(path.c_str(), texture_loader);
+  ModelLoadTimings total{};
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::filesystem::remove(mesh_cache::cache_path_for(path));
+    state.ResumeTiming();
+    const Model model(path.c_str(), texture_loader);
+    if (model.LoadTimings().from_cache ||
+        model.MemoryReport().num_meshes == 0) {
+      state.SkipWithError("Model wasn't imported");
+      break;
+    }
+    add_timings(total, model.LoadTimings());
+  }
+  report_timings(state, total);
+}
+
+auto BM_ModelLoadWarm(benchmark::State& state, const std::string& path)
+    -> void {
+  TextureLoader texture_loader(2, 16);
+  // Writes the cache if the file changed since it was last written
+  const Model first_model(path.c_str(), texture_loader);
+  ModelLoadTimings total{};
+  for (auto _ : state) {
+    const Model model(path.c_str(), texture_loader);
+    if (!model.LoadTimings().from_cache) {
+      state.SkipWithError("Model wasn't loaded from its mesh cache");
+      break;
+    }
+    add_timings(total, model.LoadTimings());
+  }
+  report_timings(state, total);
+}
+}  // namespace
+
+auto main(int argc, char** argv) -> int {
+  benchmark::Initialize(&argc, argv);
+  std::vector<std::string> paths(argv + 1, argv + argc);
+  if (paths.empty()) {
+    paths = {"../ModelLoading/models/spider.obj",
+             "models/backpack/backpack.obj"};
+  }
+  fake_gl::install();
+  for (const auto& path : paths) {
+    if (!std::filesystem::exists(path)) {
+      std::println(std::cerr, "Skipping missing model '{}'", path);
+      continue;
+    }
+    benchmark::RegisterBenchmark(("BM_ModelLoadCold/" + path).c_str(),
+                                 BM_ModelLoadCold, path)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark(("BM_ModelLoadWarm/" + path).c_str(),
+                                 BM_ModelLoadWarm, path)
+        ->Unit(benchmark::kMillisecond);
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
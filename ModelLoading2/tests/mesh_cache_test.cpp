@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "mesh_cache/mesh_cache.h"
+
+namespace {
+using mesh_cache::MeshCache;
+using mesh_cache::MeshData;
+
+// Three floats a vertex
+constexpr uint32_t vertex_size = 3 * sizeof(float);
+// Of the version and of the first mesh record's vertex offset in the file
+constexpr size_t version_offset = 8;
+constexpr size_t vertices_offset_offset = 64;
+
+auto read_bytes(const std::filesystem::path& path) -> std::vector<char> {
+  std::ifstream file(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+auto write_bytes(const std::filesystem::path& path, const char* bytes,
+                 const size_t size) -> void {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(bytes, static_cast<std::streamsize>(size));
+}
+
+class MeshCacheTest : public testing::Test {
+ protected:
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "mesh_cache_test";
+  std::string source_path;
+  std::string cache_path;
+
+  // A quad with two levels of detail and a triangle without textures
+  std::vector<float> quad_vertices = {0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0};
+  std::vector<unsigned int> quad_indices = {0, 1, 2, 0, 2, 3, 0, 1, 2};
+  std::vector<float> triangle_vertices = {0, 0, 1, 1, 0, 1, 0, 1, 1};
+  std::vector<unsigned int> triangle_indices = {2, 1, 0};
+  std::vector<MeshData> meshes;
+
+  auto SetUp() -> void override {
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    source_path = (directory / "model.obj").string();
+    cache_path = mesh_cache::cache_path_for(source_path);
+    write_source("v 0 0 0\n");
+    meshes = {
+        MeshData{.vertices = std::as_bytes(std::span(quad_vertices)),
+                 .num_vertices = 4,
+                 .indices = quad_indices,
+                 .textures = {{.type = "texture_diffuse",
+                               .path = "textures/diffuse.png"},
+                              {.type = "texture_specular",
+                               .path = "textures/specular.png"}},
+                 .lods = {{.first_index = 0, .num_indices = 6, .error = 0},
+                          {.first_index = 6,
+                           .num_indices = 3,
+                           .error = 0.25F}}},
+        MeshData{.vertices = std::as_bytes(std::span(triangle_vertices)),
+                 .num_vertices = 3,
+                 .indices = triangle_indices,
+                 .textures = {},
+                 .lods = {}}};
+  }
+
+  auto TearDown() -> void override { std::filesystem::remove_all(directory); }
+
+  auto write_source(const std::string& contents) const -> void {
+    write_bytes(source_path, contents.data(), contents.size());
+  }
+
+  auto open() const -> std::optional<MeshCache> {
+    return MeshCache::open(cache_path, source_path, vertex_size);
+  }
+};
+
+TEST_F(MeshCacheTest, MeshesSurviveTheRoundTrip) {
+  ASSERT_TRUE(mesh_cache::write(cache_path, source_path, vertex_size, meshes));
+
+  const auto cache = open();
+
+  ASSERT_TRUE(cache.has_value());
+  ASSERT_EQ(cache->meshes().size(), meshes.size());
+  for (size_t i = 0; i < meshes.size(); ++i) {
+    const auto& cached = cache->meshes()[i];
+    const auto& mesh = meshes[i];
+    ASSERT_EQ(cached.num_vertices, mesh.num_vertices);
+    EXPECT_EQ(std::memcmp(cached.vertices, mesh.vertices.data(),
+                          mesh.vertices.size()),
+              0);
+    EXPECT_EQ(std::vector(cached.indices, cached.indices + cached.num_indices),
+              std::vector(mesh.indices.begin(), mesh.indices.end()));
+    ASSERT_EQ(cached.textures.size(), mesh.textures.size());
+    for (size_t j = 0; j < mesh.textures.size(); ++j) {
+      EXPECT_EQ(cached.textures[j].type, mesh.textures[j].type);
+      EXPECT_EQ(cached.textures[j].path, mesh.textures[j].path);
+    }
+    ASSERT_EQ(cached.lods.size(), mesh.lods.size());
+    for (size_t j = 0; j < mesh.lods.size(); ++j) {
+      EXPECT_EQ(cached.lods[j].first_index, mesh.lods[j].first_index);
+      EXPECT_EQ(cached.lods[j].num_indices, mesh.lods[j].num_indices);
+      EXPECT_EQ(cached.lods[j].error, mesh.lods[j].error);
+    }
+    // Vertex data can go straight into a buffer, indices are read in place
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(cached.vertices) % 16, 0U);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(cached.indices) %
+                  alignof(unsigned int),
+              0U);
+  }
+}
+
+TEST_F(MeshCacheTest, ChangedSourceForcesARebuild) {
+  ASSERT_TRUE(mesh_cache::write(cache_path, source_path, vertex_size, meshes));
+
+  // Same size, then a different size
+  write_source("v 1 0 0\n");
+  EXPECT_FALSE(open().has_value());
+  write_source("v 0 0 0\nv 1 0 0\n");
+  EXPECT_FALSE(open().has_value());
+
+  ASSERT_TRUE(mesh_cache::write(cache_path, source_path, vertex_size, meshes));
+  EXPECT_TRUE(open().has_value());
+  std::filesystem::remove(source_path);
+  EXPECT_FALSE(open().has_value());
+}
+
+TEST_F(MeshCacheTest, OtherVertexSizeOrVersionIsRejected) {
+  ASSERT_TRUE(mesh_cache::write(cache_path, source_path, vertex_size, meshes));
+  EXPECT_FALSE(
+      MeshCache::open(cache_path, source_path, vertex_size + 4).has_value());
+  EXPECT_FALSE(MeshCache::open(cache_path, source_path, 0).has_value());
+  // Meshes whose bytes don't match the vertex size aren't written
+  EXPECT_FALSE(
+      mesh_cache::write(cache_path, source_path, vertex_size + 4, meshes));
+
+  auto bytes = read_bytes(cache_path);
+  const uint32_t older_version = mesh_cache::version - 1;
+  std::memcpy(&bytes[version_offset], &older_version, sizeof(older_version));
+  write_bytes(cache_path, bytes.data(), bytes.size());
+  EXPECT_FALSE(open().has_value());
+}
+
+// Cut after every byte, so each record and every piece of data is cut
+// somewhere
+TEST_F(MeshCacheTest, TruncatedFileIsRejected) {
+  ASSERT_TRUE(mesh_cache::write(cache_path, source_path, vertex_size, meshes));
+  const auto bytes = read_bytes(cache_path);
+  ASSERT_FALSE(bytes.empty());
+
+  for (size_t size = 0; size < bytes.size(); ++size) {
+    write_bytes(cache_path, bytes.data(), size);
+    EXPECT_FALSE(open().has_value()) << "Cut at " << size;
+  }
+  write_bytes(cache_path, bytes.data(), bytes.size());
+  EXPECT_TRUE(open().has_value());
+}
+
+TEST_F(MeshCacheTest, RecordsPointingOutOfTheFileAreRejected) {
+  ASSERT_TRUE(mesh_cache::write(cache_path, source_path, vertex_size, meshes));
+  auto bytes = read_bytes(cache_path);
+
+  // Right at the end, and far enough to wrap around when the size is added
+  for (const uint64_t vertices_offset :
+       {static_cast<uint64_t>(bytes.size()), UINT64_MAX - 8}) {
+    std::memcpy(&bytes[vertices_offset_offset], &vertices_offset,
+                sizeof(vertices_offset));
+    write_bytes(cache_path, bytes.data(), bytes.size());
+    EXPECT_FALSE(open().has_value()) << vertices_offset;
+  }
+}
+}  // namespace
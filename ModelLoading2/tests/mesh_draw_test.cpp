@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "fake_gl.h"
+#include "mesh.h"
+#include "program.h"
+
+namespace {
+std::atomic<size_t> num_allocations{0};
+}  // namespace
+
+// Every new of the test executable is counted, array news end up here too
+auto operator new(const std::size_t size) -> void* {
+  ++num_allocations;
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+auto operator delete(void* pointer) noexcept -> void { std::free(pointer); }
+
+auto operator delete(void* pointer, std::size_t) noexcept -> void {
+  std::free(pointer);
+}
+
+namespace {
+using model_loading::Mesh;
+using model_loading::Program;
+using model_loading::Texture;
+using model_loading::Vertex;
+using model_loading::VertexFormat;
+
+constexpr size_t num_meshes = 64;
+constexpr size_t num_frames = 100;
+
+auto write_file(const std::filesystem::path& path, const char* contents)
+    -> void {
+  std::ofstream file(path);
+  file << contents;
+}
+
+class MeshDrawTest : public testing::Test {
+ protected:
+  const unsigned int diffuse_texture_id = 7;
+  const unsigned int specular_texture_id = 8;
+  std::unique_ptr<Program> program;
+  std::vector<Mesh> meshes;
+
+  auto SetUp() -> void override {
+    fake_gl::install();
+    const auto directory = std::filesystem::temp_directory_path();
+    const auto vertex_shader = directory / "mesh_draw_test_vertex.glsl";
+    const auto fragment_shader = directory / "mesh_draw_test_fragment.glsl";
+    write_file(vertex_shader, "void main() {}\n");
+    write_file(fragment_shader, "void main() {}\n");
+    auto created = Program::Create(vertex_shader.string(),
+                                   fragment_shader.string());
+    ASSERT_TRUE(created) << created.error().message;
+    program = std::make_unique<Program>(std::move(*created));
+
+    const std::vector<Vertex> vertices = {
+        Vertex{.position = {0, 0, 0}, .normal = {0, 0, 1}, .uv = {0, 0}},
+        Vertex{.position = {1, 0, 0}, .normal = {0, 0, 1}, .uv = {1, 0}},
+        Vertex{.position = {0, 1, 0}, .normal = {0, 0, 1}, .uv = {0, 1}}};
+    const std::vector<unsigned int> indices = {0, 1, 2};
+    meshes.reserve(num_meshes);
+    for (size_t i = 0; i < num_meshes; ++i) {
+      // Every other mesh also sets the uniforms decoding packed positions
+      const auto format =
+          i % 2 == 0 ? VertexFormat::kFloat : VertexFormat::kPacked;
+      meshes.emplace_back(
+          vertices, indices, std::vector<model_loading::MeshLod>{},
+          std::vector<Texture>{
+              Texture{.id = &diffuse_texture_id,
+                      .type = "texture_diffuse",
+                      .path = "diffuse.png"},
+              Texture{.id = &specular_texture_id,
+                      .type = "texture_specular",
+                      .path = "specular.png"}},
+          model_loading::MeshResidency::kUploadAndRelease, format);
+    }
+  }
+};
+
+TEST_F(MeshDrawTest, BindMaterialsResolvesEveryUniformOnce) {
+  fake_gl::reset_calls();
+  for (auto& mesh : meshes) {
+    mesh.BindMaterials(*program);
+  }
+  // Two samplers per mesh, plus the position bounds of packed ones
+  EXPECT_EQ(fake_gl::calls().get_uniform_location,
+            num_meshes * 2 + num_meshes / 2 * 2);
+}
+
+TEST_F(MeshDrawTest, DrawingBoundMeshesDoesntAllocate) {
+  for (auto& mesh : meshes) {
+    mesh.BindMaterials(*program);
+  }
+  fake_gl::reset_calls();
+
+  const auto allocations_before = num_allocations.load();
+  for (size_t frame = 0; frame < num_frames; ++frame) {
+    program->Use();
+    for (const auto& mesh : meshes) {
+      mesh.Draw(*program);
+    }
+  }
+  const auto allocations = num_allocations.load() - allocations_before;
+
+  EXPECT_EQ(allocations, 0U);
+  const auto& calls = fake_gl::calls();
+  EXPECT_EQ(calls.use_program, num_frames);
+  EXPECT_EQ(calls.get_uniform_location, 0U);
+  EXPECT_EQ(calls.bind_texture_unit, num_frames * num_meshes * 2);
+  EXPECT_EQ(calls.uniform,
+            num_frames * (num_meshes * 2 + num_meshes / 2 * 2));
+  // Bound and unbound
+  EXPECT_EQ(calls.bind_vertex_array, num_frames * num_meshes * 2);
+}
+
+TEST_F(MeshDrawTest, MeshBoundForAnotherProgramIsntDrawn) {
+  meshes[0].BindMaterials(*program);
+  const auto directory = std::filesystem::temp_directory_path();
+  auto other_program =
+      Program::Create((directory / "mesh_draw_test_vertex.glsl").string(),
+                      (directory / "mesh_draw_test_fragment.glsl").string());
+  ASSERT_TRUE(other_program);
+  fake_gl::reset_calls();
+
+  testing::internal::CaptureStderr();
+  meshes[0].Draw(*other_program);
+  testing::internal::GetCapturedStderr();
+
+  EXPECT_EQ(fake_gl::calls().bind_vertex_array, 0U);
+  EXPECT_EQ(fake_gl::calls().uniform, 0U);
+}
+}  // namespace
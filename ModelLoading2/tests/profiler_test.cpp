@@ -0,0 +1,318 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <format>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "profiler/profiler.h"
+
+namespace {
+constexpr size_t num_recorders = 4;
+// Spans several chunks of each track
+constexpr size_t num_batches = 20;
+constexpr size_t num_zones_per_batch = 1'000;
+constexpr size_t num_zones_per_recorder = num_batches * num_zones_per_batch;
+constexpr auto zone_name = "Concurrent zone";
+
+// Just enough JSON for the trace, numbers as doubles and objects as their
+// members in order
+struct Json {
+  using Array = std::vector<Json>;
+  using Object = std::vector<std::pair<std::string, Json>>;
+  std::variant<std::nullptr_t, bool, double, std::string, Array, Object> value;
+
+  [[nodiscard]] auto member(const std::string_view key) const -> const Json* {
+    const auto* const object = std::get_if<Object>(&value);
+    if (object == nullptr) {
+      return nullptr;
+    }
+    const auto it = std::ranges::find(*object, key, &Object::value_type::first);
+    return it == object->end() ? nullptr : &it->second;
+  }
+};
+
+class JsonParser {
+ private:
+  std::string_view text_;
+  size_t position_ = 0;
+
+  auto skip_whitespace() -> void {
+    while (position_ < text_.size() &&
+           std::isspace(static_cast<unsigned char>(text_[position_]))) {
+      position_++;
+    }
+  }
+
+  auto consume(const char expected) -> bool {
+    skip_whitespace();
+    if (position_ < text_.size() && text_[position_] == expected) {
+      position_++;
+      return true;
+    }
+    return false;
+  }
+
+  auto parse_string() -> std::optional<std::string> {
+    if (!consume('"')) {
+      return std::nullopt;
+    }
+    std::string string;
+    while (position_ < text_.size() && text_[position_] != '"') {
+      auto character = text_[position_++];
+      if (static_cast<unsigned char>(character) < 0x20) {
+        return std::nullopt;
+      }
+      if (character == '\\') {
+        if (position_ == text_.size()) {
+          return std::nullopt;
+        }
+        character = text_[position_++];
+        if (character == 'u') {
+          unsigned int code = 0;
+          const auto hex = text_.substr(position_, 4);
+          if (hex.size() != 4 ||
+              std::from_chars(hex.data(), hex.data() + 4, code, 16).ptr !=
+                  hex.data() + 4) {
+            return std::nullopt;
+          }
+          position_ += 4;
+          character = static_cast<char>(code);
+        } else if (character != '"' && character != '\\') {
+          return std::nullopt;
+        }
+      }
+      string += character;
+    }
+    if (!consume('"')) {
+      return std::nullopt;
+    }
+    return string;
+  }
+
+  auto parse_number() -> std::optional<double> {
+    double number = 0.0;
+    const auto [end, error] = std::from_chars(
+        text_.data() + position_, text_.data() + text_.size(), number);
+    if (error != std::errc{}) {
+      return std::nullopt;
+    }
+    position_ = end - text_.data();
+    return number;
+  }
+
+ public:
+  explicit JsonParser(const std::string_view text) : text_(text) {}
+
+  auto parse_value() -> std::optional<Json> {
+    skip_whitespace();
+    if (position_ == text_.size()) {
+      return std::nullopt;
+    }
+    if (text_[position_] == '"') {
+      auto string = parse_string();
+      return string ? std::optional(Json{std::move(*string)}) : std::nullopt;
+    }
+    if (consume('[')) {
+      Json::Array array;
+      if (consume(']')) {
+        return Json{std::move(array)};
+      }
+      do {
+        auto element = parse_value();
+        if (!element) {
+          return std::nullopt;
+        }
+        array.push_back(std::move(*element));
+      } while (consume(','));
+      return consume(']') ? std::optional(Json{std::move(array)})
+                          : std::nullopt;
+    }
+    if (consume('{')) {
+      Json::Object object;
+      if (consume('}')) {
+        return Json{std::move(object)};
+      }
+      do {
+        auto key = parse_string();
+        if (!key || !consume(':')) {
+          return std::nullopt;
+        }
+        auto member = parse_value();
+        if (!member) {
+          return std::nullopt;
+        }
+        object.emplace_back(std::move(*key), std::move(*member));
+      } while (consume(','));
+      return consume('}') ? std::optional(Json{std::move(object)})
+                          : std::nullopt;
+    }
+    for (const auto& [literal, value] :
+         {std::pair<std::string_view, Json>{"true", Json{true}},
+          {"false", Json{false}},
+          {"null", Json{nullptr}}}) {
+      if (text_.substr(position_).starts_with(literal)) {
+        position_ += literal.size();
+        return value;
+      }
+    }
+    auto number = parse_number();
+    return number ? std::optional(Json{*number}) : std::nullopt;
+  }
+
+  // The whole text as one value, nullopt if it isn't valid
+  auto parse() -> std::optional<Json> {
+    auto value = parse_value();
+    skip_whitespace();
+    return position_ == text_.size() ? value : std::nullopt;
+  }
+};
+
+using TraceCounts = struct TraceCounts {
+  // Of every track by tid
+  std::map<double, std::string> track_names;
+  // zone_name events by tid
+  std::map<double, size_t> num_zones;
+};
+
+// Checks every event of the trace has the fields its phase needs
+auto count_trace(const std::string& trace) -> std::optional<TraceCounts> {
+  const auto json = JsonParser(trace).parse();
+  if (!json) {
+    ADD_FAILURE() << "Trace isn't valid JSON";
+    return std::nullopt;
+  }
+  const auto* const events = json->member("traceEvents");
+  if (events == nullptr || !std::holds_alternative<Json::Array>(events->value)) {
+    ADD_FAILURE() << "Trace has no traceEvents array";
+    return std::nullopt;
+  }
+  TraceCounts counts;
+  for (const auto& event : std::get<Json::Array>(events->value)) {
+    const auto* const phase = event.member("ph");
+    const auto* const tid = event.member("tid");
+    const auto* const name = event.member("name");
+    if (phase == nullptr || tid == nullptr || name == nullptr) {
+      ADD_FAILURE() << "Event without ph, tid or name";
+      return std::nullopt;
+    }
+    const auto thread = std::get<double>(tid->value);
+    if (std::get<std::string>(phase->value) == "M") {
+      counts.track_names[thread] =
+          std::get<std::string>(event.member("args")->member("name")->value);
+      continue;
+    }
+    EXPECT_EQ(std::get<std::string>(phase->value), "X");
+    EXPECT_GE(std::get<double>(event.member("ts")->value), 0.0);
+    EXPECT_GE(std::get<double>(event.member("dur")->value), 0.0);
+    if (std::get<std::string>(name->value) == zone_name) {
+      counts.num_zones[thread]++;
+    }
+  }
+  return counts;
+}
+
+TEST(ProfilerTest, TraceIsWrittenWhileThreadsRecord) {
+  const auto stats_before = profiler::stats();
+  // A recorder only starts its next batch once as many traces were written,
+  // so it can't finish before the writer is well under way
+  std::atomic<size_t> num_traces = 0;
+  std::atomic<size_t> num_recording = num_recorders;
+  std::vector<std::jthread> recorders;
+  for (size_t i = 0; i < num_recorders; i++) {
+    recorders.emplace_back([i, &num_traces, &num_recording]() {
+      profiler::set_thread_name(std::format("Recorder {}", i));
+      for (size_t batch = 0; batch < num_batches; batch++) {
+        while (num_traces.load() < batch) {
+          std::this_thread::yield();
+        }
+        for (size_t zone = 0; zone < num_zones_per_batch; zone++) {
+          const profiler::Zone recorded_zone(zone_name);
+        }
+      }
+      num_recording.fetch_sub(1);
+    });
+  }
+
+  // Each trace written while recording shows a prefix of every track, so
+  // counts only grow between traces
+  std::map<double, size_t> last_num_zones;
+  auto traces_valid = true;
+  while (num_recording.load() != 0) {
+    std::ostringstream trace;
+    profiler::write_chrome_trace(trace);
+    const auto counts = count_trace(trace.str());
+    if (!counts) {
+      // Lets the recorders run to the end
+      traces_valid = false;
+      num_traces.store(num_batches);
+      break;
+    }
+    for (const auto& [tid, num_zones] : counts->num_zones) {
+      EXPECT_GE(num_zones, last_num_zones[tid]);
+      EXPECT_LE(num_zones, num_zones_per_recorder);
+      last_num_zones[tid] = num_zones;
+    }
+    num_traces.fetch_add(1);
+  }
+  recorders.clear();
+  ASSERT_TRUE(traces_valid);
+  EXPECT_GE(num_traces.load(), num_batches - 1);
+
+  std::ostringstream trace;
+  profiler::write_chrome_trace(trace);
+  auto counts = count_trace(trace.str());
+  ASSERT_TRUE(counts.has_value());
+  for (size_t i = 0; i < num_recorders; i++) {
+    const auto track = std::ranges::find(
+        counts->track_names, std::format("Recorder {}", i),
+        &std::map<double, std::string>::value_type::second);
+    ASSERT_NE(track, counts->track_names.end()) << "Recorder " << i;
+    EXPECT_EQ(counts->num_zones[track->first], num_zones_per_recorder)
+        << "Recorder " << i;
+  }
+  const auto stats = profiler::stats();
+  EXPECT_EQ(stats.num_tracks, stats_before.num_tracks + num_recorders);
+  EXPECT_EQ(stats.num_events,
+            stats_before.num_events + num_recorders * num_zones_per_recorder);
+  EXPECT_EQ(stats.num_dropped, stats_before.num_dropped);
+}
+
+TEST(ProfilerTest, NamesAreEscaped) {
+  auto& track = profiler::create_track("GPU \"queue\"\n");
+  profiler::record(track, profiler::Event{
+                              .name = "Draw \\ shadows\t",
+                              .start_ns = profiler::now_ns(),
+                              .duration_ns = 1500});
+
+  std::ostringstream trace;
+  profiler::write_chrome_trace(trace);
+  const auto json = JsonParser(trace.str()).parse();
+  ASSERT_TRUE(json.has_value());
+  const auto& events =
+      std::get<Json::Array>(json->member("traceEvents")->value);
+  const auto event = std::ranges::find_if(events, [](const Json& event) {
+    return std::get<std::string>(event.member("name")->value) ==
+           "Draw \\ shadows\t";
+  });
+  ASSERT_NE(event, events.end());
+  EXPECT_DOUBLE_EQ(std::get<double>(event->member("dur")->value), 1.5);
+  const auto track_name = std::ranges::find_if(events, [](const Json& event) {
+    const auto* const args = event.member("args");
+    return args != nullptr &&
+           std::get<std::string>(args->member("name")->value) ==
+               "GPU \"queue\"\n";
+  });
+  EXPECT_NE(track_name, events.end());
+}
+}  // namespace
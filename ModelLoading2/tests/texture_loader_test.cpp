@@ -0,0 +1,110 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fake_gl.h"
+#include "texture_loader.h"
+
+namespace {
+using model_loading::TextureLoader;
+using model_loading::TextureReference;
+
+constexpr size_t num_paths = 10;
+
+// 2x2 binary PPM, which stb_image decodes like any other format
+auto image_contents() -> std::string {
+  std::string contents = "P6\n2 2\n255\n";
+  for (int i = 0; i < 4; ++i) {
+    contents += {static_cast<char>(60 * i), '\x80', '\xFF'};
+  }
+  return contents;
+}
+
+class TextureLoaderTest : public testing::Test {
+ protected:
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "texture_loader_test";
+
+  auto SetUp() -> void override {
+    fake_gl::install();
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+  }
+
+  auto TearDown() -> void override { std::filesystem::remove_all(directory); }
+
+  auto write_file(const std::string& name, const std::string& contents) const
+      -> std::string {
+    const auto path = directory / name;
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    return path.string();
+  }
+
+  // Uploads on this thread, like the render loop would
+  static auto wait_for_uploads(TextureLoader& loader) -> bool {
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (loader.NumPending() != 0) {
+      if (deadline < std::chrono::steady_clock::now()) {
+        return false;
+      }
+      loader.Update(std::chrono::milliseconds(1));
+      std::this_thread::yield();
+    }
+    return true;
+  }
+};
+
+TEST_F(TextureLoaderTest, SameImageUnderManyPathsIsDecodedOnce) {
+  TextureLoader loader(4, 4);
+  std::vector<TextureReference> references;
+  for (size_t i = 0; i < num_paths; ++i) {
+    references.push_back(loader.Load(
+        write_file(std::format("copy_{}.ppm", i), image_contents())));
+  }
+  ASSERT_TRUE(wait_for_uploads(loader));
+
+  const auto stats = loader.Stats();
+  EXPECT_EQ(stats.requested, num_paths);
+  EXPECT_EQ(stats.path_hits, 0U);
+  EXPECT_EQ(stats.content_hits, num_paths - 1);
+  EXPECT_EQ(stats.decoded, 1U);
+  EXPECT_EQ(stats.uploaded, 1U);
+  EXPECT_EQ(stats.failed, 0U);
+  EXPECT_EQ(stats.num_textures, 1U);
+  for (const auto& reference : references) {
+    EXPECT_EQ(*reference.id, *references.front().id);
+  }
+  for (const auto& reference : references) {
+    loader.Release(reference.slot);
+  }
+  EXPECT_EQ(loader.Stats().num_textures, 0U);
+}
+
+TEST_F(TextureLoaderTest, FailedDecodeIsNotCounted) {
+  TextureLoader loader(1, 1);
+  const auto not_an_image = write_file("not_an_image.ppm", "P6\nbroken");
+
+  testing::internal::CaptureStderr();
+  const auto reference = loader.Load(not_an_image);
+  const auto uploaded = wait_for_uploads(loader);
+  testing::internal::GetCapturedStderr();
+
+  ASSERT_TRUE(uploaded);
+  const auto stats = loader.Stats();
+  EXPECT_EQ(stats.decoded, 0U);
+  EXPECT_EQ(stats.failed, 1U);
+  EXPECT_EQ(stats.uploaded, 0U);
+  loader.Release(reference.slot);
+}
+}  // namespace
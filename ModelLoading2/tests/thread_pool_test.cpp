@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace {
+using model_loading::ThreadPool;
+
+TEST(ThreadPoolTest, ParallelForRunsEveryIndexOnce) {
+  ThreadPool thread_pool(4);
+  std::vector<std::atomic<int>> runs(10'000);
+  thread_pool.ParallelFor(runs.size(), [&](const size_t i) { ++runs[i]; });
+  for (size_t i = 0; i < runs.size(); ++i) {
+    ASSERT_EQ(runs[i].load(), 1) << "index " << i;
+  }
+}
+
+TEST(ThreadPoolTest, TasksSubmittedFromManyThreadsAllRun) {
+  ThreadPool thread_pool(4);
+  std::atomic<size_t> num_run = 0;
+  constexpr size_t num_submitters = 4;
+  constexpr size_t tasks_per_submitter = 50'000;
+  {
+    std::vector<std::jthread> submitters;
+    for (size_t i = 0; i < num_submitters; ++i) {
+      submitters.emplace_back([&]() {
+        for (size_t task = 0; task < tasks_per_submitter; ++task) {
+          thread_pool.Submit([&]() { ++num_run; });
+        }
+      });
+    }
+  }
+  thread_pool.Wait();
+  EXPECT_EQ(num_run.load(), num_submitters * tasks_per_submitter);
+}
+
+// Workers fall asleep between the bursts, each burst has to wake them
+TEST(ThreadPoolTest, SleepingWorkersWakeForEveryBurst) {
+  ThreadPool thread_pool(8);
+  std::atomic<size_t> num_run = 0;
+  for (int burst = 0; burst < 200; ++burst) {
+    if (burst % 20 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (int task = 0; task < 1 + burst % 7; ++task) {
+      thread_pool.Submit([&]() { ++num_run; });
+    }
+    thread_pool.Wait();
+  }
+  size_t expected = 0;
+  for (int burst = 0; burst < 200; ++burst) {
+    expected += 1 + burst % 7;
+  }
+  EXPECT_EQ(num_run.load(), expected);
+}
+
+TEST(ThreadPoolTest, DestructorFinishesQueuedTasks) {
+  std::atomic<size_t> num_run = 0;
+  {
+    ThreadPool thread_pool(2);
+    for (int task = 0; task < 1000; ++task) {
+      thread_pool.Submit([&]() { ++num_run; });
+    }
+  }
+  EXPECT_EQ(num_run.load(), 1000U);
+}
+}  // namespace
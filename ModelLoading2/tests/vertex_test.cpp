@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "vertex.h"
+
+namespace {
+using model_loading::PackedVertex;
+using model_loading::Vertex;
+
+const glm::vec3 bounds_min(-10.0f, 0.0f, -2.5f);
+const glm::vec3 bounds_max(15.0f, 4.0f, 2.5f);
+
+// Positions anywhere in the bounds, unit normals in every direction and UVs
+// tiling up to 4 times
+auto random_vertices(const size_t num_vertices) -> std::vector<Vertex> {
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::normal_distribution<float> gaussian;
+  std::uniform_real_distribution<float> uv(-4.0f, 4.0f);
+  std::vector<Vertex> vertices(num_vertices);
+  for (auto& vertex : vertices) {
+    vertex.position =
+        bounds_min +
+        glm::vec3(unit(random), unit(random), unit(random)) *
+            (bounds_max - bounds_min);
+    vertex.normal =
+        glm::normalize(glm::vec3(gaussian(random), gaussian(random),
+                                 gaussian(random)));
+    vertex.uv = glm::vec2(uv(random), uv(random));
+  }
+  return vertices;
+}
+
+// Of unit vectors, accurate for small angles unlike acos
+auto degrees_between(const glm::vec3 a, const glm::vec3 b) -> float {
+  return glm::degrees(
+      std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+}
+
+TEST(VertexTest, PackedVertexIsHalfTheSize) {
+  EXPECT_EQ(sizeof(PackedVertex) * 2, sizeof(Vertex));
+}
+
+TEST(VertexTest, EveryAttributeDecodesWithinItsQuantizationBound) {
+  const auto vertices = random_vertices(200'000);
+  const auto packed =
+      model_loading::PackVertices(vertices, bounds_min, bounds_max);
+  // Rounding to the nearest of 65536 steps over the extent of each axis,
+  // plus the float rounding of decoding, a few ulps of the largest coordinate
+  const auto half_step = (bounds_max - bounds_min) / (2.0f * 65535.0f);
+  const float decode_rounding =
+      4.0f * std::numeric_limits<float>::epsilon() * 15.0f;
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const auto decoded =
+        model_loading::UnpackVertex(packed[i], bounds_min, bounds_max);
+    for (int axis = 0; axis < 3; ++axis) {
+      ASSERT_LE(std::abs(decoded.position[axis] - vertices[i].position[axis]),
+                half_step[axis] + decode_rounding)
+          << "vertex " << i << " axis " << axis;
+      // Half floats keep 11 significant bits
+      ASSERT_LE(std::abs(decoded.uv[axis % 2] - vertices[i].uv[axis % 2]),
+                std::abs(vertices[i].uv[axis % 2]) / 2048.0f + 1e-7f)
+          << "vertex " << i;
+    }
+    ASSERT_LT(degrees_between(decoded.normal, vertices[i].normal), 0.005f)
+        << "vertex " << i;
+  }
+}
+
+TEST(VertexTest, MeasuredErrorIsTheWorstOfEveryVertex) {
+  const auto vertices = random_vertices(10'000);
+  const auto packed =
+      model_loading::PackVertices(vertices, bounds_min, bounds_max);
+  model_loading::PackingError expected{};
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const auto decoded =
+        model_loading::UnpackVertex(packed[i], bounds_min, bounds_max);
+    expected.max_position_error =
+        std::max(expected.max_position_error,
+                 glm::length(decoded.position - vertices[i].position));
+    expected.max_normal_error_degrees =
+        std::max(expected.max_normal_error_degrees,
+                 degrees_between(decoded.normal, vertices[i].normal));
+    expected.max_uv_error = std::max(
+        expected.max_uv_error, glm::length(decoded.uv - vertices[i].uv));
+  }
+
+  const auto error = model_loading::MeasurePackingError(vertices, packed,
+                                                        bounds_min, bounds_max);
+  EXPECT_FLOAT_EQ(error.max_position_error, expected.max_position_error);
+  // The report normalizes the normals again
+  EXPECT_NEAR(error.max_normal_error_degrees,
+              expected.max_normal_error_degrees, 1e-6f);
+  EXPECT_FLOAT_EQ(error.max_uv_error, expected.max_uv_error);
+  // The whole report stays within the per attribute bounds
+  EXPECT_LE(error.max_position_error,
+            glm::length(bounds_max - bounds_min) / (2.0f * 65535.0f));
+  EXPECT_LT(error.max_normal_error_degrees, 0.005f);
+  EXPECT_LE(error.max_uv_error, 4.0f * std::sqrt(2.0f) / 2048.0f);
+}
+
+TEST(VertexTest, BoundsAndAxesDecodeExactly) {
+  for (const auto position : {bounds_min, bounds_max}) {
+    const auto decoded = model_loading::UnpackVertex(
+        model_loading::PackVertex(
+            Vertex{.position = position, .normal = {0, 0, 1}, .uv = {0, 1}},
+            bounds_min, bounds_max),
+        bounds_min, bounds_max);
+    EXPECT_EQ(decoded.position, position);
+    EXPECT_EQ(decoded.uv, glm::vec2(0.0f, 1.0f));
+  }
+  for (const auto normal :
+       {glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+        glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)}) {
+    EXPECT_EQ(model_loading::DecodeOctahedral(
+                  model_loading::EncodeOctahedral(normal)),
+              normal);
+  }
+}
+
+TEST(VertexTest, FlatAxisAndZeroNormalPackToDefaults) {
+  // A mesh flat along y, bounds_min.y == bounds_max.y
+  const glm::vec3 flat_max(1.0f, 0.0f, 1.0f);
+  const Vertex vertex{
+      .position = {0.5f, 0.0f, 0.25f}, .normal = {0, 0, 0}, .uv = {0, 0}};
+  const auto packed =
+      model_loading::PackVertex(vertex, glm::vec3(0.0f), flat_max);
+  const auto decoded =
+      model_loading::UnpackVertex(packed, glm::vec3(0.0f), flat_max);
+  EXPECT_EQ(decoded.position.y, 0.0f);
+  EXPECT_NEAR(decoded.position.x, 0.5f, 1.0f / 65535.0f);
+  // No code is left for zero normals, they decode as +Z
+  EXPECT_EQ(decoded.normal, glm::vec3(0.0f, 0.0f, 1.0f));
+  // and are skipped by the report
+  const auto error = model_loading::MeasurePackingError(
+      std::span(&vertex, 1), std::span(&packed, 1), glm::vec3(0.0f), flat_max);
+  EXPECT_EQ(error.max_normal_error_degrees, 0.0f);
+}
+}  // namespace
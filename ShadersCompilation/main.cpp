@@ -1,3 +1,4 @@
+#include <chrono>
 #include <cstdlib>
 #include <exception>
 #include <fstream>
@@ -11,6 +12,8 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "program_cache/program_cache.h"
+
 template <typename... Args>
 static void printError(Args... args) noexcept {
   try {
@@ -42,17 +45,9 @@ auto ReadFile(const std::string &filename) -> std::string {
   return strBuf.str();
 };
 
-auto GetShaderFromFile(const std::string &filename, GLenum type) noexcept
+auto GetShaderFromSource(const std::string &source_code,
+                         const std::string &filename, GLenum type) noexcept
     -> unsigned int {
-  std::string source_code;
-  try {
-    source_code = ReadFile(filename);
-  } catch (const std::exception &ex) {
-    printError("Error reading from file \"", filename.c_str(),
-               "\": ", ex.what(), "\n");
-    return 0;
-  }
-
   if (source_code.empty()) {
     return 0;
   }
@@ -78,6 +73,16 @@ auto GetShaderFromFile(const std::string &filename, GLenum type) noexcept
   return shader;
 }
 
+auto ReadShaderSource(const std::string &filename) noexcept -> std::string {
+  try {
+    return ReadFile(filename);
+  } catch (const std::exception &ex) {
+    printError("Error reading from file \"", filename.c_str(),
+               "\": ", ex.what(), "\n");
+    return "";
+  }
+}
+
 auto main() -> int {
   if (glfwInit() != GLFW_TRUE) {
     printError("Initialization failed\n");
@@ -107,32 +112,55 @@ auto main() -> int {
     printError("Glew Error: ", glewGetErrorString(glew_err), "\n");
   }
 
-  unsigned int vertex_shader =
-      GetShaderFromFile("shaders/vertex.glsl", GL_VERTEX_SHADER);
-  if (vertex_shader == 0) {
-    printError("Error building VERTEX SHADER\n");
-    exit(EXIT_FAILURE);
-  }
-  unsigned int fragment_shader =
-      GetShaderFromFile("shaders/fragment.glsl", GL_FRAGMENT_SHADER);
-  if (fragment_shader == 0) {
-    printError("Error building FRAGMENT SHADER\n");
-    exit(EXIT_FAILURE);
-  }
-
-  const auto program = glCreateProgram();
-  glAttachShader(program, vertex_shader);
-  glAttachShader(program, fragment_shader);
-  glLinkProgram(program);
-  int link_successful = 0;
-  glGetProgramiv(program, GL_LINK_STATUS, &link_successful);
-  if (link_successful == 0) {
-    GLsizei log_length = 0;
-    const unsigned int buf_len = 1024;
-    GLchar message[buf_len];
-    glGetProgramInfoLog(program, buf_len, &log_length, message);
-    printError("Error linking program ", program, ": ", message, "\n");
+  const auto vertex_source = ReadShaderSource("shaders/vertex.glsl");
+  const auto fragment_source = ReadShaderSource("shaders/fragment.glsl");
+
+  // Linked programs are cached on disk, so only the first run compiles
+  const auto link_start = std::chrono::steady_clock::now();
+  const auto cache_key = program_cache::key_for(vertex_source, fragment_source);
+  auto program = program_cache::load("shader_cache", cache_key);
+  const auto cache_hit = program != 0;
+  if (!cache_hit) {
+    unsigned int vertex_shader = GetShaderFromSource(
+        vertex_source, "shaders/vertex.glsl", GL_VERTEX_SHADER);
+    if (vertex_shader == 0) {
+      printError("Error building VERTEX SHADER\n");
+      exit(EXIT_FAILURE);
+    }
+    unsigned int fragment_shader = GetShaderFromSource(
+        fragment_source, "shaders/fragment.glsl", GL_FRAGMENT_SHADER);
+    if (fragment_shader == 0) {
+      printError("Error building FRAGMENT SHADER\n");
+      exit(EXIT_FAILURE);
+    }
+
+    program = glCreateProgram();
+    program_cache::prepare_for_link(program);
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glLinkProgram(program);
+    glDetachShader(program, vertex_shader);
+    glDetachShader(program, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    int link_successful = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_successful);
+    if (link_successful == 0) {
+      GLsizei log_length = 0;
+      const unsigned int buf_len = 1024;
+      GLchar message[buf_len];
+      glGetProgramInfoLog(program, buf_len, &log_length, message);
+      printError("Error linking program ", program, ": ", message, "\n");
+    } else {
+      program_cache::store("shader_cache", cache_key, program);
+    }
   }
+  const std::chrono::duration<double, std::milli> link_time =
+      std::chrono::steady_clock::now() - link_start;
+  const auto cache_stats = program_cache::stats();
+  std::cout << "Program cache " << (cache_hit ? "hit" : "miss") << ", "
+            << link_time.count() << " ms (" << cache_stats.hits << " hits, "
+            << cache_stats.misses << " misses)\n";
 
   while (glfwWindowShouldClose(window) == GLFW_FALSE) {
     // Keep running
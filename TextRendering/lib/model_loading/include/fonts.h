@@ -17,6 +17,13 @@ using Vertex2 = struct Vertex2 {
 static constexpr uint32_t font_atlas_width = 1024;
 static constexpr uint32_t font_atlas_height = 1024;
 
+// Read from ASCII 32(Space) to ASCII 126(~).
+static constexpr uint32_t code_point_first_char = 32;
+static constexpr uint32_t amount_chars_to_read = 95;
+
+// Font pixel height
+static constexpr float font_size = 64.0F;
+
 [[nodiscard]]
 inline uint8_t* read_font_atlas(const std::string& filename) {
   auto input_file_stream = std::ifstream(filename, std::ios::binary);
@@ -29,20 +36,13 @@ inline uint8_t* read_font_atlas(const std::string& filename) {
   return font_data_buf;
 }
 
-uint8_t* load_atlas_bitmap(const uint8_t* font_data_buf) {
+// packed_chars and aligned_quads hold amount_chars_to_read glyphs
+uint8_t* load_atlas_bitmap(const uint8_t* font_data_buf,
+                           stbtt_packedchar packed_chars[],
+                           stbtt_aligned_quad aligned_quads[]) {
   uint8_t* font_atlas_bitmap =
       new uint8_t[font_atlas_width * font_atlas_height];
 
-  // Read from ASCII 32(Space) to ASCII 126(~).
-  constexpr uint32_t code_point_first_char = 32;
-  constexpr uint32_t amount_chars_to_read = 95;
-
-  // Font pixel height
-  constexpr float font_size = 64.0F;
-
-  stbtt_packedchar packed_chars[amount_chars_to_read];
-  stbtt_aligned_quad aligned_quads[amount_chars_to_read];
-
   stbtt_pack_context pack_context;
   stbtt_PackBegin(&pack_context, font_atlas_bitmap, font_atlas_width,
                   font_atlas_height, 0, 1, nullptr);
@@ -94,17 +94,18 @@ unsigned int generate_font_atlas_texture(const uint8_t* font_atlas_bitmap) {
   return font_atlas_texture_id;
 }
 
+// Appends two triangles per glyph to vertices
 void draw_text(const std::string& text, glm::vec3 position, glm::vec4 color,
                float size, float pixel_scale, stbtt_packedchar packed_chars[],
                stbtt_aligned_quad aligned_quads[],
                unsigned int code_point_first_char,
-               unsigned int chars_to_include_in_font_alias) {
+               unsigned int chars_to_include_in_font_alias,
+               std::vector<Vertex2>& vertices) {
   glm::vec3 localPosition = position;
 
-  std::vector<Vertex2> vertices;
   for (char ch : text) {
     if (ch >= code_point_first_char &&
-        ch <= code_point_first_char + chars_to_include_in_font_alias) {
+        ch < code_point_first_char + chars_to_include_in_font_alias) {
       stbtt_packedchar* packed_char = &packed_chars[ch - code_point_first_char];
       stbtt_aligned_quad* aligned_quad =
           &aligned_quads[ch - code_point_first_char];
@@ -137,16 +138,13 @@ void draw_text(const std::string& text, glm::vec3 position, glm::vec4 color,
           {aligned_quad->s0, aligned_quad->t1},
           {aligned_quad->s1, aligned_quad->t1}};
 
-      // int vertex_index = 0; Tal vez deba ser local, sobretodo si uso un mesh
-      static int vertex_index = 0;
       int order[6] = {0, 1, 2, 0, 2, 3};
       for (int i = 0; i < 6; i++) {
-        vertices[vertex_index + i].position =
-            glm::vec3(glyph_vertices[order[i]], position.z);
-        vertices[vertex_index + i].color = color;
-        vertices[vertex_index + i].uv = glyph_texture_coordinates[order[i]];
+        vertices.push_back(
+            Vertex2{.position = glm::vec3(glyph_vertices[order[i]], position.z),
+                    .color = color,
+                    .uv = glyph_texture_coordinates[order[i]]});
       }
-      vertex_index += 6;
 
       localPosition.x += packed_char->xadvance * pixel_scale * size;
     } else if (ch == '\n') {                          // Handle newline
@@ -0,0 +1,101 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+
+#include "error.h"
+
+namespace text_renderer {
+using FenceId = uint64_t;
+
+// Where the ring buffer gets its GPU fences from. Implemented with GL sync
+// objects for rendering and with a fake in tests.
+class FenceSource {
+ public:
+  virtual ~FenceSource() = default;
+
+  virtual auto Insert() -> FenceId = 0;
+  [[nodiscard]] virtual auto IsSignaled(FenceId fence) -> bool = 0;
+  // Blocks until the fence is signaled
+  virtual auto Wait(FenceId fence) -> void = 0;
+  virtual auto Release(FenceId fence) -> void = 0;
+};
+
+using RingBufferRegion = struct RingBufferRegion {
+  size_t offset;
+  size_t size;
+};
+
+using RingBufferStats = struct RingBufferStats {
+  uint64_t allocations;
+  // Times the CPU had to wait on a fence before it could write
+  uint64_t stalls;
+  // Times an allocation did not fit before the end and restarted at offset 0
+  uint64_t wraps;
+};
+
+// Hands out write regions of a fixed size buffer and retires them per frame
+// once the fence inserted at the end of the frame has been signaled. Only does
+// the bookkeeping, the memory itself is owned by the caller.
+class RingBufferAllocator {
+ private:
+  using InFlightFrame = struct InFlightFrame {
+    FenceId fence;
+    size_t bytes;
+  };
+
+  FenceSource* fence_source_ = nullptr;
+  size_t capacity_ = 0;
+  unsigned int num_frames_ = 0;
+
+  size_t head_ = 0;
+  // Bytes not yet retired, including the bytes skipped when wrapping
+  size_t used_ = 0;
+  size_t current_frame_bytes_ = 0;
+  std::deque<InFlightFrame> in_flight_frames_;
+  RingBufferStats stats_ = {};
+
+  auto retire_front() -> void;
+  auto wait_front() -> void;
+
+ public:
+  RingBufferAllocator() = default;
+  // Triple buffering is num_frames = 3
+  RingBufferAllocator(FenceSource* fence_source, size_t capacity,
+                      unsigned int num_frames);
+
+  RingBufferAllocator(const RingBufferAllocator&) = delete;
+  auto operator=(const RingBufferAllocator&) -> RingBufferAllocator& = delete;
+  RingBufferAllocator(RingBufferAllocator&& other) noexcept;
+  auto operator=(RingBufferAllocator&& other) noexcept -> RingBufferAllocator&;
+
+  ~RingBufferAllocator();
+
+  // Retires finished frames and waits if num_frames are still in flight
+  auto BeginFrame() -> void;
+
+  // Fences every region allocated since BeginFrame
+  auto EndFrame() -> void;
+
+  // Retires every frame whose fence is signaled, without blocking
+  auto Retire() -> void;
+
+  // Waits on the oldest frames until the region is free. Offset is rounded
+  // up to a multiple of alignment, which doesn't need to be a power of two so
+  // vertex sized alignments work with glDrawArrays first.
+  [[nodiscard]] auto Allocate(size_t size, size_t alignment)
+      -> std::expected<RingBufferRegion, Error>;
+
+  [[nodiscard]] auto Capacity() const -> size_t { return capacity_; }
+  [[nodiscard]] auto Used() const -> size_t { return used_; }
+  [[nodiscard]] auto FramesInFlight() const -> size_t {
+    return in_flight_frames_.size();
+  }
+  [[nodiscard]] auto Stats() const -> RingBufferStats { return stats_; }
+};
+}  // namespace text_renderer
+
+#endif  // RING_BUFFER_H
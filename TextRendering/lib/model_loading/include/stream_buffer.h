@@ -0,0 +1,66 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <GL/glew.h>
+
+#include <expected>
+#include <memory>
+
+#include "error.h"
+#include "ring_buffer.h"
+
+namespace text_renderer {
+class GlFenceSource final : public FenceSource {
+ public:
+  auto Insert() -> FenceId override;
+  [[nodiscard]] auto IsSignaled(FenceId fence) -> bool override;
+  auto Wait(FenceId fence) -> void override;
+  auto Release(FenceId fence) -> void override;
+};
+
+using StreamBufferRegion = struct StreamBufferRegion {
+  std::byte* data;
+  size_t offset;
+  size_t size;
+};
+
+// Persistently mapped buffer streamed through a RingBufferAllocator, so
+// writing a new chunk never waits for the GPU to finish reading the last one
+class StreamBuffer {
+ private:
+  unsigned int buffer_id_ = 0;
+  std::byte* mapped_ = nullptr;
+  std::unique_ptr<GlFenceSource> fence_source_;
+  RingBufferAllocator allocator_;
+
+  StreamBuffer(unsigned int buffer_id, std::byte* mapped,
+               std::unique_ptr<GlFenceSource> fence_source, size_t capacity,
+               unsigned int num_frames);
+
+ public:
+  // Delete copy constructors
+  StreamBuffer(const StreamBuffer&) = delete;
+  auto operator=(const StreamBuffer&) -> StreamBuffer& = delete;
+
+  // Take ownership of the buffer
+  StreamBuffer(StreamBuffer&& other) noexcept;
+
+  ~StreamBuffer();
+
+  static auto Create(size_t capacity, unsigned int num_frames)
+      -> std::expected<StreamBuffer, Error>;
+
+  auto BeginFrame() -> void;
+  auto EndFrame() -> void;
+
+  [[nodiscard]] auto Allocate(size_t size, size_t alignment)
+      -> std::expected<StreamBufferRegion, Error>;
+
+  [[nodiscard]] auto Id() const -> unsigned int { return buffer_id_; }
+  [[nodiscard]] auto Stats() const -> RingBufferStats {
+    return allocator_.Stats();
+  }
+};
+}  // namespace text_renderer
+
+#endif  // STREAM_BUFFER_H
@@ -0,0 +1,127 @@
+#include "ring_buffer.h"
+
+#include <format>
+#include <tuple>
+#include <utility>
+
+namespace text_renderer {
+RingBufferAllocator::RingBufferAllocator(FenceSource* fence_source,
+                                         const size_t capacity,
+                                         const unsigned int num_frames)
+    : fence_source_(fence_source),
+      capacity_(capacity),
+      num_frames_(num_frames) {}
+
+RingBufferAllocator::RingBufferAllocator(RingBufferAllocator&& other) noexcept {
+  *this = std::move(other);
+}
+
+auto RingBufferAllocator::operator=(RingBufferAllocator&& other) noexcept
+    -> RingBufferAllocator& {
+  std::swap(fence_source_, other.fence_source_);
+  std::swap(capacity_, other.capacity_);
+  std::swap(num_frames_, other.num_frames_);
+  std::swap(head_, other.head_);
+  std::swap(used_, other.used_);
+  std::swap(current_frame_bytes_, other.current_frame_bytes_);
+  std::swap(in_flight_frames_, other.in_flight_frames_);
+  std::swap(stats_, other.stats_);
+  return *this;
+}
+
+RingBufferAllocator::~RingBufferAllocator() {
+  for (const auto& frame : in_flight_frames_) {
+    fence_source_->Release(frame.fence);
+  }
+}
+
+auto RingBufferAllocator::retire_front() -> void {
+  const auto frame = in_flight_frames_.front();
+  in_flight_frames_.pop_front();
+  fence_source_->Release(frame.fence);
+  used_ -= frame.bytes;
+}
+
+auto RingBufferAllocator::wait_front() -> void {
+  ++stats_.stalls;
+  fence_source_->Wait(in_flight_frames_.front().fence);
+  retire_front();
+}
+
+auto RingBufferAllocator::Retire() -> void {
+  while (!in_flight_frames_.empty() &&
+         fence_source_->IsSignaled(in_flight_frames_.front().fence)) {
+    retire_front();
+  }
+}
+
+auto RingBufferAllocator::BeginFrame() -> void {
+  Retire();
+  // The frame about to be written takes one of the num_frames slots, the
+  // num_frames - 1 before it can stay in flight
+  while (num_frames_ <= in_flight_frames_.size() &&
+         !in_flight_frames_.empty()) {
+    wait_front();
+  }
+}
+
+auto RingBufferAllocator::EndFrame() -> void {
+  if (current_frame_bytes_ == 0) {
+    return;
+  }
+  in_flight_frames_.push_back(InFlightFrame{
+      .fence = fence_source_->Insert(), .bytes = current_frame_bytes_});
+  current_frame_bytes_ = 0;
+}
+
+auto RingBufferAllocator::Allocate(const size_t size, const size_t alignment)
+    -> std::expected<RingBufferRegion, Error> {
+  if (size == 0 || alignment == 0) {
+    return std::unexpected(Error{.message = "Invalid allocation size"});
+  }
+  if (capacity_ < size) {
+    return std::unexpected(Error{
+        .message = std::format("Allocation of {} bytes exceeds capacity {}",
+                               size, capacity_)});
+  }
+
+  // Where the region goes depends on head_, which restarts at 0 once
+  // everything is retired, so it's placed again after every wait
+  const auto place = [this, size, alignment]() {
+    if (used_ == 0) {
+      head_ = 0;
+    }
+    const auto aligned_head = (head_ + alignment - 1) / alignment * alignment;
+    const bool wraps = capacity_ < aligned_head + size;
+    // Skipped bytes stay used until the frame that skipped them is retired
+    return std::tuple{wraps, wraps ? size_t{0} : aligned_head,
+                      wraps ? (capacity_ - head_) + size
+                            : (aligned_head - head_) + size};
+  };
+  auto [wraps, offset, needed] = place();
+  while (capacity_ - used_ < needed) {
+    if (in_flight_frames_.empty()) {
+      // The current frame alone filled the buffer, fence what it wrote so far
+      EndFrame();
+    }
+    if (in_flight_frames_.empty()) {
+      // Nothing left to wait for, can't happen for a size within capacity
+      return std::unexpected(Error{
+          .message = std::format("Allocation of {} bytes with alignment {} "
+                                 "doesn't fit in capacity {}",
+                                 size, alignment, capacity_)});
+    }
+    wait_front();
+    std::tie(wraps, offset, needed) = place();
+  }
+
+  if (wraps) {
+    ++stats_.wraps;
+  }
+  ++stats_.allocations;
+  head_ = offset + size;
+  used_ += needed;
+  current_frame_bytes_ += needed;
+  return RingBufferRegion{.offset = offset, .size = size};
+}
+}  // namespace text_renderer
@@ -0,0 +1,98 @@
+#include "stream_buffer.h"
+
+#include <format>
+#include <utility>
+
+namespace text_renderer {
+auto GlFenceSource::Insert() -> FenceId {
+  return reinterpret_cast<FenceId>(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+auto GlFenceSource::IsSignaled(const FenceId fence) -> bool {
+  const auto result =
+      glClientWaitSync(reinterpret_cast<GLsync>(fence), 0, 0);
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+auto GlFenceSource::Wait(const FenceId fence) -> void {
+  static constexpr GLuint64 wait_timeout_ns = 1'000'000;
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  while (true) {
+    const auto result = glClientWaitSync(reinterpret_cast<GLsync>(fence),
+                                         flags, wait_timeout_ns);
+    if (result != GL_TIMEOUT_EXPIRED) {
+      return;
+    }
+    flags = 0;
+  }
+}
+
+auto GlFenceSource::Release(const FenceId fence) -> void {
+  glDeleteSync(reinterpret_cast<GLsync>(fence));
+}
+
+StreamBuffer::StreamBuffer(const unsigned int buffer_id, std::byte* mapped,
+                           std::unique_ptr<GlFenceSource> fence_source,
+                           const size_t capacity, const unsigned int num_frames)
+    : buffer_id_(buffer_id),
+      mapped_(mapped),
+      fence_source_(std::move(fence_source)),
+      allocator_(fence_source_.get(), capacity, num_frames) {}
+
+StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept {
+  std::swap(buffer_id_, other.buffer_id_);
+  std::swap(mapped_, other.mapped_);
+  std::swap(fence_source_, other.fence_source_);
+  std::swap(allocator_, other.allocator_);
+}
+
+StreamBuffer::~StreamBuffer() {
+  // Fences are released by the allocator before the buffer goes away
+  allocator_ = RingBufferAllocator();
+  if (buffer_id_ != 0) {
+    glUnmapNamedBuffer(buffer_id_);
+    glDeleteBuffers(1, &buffer_id_);
+  }
+}
+
+auto StreamBuffer::Create(const size_t capacity, const unsigned int num_frames)
+    -> std::expected<StreamBuffer, Error> {
+  if (capacity == 0 || num_frames == 0) {
+    return std::unexpected(
+        Error{.message = "Stream buffer needs a capacity and frame count"});
+  }
+  static constexpr GLbitfield map_flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  unsigned int buffer_id;
+  glCreateBuffers(1, &buffer_id);
+  glNamedBufferStorage(buffer_id, static_cast<GLsizeiptr>(capacity), nullptr,
+                       map_flags);
+  auto* mapped = static_cast<std::byte*>(glMapNamedBufferRange(
+      buffer_id, 0, static_cast<GLsizeiptr>(capacity), map_flags));
+  if (mapped == nullptr) {
+    glDeleteBuffers(1, &buffer_id);
+    return std::unexpected(Error{
+        .message = std::format("Could not map stream buffer of {} bytes",
+                               capacity)});
+  }
+  return StreamBuffer(buffer_id, mapped, std::make_unique<GlFenceSource>(),
+                      capacity, num_frames);
+}
+
+auto StreamBuffer::BeginFrame() -> void { allocator_.BeginFrame(); }
+
+auto StreamBuffer::EndFrame() -> void { allocator_.EndFrame(); }
+
+auto StreamBuffer::Allocate(const size_t size, const size_t alignment)
+    -> std::expected<StreamBufferRegion, Error> {
+  const auto region = allocator_.Allocate(size, alignment);
+  if (!region) {
+    return std::unexpected(
+        with_context(region.error(), "Could not allocate stream region"));
+  }
+  return StreamBufferRegion{.data = mapped_ + region->offset,
+                            .offset = region->offset,
+                            .size = region->size};
+}
+}  // namespace text_renderer
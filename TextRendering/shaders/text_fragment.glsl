@@ -0,0 +1,12 @@
+#version 450 core
+
+layout (location = 0) out vec4 fColor;
+
+in vec4 color;
+in vec2 texCoords;
+
+uniform sampler2D uFontAtlasTexture;
+
+void main() {
+    fColor = vec4(texture(uFontAtlasTexture, texCoords).r) * color;
+}
@@ -0,0 +1,16 @@
+#version 450 core
+
+layout (location = 0) in vec3 vPos;
+layout (location = 1) in vec4 vColor;
+layout (location = 2) in vec2 vTexPos;
+
+uniform mat4 uViewProjectionMat;
+
+out vec4 color;
+out vec2 texCoords;
+
+void main() {
+    gl_Position = uViewProjectionMat * vec4(vPos, 1.0);
+    color = vColor;
+    texCoords = vTexPos;
+}
@@ -4,6 +4,9 @@
 #include <GLFW/glfw3.h>
 #include <stb_truetype.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
@@ -12,6 +15,7 @@
 #include "mesh.h"
 #include "model.h"
 #include "program.h"
+#include "stream_buffer.h"
 
 void APIENTRY glDebugCallback(GLenum source, GLenum type, GLuint error_id,
                               GLenum severity, GLsizei length,
@@ -25,40 +29,49 @@ void glfwErrorCallback(const int error, const char* description) {
   std::cerr << "GLFW error: " << description << "\n";
 }
 
-const size_t VBO_SIZE = 600000 * sizeof(text_renderer::Vertex2);
-
-static void Render(const std::vector<text_renderer::Vertex2>& vertices,
-                   unsigned int shader_program_id, unsigned int vao,
-                   unsigned int vbo, glm::mat4 view_projection_matrix) {
-  // The vertex buffer need to be divided into chunks of size 'VBO_SIZE',
-  // Upload them to the VBO and render
-  // This is repeated for every divided chunk of the vertex buffer.
-  size_t sizeOfVertices = vertices.size() * sizeof(text_renderer::Vertex2);
-  uint32_t drawCallCount =
-      (sizeOfVertices / VBO_SIZE) + 1;  // aka number of chunks.
-
-  // Render each chunk of vertex data.
-  for (int i = 0; i < drawCallCount; i++) {
-    const text_renderer::Vertex2* data = vertices.data() + i * VBO_SIZE;
-
-    uint32_t vertexCount =
-        i == drawCallCount - 1
-            ? (sizeOfVertices % VBO_SIZE) / sizeof(text_renderer::Vertex2)
-            : VBO_SIZE / (sizeof(text_renderer::Vertex2) * 6);
-
-    int uniformLocation =
-        glGetUniformLocation(shader_program_id, "uViewProjectionMat");
-    glUniformMatrix4fv(uniformLocation, 1, GL_TRUE,
-                       glm::value_ptr(view_projection_matrix));
-
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferSubData(
-        GL_ARRAY_BUFFER, 0,
-        i == drawCallCount - 1 ? sizeOfVertices % VBO_SIZE : VBO_SIZE, data);
-
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+static constexpr size_t stream_buffer_size = 600000 * sizeof(Vertex2);
+// Triple buffered: the CPU writes one frame while the GPU reads the other two
+static constexpr unsigned int stream_buffer_frames = 3;
+
+static auto Render(const std::vector<Vertex2>& vertices,
+                   const text_renderer::Program& program, unsigned int vao,
+                   text_renderer::StreamBuffer* stream_buffer,
+                   glm::mat4 view_projection_matrix)
+    -> std::expected<void, text_renderer::Error> {
+  // Chunks hold whole triangles and fit in one frame's share of the buffer
+  static constexpr size_t max_chunk_vertices =
+      stream_buffer_size / stream_buffer_frames / sizeof(Vertex2) / 3 * 3;
+
+  if (const auto res = program.SetUniformMatrix("uViewProjectionMat",
+                                                view_projection_matrix);
+      !res) {
+    return std::unexpected(res.error());
   }
+  program.Use();
+
+  glBindVertexArray(vao);
+  glVertexArrayVertexBuffer(vao, 0, stream_buffer->Id(), 0, sizeof(Vertex2));
+
+  stream_buffer->BeginFrame();
+  for (size_t first = 0; first < vertices.size();
+       first += max_chunk_vertices) {
+    const auto chunk_vertices =
+        std::min(max_chunk_vertices, vertices.size() - first);
+    // Aligned to the vertex size so the offset maps to a first vertex index
+    const auto region = stream_buffer->Allocate(
+        chunk_vertices * sizeof(Vertex2), sizeof(Vertex2));
+    if (!region) {
+      stream_buffer->EndFrame();
+      return std::unexpected(
+          with_context(region.error(), "Could not stream text vertices"));
+    }
+    std::memcpy(region->data, vertices.data() + first, region->size);
+    glDrawArrays(GL_TRIANGLES,
+                 static_cast<GLint>(region->offset / sizeof(Vertex2)),
+                 static_cast<GLsizei>(chunk_vertices));
+  }
+  stream_buffer->EndFrame();
+  return {};
 }
 
 auto main() -> int {
@@ -235,64 +248,137 @@ auto main() -> int {
   } else {
     std::cout << "The file contains " << font_count << " fonts.\n";
   }
-  const uint8_t* font_atlas_bitmap = load_atlas_bitmap(font_data);
+  stbtt_packedchar packed_chars[amount_chars_to_read];
+  stbtt_aligned_quad aligned_quads[amount_chars_to_read];
+  const uint8_t* font_atlas_bitmap =
+      load_atlas_bitmap(font_data, packed_chars, aligned_quads);
   const unsigned int font_atlas_texture_id =
-      generate_font_atlas_texture(font_data);
+      generate_font_atlas_texture(font_atlas_bitmap);
   // delete[] font_atlas_bitmap;
   // delete[] font_data;
 
   float pixel_scale = 2.0 / window_height;
 
+  const auto text_program = text_renderer::Program::Create(
+      "shaders/text_vertex.glsl", "shaders/text_fragment.glsl");
+  if (!text_program) {
+    std::cerr << "Failed to initialize text program: "
+              << text_program.error().message << "\n";
+    glfwTerminate();
+    return 1;
+  }
+  if (const auto res = text_program->SetUniform1I("uFontAtlasTexture", 0);
+      !res) {
+    std::cerr << "Failed to set uniform: " << res.error().message << "\n";
+    glfwTerminate();
+    return 1;
+  }
 
-  glEnable(GL_DEPTH_TEST);
-  glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
-
-  // Rendering loop
-  while (glfwWindowShouldClose(window) != GLFW_TRUE) {
-    const auto delta_time = static_cast<float>(get_delta());
-    handle_input(delta_time);
-
-    const auto projection_matrix = glm::perspective(
-        glm::radians(45.0F), window_status.aspect_ratio, 0.1F, 100.0F);
-    if (const auto set_m_projection_result =
-            program->SetUniformMatrix("mProjection", projection_matrix);
-        !set_m_projection_result) {
-      std::cerr << "Failed to set uniform: "
-                << set_m_projection_result.error().message << "\n";
-      glfwTerminate();
-      return 1;
-    }
-
-    const auto view_matrix =
-        glm::lookAt(camera_position, camera_position + camera_front, camera_up);
-    if (const auto set_m_view_result =
-            program->SetUniformMatrix("mView", view_matrix);
-        !set_m_view_result) {
-      std::cerr << "Failed to set uniform: "
-                << set_m_view_result.error().message << "\n";
+  // The stream buffer goes out of scope before glfwTerminate, its destructor
+  // unmaps the buffer and deletes its fences in the context
+  auto exit_code = 0;
+  {
+    auto stream_buffer = text_renderer::StreamBuffer::Create(
+        stream_buffer_size, stream_buffer_frames);
+    if (!stream_buffer) {
+      std::cerr << "Failed to create stream buffer: "
+                << stream_buffer.error().message << "\n";
       glfwTerminate();
       return 1;
     }
 
-    auto model_matrix = glm::mat4(1.0F);
-    if (const auto res = program->SetUniformMatrix("mModel", model_matrix);
-        !res) {
-      std::cerr << "Failed to set uniform: " << res.error().message << "\n";
-      glfwTerminate();
-      return 1;
-    }
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Vertex2 layout, the buffer is bound per frame by Render
+    unsigned int text_vao;
+    glCreateVertexArrays(1, &text_vao);
+    glEnableVertexArrayAttrib(text_vao, 0);
+    glVertexArrayAttribFormat(text_vao, 0, 3, GL_FLOAT, GL_FALSE,
+                              offsetof(Vertex2, position));
+    glVertexArrayAttribBinding(text_vao, 0, 0);
+    glEnableVertexArrayAttrib(text_vao, 1);
+    glVertexArrayAttribFormat(text_vao, 1, 4, GL_FLOAT, GL_FALSE,
+                              offsetof(Vertex2, color));
+    glVertexArrayAttribBinding(text_vao, 1, 0);
+    glEnableVertexArrayAttrib(text_vao, 2);
+    glVertexArrayAttribFormat(text_vao, 2, 2, GL_FLOAT, GL_FALSE,
+                              offsetof(Vertex2, uv));
+    glVertexArrayAttribBinding(text_vao, 2, 0);
+
+    std::vector<Vertex2> text_vertices;
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.0F, 0.0F, 0.0F, 1.0F);
+
+    // Rendering loop
+    while (glfwWindowShouldClose(window) != GLFW_TRUE) {
+      const auto delta_time = static_cast<float>(get_delta());
+      handle_input(delta_time);
+
+      const auto projection_matrix = glm::perspective(
+          glm::radians(45.0F), window_status.aspect_ratio, 0.1F, 100.0F);
+      if (const auto set_m_projection_result =
+              program->SetUniformMatrix("mProjection", projection_matrix);
+          !set_m_projection_result) {
+        std::cerr << "Failed to set uniform: "
+                  << set_m_projection_result.error().message << "\n";
+        exit_code = 1;
+        break;
+      }
 
-    program->Use();
+      const auto view_matrix = glm::lookAt(
+          camera_position, camera_position + camera_front, camera_up);
+      if (const auto set_m_view_result =
+              program->SetUniformMatrix("mView", view_matrix);
+          !set_m_view_result) {
+        std::cerr << "Failed to set uniform: "
+                  << set_m_view_result.error().message << "\n";
+        exit_code = 1;
+        break;
+      }
 
-    // Render
-    square_mesh.Draw(*program);
+      auto model_matrix = glm::mat4(1.0F);
+      if (const auto res = program->SetUniformMatrix("mModel", model_matrix);
+          !res) {
+        std::cerr << "Failed to set uniform: " << res.error().message << "\n";
+        exit_code = 1;
+        break;
+      }
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+      program->Use();
+
+      // Render
+      square_mesh.Draw(*program);
+
+      // Text goes on top of the scene, in screen space
+      text_vertices.clear();
+      draw_text("Text Rendering", glm::vec3(-0.9F, 0.8F, 0.0F),
+                glm::vec4(1.0F, 1.0F, 1.0F, 1.0F), 0.5F, pixel_scale,
+                packed_chars, aligned_quads, code_point_first_char,
+                amount_chars_to_read, text_vertices);
+      glDisable(GL_DEPTH_TEST);
+      glEnable(GL_BLEND);
+      glBindTextureUnit(0, font_atlas_texture_id);
+      const auto text_projection_matrix = glm::ortho(
+          -window_status.aspect_ratio, window_status.aspect_ratio, -1.0F, 1.0F);
+      if (const auto res = Render(text_vertices, *text_program, text_vao,
+                                  &*stream_buffer, text_projection_matrix);
+          !res) {
+        std::cerr << res.error().message << "\n";
+        exit_code = 1;
+        break;
+      }
+      glDisable(GL_BLEND);
+      glEnable(GL_DEPTH_TEST);
 
-    glUseProgram(0);
+      glUseProgram(0);
 
-    glfwSwapBuffers(window);
-    glfwPollEvents();
+      glfwSwapBuffers(window);
+      glfwPollEvents();
+    }
+    glDeleteVertexArrays(1, &text_vao);
   }
   glfwTerminate();
-  return 0;
+  return exit_code;
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "ring_buffer.h"
+
+namespace {
+using text_renderer::FenceId;
+using text_renderer::FenceSource;
+using text_renderer::RingBufferAllocator;
+
+// GPU that finishes a frame's fence only once the CPU is gpu_lag frames ahead
+// of it, or when the CPU waits on it
+class FakeFenceSource final : public FenceSource {
+ public:
+  FenceId next_fence = 0;
+  // Fences below are signaled
+  FenceId num_signaled = 0;
+  int num_waits = 0;
+  std::vector<FenceId> released;
+
+  auto Insert() -> FenceId override { return next_fence++; }
+  [[nodiscard]] auto IsSignaled(const FenceId fence) -> bool override {
+    return fence < num_signaled;
+  }
+  auto Wait(const FenceId fence) -> void override {
+    ++num_waits;
+    num_signaled = std::max(num_signaled, fence + 1);
+  }
+  auto Release(const FenceId fence) -> void override {
+    released.push_back(fence);
+  }
+
+  // Called before the CPU begins frame, frames frame - gpu_lag and later are
+  // still being rendered
+  auto Advance(const FenceId frame, const FenceId gpu_lag) -> void {
+    if (gpu_lag <= frame) {
+      num_signaled = std::max(num_signaled, frame - gpu_lag);
+    }
+  }
+};
+
+TEST(RingBufferAllocatorTest, AlignsOffsetsToAnyAlignment) {
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 1024, 3);
+  ring.BeginFrame();
+
+  const auto first = ring.Allocate(10, 1);
+  const auto second = ring.Allocate(16, 16);
+  // Vertex sized, not a power of two
+  const auto third = ring.Allocate(24, 12);
+  ASSERT_TRUE(first && second && third);
+  EXPECT_EQ(first->offset, 0U);
+  EXPECT_EQ(second->offset, 16U);
+  EXPECT_EQ(third->offset, 36U);
+  EXPECT_EQ(ring.Used(), 60U);
+  EXPECT_EQ(ring.Stats().allocations, 3U);
+  EXPECT_EQ(ring.Stats().stalls, 0U);
+}
+
+TEST(RingBufferAllocatorTest, RejectsInvalidSizes) {
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 64, 3);
+  ring.BeginFrame();
+  EXPECT_FALSE(ring.Allocate(0, 4));
+  EXPECT_FALSE(ring.Allocate(4, 0));
+  EXPECT_FALSE(ring.Allocate(65, 1));
+  EXPECT_EQ(ring.Stats().allocations, 0U);
+}
+
+TEST(RingBufferAllocatorTest, WrapsAndKeepsSkippedBytesUntilRetired) {
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 100, 3);
+  ring.BeginFrame();
+  ASSERT_TRUE(ring.Allocate(40, 1));
+  ring.EndFrame();
+  ring.BeginFrame();
+  ASSERT_TRUE(ring.Allocate(40, 1));
+  ring.EndFrame();
+
+  // Frame 0 done, its 40 bytes are free again but only at the start
+  fences.num_signaled = 1;
+  ring.BeginFrame();
+  const auto region = ring.Allocate(30, 1);
+  ASSERT_TRUE(region);
+  EXPECT_EQ(region->offset, 0U);
+  EXPECT_EQ(ring.Stats().wraps, 1U);
+  EXPECT_EQ(ring.Stats().stalls, 0U);
+  // Frame 1 plus the 20 bytes skipped at the end plus the new region
+  EXPECT_EQ(ring.Used(), 90U);
+  ring.EndFrame();
+
+  fences.num_signaled = 3;
+  ring.Retire();
+  EXPECT_EQ(ring.Used(), 0U);
+  EXPECT_EQ(ring.FramesInFlight(), 0U);
+  EXPECT_EQ(fences.released, (std::vector<FenceId>{0, 1, 2}));
+}
+
+TEST(RingBufferAllocatorTest, RetireDoesntWaitOnUnsignaledFrames) {
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 100, 3);
+  for (int frame = 0; frame < 2; ++frame) {
+    ring.BeginFrame();
+    ASSERT_TRUE(ring.Allocate(10, 1));
+    ring.EndFrame();
+  }
+
+  ring.Retire();
+  EXPECT_EQ(ring.FramesInFlight(), 2U);
+  fences.num_signaled = 1;
+  ring.Retire();
+  EXPECT_EQ(ring.FramesInFlight(), 1U);
+  EXPECT_EQ(ring.Used(), 10U);
+  EXPECT_EQ(fences.num_waits, 0);
+  EXPECT_EQ(fences.released, (std::vector<FenceId>{0}));
+}
+
+TEST(RingBufferAllocatorTest, FullBufferWaitsOnOldestFrame) {
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 100, 3);
+  ring.BeginFrame();
+  ASSERT_TRUE(ring.Allocate(80, 1));
+  ring.EndFrame();
+
+  ring.BeginFrame();
+  const auto region = ring.Allocate(80, 1);
+  ASSERT_TRUE(region);
+  EXPECT_EQ(region->offset, 0U);
+  EXPECT_EQ(ring.Stats().stalls, 1U);
+  EXPECT_EQ(fences.num_waits, 1);
+  // Frame 0 was the only one in flight, the ring was empty before the region
+  EXPECT_EQ(ring.Used(), 80U);
+  EXPECT_EQ(ring.Stats().wraps, 0U);
+}
+
+TEST(RingBufferAllocatorTest, FrameFillingTheBufferFencesItself) {
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 100, 3);
+  ring.BeginFrame();
+  ASSERT_TRUE(ring.Allocate(60, 1));
+  ASSERT_TRUE(ring.Allocate(60, 1));
+  EXPECT_EQ(fences.next_fence, 1U);
+  EXPECT_EQ(ring.Stats().stalls, 1U);
+  // Waiting retired the first region, so the second starts the empty ring
+  // over instead of wrapping
+  EXPECT_EQ(ring.Used(), 60U);
+  EXPECT_EQ(ring.Stats().wraps, 0U);
+}
+
+// Placed at the end of frame 0 the region would need the 70 bytes skipped
+// there too, more than the whole ring. Once frame 0 is retired the ring is
+// empty and the region starts over at 0.
+TEST(RingBufferAllocatorTest, RegionIsPlacedAgainAfterWaiting) {
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 100, 3);
+  ring.BeginFrame();
+  ASSERT_TRUE(ring.Allocate(30, 1));
+  ring.EndFrame();
+
+  ring.BeginFrame();
+  const auto region = ring.Allocate(80, 1);
+  ASSERT_TRUE(region);
+  EXPECT_EQ(region->offset, 0U);
+  EXPECT_EQ(ring.Stats().stalls, 1U);
+  EXPECT_EQ(ring.Stats().wraps, 0U);
+  EXPECT_EQ(ring.Used(), 80U);
+  EXPECT_EQ(ring.FramesInFlight(), 0U);
+  ring.EndFrame();
+
+  // and the ring goes on from there
+  ring.BeginFrame();
+  const auto next = ring.Allocate(20, 1);
+  ASSERT_TRUE(next);
+  EXPECT_EQ(next->offset, 80U);
+}
+
+TEST(RingBufferAllocatorTest, RegionLargerThanTheRingDoesntWait) {
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 100, 3);
+  ring.BeginFrame();
+  ASSERT_TRUE(ring.Allocate(30, 1));
+  ring.EndFrame();
+
+  ring.BeginFrame();
+  EXPECT_FALSE(ring.Allocate(101, 1));
+  EXPECT_EQ(fences.num_waits, 0);
+  EXPECT_EQ(ring.FramesInFlight(), 1U);
+  EXPECT_EQ(ring.Used(), 30U);
+  // The whole ring still fits once frame 0 is waited on
+  const auto region = ring.Allocate(100, 1);
+  ASSERT_TRUE(region);
+  EXPECT_EQ(region->offset, 0U);
+}
+
+struct FramesInFlightCase {
+  unsigned int num_frames;
+  // Per frame, after BeginFrame
+  std::vector<size_t> frames_in_flight;
+  std::vector<uint64_t> stalls;
+};
+
+class RingBufferFramesInFlightTest
+    : public testing::TestWithParam<FramesInFlightCase> {};
+
+// The GPU is two frames behind, so only triple buffering keeps it busy
+// without the CPU waiting
+TEST_P(RingBufferFramesInFlightTest, StallsOnlyWhenNumFramesAreInFlight) {
+  const auto& [num_frames, frames_in_flight, stalls] = GetParam();
+  FakeFenceSource fences;
+  RingBufferAllocator ring(&fences, 1024, num_frames);
+  for (FenceId frame = 0; frame < frames_in_flight.size(); ++frame) {
+    fences.Advance(frame, 2);
+    ring.BeginFrame();
+    EXPECT_EQ(ring.FramesInFlight(), frames_in_flight[frame])
+        << "frame " << frame;
+    EXPECT_EQ(ring.Stats().stalls, stalls[frame]) << "frame " << frame;
+    ASSERT_TRUE(ring.Allocate(64, 4));
+    ring.EndFrame();
+  }
+  EXPECT_EQ(ring.Stats().wraps, 0U);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    NumFrames, RingBufferFramesInFlightTest,
+    testing::Values(
+        FramesInFlightCase{.num_frames = 2,
+                           .frames_in_flight = {0, 1, 1, 1, 1},
+                           .stalls = {0, 0, 1, 2, 3}},
+        FramesInFlightCase{.num_frames = 3,
+                           .frames_in_flight = {0, 1, 2, 2, 2},
+                           .stalls = {0, 0, 0, 0, 0}}),
+    [](const testing::TestParamInfo<FramesInFlightCase>& info) {
+      return std::to_string(info.param.num_frames);
+    });
+}  // namespace
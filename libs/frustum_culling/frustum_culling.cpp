@@ -0,0 +1,222 @@
+#include "frustum_culling.h"
+
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+namespace frustum_culling {
+
+namespace {
+
+// The few lane operations the tests need, over simd_width floats
+#if defined(__AVX__)
+using Lanes = __m256;
+constexpr unsigned int all_lanes = 0xff;
+
+auto load(const float* values) -> Lanes { return _mm256_loadu_ps(values); }
+auto splat(const float value) -> Lanes { return _mm256_set1_ps(value); }
+auto add(const Lanes a, const Lanes b) -> Lanes { return _mm256_add_ps(a, b); }
+auto mul(const Lanes a, const Lanes b) -> Lanes { return _mm256_mul_ps(a, b); }
+// Bit per lane, set where value >= 0
+auto non_negative(const Lanes value) -> unsigned int {
+  return static_cast<unsigned int>(_mm256_movemask_ps(
+      _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GE_OQ)));
+}
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+using Lanes = __m128;
+constexpr unsigned int all_lanes = 0xf;
+
+auto load(const float* values) -> Lanes { return _mm_loadu_ps(values); }
+auto splat(const float value) -> Lanes { return _mm_set1_ps(value); }
+auto add(const Lanes a, const Lanes b) -> Lanes { return _mm_add_ps(a, b); }
+auto mul(const Lanes a, const Lanes b) -> Lanes { return _mm_mul_ps(a, b); }
+auto non_negative(const Lanes value) -> unsigned int {
+  return static_cast<unsigned int>(
+      _mm_movemask_ps(_mm_cmpge_ps(value, _mm_setzero_ps())));
+}
+#else
+using Lanes = float;
+constexpr unsigned int all_lanes = 0x1;
+
+auto load(const float* values) -> Lanes { return *values; }
+auto splat(const float value) -> Lanes { return value; }
+auto add(const Lanes a, const Lanes b) -> Lanes { return a + b; }
+auto mul(const Lanes a, const Lanes b) -> Lanes { return a * b; }
+auto non_negative(const Lanes value) -> unsigned int {
+  return value >= 0.0f ? 1 : 0;
+}
+#endif
+
+// Sums in the same order as the SIMD lanes, so every path gives the same
+// result for a bound
+auto sphere_inside(const Frustum& frustum, const Spheres& spheres,
+                   const size_t i) -> bool {
+  for (const auto& plane : frustum.planes) {
+    const float distance =
+        (plane.a * spheres.x[i] + plane.b * spheres.y[i]) +
+        ((plane.c * spheres.z[i] + plane.d) + spheres.radius[i]);
+    if (distance < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto box_inside(const Frustum& frustum, const Boxes& boxes, const size_t i)
+    -> bool {
+  for (const auto& plane : frustum.planes) {
+    const float center =
+        (plane.a * boxes.center_x[i] + plane.b * boxes.center_y[i]) +
+        (plane.c * boxes.center_z[i] + plane.d);
+    const float reach = (std::abs(plane.a) * boxes.extent_x[i] +
+                         std::abs(plane.b) * boxes.extent_y[i]) +
+                        std::abs(plane.c) * boxes.extent_z[i];
+    if (center + reach < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto append_lanes(unsigned int mask, const size_t first,
+                  std::vector<uint32_t>& visible) -> void {
+  while (mask != 0) {
+    visible.push_back(static_cast<uint32_t>(first + std::countr_zero(mask)));
+    mask &= mask - 1;
+  }
+}
+
+}  // namespace
+
+auto extract_frustum(const std::span<const float, 16> matrix) -> Frustum {
+  const auto row = [&matrix](const size_t i) -> std::array<float, 4> {
+    return {matrix[i], matrix[4 + i], matrix[8 + i], matrix[12 + i]};
+  };
+  const auto plane = [](const std::array<float, 4>& w,
+                        const std::array<float, 4>& row, const float sign) {
+    Plane plane{w[0] + sign * row[0], w[1] + sign * row[1],
+                w[2] + sign * row[2], w[3] + sign * row[3]};
+    const float length =
+        std::sqrt(plane.a * plane.a + plane.b * plane.b + plane.c * plane.c);
+    if (length > 0.0f) {
+      plane = Plane{plane.a / length, plane.b / length, plane.c / length,
+                    plane.d / length};
+    }
+    return plane;
+  };
+  // -w <= x, y, z <= w in clip space
+  const auto w = row(3);
+  return Frustum{.planes = {plane(w, row(0), 1.0f), plane(w, row(0), -1.0f),
+                            plane(w, row(1), 1.0f), plane(w, row(1), -1.0f),
+                            plane(w, row(2), 1.0f), plane(w, row(2), -1.0f)}};
+}
+
+auto add_sphere(Spheres& spheres, const float x, const float y, const float z,
+                const float radius) -> void {
+  spheres.x.push_back(x);
+  spheres.y.push_back(y);
+  spheres.z.push_back(z);
+  spheres.radius.push_back(radius);
+}
+
+auto add_box(Boxes& boxes, const std::array<float, 3> min,
+             const std::array<float, 3> max) -> void {
+  boxes.center_x.push_back((min[0] + max[0]) * 0.5f);
+  boxes.center_y.push_back((min[1] + max[1]) * 0.5f);
+  boxes.center_z.push_back((min[2] + max[2]) * 0.5f);
+  boxes.extent_x.push_back((max[0] - min[0]) * 0.5f);
+  boxes.extent_y.push_back((max[1] - min[1]) * 0.5f);
+  boxes.extent_z.push_back((max[2] - min[2]) * 0.5f);
+}
+
+auto cull_spheres(const Frustum& frustum, const Spheres& spheres,
+                  std::vector<uint32_t>& visible) -> void {
+  visible.clear();
+  const size_t count = spheres.x.size();
+  size_t i = 0;
+  for (; i + simd_width <= count; i += simd_width) {
+    const auto x = load(&spheres.x[i]);
+    const auto y = load(&spheres.y[i]);
+    const auto z = load(&spheres.z[i]);
+    const auto radius = load(&spheres.radius[i]);
+    unsigned int mask = all_lanes;
+    for (const auto& plane : frustum.planes) {
+      const auto distance =
+          add(add(mul(splat(plane.a), x), mul(splat(plane.b), y)),
+              add(add(mul(splat(plane.c), z), splat(plane.d)), radius));
+      mask &= non_negative(distance);
+      if (mask == 0) {
+        break;
+      }
+    }
+    append_lanes(mask, i, visible);
+  }
+  for (; i < count; ++i) {
+    if (sphere_inside(frustum, spheres, i)) {
+      visible.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+auto cull_boxes(const Frustum& frustum, const Boxes& boxes,
+                std::vector<uint32_t>& visible) -> void {
+  visible.clear();
+  const size_t count = boxes.center_x.size();
+  size_t i = 0;
+  for (; i + simd_width <= count; i += simd_width) {
+    const auto x = load(&boxes.center_x[i]);
+    const auto y = load(&boxes.center_y[i]);
+    const auto z = load(&boxes.center_z[i]);
+    const auto extent_x = load(&boxes.extent_x[i]);
+    const auto extent_y = load(&boxes.extent_y[i]);
+    const auto extent_z = load(&boxes.extent_z[i]);
+    unsigned int mask = all_lanes;
+    for (const auto& plane : frustum.planes) {
+      // Distance of the corner furthest along the plane normal
+      const auto center =
+          add(add(mul(splat(plane.a), x), mul(splat(plane.b), y)),
+              add(mul(splat(plane.c), z), splat(plane.d)));
+      const auto reach =
+          add(add(mul(splat(std::abs(plane.a)), extent_x),
+                  mul(splat(std::abs(plane.b)), extent_y)),
+              mul(splat(std::abs(plane.c)), extent_z));
+      mask &= non_negative(add(center, reach));
+      if (mask == 0) {
+        break;
+      }
+    }
+    append_lanes(mask, i, visible);
+  }
+  for (; i < count; ++i) {
+    if (box_inside(frustum, boxes, i)) {
+      visible.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+auto cull_spheres_scalar(const Frustum& frustum, const Spheres& spheres,
+                         std::vector<uint32_t>& visible) -> void {
+  visible.clear();
+  for (size_t i = 0; i < spheres.x.size(); ++i) {
+    if (sphere_inside(frustum, spheres, i)) {
+      visible.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+auto cull_boxes_scalar(const Frustum& frustum, const Boxes& boxes,
+                       std::vector<uint32_t>& visible) -> void {
+  visible.clear();
+  for (size_t i = 0; i < boxes.center_x.size(); ++i) {
+    if (box_inside(frustum, boxes, i)) {
+      visible.push_back(static_cast<uint32_t>(i));
+    }
+  }
+}
+
+}
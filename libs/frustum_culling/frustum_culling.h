@@ -0,0 +1,88 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Tests batches of bounding volumes against the six planes of a view
+// frustum. Bounds are stored as structures of arrays so a batch loads into
+// one SIMD register per coordinate: eight bounds per test with AVX, four
+// with SSE2 and one at a time otherwise.
+namespace frustum_culling {
+
+// Bounds tested per SIMD instruction
+#if defined(__AVX__)
+constexpr size_t simd_width = 8;
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+constexpr size_t simd_width = 4;
+#else
+constexpr size_t simd_width = 1;
+#endif
+
+// Points with ax + by + cz + d >= 0 are inside, (a, b, c) has unit length
+using Plane = struct Plane {
+  float a;
+  float b;
+  float c;
+  float d;
+};
+
+using Frustum = struct Frustum {
+  // Left, right, bottom, top, near, far
+  std::array<Plane, 6> planes;
+};
+
+using Spheres = struct Spheres {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<float> radius;
+};
+
+// Axis aligned boxes as center and half extents
+using Boxes = struct Boxes {
+  std::vector<float> center_x;
+  std::vector<float> center_y;
+  std::vector<float> center_z;
+  std::vector<float> extent_x;
+  std::vector<float> extent_y;
+  std::vector<float> extent_z;
+};
+
+// Planes of the clip volume of an OpenGL projection, from a column major
+// matrix like glm::value_ptr returns (Gribb and Hartmann, 2001). The planes
+// are in the space the matrix transforms from, pass projection * view *
+// model to cull bounds in model space.
+auto extract_frustum(std::span<const float, 16> matrix) -> Frustum;
+
+auto add_sphere(Spheres& spheres, float x, float y, float z, float radius)
+    -> void;
+
+auto add_box(Boxes& boxes, std::array<float, 3> min, std::array<float, 3> max)
+    -> void;
+
+// Replaces visible with the indices of the bounds not fully outside any
+// plane, in increasing order. Conservative, bounds outside the frustum but
+// not outside a single plane, near its corners, are kept.
+auto cull_spheres(const Frustum& frustum, const Spheres& spheres,
+                  std::vector<uint32_t>& visible) -> void;
+
+auto cull_boxes(const Frustum& frustum, const Boxes& boxes,
+                std::vector<uint32_t>& visible) -> void;
+
+// One bound at a time, like the bounds left over after the last full SIMD
+// batch. Same results as cull_spheres and cull_boxes, kept to check and
+// time them against.
+auto cull_spheres_scalar(const Frustum& frustum, const Spheres& spheres,
+                         std::vector<uint32_t>& visible) -> void;
+
+auto cull_boxes_scalar(const Frustum& frustum, const Boxes& boxes,
+                       std::vector<uint32_t>& visible) -> void;
+
+}
+
+#endif  // FRUSTUM_CULLING_H
@@ -0,0 +1,408 @@
+#include "mesh_cache.h"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mesh_cache {
+
+namespace {
+
+constexpr std::array<char, 8> magic = {'M', 'E', 'S', 'H', 'C', 'A', 'C', 'H'};
+constexpr size_t data_alignment = 16;
+
+// Header, then the mesh, texture and LOD records, the strings the texture
+// records point into and finally vertex and index data
+using Header = struct Header {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t vertex_size;
+  uint64_t source_size;
+  uint64_t source_hash;
+  uint64_t num_meshes;
+  uint64_t num_textures;
+  uint64_t num_lods;
+  uint64_t strings_size;
+};
+
+// Offsets from the start of the file
+using MeshRecord = struct MeshRecord {
+  uint64_t vertices_offset;
+  uint64_t num_vertices;
+  uint64_t indices_offset;
+  uint64_t num_indices;
+  uint64_t first_texture;
+  uint64_t num_textures;
+  uint64_t first_lod;
+  uint64_t num_lods;
+};
+
+// Offsets from the start of the strings
+using TextureRecord = struct TextureRecord {
+  uint64_t type_offset;
+  uint64_t type_size;
+  uint64_t path_offset;
+  uint64_t path_size;
+};
+
+// Indices relative to the mesh's
+using LodRecord = struct LodRecord {
+  uint64_t first_index;
+  uint64_t num_indices;
+  double error;
+};
+
+auto align(const uint64_t offset) -> uint64_t {
+  return (offset + data_alignment - 1) / data_alignment * data_alignment;
+}
+
+// FNV-1a over the whole file, nullopt if it can't be read
+auto hash_file(const std::string& filename)
+    -> std::optional<std::pair<uint64_t, uint64_t>> {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+  uint64_t hash = 0xcbf29ce484222325;
+  uint64_t size = 0;
+  std::array<char, 64 * 1024> buffer{};
+  while (file) {
+    file.read(buffer.data(), buffer.size());
+    const auto count = static_cast<size_t>(file.gcount());
+    for (size_t i = 0; i < count; ++i) {
+      hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 0x100000001b3;
+    }
+    size += count;
+  }
+  if (file.bad()) {
+    return std::nullopt;
+  }
+  return std::pair{hash, size};
+}
+
+// Read only mapping of the whole file
+auto map_file(const std::string& filename)
+    -> std::optional<std::pair<const std::byte*, size_t>> {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return std::nullopt;
+  }
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(file, &size) == 0 || size.QuadPart == 0) {
+    CloseHandle(file);
+    return std::nullopt;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return std::nullopt;
+  }
+  // The view keeps the mapping alive
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == nullptr) {
+    return std::nullopt;
+  }
+  return std::pair{static_cast<const std::byte*>(data),
+                   static_cast<size_t>(size.QuadPart)};
+#else
+  const int file = ::open(filename.c_str(), O_RDONLY);
+  if (file == -1) {
+    return std::nullopt;
+  }
+  struct stat status {};
+  if (fstat(file, &status) != 0 || status.st_size == 0) {
+    ::close(file);
+    return std::nullopt;
+  }
+  const auto size = static_cast<size_t>(status.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  ::close(file);
+  if (data == MAP_FAILED) {
+    return std::nullopt;
+  }
+  // Everything is read right away, start paging it in
+  posix_madvise(data, size, POSIX_MADV_WILLNEED);
+  return std::pair{static_cast<const std::byte*>(data), size};
+#endif
+}
+
+auto unmap_file(const std::byte* data, const size_t size) -> void {
+  if (data == nullptr) {
+    return;
+  }
+#ifdef _WIN32
+  UnmapViewOfFile(data);
+#else
+  munmap(const_cast<std::byte*>(data), size);
+#endif
+}
+
+// Whether [offset, offset + count * element_size) lies within size bytes
+auto in_bounds(const uint64_t offset, const uint64_t count,
+               const uint64_t element_size, const uint64_t size) -> bool {
+  return offset <= size && count <= (size - offset) / element_size;
+}
+
+}  // namespace
+
+auto MeshCache::open(const std::string& cache_path,
+                     const std::string& source_path,
+                     const uint32_t vertex_size) -> std::optional<MeshCache> {
+  if (vertex_size == 0) {
+    return std::nullopt;
+  }
+  const auto source = hash_file(source_path);
+  if (!source) {
+    return std::nullopt;
+  }
+  const auto mapping = map_file(cache_path);
+  if (!mapping) {
+    return std::nullopt;
+  }
+  MeshCache cache;
+  cache.data = mapping->first;
+  cache.size = mapping->second;
+
+  if (cache.size < sizeof(Header)) {
+    return std::nullopt;
+  }
+  Header header;
+  std::memcpy(&header, cache.data, sizeof(Header));
+  const auto [source_hash, source_size] = *source;
+  if (header.magic != magic || header.version != version ||
+      header.vertex_size != vertex_size || header.source_size != source_size ||
+      header.source_hash != source_hash) {
+    return std::nullopt;
+  }
+
+  const uint64_t meshes_offset = sizeof(Header);
+  const uint64_t textures_offset =
+      meshes_offset + header.num_meshes * sizeof(MeshRecord);
+  const uint64_t lods_offset =
+      textures_offset + header.num_textures * sizeof(TextureRecord);
+  const uint64_t strings_offset =
+      lods_offset + header.num_lods * sizeof(LodRecord);
+  if (!in_bounds(meshes_offset, header.num_meshes, sizeof(MeshRecord),
+                 cache.size) ||
+      !in_bounds(textures_offset, header.num_textures, sizeof(TextureRecord),
+                 cache.size) ||
+      !in_bounds(lods_offset, header.num_lods, sizeof(LodRecord),
+                 cache.size) ||
+      !in_bounds(strings_offset, header.strings_size, 1, cache.size)) {
+    return std::nullopt;
+  }
+  const auto* strings =
+      reinterpret_cast<const char*>(cache.data + strings_offset);
+
+  std::vector<MaterialTexture> textures(header.num_textures);
+  for (uint64_t i = 0; i < header.num_textures; ++i) {
+    TextureRecord record;
+    std::memcpy(&record, cache.data + textures_offset + i * sizeof(record),
+                sizeof(record));
+    if (!in_bounds(record.type_offset, record.type_size, 1,
+                   header.strings_size) ||
+        !in_bounds(record.path_offset, record.path_size, 1,
+                   header.strings_size)) {
+      return std::nullopt;
+    }
+    textures[i].type.assign(strings + record.type_offset, record.type_size);
+    textures[i].path.assign(strings + record.path_offset, record.path_size);
+  }
+
+  cache.cached_meshes.reserve(header.num_meshes);
+  for (uint64_t i = 0; i < header.num_meshes; ++i) {
+    MeshRecord record;
+    std::memcpy(&record, cache.data + meshes_offset + i * sizeof(record),
+                sizeof(record));
+    if (!in_bounds(record.vertices_offset, record.num_vertices, vertex_size,
+                   cache.size) ||
+        !in_bounds(record.indices_offset, record.num_indices,
+                   sizeof(unsigned int), cache.size) ||
+        !in_bounds(record.first_texture, record.num_textures, 1,
+                   header.num_textures) ||
+        !in_bounds(record.first_lod, record.num_lods, 1, header.num_lods) ||
+        record.indices_offset % alignof(unsigned int) != 0) {
+      return std::nullopt;
+    }
+    std::vector<Lod> lods(record.num_lods);
+    for (uint64_t j = 0; j < record.num_lods; ++j) {
+      LodRecord lod;
+      std::memcpy(&lod,
+                  cache.data + lods_offset +
+                      (record.first_lod + j) * sizeof(lod),
+                  sizeof(lod));
+      if (!in_bounds(lod.first_index, lod.num_indices, 1,
+                     record.num_indices)) {
+        return std::nullopt;
+      }
+      lods[j] = Lod{.first_index = lod.first_index,
+                    .num_indices = lod.num_indices,
+                    .error = static_cast<float>(lod.error)};
+    }
+    cache.cached_meshes.push_back(CachedMesh{
+        .vertices = cache.data + record.vertices_offset,
+        .num_vertices = record.num_vertices,
+        .indices = reinterpret_cast<const unsigned int*>(
+            cache.data + record.indices_offset),
+        .num_indices = record.num_indices,
+        .textures = std::vector<MaterialTexture>(
+            textures.begin() + static_cast<ptrdiff_t>(record.first_texture),
+            textures.begin() + static_cast<ptrdiff_t>(record.first_texture +
+                                                      record.num_textures)),
+        .lods = std::move(lods),
+    });
+  }
+  return cache;
+}
+
+MeshCache::MeshCache(MeshCache&& other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      size(std::exchange(other.size, 0)),
+      cached_meshes(std::move(other.cached_meshes)) {}
+
+auto MeshCache::operator=(MeshCache&& other) noexcept -> MeshCache& {
+  std::swap(data, other.data);
+  std::swap(size, other.size);
+  std::swap(cached_meshes, other.cached_meshes);
+  return *this;
+}
+
+MeshCache::~MeshCache() { unmap_file(data, size); }
+
+auto MeshCache::meshes() const -> const std::vector<CachedMesh>& {
+  return cached_meshes;
+}
+
+auto cache_path_for(const std::string& source_path) -> std::string {
+  return source_path + ".meshcache";
+}
+
+auto write(const std::string& cache_path, const std::string& source_path,
+           const uint32_t vertex_size, const std::vector<MeshData>& meshes)
+    -> bool {
+  const auto source = hash_file(source_path);
+  if (!source) {
+    return false;
+  }
+
+  std::string strings;
+  std::vector<TextureRecord> texture_records;
+  std::vector<LodRecord> lod_records;
+  std::vector<MeshRecord> mesh_records;
+  for (const auto& mesh : meshes) {
+    if (mesh.vertices.size() != mesh.num_vertices * vertex_size) {
+      return false;
+    }
+    mesh_records.push_back(MeshRecord{
+        .vertices_offset = 0,
+        .num_vertices = mesh.num_vertices,
+        .indices_offset = 0,
+        .num_indices = mesh.indices.size(),
+        .first_texture = texture_records.size(),
+        .num_textures = mesh.textures.size(),
+        .first_lod = lod_records.size(),
+        .num_lods = mesh.lods.size(),
+    });
+    for (const auto& lod : mesh.lods) {
+      lod_records.push_back(LodRecord{.first_index = lod.first_index,
+                                      .num_indices = lod.num_indices,
+                                      .error = lod.error});
+    }
+    for (const auto& texture : mesh.textures) {
+      texture_records.push_back(TextureRecord{
+          .type_offset = strings.size(),
+          .type_size = texture.type.size(),
+          .path_offset = strings.size() + texture.type.size(),
+          .path_size = texture.path.size(),
+      });
+      strings += texture.type;
+      strings += texture.path;
+    }
+  }
+
+  uint64_t offset = sizeof(Header) + mesh_records.size() * sizeof(MeshRecord) +
+                    texture_records.size() * sizeof(TextureRecord) +
+                    lod_records.size() * sizeof(LodRecord) + strings.size();
+  for (size_t i = 0; i < meshes.size(); ++i) {
+    offset = align(offset);
+    mesh_records[i].vertices_offset = offset;
+    offset += meshes[i].vertices.size();
+    offset = align(offset);
+    mesh_records[i].indices_offset = offset;
+    offset += meshes[i].indices.size_bytes();
+  }
+
+  const auto [source_hash, source_size] = *source;
+  const Header header{
+      .magic = magic,
+      .version = version,
+      .vertex_size = vertex_size,
+      .source_size = source_size,
+      .source_hash = source_hash,
+      .num_meshes = mesh_records.size(),
+      .num_textures = texture_records.size(),
+      .num_lods = lod_records.size(),
+      .strings_size = strings.size(),
+  };
+
+  const auto temporary_path = cache_path + ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      return false;
+    }
+    uint64_t written = 0;
+    const auto write_bytes = [&file, &written](const void* bytes,
+                                               const size_t count) {
+      file.write(static_cast<const char*>(bytes),
+                 static_cast<std::streamsize>(count));
+      written += count;
+    };
+    const auto pad = [&write_bytes, &written](const uint64_t to_offset) {
+      static constexpr std::array<char, data_alignment> zeros{};
+      write_bytes(zeros.data(), to_offset - written);
+    };
+    write_bytes(&header, sizeof(header));
+    write_bytes(mesh_records.data(), mesh_records.size() * sizeof(MeshRecord));
+    write_bytes(texture_records.data(),
+                texture_records.size() * sizeof(TextureRecord));
+    write_bytes(lod_records.data(), lod_records.size() * sizeof(LodRecord));
+    write_bytes(strings.data(), strings.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+      pad(mesh_records[i].vertices_offset);
+      write_bytes(meshes[i].vertices.data(), meshes[i].vertices.size());
+      pad(mesh_records[i].indices_offset);
+      write_bytes(meshes[i].indices.data(), meshes[i].indices.size_bytes());
+    }
+    if (!file) {
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, cache_path, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+    return false;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,96 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// Binary cache of the meshes imported from a model file, so warm starts skip
+// parsing. A cache file stores raw vertex bytes, 32 bit indices and material
+// texture references for each mesh, along with a hash of the source file it
+// was built from. It is memory mapped on load and vertex data can go from the
+// mapping straight into glNamedBufferStorage.
+//
+// The layout is native endian and the vertex bytes are copied as is, so
+// caches aren't portable between machines or vertex layouts.
+namespace mesh_cache {
+
+// Bumped whenever the layout of the file or how the stored meshes are
+// processed changes. 2: meshes are welded and reordered. 3: levels of detail.
+constexpr uint32_t version = 3;
+
+using MaterialTexture = struct MaterialTexture {
+  // texture_diffuse, texture_specular...
+  std::string type;
+  // As referenced by the material, relative to the model
+  std::string path;
+};
+
+// Range of a mesh's indices drawing one level of detail
+using Lod = struct Lod {
+  size_t first_index;
+  size_t num_indices;
+  float error;
+};
+
+using MeshData = struct MeshData {
+  // num_vertices * vertex_size bytes
+  std::span<const std::byte> vertices;
+  size_t num_vertices;
+  std::span<const unsigned int> indices;
+  std::vector<MaterialTexture> textures;
+  // Empty if indices is a single level
+  std::vector<Lod> lods;
+};
+
+// Points into the mapping, valid while the MeshCache is alive
+using CachedMesh = struct CachedMesh {
+  const void* vertices;
+  size_t num_vertices;
+  const unsigned int* indices;
+  size_t num_indices;
+  std::vector<MaterialTexture> textures;
+  std::vector<Lod> lods;
+};
+
+class MeshCache {
+ public:
+  // Maps cache_path if it was written for the current contents of
+  // source_path with the same vertex size, nullopt if it is missing, stale
+  // or corrupt
+  static auto open(const std::string& cache_path,
+                   const std::string& source_path, uint32_t vertex_size)
+      -> std::optional<MeshCache>;
+
+  MeshCache(const MeshCache&) = delete;
+  auto operator=(const MeshCache&) -> MeshCache& = delete;
+
+  MeshCache(MeshCache&& other) noexcept;
+  auto operator=(MeshCache&& other) noexcept -> MeshCache&;
+
+  ~MeshCache();
+
+  [[nodiscard]] auto meshes() const -> const std::vector<CachedMesh>&;
+
+ private:
+  MeshCache() = default;
+
+  const std::byte* data = nullptr;
+  size_t size = 0;
+  std::vector<CachedMesh> cached_meshes;
+};
+
+// Cache file next to the model
+auto cache_path_for(const std::string& source_path) -> std::string;
+
+// Writes the cache through a temporary file renamed into place, so readers
+// never see a partially written cache. Returns false on failure.
+auto write(const std::string& cache_path, const std::string& source_path,
+           uint32_t vertex_size, const std::vector<MeshData>& meshes) -> bool;
+
+}
+
+#endif  // MESH_CACHE_H
@@ -0,0 +1,529 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace mesh_optimizer {
+
+namespace {
+
+constexpr unsigned int no_vertex = std::numeric_limits<unsigned int>::max();
+
+auto hash_bytes(const std::byte* bytes, const size_t size) -> uint64_t {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<uint64_t>(bytes[i])) * 0x100000001b3;
+  }
+  return hash;
+}
+
+// Triangles using each vertex, packed by vertex
+using Adjacency = struct Adjacency {
+  std::vector<unsigned int> offsets;
+  std::vector<unsigned int> triangles;
+};
+
+auto build_adjacency(const std::span<const unsigned int> indices,
+                     const size_t num_vertices) -> Adjacency {
+  Adjacency adjacency;
+  adjacency.offsets.assign(num_vertices + 1, 0);
+  for (const auto index : indices) {
+    ++adjacency.offsets[index + 1];
+  }
+  for (size_t i = 0; i < num_vertices; ++i) {
+    adjacency.offsets[i + 1] += adjacency.offsets[i];
+  }
+  adjacency.triangles.resize(indices.size());
+  std::vector<unsigned int> filled(adjacency.offsets.begin(),
+                                   adjacency.offsets.end() - 1);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    adjacency.triangles[filled[indices[i]]++] =
+        static_cast<unsigned int>(i / 3);
+  }
+  return adjacency;
+}
+
+using Vector3 = std::array<double, 3>;
+
+auto subtract(const Vector3& a, const Vector3& b) -> Vector3 {
+  return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+auto cross(const Vector3& a, const Vector3& b) -> Vector3 {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+
+auto dot(const Vector3& a, const Vector3& b) -> double {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// Sum of squared distances to a set of planes, weighted by triangle area
+using Quadric = struct Quadric {
+  // a², b², c², ab, ac, bc, ad, bd, cd, d² of the planes ax + by + cz + d
+  std::array<double, 10> terms;
+  double weight;
+};
+
+auto add_plane(Quadric& quadric, const Vector3& normal, const double d,
+               const double weight) -> void {
+  const auto [a, b, c] = normal;
+  const std::array<double, 10> terms = {a * a, b * b, c * c, a * b, a * c,
+                                        b * c, a * d,  b * d, c * d, d * d};
+  for (size_t i = 0; i < terms.size(); ++i) {
+    quadric.terms[i] += terms[i] * weight;
+  }
+  quadric.weight += weight;
+}
+
+auto add(Quadric& quadric, const Quadric& other) -> void {
+  for (size_t i = 0; i < quadric.terms.size(); ++i) {
+    quadric.terms[i] += other.terms[i];
+  }
+  quadric.weight += other.weight;
+}
+
+auto evaluate(const Quadric& quadric, const Vector3& point) -> double {
+  const auto [x, y, z] = point;
+  const auto& q = quadric.terms;
+  return q[0] * x * x + q[1] * y * y + q[2] * z * z +
+         2 * (q[3] * x * y + q[4] * x * z + q[5] * y * z) +
+         2 * (q[6] * x + q[7] * y + q[8] * z) + q[9];
+}
+
+}  // namespace
+
+auto weld_vertices(void* vertices, const size_t num_vertices,
+                   const size_t vertex_size,
+                   const std::span<const unsigned int> indices,
+                   std::vector<unsigned int>& out_indices) -> size_t {
+  auto* bytes = static_cast<std::byte*>(vertices);
+
+  // Open addressing over the unique vertices, at most half full
+  size_t table_size = 16;
+  while (table_size < num_vertices * 2) {
+    table_size *= 2;
+  }
+  std::vector<unsigned int> table(table_size, no_vertex);
+
+  std::vector<unsigned int> remap(num_vertices);
+  size_t num_unique = 0;
+  for (size_t i = 0; i < num_vertices; ++i) {
+    const std::byte* vertex = bytes + i * vertex_size;
+    size_t slot = hash_bytes(vertex, vertex_size) & (table_size - 1);
+    while (table[slot] != no_vertex &&
+           std::memcmp(bytes + table[slot] * vertex_size, vertex,
+                       vertex_size) != 0) {
+      slot = (slot + 1) & (table_size - 1);
+    }
+    if (table[slot] == no_vertex) {
+      // Unique vertices only move towards the front, never over one not
+      // visited yet
+      if (num_unique != i) {
+        std::memcpy(bytes + num_unique * vertex_size, vertex, vertex_size);
+      }
+      table[slot] = static_cast<unsigned int>(num_unique++);
+    }
+    remap[i] = table[slot];
+  }
+
+  if (indices.empty()) {
+    out_indices = std::move(remap);
+  } else {
+    out_indices.resize(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+      out_indices[i] = remap[indices[i]];
+    }
+  }
+  return num_unique;
+}
+
+auto optimize_vertex_cache(const std::span<unsigned int> indices,
+                           const size_t num_vertices, const size_t cache_size)
+    -> void {
+  const size_t num_triangles = indices.size() / 3;
+  if (num_triangles == 0) {
+    return;
+  }
+  const auto adjacency = build_adjacency(indices, num_vertices);
+
+  // Triangles not emitted yet around each vertex
+  std::vector<unsigned int> live(num_vertices);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    live[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+  }
+  // Time a vertex entered the simulated cache, it is still cached while
+  // time - cache_time <= cache_size
+  std::vector<size_t> cache_time(num_vertices, 0);
+  size_t time = cache_size + 1;
+  std::vector<bool> emitted(num_triangles, false);
+  std::vector<unsigned int> dead_end;
+  std::vector<unsigned int> candidates;
+  std::vector<unsigned int> output;
+  output.reserve(indices.size());
+  size_t cursor = 0;
+
+  // Recently used vertices with triangles left, then any vertex in order
+  const auto skip_dead_end = [&]() -> unsigned int {
+    while (!dead_end.empty()) {
+      const auto vertex = dead_end.back();
+      dead_end.pop_back();
+      if (live[vertex] > 0) {
+        return vertex;
+      }
+    }
+    while (cursor < num_vertices) {
+      const auto vertex = static_cast<unsigned int>(cursor++);
+      if (live[vertex] > 0) {
+        return vertex;
+      }
+    }
+    return no_vertex;
+  };
+
+  unsigned int fanning = skip_dead_end();
+  while (fanning != no_vertex) {
+    candidates.clear();
+    for (auto i = adjacency.offsets[fanning];
+         i < adjacency.offsets[fanning + 1]; ++i) {
+      const auto triangle = adjacency.triangles[i];
+      if (emitted[triangle]) {
+        continue;
+      }
+      emitted[triangle] = true;
+      for (size_t corner = 0; corner < 3; ++corner) {
+        const auto vertex = indices[triangle * 3 + corner];
+        output.push_back(vertex);
+        dead_end.push_back(vertex);
+        candidates.push_back(vertex);
+        --live[vertex];
+        if (cache_size < time - cache_time[vertex]) {
+          cache_time[vertex] = time++;
+        }
+      }
+    }
+
+    // Fan around the candidate that will still be cached after emitting all
+    // its triangles and was cached the longest
+    unsigned int next = no_vertex;
+    size_t best_priority = 0;
+    for (const auto vertex : candidates) {
+      if (live[vertex] == 0) {
+        continue;
+      }
+      size_t priority = 1;
+      if (time - cache_time[vertex] + 2 * live[vertex] <= cache_size) {
+        priority = time - cache_time[vertex] + 1;
+      }
+      if (best_priority < priority) {
+        best_priority = priority;
+        next = vertex;
+      }
+    }
+    fanning = next != no_vertex ? next : skip_dead_end();
+  }
+  std::copy(output.begin(), output.end(), indices.begin());
+}
+
+auto optimize_vertex_fetch(void* vertices, const size_t num_vertices,
+                           const size_t vertex_size,
+                           const std::span<unsigned int> indices) -> size_t {
+  auto* bytes = static_cast<std::byte*>(vertices);
+  std::vector<unsigned int> remap(num_vertices, no_vertex);
+  std::vector<std::byte> reordered;
+  reordered.reserve(num_vertices * vertex_size);
+  size_t num_used = 0;
+  for (auto& index : indices) {
+    if (remap[index] == no_vertex) {
+      remap[index] = static_cast<unsigned int>(num_used++);
+      reordered.insert(reordered.end(), bytes + index * vertex_size,
+                       bytes + (index + 1) * vertex_size);
+    }
+    index = remap[index];
+  }
+  std::copy(reordered.begin(), reordered.end(), bytes);
+  return num_used;
+}
+
+auto simulate_vertex_cache(const std::span<const unsigned int> indices,
+                           const size_t num_vertices, const size_t cache_size)
+    -> size_t {
+  // Same bookkeeping as a FIFO, a vertex is evicted cache_size misses after
+  // it was loaded
+  std::vector<size_t> cache_time(num_vertices, 0);
+  size_t time = cache_size + 1;
+  size_t misses = 0;
+  for (const auto vertex : indices) {
+    if (cache_size <= time - cache_time[vertex] - 1) {
+      cache_time[vertex] = time++;
+      ++misses;
+    }
+  }
+  return misses;
+}
+
+auto simplify(const std::span<const unsigned int> indices,
+              const float* positions, const size_t num_vertices,
+              const size_t position_stride, const size_t target_num_indices)
+    -> SimplifyResult {
+  const auto* position_bytes = reinterpret_cast<const std::byte*>(positions);
+  const auto position = [&](const unsigned int vertex) -> Vector3 {
+    std::array<float, 3> xyz;
+    std::memcpy(xyz.data(), position_bytes + vertex * position_stride,
+                sizeof(xyz));
+    return {xyz[0], xyz[1], xyz[2]};
+  };
+
+  // First vertex at the same position as each vertex, collapses are decided
+  // between positions so seams don't split the surface
+  std::vector<unsigned int> position_ids(num_vertices);
+  std::vector<unsigned int> num_at_position(num_vertices, 0);
+  {
+    size_t table_size = 16;
+    while (table_size < num_vertices * 2) {
+      table_size *= 2;
+    }
+    std::vector<unsigned int> table(table_size, no_vertex);
+    constexpr size_t position_size = 3 * sizeof(float);
+    for (size_t i = 0; i < num_vertices; ++i) {
+      const std::byte* bytes = position_bytes + i * position_stride;
+      size_t slot = hash_bytes(bytes, position_size) & (table_size - 1);
+      while (table[slot] != no_vertex &&
+             std::memcmp(position_bytes + table[slot] * position_stride,
+                         bytes, position_size) != 0) {
+        slot = (slot + 1) & (table_size - 1);
+      }
+      if (table[slot] == no_vertex) {
+        table[slot] = static_cast<unsigned int>(i);
+      }
+      position_ids[i] = table[slot];
+      ++num_at_position[table[slot]];
+    }
+  }
+
+  // Positions on edges not shared by exactly two triangles are on a border
+  // or non-manifold, moving them would open holes
+  std::vector<bool> locked(num_vertices, false);
+  {
+    std::unordered_map<uint64_t, unsigned int> edge_counts;
+    edge_counts.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+      for (size_t corner = 0; corner < 3; ++corner) {
+        auto a = position_ids[indices[i + corner]];
+        auto b = position_ids[indices[i + (corner + 1) % 3]];
+        if (b < a) {
+          std::swap(a, b);
+        }
+        ++edge_counts[(static_cast<uint64_t>(a) << 32) | b];
+      }
+    }
+    for (const auto& [edge, count] : edge_counts) {
+      if (count != 2) {
+        locked[edge >> 32] = true;
+        locked[edge & 0xffffffff] = true;
+      }
+    }
+  }
+  for (size_t i = 0; i < num_vertices; ++i) {
+    locked[i] = locked[position_ids[i]] || num_at_position[position_ids[i]] > 1;
+  }
+
+  std::vector<Quadric> quadrics(num_vertices, Quadric{});
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    const auto p0 = position(indices[i]);
+    const auto normal =
+        cross(subtract(position(indices[i + 1]), p0),
+              subtract(position(indices[i + 2]), p0));
+    const double length = std::sqrt(dot(normal, normal));
+    if (length == 0.0) {
+      continue;
+    }
+    const Vector3 unit = {normal[0] / length, normal[1] / length,
+                          normal[2] / length};
+    for (size_t corner = 0; corner < 3; ++corner) {
+      add_plane(quadrics[position_ids[indices[i + corner]]], unit,
+                -dot(unit, p0), length / 2);
+    }
+  }
+  const auto collapse_cost = [&](const unsigned int from,
+                                 const unsigned int to) -> double {
+    const auto& from_quadric = quadrics[position_ids[from]];
+    const auto& to_quadric = quadrics[position_ids[to]];
+    const double weight = from_quadric.weight + to_quadric.weight;
+    if (weight == 0.0) {
+      return 0.0;
+    }
+    const auto point = position(to);
+    return std::max(0.0, (evaluate(from_quadric, point) +
+                          evaluate(to_quadric, point)) /
+                             weight);
+  };
+
+  using Collapse = struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+  };
+
+  std::vector<unsigned int> result(indices.begin(), indices.end());
+  result.resize(result.size() / 3 * 3);
+  std::vector<unsigned int> remap(num_vertices);
+  std::vector<bool> touched(num_vertices);
+  std::vector<Collapse> collapses;
+  double max_cost = 0.0;
+  // Each pass collapses the cheapest edges whose neighbourhoods don't
+  // overlap, so adjacency stays valid within a pass
+  while (target_num_indices < result.size()) {
+    const auto adjacency = build_adjacency(result, num_vertices);
+    collapses.clear();
+    for (unsigned int vertex = 0; vertex < num_vertices; ++vertex) {
+      if (locked[vertex]) {
+        continue;
+      }
+      Collapse best{vertex, no_vertex, std::numeric_limits<double>::max()};
+      for (auto i = adjacency.offsets[vertex];
+           i < adjacency.offsets[vertex + 1]; ++i) {
+        const auto triangle = adjacency.triangles[i];
+        for (size_t corner = 0; corner < 3; ++corner) {
+          const auto other = result[triangle * 3 + corner];
+          if (position_ids[other] == position_ids[vertex]) {
+            continue;
+          }
+          if (const double cost = collapse_cost(vertex, other);
+              cost < best.cost) {
+            best.to = other;
+            best.cost = cost;
+          }
+        }
+      }
+      if (best.to != no_vertex) {
+        collapses.push_back(best);
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse& a, const Collapse& b) {
+                return a.cost < b.cost;
+              });
+
+    for (size_t i = 0; i < num_vertices; ++i) {
+      remap[i] = static_cast<unsigned int>(i);
+    }
+    std::fill(touched.begin(), touched.end(), false);
+    const size_t num_to_remove = (result.size() - target_num_indices + 2) / 3;
+    size_t num_removed = 0;
+    for (const auto& collapse : collapses) {
+      if (num_to_remove <= num_removed) {
+        break;
+      }
+      if (touched[collapse.from] || touched[collapse.to]) {
+        continue;
+      }
+      // Triangles around from that survive mustn't flip
+      const auto to_position = position(collapse.to);
+      size_t num_degenerate = 0;
+      bool flips = false;
+      for (auto i = adjacency.offsets[collapse.from];
+           i < adjacency.offsets[collapse.from + 1] && !flips; ++i) {
+        const auto* triangle = &result[adjacency.triangles[i] * 3];
+        if (position_ids[triangle[0]] == position_ids[collapse.to] ||
+            position_ids[triangle[1]] == position_ids[collapse.to] ||
+            position_ids[triangle[2]] == position_ids[collapse.to]) {
+          ++num_degenerate;
+          continue;
+        }
+        std::array<Vector3, 3> corners = {position(triangle[0]),
+                                          position(triangle[1]),
+                                          position(triangle[2])};
+        const auto before =
+            cross(subtract(corners[1], corners[0]),
+                  subtract(corners[2], corners[0]));
+        for (size_t corner = 0; corner < 3; ++corner) {
+          if (triangle[corner] == collapse.from) {
+            corners[corner] = to_position;
+          }
+        }
+        const auto after =
+            cross(subtract(corners[1], corners[0]),
+                  subtract(corners[2], corners[0]));
+        flips = dot(before, after) <= 0.0;
+      }
+      if (flips) {
+        continue;
+      }
+
+      remap[collapse.from] = collapse.to;
+      add(quadrics[position_ids[collapse.to]],
+          quadrics[position_ids[collapse.from]]);
+      max_cost = std::max(max_cost, collapse.cost);
+      num_removed += num_degenerate;
+      for (auto i = adjacency.offsets[collapse.from];
+           i < adjacency.offsets[collapse.from + 1]; ++i) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+          touched[result[adjacency.triangles[i] * 3 + corner]] = true;
+        }
+      }
+      touched[collapse.to] = true;
+    }
+    if (num_removed == 0) {
+      break;
+    }
+
+    size_t num_kept = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+      const auto a = remap[result[i]];
+      const auto b = remap[result[i + 1]];
+      const auto c = remap[result[i + 2]];
+      if (position_ids[a] == position_ids[b] ||
+          position_ids[b] == position_ids[c] ||
+          position_ids[c] == position_ids[a]) {
+        continue;
+      }
+      result[num_kept++] = a;
+      result[num_kept++] = b;
+      result[num_kept++] = c;
+    }
+    result.resize(num_kept);
+  }
+  return SimplifyResult{.indices = std::move(result),
+                        .error = static_cast<float>(std::sqrt(max_cost))};
+}
+
+auto build_lod_chain(const std::span<const unsigned int> indices,
+                     const float* positions, const size_t num_vertices,
+                     const size_t position_stride, const size_t max_num_lods,
+                     const size_t cache_size) -> LodChain {
+  // Levels smaller than this are not worth a draw of their own
+  constexpr size_t min_num_triangles = 64;
+
+  LodChain chain;
+  chain.indices.assign(indices.begin(), indices.end());
+  chain.lods.push_back(
+      Lod{.first_index = 0, .num_indices = indices.size(), .error = 0.0f});
+  while (chain.lods.size() < max_num_lods) {
+    const size_t previous_num_indices = chain.lods.back().num_indices;
+    const size_t target_num_indices = previous_num_indices / 6 * 3;
+    if (target_num_indices < min_num_triangles * 3) {
+      break;
+    }
+    auto simplified = simplify(indices, positions, num_vertices,
+                               position_stride, target_num_indices);
+    if (previous_num_indices * 3 / 4 < simplified.indices.size()) {
+      break;
+    }
+    optimize_vertex_cache(simplified.indices, num_vertices, cache_size);
+    chain.lods.push_back(Lod{
+        .first_index = chain.indices.size(),
+        .num_indices = simplified.indices.size(),
+        .error = std::max(chain.lods.back().error, simplified.error)});
+    chain.indices.insert(chain.indices.end(), simplified.indices.begin(),
+                         simplified.indices.end());
+  }
+  return chain;
+}
+
+}
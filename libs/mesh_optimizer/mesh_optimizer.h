@@ -0,0 +1,145 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Load time optimizations of indexed triangle lists. Vertices are handled as
+// raw bytes of vertex_size each, so they work with any vertex layout without
+// padding.
+namespace mesh_optimizer {
+
+// Entries of the post-transform cache assumed when reordering and simulating
+constexpr size_t default_cache_size = 16;
+
+// Levels of detail built per mesh, counting the full resolution one
+constexpr size_t default_max_num_lods = 5;
+
+using OptimizeStats = struct OptimizeStats {
+  size_t num_vertices_before;
+  size_t num_vertices_after;
+  size_t num_triangles;
+  // Simulated post-transform cache misses, divide by num_triangles for the
+  // average cache miss ratio (ACMR)
+  size_t cache_misses_before;
+  size_t cache_misses_after;
+};
+
+// Merges vertices whose bytes are identical, compacting unique vertices to
+// the front of vertices in first occurrence order. out_indices gets the
+// triangle list rewritten to the unique vertices. If indices is empty the
+// vertices are taken as an unindexed triangle list. Returns the number of
+// unique vertices.
+auto weld_vertices(void* vertices, size_t num_vertices, size_t vertex_size,
+                   std::span<const unsigned int> indices,
+                   std::vector<unsigned int>& out_indices) -> size_t;
+
+// Reorders triangles so consecutive ones share vertices still in a FIFO
+// post-transform cache of cache_size entries, with Tipsify (Sander, Nehab
+// and Barczak, 2007).
+auto optimize_vertex_cache(std::span<unsigned int> indices,
+                           size_t num_vertices,
+                           size_t cache_size = default_cache_size) -> void;
+
+// Reorders vertices by first use in indices so fetches walk memory forwards,
+// rewriting indices. Unreferenced vertices are dropped, returns the number
+// of vertices kept at the front.
+auto optimize_vertex_fetch(void* vertices, size_t num_vertices,
+                           size_t vertex_size, std::span<unsigned int> indices)
+    -> size_t;
+
+// Misses of a FIFO post-transform cache of cache_size entries drawing indices
+auto simulate_vertex_cache(std::span<const unsigned int> indices,
+                           size_t num_vertices,
+                           size_t cache_size = default_cache_size) -> size_t;
+
+using SimplifyResult = struct SimplifyResult {
+  std::vector<unsigned int> indices;
+  // Root mean square distance from the moved vertices to the planes of the
+  // triangles they were merged from, in the units of the positions
+  float error;
+};
+
+// Collapses edges onto one of their two vertices, cheapest first by quadric
+// error (Garland and Heckbert, 1997), until at most target_num_indices are
+// left or nothing can collapse. Simplified triangles reference a subset of
+// the same vertices. Vertices on open borders or sharing their position with
+// other vertices, like along UV seams, stay in place. positions points at
+// the x, y and z floats of the first vertex, position_stride bytes apart.
+auto simplify(std::span<const unsigned int> indices, const float* positions,
+              size_t num_vertices, size_t position_stride,
+              size_t target_num_indices) -> SimplifyResult;
+
+using Lod = struct Lod {
+  size_t first_index;
+  size_t num_indices;
+  // Simplification error, zero for the full resolution level
+  float error;
+};
+
+using LodChain = struct LodChain {
+  // Every level one after another, finest first, all over the same vertices
+  std::vector<unsigned int> indices;
+  std::vector<Lod> lods;
+};
+
+// Simplifies indices to half the triangles of the previous level, each level
+// from the full mesh so errors are measured against it, and reorders the
+// levels for the vertex cache. Stops early once a level would not be much
+// smaller than the previous one.
+auto build_lod_chain(std::span<const unsigned int> indices,
+                     const float* positions, size_t num_vertices,
+                     size_t position_stride,
+                     size_t max_num_lods = default_max_num_lods,
+                     size_t cache_size = default_cache_size) -> LodChain;
+
+// Whether every byte of a Vertex belongs to its value, which welding
+// relies on since it compares vertices byte for byte. Padding holds
+// whatever was there before and would keep equal vertices apart. Floats
+// never have unique object representations, 0.0f and -0.0f compare equal,
+// so vertex types made of floats specialize this once they've checked
+// their size leaves no room for padding.
+template <typename Vertex>
+constexpr bool has_no_padding =
+    std::has_unique_object_representations_v<Vertex>;
+
+// Welds, reorders triangles and then vertices. If indices is empty vertices
+// are taken as an unindexed triangle list, either way indices holds the
+// optimized triangle list afterwards.
+template <typename Vertex>
+auto optimize_mesh(std::vector<Vertex>& vertices,
+                   std::vector<unsigned int>& indices,
+                   const size_t cache_size = default_cache_size)
+    -> OptimizeStats {
+  static_assert(std::is_trivially_copyable_v<Vertex> &&
+                    has_no_padding<Vertex>,
+                "Vertices are compared and moved as raw bytes");
+  OptimizeStats stats{};
+  stats.num_vertices_before = vertices.size();
+
+  std::vector<unsigned int> welded_indices;
+  const size_t num_unique =
+      weld_vertices(vertices.data(), vertices.size(), sizeof(Vertex), indices,
+                    welded_indices);
+  stats.num_triangles = welded_indices.size() / 3;
+  stats.cache_misses_before =
+      indices.empty()
+          ? welded_indices.size()
+          : simulate_vertex_cache(indices, vertices.size(), cache_size);
+  vertices.resize(num_unique);
+  indices = std::move(welded_indices);
+
+  optimize_vertex_cache(indices, vertices.size(), cache_size);
+  vertices.resize(optimize_vertex_fetch(vertices.data(), vertices.size(),
+                                        sizeof(Vertex), indices));
+  stats.cache_misses_after =
+      simulate_vertex_cache(indices, vertices.size(), cache_size);
+  stats.num_vertices_after = vertices.size();
+  return stats;
+}
+
+}
+
+#endif  // MESH_OPTIMIZER_H
@@ -0,0 +1,85 @@
+#include "gpu_timer.h"
+
+#include <GL/glew.h>
+
+namespace profiler {
+
+GpuTimer::GpuTimer(const std::string& track_name)
+    : track_(&create_track(track_name)) {}
+
+GpuTimer::~GpuTimer() {
+  for (const auto& frame : frames_) {
+    glDeleteQueries(static_cast<GLsizei>(frame.queries.size()),
+                    frame.queries.data());
+  }
+}
+
+auto GpuTimer::BeginFrame() -> void {
+  if (in_zone_) {
+    End();
+  }
+  current_ = (current_ + 1) % 2;
+  auto& frame = frames_[current_];
+
+  last_timings_.clear();
+  for (size_t i = 0; i < frame.zones.size(); i++) {
+    const auto query = frame.queries[i];
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE) {
+      num_unavailable_++;
+      continue;
+    }
+    GLuint64 elapsed_ns = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+    const auto& [name, submitted_ns] = frame.zones[i];
+    record(*track_, Event{.name = name,
+                          .start_ns = submitted_ns,
+                          .duration_ns = static_cast<int64_t>(elapsed_ns)});
+    last_timings_.push_back(GpuTiming{
+        .name = name,
+        .milliseconds = static_cast<double>(elapsed_ns) / 1'000'000.0});
+  }
+  frame.zones.clear();
+}
+
+auto GpuTimer::Begin(const char* name) -> bool {
+  if (in_zone_) {
+    return false;
+  }
+  auto& frame = frames_[current_];
+  if (frame.zones.size() == frame.queries.size()) {
+    GLuint query;
+    glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+    frame.queries.push_back(query);
+  }
+  glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.zones.size()]);
+  frame.zones.push_back(PendingZone{.name = name, .submitted_ns = now_ns()});
+  in_zone_ = true;
+  return true;
+}
+
+auto GpuTimer::End() -> void {
+  if (!in_zone_) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED);
+  in_zone_ = false;
+}
+
+auto GpuTimer::LastTimings() const -> std::span<const GpuTiming> {
+  return last_timings_;
+}
+
+auto GpuTimer::NumUnavailable() const -> size_t { return num_unavailable_; }
+
+GpuZone::GpuZone(GpuTimer& timer, const char* name)
+    : timer_(timer), started_(timer.Begin(name)) {}
+
+GpuZone::~GpuZone() {
+  if (started_) {
+    timer_.End();
+  }
+}
+
+}  // namespace profiler
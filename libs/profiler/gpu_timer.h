@@ -0,0 +1,89 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "profiler.h"
+
+// Times GPU work with GL_TIME_ELAPSED queries and records it on a track of
+// its own in the profiler's trace. Queries are double buffered: a frame's
+// results are read when its queries are reused two frames later, by which
+// point the GPU has long finished them, so reading never stalls.
+//
+// Elapsed time queries can't nest, so neither can GpuZones. The GPU doesn't
+// say when the work started, its events are placed at the time the zone was
+// submitted. Needs a current context for every call.
+namespace profiler {
+
+using GpuTiming = struct GpuTiming {
+  const char* name;
+  double milliseconds;
+};
+
+class GpuTimer {
+ private:
+  using PendingZone = struct PendingZone {
+    const char* name;
+    int64_t submitted_ns;
+  };
+
+  using Frame = struct Frame {
+    // Grown as a frame uses more zones, reused afterwards
+    std::vector<unsigned int> queries;
+    std::vector<PendingZone> zones;
+  };
+
+  Track* track_;
+  Frame frames_[2];
+  size_t current_ = 0;
+  bool in_zone_ = false;
+  std::vector<GpuTiming> last_timings_;
+  size_t num_unavailable_ = 0;
+
+ public:
+  explicit GpuTimer(const std::string& track_name = "GPU");
+  ~GpuTimer();
+
+  // Delete copy constructors
+  GpuTimer(const GpuTimer&) = delete;
+  auto operator=(const GpuTimer&) -> GpuTimer& = delete;
+
+  // Starts the next frame, reading back the results of the frame whose
+  // queries it reuses. Call once per frame before any zone.
+  auto BeginFrame() -> void;
+
+  // Ignored, returning false, while a zone is already being timed
+  auto Begin(const char* name) -> bool;
+  auto End() -> void;
+
+  // Timings of the frame read back by the last BeginFrame, in order
+  [[nodiscard]] auto LastTimings() const -> std::span<const GpuTiming>;
+
+  // Zones whose result wasn't available yet when read back, and so were
+  // dropped. Should stay 0.
+  [[nodiscard]] auto NumUnavailable() const -> size_t;
+};
+
+// Times the GPU work submitted between its construction and destruction
+class GpuZone {
+ private:
+  GpuTimer& timer_;
+  // False inside another zone, which keeps timing
+  bool started_;
+
+ public:
+  // name must outlive the profiler, usually a string literal
+  GpuZone(GpuTimer& timer, const char* name);
+  ~GpuZone();
+
+  // Delete copy constructors
+  GpuZone(const GpuZone&) = delete;
+  auto operator=(const GpuZone&) -> GpuZone& = delete;
+};
+
+}  // namespace profiler
+
+#endif  // GPU_TIMER_H
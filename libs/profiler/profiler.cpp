@@ -0,0 +1,211 @@
+#include "profiler.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace profiler {
+
+namespace {
+
+constexpr size_t chunk_size = 4096;
+
+// Chunks are only ever appended, so events don't move while the trace is
+// being written
+struct Chunk {
+  std::array<Event, chunk_size> events;
+  std::atomic<Chunk*> next = nullptr;
+};
+
+}  // namespace
+
+class Track {
+ public:
+  // Its tid in the trace
+  size_t id;
+  // Guarded by the registry's mutex
+  std::string name;
+
+  std::unique_ptr<Chunk> head = std::make_unique<Chunk>();
+  // Only used by the thread recording
+  Chunk* tail = head.get();
+  // Published after the event is written, readers see every event before it
+  std::atomic<size_t> num_events = 0;
+  std::atomic<size_t> num_dropped = 0;
+
+  Track(const size_t id, std::string name) : id(id), name(std::move(name)) {}
+
+  Track(const Track&) = delete;
+  auto operator=(const Track&) -> Track& = delete;
+
+  ~Track() {
+    auto* chunk = head->next.load(std::memory_order_relaxed);
+    while (chunk != nullptr) {
+      auto* const next = chunk->next.load(std::memory_order_relaxed);
+      delete chunk;
+      chunk = next;
+    }
+  }
+
+  // Calls visit with each event published so far, from any thread
+  template <typename Visit>
+  auto for_each_event(Visit visit) const -> void {
+    const auto count = num_events.load(std::memory_order_acquire);
+    const Chunk* chunk = head.get();
+    for (size_t i = 0; i < count; i++) {
+      if (i != 0 && i % chunk_size == 0) {
+        chunk = chunk->next.load(std::memory_order_acquire);
+      }
+      visit(chunk->events[i % chunk_size]);
+    }
+  }
+};
+
+namespace {
+
+using Registry = struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Track>> tracks;
+};
+
+auto registry() -> Registry& {
+  static Registry registry;
+  return registry;
+}
+
+auto add_track(const std::string& name) -> Track& {
+  auto& [mutex, tracks] = registry();
+  std::scoped_lock lock(mutex);
+  const auto id = tracks.size() + 1;
+  tracks.push_back(std::make_unique<Track>(
+      id, name.empty() ? std::format("Thread {}", id) : name));
+  return *tracks.back();
+}
+
+thread_local Track* thread_track = nullptr;
+
+auto current_track() -> Track& {
+  if (thread_track == nullptr) {
+    thread_track = &add_track({});
+  }
+  return *thread_track;
+}
+
+auto write_json_string(std::ostream& stream, const std::string_view text)
+    -> void {
+  stream << '"';
+  for (const auto character : text) {
+    if (character == '"' || character == '\\') {
+      stream << '\\' << character;
+    } else if (static_cast<unsigned char>(character) < 0x20) {
+      stream << std::format("\\u{:04x}", static_cast<int>(character));
+    } else {
+      stream << character;
+    }
+  }
+  stream << '"';
+}
+
+}  // namespace
+
+auto now_ns() -> int64_t {
+  static const auto epoch = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - epoch)
+      .count();
+}
+
+auto record(const Event& event) -> void { record(current_track(), event); }
+
+auto create_track(const std::string& name) -> Track& { return add_track(name); }
+
+auto record(Track& track, const Event& event) -> void {
+  // Only this thread writes num_events
+  const auto index = track.num_events.load(std::memory_order_relaxed);
+  if (index == max_events_per_track) {
+    track.num_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (index != 0 && index % chunk_size == 0) {
+    auto* const chunk = new Chunk;
+    track.tail->next.store(chunk, std::memory_order_release);
+    track.tail = chunk;
+  }
+  track.tail->events[index % chunk_size] = event;
+  track.num_events.store(index + 1, std::memory_order_release);
+}
+
+auto set_thread_name(const std::string& name) -> void {
+  auto& track = current_track();
+  std::scoped_lock lock(registry().mutex);
+  track.name = name;
+}
+
+Zone::Zone(const char* name) : name_(name), start_ns_(now_ns()) {}
+
+Zone::~Zone() {
+  record(Event{.name = name_,
+               .start_ns = start_ns_,
+               .duration_ns = now_ns() - start_ns_});
+}
+
+auto stats() -> Stats {
+  auto& [mutex, tracks] = registry();
+  std::scoped_lock lock(mutex);
+  Stats stats{.num_tracks = tracks.size(), .num_events = 0, .num_dropped = 0};
+  for (const auto& track : tracks) {
+    stats.num_events += track->num_events.load(std::memory_order_acquire);
+    stats.num_dropped += track->num_dropped.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+auto write_chrome_trace(std::ostream& stream) -> void {
+  auto& [mutex, tracks] = registry();
+  std::scoped_lock lock(mutex);
+  // Complete events with microsecond timestamps, one process with a thread
+  // per track
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  auto first = true;
+  const auto separate = [&stream, &first]() {
+    stream << (first ? "\n" : ",\n");
+    first = false;
+  };
+  for (const auto& track : tracks) {
+    separate();
+    stream << std::format(
+        R"({{"ph":"M","pid":1,"tid":{},"name":"thread_name","args":{{"name":)",
+        track->id);
+    write_json_string(stream, track->name);
+    stream << "}}";
+    track->for_each_event([&stream, &separate, &track](const Event& event) {
+      separate();
+      stream << std::format(R"({{"ph":"X","pid":1,"tid":{},"name":)",
+                            track->id);
+      write_json_string(stream, event.name);
+      stream << std::format(R"(,"ts":{:.3f},"dur":{:.3f}}})",
+                            static_cast<double>(event.start_ns) / 1000.0,
+                            static_cast<double>(event.duration_ns) / 1000.0);
+    });
+  }
+  stream << "\n]}\n";
+}
+
+auto write_chrome_trace(const std::string& filename) -> bool {
+  std::ofstream file(filename);
+  if (!file) {
+    return false;
+  }
+  write_chrome_trace(file);
+  file.close();
+  return !file.fail();
+}
+
+}  // namespace profiler
@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Timed zones of CPU work, written out as a Chrome trace that
+// chrome://tracing or ui.perfetto.dev can open. Each thread appends its
+// events to a buffer of its own without locking, a lock is only taken the
+// first time a thread records and when the trace is written, which can
+// happen while other threads keep recording.
+//
+// Pure CPU code, it doesn't need a context. gpu_timer.h records GPU work
+// into the same trace.
+namespace profiler {
+
+// Beyond this a track drops its events
+constexpr size_t max_events_per_track = size_t{1} << 20;
+
+using Event = struct Event {
+  // Must outlive the profiler, usually a string literal
+  const char* name;
+  // Nanoseconds since the profiler's epoch, see now_ns
+  int64_t start_ns;
+  int64_t duration_ns;
+};
+
+// A row of the trace. Every thread gets one when it first records,
+// timings measured elsewhere, like on the GPU, get their own.
+class Track;
+
+using Stats = struct Stats {
+  size_t num_tracks;
+  size_t num_events;
+  size_t num_dropped;
+};
+
+// Nanoseconds since the first call, on a steady clock
+auto now_ns() -> int64_t;
+
+// Appends to the calling thread's track
+auto record(const Event& event) -> void;
+
+// Creates a track named name for timings not measured by the thread
+// recording them. Lives as long as the program, only one thread may record
+// to it at a time.
+auto create_track(const std::string& name) -> Track&;
+
+// Appends to track
+auto record(Track& track, const Event& event) -> void;
+
+// Names the calling thread's track in the trace
+auto set_thread_name(const std::string& name) -> void;
+
+// Records the time between its construction and destruction on the calling
+// thread's track
+class Zone {
+ private:
+  const char* name_;
+  int64_t start_ns_;
+
+ public:
+  // name must outlive the profiler, usually a string literal
+  explicit Zone(const char* name);
+  ~Zone();
+
+  // Delete copy constructors
+  Zone(const Zone&) = delete;
+  auto operator=(const Zone&) -> Zone& = delete;
+};
+
+// Events recorded so far, across every track
+auto stats() -> Stats;
+
+// Writes the events recorded so far in the Chrome trace event format
+auto write_chrome_trace(std::ostream& stream) -> void;
+
+// Writes the trace to filename, returns false if it can't be written
+auto write_chrome_trace(const std::string& filename) -> bool;
+
+}  // namespace profiler
+
+#endif  // PROFILER_H
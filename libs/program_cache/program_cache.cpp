@@ -0,0 +1,177 @@
+#include "program_cache.h"
+
+#include <GL/glew.h>
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace program_cache {
+
+namespace {
+
+constexpr std::array<char, 8> magic = {'P', 'R', 'O', 'G', 'C', 'A', 'C', 'H'};
+
+// Header, then binary_size bytes of the binary
+using Header = struct Header {
+  std::array<char, 8> magic;
+  uint32_t version;
+  uint32_t binary_format;
+  uint64_t key;
+  uint64_t binary_size;
+};
+
+std::atomic<size_t> num_hits = 0;
+std::atomic<size_t> num_misses = 0;
+
+// FNV-1a, continuing from hash
+auto hash_bytes(uint64_t hash, const std::string_view bytes) -> uint64_t {
+  for (const auto byte : bytes) {
+    hash = (hash ^ static_cast<unsigned char>(byte)) * 0x100000001b3;
+  }
+  return hash;
+}
+
+auto gl_string(const GLenum name) -> std::string_view {
+  const auto* const string = glGetString(name);
+  return string == nullptr ? std::string_view{}
+                           : reinterpret_cast<const char*>(string);
+}
+
+auto path_for(const std::string& cache_directory, const uint64_t key)
+    -> std::filesystem::path {
+  std::array<char, 17> name{};
+  std::snprintf(name.data(), name.size(), "%016llx",
+                static_cast<unsigned long long>(key));
+  return std::filesystem::path(cache_directory) /
+         (std::string(name.data()) + ".progbin");
+}
+
+// Reads the binary stored under key, empty if it's missing or corrupt
+auto read_binary(const std::filesystem::path& path, const uint64_t key,
+                 GLenum& binary_format) -> std::vector<char> {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return {};
+  }
+  Header header{};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!file || header.magic != magic || header.version != version ||
+      header.key != key || header.binary_size == 0) {
+    return {};
+  }
+  std::vector<char> binary(header.binary_size);
+  file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+  if (!file) {
+    return {};
+  }
+  binary_format = header.binary_format;
+  return binary;
+}
+
+}  // namespace
+
+auto key_for(const std::string_view vertex_source,
+             const std::string_view fragment_source) -> uint64_t {
+  // Sizes keep moving text from one source to the other from colliding
+  auto hash =
+      hash_bytes(0xcbf29ce484222325, std::to_string(vertex_source.size()));
+  hash = hash_bytes(hash, vertex_source);
+  hash = hash_bytes(hash, std::to_string(fragment_source.size()));
+  hash = hash_bytes(hash, fragment_source);
+  // Binaries only load on the driver that wrote them
+  for (const auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    hash = hash_bytes(hash, gl_string(name));
+  }
+  return hash;
+}
+
+auto load(const std::string& cache_directory, const uint64_t key)
+    -> unsigned int {
+  GLenum binary_format = 0;
+  const auto binary =
+      read_binary(path_for(cache_directory, key), key, binary_format);
+  if (binary.empty()) {
+    ++num_misses;
+    return 0;
+  }
+
+  const auto program_id = glCreateProgram();
+  glProgramBinary(program_id, binary_format, binary.data(),
+                  static_cast<GLsizei>(binary.size()));
+  // Fails when the driver no longer supports the format or was updated
+  // without changing its version string
+  auto link_status = GL_FALSE;
+  glGetProgramiv(program_id, GL_LINK_STATUS, &link_status);
+  if (link_status != GL_TRUE) {
+    glDeleteProgram(program_id);
+    ++num_misses;
+    return 0;
+  }
+  ++num_hits;
+  return program_id;
+}
+
+auto prepare_for_link(const unsigned int program_id) -> void {
+  glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+auto store(const std::string& cache_directory, const uint64_t key,
+           const unsigned int program_id) -> bool {
+  GLint binary_size = 0;
+  glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &binary_size);
+  if (binary_size <= 0) {
+    return false;
+  }
+  std::vector<char> binary(static_cast<size_t>(binary_size));
+  GLenum binary_format = 0;
+  GLsizei written_size = 0;
+  glGetProgramBinary(program_id, binary_size, &written_size, &binary_format,
+                     binary.data());
+  if (written_size <= 0) {
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(cache_directory, error);
+  if (error) {
+    return false;
+  }
+  const auto cache_path = path_for(cache_directory, key);
+  auto temporary_path = cache_path;
+  temporary_path += ".tmp";
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      return false;
+    }
+    const Header header{.magic = magic,
+                        .version = version,
+                        .binary_format = binary_format,
+                        .key = key,
+                        .binary_size = static_cast<uint64_t>(written_size)};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), written_size);
+    if (!file) {
+      file.close();
+      std::filesystem::remove(temporary_path, error);
+      return false;
+    }
+  }
+  std::filesystem::rename(temporary_path, cache_path, error);
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+    return false;
+  }
+  return true;
+}
+
+auto stats() -> Stats {
+  return Stats{.hits = num_hits.load(), .misses = num_misses.load()};
+}
+
+}  // namespace program_cache
@@ -0,0 +1,48 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// On-disk cache of linked program binaries, so warm starts skip compiling
+// and linking GLSL. A binary is stored under a hash of the vertex and
+// fragment sources along with the driver's vendor, renderer and version, and
+// read back with glProgramBinary. Drivers may still reject a binary they
+// wrote, load then reports a miss and the caller compiles from source.
+//
+// Needs a current context for every call.
+namespace program_cache {
+
+// Bumped whenever the layout of the file changes
+constexpr uint32_t version = 1;
+
+using Stats = struct Stats {
+  size_t hits;
+  size_t misses;
+};
+
+// Identifies a program built from these sources by the current driver
+auto key_for(std::string_view vertex_source, std::string_view fragment_source)
+    -> uint64_t;
+
+// Program linked from the binary cached under key in cache_directory, 0 if
+// there is none or the driver rejects it. Counts a hit or a miss.
+auto load(const std::string& cache_directory, uint64_t key) -> unsigned int;
+
+// Must be called on a program before linking it for store to retrieve its
+// binary
+auto prepare_for_link(unsigned int program_id) -> void;
+
+// Saves the binary of the linked program_id under key, through a temporary
+// file renamed into place. Returns false on failure.
+auto store(const std::string& cache_directory, uint64_t key,
+           unsigned int program_id) -> bool;
+
+// Hits and misses of load since startup
+auto stats() -> Stats;
+
+}  // namespace program_cache
+
+#endif  // PROGRAM_CACHE_H
@@ -0,0 +1,187 @@
+#include "shader_preprocessor.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <tuple>
+
+namespace shader_preprocessor {
+
+namespace {
+
+auto read_file(const std::filesystem::path& path)
+    -> std::optional<std::string> {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  if (file.bad()) {
+    return std::nullopt;
+  }
+  return contents.str();
+}
+
+auto trim_start(const std::string_view text) -> std::string_view {
+  const auto start = text.find_first_not_of(" \t");
+  return start == std::string_view::npos ? std::string_view{}
+                                         : text.substr(start);
+}
+
+// Name of the directive line starts with, # followed by optional spaces
+auto directive(const std::string_view line) -> std::string_view {
+  const auto trimmed = trim_start(line);
+  if (!trimmed.starts_with('#')) {
+    return {};
+  }
+  const auto rest = trim_start(trimmed.substr(1));
+  return rest.substr(0, rest.find_first_of(" \t\"<"));
+}
+
+// File named by an #include line, nullopt if it isn't quoted or in <>
+auto include_name(const std::string_view line)
+    -> std::optional<std::string_view> {
+  const auto open = line.find_first_of("\"<");
+  if (open == std::string_view::npos) {
+    return std::nullopt;
+  }
+  const auto close = line.find(line[open] == '"' ? '"' : '>', open + 1);
+  if (close == std::string_view::npos || close == open + 1) {
+    return std::nullopt;
+  }
+  return line.substr(open + 1, close - open - 1);
+}
+
+// Whether a line of text is a #version directive, unlike a mention of it in
+// a comment or string
+auto has_version(const std::string& text) -> bool {
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (directive(line) == "version") {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto emit_defines(const std::span<const Define> defines, std::string& source)
+    -> void {
+  for (const auto& [name, value] : defines) {
+    source += value.empty() ? std::format("#define {}\n", name)
+                            : std::format("#define {} {}\n", name, value);
+  }
+}
+
+auto expand(const std::filesystem::path& path,
+            const std::span<const Define> defines, Preprocessed& preprocessed)
+    -> std::expected<void, std::string> {
+  const auto contents = read_file(path);
+  if (!contents) {
+    return std::unexpected(
+        std::format("Could not open file '{}'", path.string()));
+  }
+  const auto file_index = preprocessed.files.size();
+  preprocessed.files.push_back(path.string());
+  auto& source = preprocessed.source;
+
+  // Without #version the defines go first
+  auto defines_emitted = defines.empty();
+  if (!defines_emitted && !has_version(*contents)) {
+    emit_defines(defines, source);
+    source += std::format("#line 1 {}\n", file_index);
+    defines_emitted = true;
+  } else if (file_index != 0) {
+    source += std::format("#line 1 {}\n", file_index);
+  }
+
+  std::istringstream lines(*contents);
+  std::string line;
+  size_t line_number = 0;
+  while (std::getline(lines, line)) {
+    line_number++;
+    const auto line_directive = directive(line);
+    if (line_directive == "version" && !defines_emitted) {
+      source += line + "\n";
+      emit_defines(defines, source);
+      source += std::format("#line {} {}\n", line_number + 1, file_index);
+      defines_emitted = true;
+      continue;
+    }
+    if (line_directive != "include") {
+      source += line + "\n";
+      continue;
+    }
+
+    const auto name = include_name(line);
+    if (!name) {
+      return std::unexpected(std::format("'{}':{}: Could not parse #include",
+                                         path.string(), line_number));
+    }
+    const auto included_path =
+        (path.parent_path() / *name).lexically_normal();
+    // Already expanded, or being expanded when includes are circular
+    if (std::ranges::find(preprocessed.files, included_path.string()) !=
+        preprocessed.files.end()) {
+      source += "\n";
+      continue;
+    }
+    if (const auto expanded = expand(included_path, {}, preprocessed);
+        !expanded) {
+      return std::unexpected(std::format("{}, included from '{}':{}",
+                                         expanded.error(), path.string(),
+                                         line_number));
+    }
+    source += std::format("#line {} {}\n", line_number + 1, file_index);
+  }
+  return {};
+}
+
+}  // namespace
+
+auto preprocess(const std::string& filename,
+                const std::span<const Define> defines)
+    -> std::expected<Preprocessed, std::string> {
+  Preprocessed preprocessed;
+  if (const auto expanded = expand(
+          std::filesystem::path(filename).lexically_normal(), defines,
+          preprocessed);
+      !expanded) {
+    return std::unexpected(expanded.error());
+  }
+  return preprocessed;
+}
+
+auto permutation_key(const std::span<const Define> defines) -> uint64_t {
+  std::vector<const Define*> sorted_defines;
+  sorted_defines.reserve(defines.size());
+  for (const auto& define : defines) {
+    sorted_defines.push_back(&define);
+  }
+  // Values break ties so repeated names hash the same in any order
+  std::ranges::sort(sorted_defines, {}, [](const Define* const define) {
+    return std::tie(define->name, define->value);
+  });
+
+  // FNV-1a over name=value lines
+  uint64_t hash = 0xcbf29ce484222325;
+  const auto hash_text = [&hash](const std::string_view text) {
+    for (const auto character : text) {
+      hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001b3;
+    }
+  };
+  for (const auto* const define : sorted_defines) {
+    hash_text(define->name);
+    hash_text("=");
+    hash_text(define->value);
+    hash_text("\n");
+  }
+  return hash;
+}
+
+}  // namespace shader_preprocessor
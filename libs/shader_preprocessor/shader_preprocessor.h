@@ -0,0 +1,44 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <vector>
+
+// Expands a GLSL file into a single source the driver can compile. Each
+// #include "file" is replaced by the file, resolved relative to the one
+// including it, and every file is included at most once so shared
+// declarations can be included from anywhere. The given defines go right
+// after #version, so one file can be built into several permutations.
+//
+// #line directives keep the driver's errors pointing at the right line, the
+// source string number of each file is its index in Preprocessed::files.
+// Pure CPU code, it doesn't need a context.
+namespace shader_preprocessor {
+
+using Define = struct Define {
+  std::string name;
+  // Empty for a define without value, like #define TEXTURED
+  std::string value;
+};
+
+using Preprocessed = struct Preprocessed {
+  std::string source;
+  // The file preprocessed first, then those it included in the order they
+  // were first included
+  std::vector<std::string> files;
+};
+
+// Error message when filename or a file it includes can't be read or an
+// #include can't be parsed
+auto preprocess(const std::string& filename, std::span<const Define> defines)
+    -> std::expected<Preprocessed, std::string>;
+
+// Identifies a set of defines regardless of their order
+auto permutation_key(std::span<const Define> defines) -> uint64_t;
+
+}  // namespace shader_preprocessor
+
+#endif  // SHADER_PREPROCESSOR_H